@@ -1,4 +1,7 @@
+import os
 import sys
+import tempfile
+import time
 
 sys.path.append(
     '/home/jeffbla/Project/bvh_analysis_viewer_withEngine/Py_package/lstm_posture_suggestion/forehand'
@@ -6,6 +9,7 @@ sys.path.append(
 
 import numpy as np
 import pandas as pd
+import torch
 from scipy import signal
 import matplotlib.pyplot as plt
 
@@ -17,6 +21,18 @@ from multipledispatch import dispatch
 
 from base_lstm import LSTMClassifier
 
+try:
+    # The native similarity engine only exists inside the testbed (pybind11 embedded module)
+    import native_similarity
+except ImportError:
+    native_similarity = None
+
+try:
+    # Native OpenPose csv loading & keypoint kernels, also only inside the testbed
+    import native_keypoints
+except ImportError:
+    native_keypoints = None
+
 #################### CONSTANT ####################
 
 target_ref_table = {
@@ -27,10 +43,38 @@ target_ref_table = {
 FOREARM_DEVIATE = 1
 STD_FOREARM_AMPLITUDE = 3
 
+FOREHAND_CHECKPOINT = "~/Project/bvh_analysis_viewer_withEngine/Py_package/lstm_posture_suggestion/forehand/pth/test/resnet-epoch=606-train_loss=0.0000.ckpt"
+
 #################### Function ####################
 
 
+def Resample(ts: np.ndarray, sz: int) -> np.ndarray:
+    """Same as TimeSeriesResampler(sz=sz).fit_transform(ts) for a single series, shape (1, sz, 1)"""
+    if native_similarity is not None:
+        return native_similarity.resample(np.ravel(ts), sz).reshape(1, -1, 1)
+    return TimeSeriesResampler(sz=sz).fit_transform(ts)
+
+
+def ZNormalize(ts: np.ndarray) -> np.ndarray:
+    """Same as TimeSeriesScalerMeanVariance(mu=0, std=1).fit_transform(ts) for a single series, shape (1, sz, 1)"""
+    if native_similarity is not None:
+        return native_similarity.znormalize(np.ravel(ts)).reshape(1, -1, 1)
+    return TimeSeriesScalerMeanVariance(mu=0, std=1).fit_transform(ts)
+
+
+def LcssSimilarity(s1: np.ndarray, s2: np.ndarray, eps: float) -> float:
+    """The similarity of tslearn.metrics.lcss_path"""
+    if native_similarity is not None:
+        return native_similarity.lcss(s1, s2, eps=eps)
+    path, sim = lcss_path(s1, s2, eps=eps)
+    return sim
+
+
+
 def WaistRotationRead(filename: str):
+    if native_keypoints is not None:
+        return native_keypoints.waist_rotation(filename)
+
     df = pd.read_csv(filename)
 
     df_rshoulder_x = df['2DX_rshoulder']
@@ -58,8 +102,8 @@ def WaistRotationPreprocess(df_target: np.ndarray, df_ref: np.ndarray):
     num_frame = max(len(df_target), len(df_ref))
 
     # Resample the time series
-    df_target = TimeSeriesResampler(sz=num_frame).fit_transform(df_target)
-    df_ref = TimeSeriesResampler(sz=num_frame).fit_transform(df_ref)
+    df_target = Resample(df_target, num_frame)
+    df_ref = Resample(df_ref, num_frame)
 
     return df_target, df_ref
 
@@ -76,8 +120,7 @@ def OpenPoseAnalysize_Waist(df_target: np.ndarray, df_ref: np.ndarray):
     dataset = np.concatenate([df_target, df_ref])
 
     # Compute the LCSS
-    path, sim = lcss_path(dataset[0, :, 0], dataset[1, :, 0], eps=0.5)
-    return sim
+    return LcssSimilarity(dataset[0, :, 0], dataset[1, :, 0], eps=0.5)
 
 
 @dispatch(str, str, str)
@@ -93,18 +136,13 @@ def BvhAnalyzePreprocess(df_target: pd.DataFrame, df_ref: pd.DataFrame,
                          target: str):
     num_frame = max(df_target.count().max(), df_ref.count().max())
 
-    scaler = TimeSeriesScalerMeanVariance(mu=0, std=1)
     df_target_result = pd.DataFrame()
     df_ref_result = pd.DataFrame()
     for column in df_target.columns:
         if target in column:
             # Rescale & Resample the time series
-            ts1 = TimeSeriesResampler(sz=num_frame).fit_transform(
-                df_target[column].values)
-            ts2 = TimeSeriesResampler(sz=num_frame).fit_transform(
-                df_ref[column].values)
-            ts1 = scaler.fit_transform(ts1)
-            ts2 = scaler.fit_transform(ts2)
+            ts1 = ZNormalize(Resample(df_target[column].values, num_frame))
+            ts2 = ZNormalize(Resample(df_ref[column].values, num_frame))
             df_target_result[column] = ts1.reshape(-1)
             df_ref_result[column] = ts2.reshape(-1)
 
@@ -130,8 +168,9 @@ def BvhAnalyze(df_target: pd.DataFrame, df_ref: pd.DataFrame,
                 [df_target[column].values, df_ref[column].values])
 
             # Compute the LCSS
-            path, sim = lcss_path(dataset[0, :, 0], dataset[1, :, 0], eps=0.5)
-            simList[column] = sim
+            simList[column] = LcssSimilarity(dataset[0, :, 0],
+                                             dataset[1, :, 0],
+                                             eps=0.5)
     return simList
 
 
@@ -144,14 +183,164 @@ def ForehandStrokeAnalysis(openpose_target_filename: str,
         columns=["openpose_files", "angle_files"])
     annotation_file.to_csv("tmp.csv", index=False)
 
-    pred = LSTMClassifier.lstm_forehand_predict(
-        "tmp.csv",
-        "~/Project/bvh_analysis_viewer_withEngine/Py_package/lstm_posture_suggestion/forehand/pth/test/resnet-epoch=606-train_loss=0.0000.ckpt",
-        batch_size=1)
+    pred = LSTMClassifier.lstm_forehand_predict("tmp.csv",
+                                                FOREHAND_CHECKPOINT,
+                                                batch_size=1)
     result = pred[0][0].tolist()
     return result
 
 
+def BuildSequence(openpose: np.ndarray, openpose_columns: list, angles: np.ndarray, angle_columns: list,
+                  feature_columns: list, mean: list, std: list, sequence_length: int) -> np.ndarray:
+    """
+    The model input of a clip, (frame, feature) float32, the same as the native LstmModel::BuildInput: each feature
+    column from the angles, else from the keypoints, resampled to sequence_length frames (the longest column's if 0),
+    standardized with the training mean & std, a missing keypoint (NaN) at the mean
+    """
+    angle_index = {name: i for i, name in enumerate(angle_columns)}
+    openpose_index = {name: i for i, name in enumerate(openpose_columns)}
+    series = []
+    for name in feature_columns:
+        if name in angle_index:
+            series.append(np.asarray(angles[:, angle_index[name]], dtype=np.float32))
+        elif name in openpose_index:
+            series.append(np.asarray(openpose[:, openpose_index[name]], dtype=np.float32))
+        else:
+            raise KeyError(f"the model input {name} is missing")
+
+    num_frame = sequence_length or max(len(column) for column in series)
+    sequence = np.empty((num_frame, len(series)), dtype=np.float32)
+    for i, column in enumerate(series):
+        resampled = np.ravel(Resample(column.reshape(1, -1, 1), num_frame))
+        value = (resampled - mean[i]) / (std[i] if std[i] != 0 else 1.0)
+        sequence[:, i] = np.where(np.isnan(value), 0.0, value)
+    return sequence
+
+
+# The models loaded by the sessions of this process, by checkpoint (ForehandSession.Version: path, size & time)
+_forehand_models = {}
+
+
+class ForehandSession:
+    """
+    Long-lived forehand classifier, created once per process by the testbed (ClassifierSession).
+    Load reads a checkpoint once for the whole process (a rewritten file is read again).
+    Predict goes through LSTMClassifier.lstm_forehand_predict, the training code's own preprocessing & output, unless
+    in_memory is set: then the session's model runs on the arrays themselves (BuildSequence), which needs a checkpoint
+    with the feature_columns hparams (ExportLstm.py's) and is only to be switched on once CheckParity agrees on real
+    clips.
+    """
+
+    def __init__(self, checkpoint: str = FOREHAND_CHECKPOINT, in_memory: bool = False):
+        self.checkpoint = os.path.expanduser(checkpoint)
+        self.in_memory = in_memory
+        self.model = None
+        self.model_load_ms = 0.0
+        self.last_inference_ms = 0.0
+
+    def Load(self):
+        if self.model is not None:
+            return
+
+        start = time.perf_counter()
+        key = self.Version()
+        model = _forehand_models.get(key)
+        if model is None:
+            model = LSTMClassifier.load_from_checkpoint(self.checkpoint)
+            model.eval()
+            _forehand_models[key] = model
+        self.model = model
+        self.model_load_ms = (time.perf_counter() - start) * 1e3
+
+    def Version(self) -> str:
+        """Changes with the checkpoint file, part of the testbed's result cache key"""
+        try:
+            stat = os.stat(self.checkpoint)
+        except OSError:
+            return self.checkpoint
+        return f"{self.checkpoint}:{stat.st_size}:{stat.st_mtime_ns}"
+
+    def Predict(self, openpose: np.ndarray, openpose_columns: list,
+                angles: np.ndarray, angle_columns: list) -> list:
+        """
+        ForehandStrokeAnalysis on in-memory data: openpose & angles are (frame, column) read-only views of the
+        C++ matrices, the DataFrames wrap them without a copy.
+        """
+        start = time.perf_counter()
+        if self.in_memory:
+            result = self.PredictInMemory(openpose, openpose_columns, angles, angle_columns)
+        else:
+            result = self.PredictReference(openpose, openpose_columns, angles, angle_columns)
+        self.last_inference_ms = (time.perf_counter() - start) * 1e3
+        return result
+
+    def PredictReference(self, openpose: np.ndarray, openpose_columns: list,
+                         angles: np.ndarray, angle_columns: list) -> list:
+        """The prediction of lstm_forehand_predict, the reference of the other paths"""
+        df_openpose = pd.DataFrame(openpose,
+                                   columns=openpose_columns,
+                                   copy=False)
+        df_angle = pd.DataFrame(angles, columns=angle_columns, copy=False)
+        df_angle.index.name = "frame"
+
+        # lstm_forehand_predict only takes an annotation file of csv paths, so the frames are spilled to a
+        # private temporary directory here
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            openpose_filename = os.path.join(tmp_dir, "openpose.csv")
+            angle_filename = os.path.join(tmp_dir, "angle.csv")
+            annotation_filename = os.path.join(tmp_dir, "annotation.csv")
+            df_openpose.to_csv(openpose_filename, index=False)
+            df_angle.to_csv(angle_filename)
+            pd.DataFrame([[openpose_filename, angle_filename]],
+                         columns=["openpose_files", "angle_files"
+                                  ]).to_csv(annotation_filename, index=False)
+
+            pred = LSTMClassifier.lstm_forehand_predict(annotation_filename,
+                                                        self.checkpoint,
+                                                        batch_size=1)
+        return pred[0][0].tolist()
+
+    def PredictInMemory(self, openpose: np.ndarray, openpose_columns: list,
+                        angles: np.ndarray, angle_columns: list) -> list:
+        """
+        The session's model on the model input built from the arrays (BuildSequence, with the feature columns,
+        statistics & sequence length of the checkpoint's hparams), nothing is written
+        """
+        self.Load()
+        hparams = getattr(self.model, "hparams", {})
+        columns = list(hparams.get("feature_columns", []))
+        if not columns:
+            raise ValueError(f"{self.checkpoint} has no feature_columns hparam, the model input is unknown")
+
+        sequence = BuildSequence(openpose, openpose_columns, angles, angle_columns, columns,
+                                 list(hparams.get("feature_mean", [0.0] * len(columns))),
+                                 list(hparams.get("feature_std", [1.0] * len(columns))),
+                                 int(hparams.get("sequence_length", 0)))
+        lstm = next(module for module in self.model.modules() if isinstance(module, torch.nn.LSTM))
+        batch = torch.from_numpy(sequence).unsqueeze(0 if lstm.batch_first else 1)
+        with torch.no_grad():
+            output = self.model(batch.to(next(self.model.parameters()).device))
+        return output.reshape(-1).tolist()
+
+    def CheckParity(self, openpose: np.ndarray, openpose_columns: list,
+                    angles: np.ndarray, angle_columns: list) -> float:
+        """Largest difference between the in-memory & the reference prediction of a clip"""
+        reference = self.PredictReference(openpose, openpose_columns, angles, angle_columns)
+        in_memory = self.PredictInMemory(openpose, openpose_columns, angles, angle_columns)
+        if len(reference) != len(in_memory):
+            return float("inf")
+        return max((abs(a - b) for a, b in zip(reference, in_memory)), default=0.0)
+
+
+def ForehandStrokeAnalysisArrays(openpose: np.ndarray, openpose_columns: list,
+                                 angles: np.ndarray,
+                                 angle_columns: list) -> list:
+    """ForehandStrokeAnalysis on in-memory data, with a session of its own sharing the loaded model"""
+    session = ForehandSession()
+    session.Load()
+    return session.Predict(openpose, openpose_columns, angles, angle_columns)
+
+
 if __name__ == "__main__":
     # print(
     #     OpenPoseAnalysize_Waist("cmake-build-debug/output/openposeTest.csv",
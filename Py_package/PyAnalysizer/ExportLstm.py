@@ -0,0 +1,189 @@
+"""
+Export the forehand LSTM checkpoint to the flat binary file of the testbed's native engine (common/LstmEngine.h).
+
+    python ExportLstm.py <checkpoint.ckpt> <output.bin> [--columns columns.txt] [--sequence-length N]
+                         [--output-activation sigmoid] [--reference reference.bin]
+
+The file is little endian:
+    "TBLSTM1\\0"
+    uint32 num_column, then for each column: uint32 length, name bytes
+    float32 mean[num_column], float32 std[num_column], uint32 sequence_length
+    uint32 num_lstm_layer, then for each: uint32 input_size, hidden_size,
+        float32 weight_ih[4H][I], weight_hh[4H][H], bias_ih + bias_hh[4H]   (gate order i, f, g, o)
+    uint32 num_dense_layer, then for each: uint32 input_size, output_size, activation (0 none, 1 relu, 2 sigmoid,
+        3 softmax), float32 weight[output][input], bias[output]
+
+The input columns, their statistics and the sequence length are read from the model's hparams
+(feature_columns, feature_mean, feature_std, sequence_length) when present, the options override them. One column
+name per model input is required: the native engine builds its input from them and refuses a model without.
+--reference also writes a random input sequence with the checkpoint's own output (model.eval(); model(sequence)),
+for the parity check of testbed_bench:
+    uint32 num_frame, num_input, float32 input[num_frame][num_input], uint32 num_output, float32 output[num_output]
+"""
+
+import argparse
+import struct
+import sys
+
+sys.path.append(
+    '/home/jeffbla/Project/bvh_analysis_viewer_withEngine/Py_package/lstm_posture_suggestion/forehand'
+)
+
+import numpy as np
+import torch
+
+from base_lstm import LSTMClassifier
+
+MAGIC = b"TBLSTM1\0"
+ACTIVATIONS = {"none": 0, "relu": 1, "sigmoid": 2, "softmax": 3}
+
+
+def CollectLayers(model: torch.nn.Module, output_activation: str):
+    """The LSTM layers then the dense layers with their activation, in module order"""
+    lstm_layers, dense_layers = [], []
+    for module in model.modules():
+        if isinstance(module, torch.nn.LSTM):
+            if module.bidirectional or module.proj_size > 0 or not module.bias:
+                raise ValueError("only unidirectional LSTM with bias and without projection are supported")
+            for layer in range(module.num_layers):
+                lstm_layers.append((
+                    getattr(module, f"weight_ih_l{layer}"),
+                    getattr(module, f"weight_hh_l{layer}"),
+                    getattr(module, f"bias_ih_l{layer}") + getattr(module, f"bias_hh_l{layer}"),
+                ))
+        elif isinstance(module, torch.nn.Linear):
+            dense_layers.append([module.weight, module.bias, ACTIVATIONS["none"]])
+        elif isinstance(module, torch.nn.ReLU) and dense_layers:
+            dense_layers[-1][2] = ACTIVATIONS["relu"]
+        elif isinstance(module, torch.nn.Sigmoid) and dense_layers:
+            dense_layers[-1][2] = ACTIVATIONS["sigmoid"]
+        elif isinstance(module, torch.nn.Softmax) and dense_layers:
+            dense_layers[-1][2] = ACTIVATIONS["softmax"]
+        elif isinstance(module, (torch.nn.Conv1d, torch.nn.Conv2d, torch.nn.GRU, torch.nn.RNN)):
+            raise ValueError(f"{type(module).__name__} is not supported by the native engine")
+
+    if not lstm_layers:
+        raise ValueError("the model has no LSTM layer")
+    # The activation applied in forward() (e.g. torch.sigmoid) is not a module
+    if dense_layers and dense_layers[-1][2] == ACTIVATIONS["none"]:
+        dense_layers[-1][2] = ACTIVATIONS[output_activation]
+    return lstm_layers, dense_layers
+
+
+def WriteFloats(file, tensor):
+    file.write(np.ascontiguousarray(tensor.detach().cpu().numpy(), dtype="<f4").tobytes())
+
+
+def Export(checkpoint: str, output: str, columns: list, mean: list, std: list, sequence_length: int,
+           output_activation: str):
+    model = LSTMClassifier.load_from_checkpoint(checkpoint)
+    model.eval()
+    hparams = getattr(model, "hparams", {})
+    columns = columns or list(hparams.get("feature_columns", []))
+    mean = mean or list(hparams.get("feature_mean", [0.0] * len(columns)))
+    std = std or list(hparams.get("feature_std", [1.0] * len(columns)))
+    sequence_length = sequence_length or int(hparams.get("sequence_length", 0))
+
+    lstm_layers, dense_layers = CollectLayers(model, output_activation)
+    num_input = lstm_layers[0][0].shape[1]
+    if len(columns) != num_input:
+        raise ValueError(f"the model takes {num_input} inputs, {len(columns)} columns are known: "
+                         "give them with --columns or the feature_columns hparam")
+    if len(mean) != num_input or len(std) != num_input:
+        raise ValueError(f"feature_mean & feature_std need {num_input} values")
+    with open(output, "wb") as file:
+        file.write(MAGIC)
+        file.write(struct.pack("<I", len(columns)))
+        for name in columns:
+            encoded = name.encode()
+            file.write(struct.pack("<I", len(encoded)))
+            file.write(encoded)
+        file.write(np.asarray(mean, dtype="<f4").tobytes())
+        file.write(np.asarray(std, dtype="<f4").tobytes())
+        file.write(struct.pack("<I", sequence_length))
+
+        file.write(struct.pack("<I", len(lstm_layers)))
+        for weight_ih, weight_hh, bias in lstm_layers:
+            file.write(struct.pack("<II", weight_ih.shape[1], weight_hh.shape[1]))
+            WriteFloats(file, weight_ih)
+            WriteFloats(file, weight_hh)
+            WriteFloats(file, bias)
+
+        file.write(struct.pack("<I", len(dense_layers)))
+        for weight, bias, activation in dense_layers:
+            file.write(struct.pack("<III", weight.shape[1], weight.shape[0], activation))
+            WriteFloats(file, weight)
+            WriteFloats(file, bias)
+    return model, lstm_layers, dense_layers
+
+
+def ExportedForward(lstm_layers, dense_layers, sequence: torch.Tensor) -> torch.Tensor:
+    """The exported graph in PyTorch: stacked LSTM, last hidden state, dense layers"""
+    x = sequence
+    for weight_ih, weight_hh, bias in lstm_layers:
+        hidden_size = weight_hh.shape[1]
+        h = torch.zeros(hidden_size, device=weight_hh.device)
+        c = torch.zeros(hidden_size, device=weight_hh.device)
+        outputs = []
+        for t in range(x.shape[0]):
+            i, f, g, o = (weight_ih @ x[t] + weight_hh @ h + bias).chunk(4)
+            c = torch.sigmoid(f) * c + torch.sigmoid(i) * torch.tanh(g)
+            h = torch.sigmoid(o) * torch.tanh(c)
+            outputs.append(h)
+        x = torch.stack(outputs)
+    y = x[-1]
+    for weight, bias, activation in dense_layers:
+        y = weight @ y + bias
+        if activation == ACTIVATIONS["relu"]:
+            y = torch.relu(y)
+        elif activation == ACTIVATIONS["sigmoid"]:
+            y = torch.sigmoid(y)
+        elif activation == ACTIVATIONS["softmax"]:
+            y = torch.softmax(y, dim=0)
+    return y
+
+
+def WriteReference(filename: str, model: torch.nn.Module, lstm_layers, dense_layers, num_frame: int):
+    """
+    The reference is the checkpoint's forward pass, not the exported graph: a layer or an activation the export
+    misses shows up in the parity check. The exported graph is compared to it here too.
+    """
+    num_input = lstm_layers[0][0].shape[1]
+    sequence = torch.randn(num_frame, num_input, generator=torch.Generator().manual_seed(0))
+    lstm = next(module for module in model.modules() if isinstance(module, torch.nn.LSTM))
+    device = next(model.parameters()).device
+    model.eval()
+    with torch.no_grad():
+        batch = sequence.unsqueeze(0 if lstm.batch_first else 1).to(device)
+        output = model(batch).reshape(-1).cpu()
+        exported = ExportedForward(lstm_layers, dense_layers, sequence.to(device)).reshape(-1).cpu()
+    if exported.shape != output.shape:
+        print(f"warning: the model gives {output.shape[0]} outputs, the exported graph {exported.shape[0]}")
+    else:
+        print(f"exported graph vs model: max error {(exported - output).abs().max().item():.3g}")
+    with open(filename, "wb") as file:
+        file.write(struct.pack("<II", num_frame, num_input))
+        WriteFloats(file, sequence)
+        file.write(struct.pack("<I", output.shape[0]))
+        WriteFloats(file, output)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Export the forehand LSTM for the native engine")
+    parser.add_argument("checkpoint")
+    parser.add_argument("output")
+    parser.add_argument("--columns", help="text file with one input column name per line")
+    parser.add_argument("--sequence-length", type=int, default=0)
+    parser.add_argument("--output-activation", choices=ACTIVATIONS.keys(), default="sigmoid")
+    parser.add_argument("--reference", help="also write a parity reference file")
+    args = parser.parse_args()
+
+    column_list = []
+    if args.columns:
+        with open(args.columns) as column_file:
+            column_list = [line.strip() for line in column_file if line.strip()]
+
+    model, lstms, denses = Export(args.checkpoint, args.output, column_list, [], [], args.sequence_length,
+                                  args.output_activation)
+    if args.reference:
+        WriteReference(args.reference, model, lstms, denses, args.sequence_length or 120)
@@ -0,0 +1,122 @@
+"""
+Record the tslearn results the native similarity engine (common/Similarity.h) must give, for the similarity/tslearn
+case of testbed_bench.
+
+    python RecordSimilarityFixtures.py [output.txt] [--target whole_body.csv --reference whole_body_ref.csv]
+
+The series are a clip of 22 angle-like channels (240 frames, slow sines plus noise) and the same motion played with a
+time warp over 300 frames with noise of its own, like a user's & an expert's stroke, or with --target & --reference
+the feature columns of two clips written by Identifier::WriteOutput. Every case is computed by tslearn
+the way Analysize computes it, and timed (median of 5 runs after a warm-up, numba's compilation left out):
+    resampled_lcss  one column of each clip: Resample to the longer clip, ZNormalize, lcss_path(eps) (BvhAnalyze)
+    lcss            all channels: lcss(eps) (lcss_path's similarity), with and without a Sakoe-Chiba band
+    dtw             all channels: dtw, with and without a Sakoe-Chiba band
+
+The file is text, the series as float32 values (the engine's precision, tslearn reads the same values as float64):
+    tslearn <version>
+    series <name> <num_frame> <num_channel>
+    <num_frame * num_channel values, time-major>
+    <kind> <series 1> <series 2> <channel, -1 for all> <eps> <radius, -1 for none> <expected> <python ms>
+"""
+
+import argparse
+import statistics
+import time
+
+import numpy as np
+import pandas as pd
+import tslearn
+from tslearn.metrics import dtw, lcss, lcss_path
+from tslearn.preprocessing import TimeSeriesResampler, TimeSeriesScalerMeanVariance
+
+OUTPUT = "benchmarks/fixtures/similarity_tslearn.txt"
+
+
+def MakeClip(num_frame: int, num_channel: int, seed: int) -> np.ndarray:
+    """Angle-like channels (degrees), the shape of SimilarityBench's MakeClip"""
+    rng = np.random.default_rng(seed)
+    t = np.arange(num_frame)[:, None]
+    phase = rng.uniform(0, 2 * np.pi, num_channel)
+    freq = rng.uniform(1, 4, num_channel)
+    clip = 60 * np.sin(freq * 2 * np.pi * t / num_frame + phase) + rng.normal(0, 2, (num_frame, num_channel))
+    return clip.astype(np.float32)
+
+
+def Warp(clip: np.ndarray, num_frame: int, seed: int) -> np.ndarray:
+    """clip played slow then fast over num_frame frames, with noise"""
+    rng = np.random.default_rng(seed)
+    x = np.linspace(0, 1, num_frame)
+    position = x ** 1.6 * (len(clip) - 1)
+    frames = np.arange(len(clip))
+    warped = np.stack([np.interp(position, frames, clip[:, c]) for c in range(clip.shape[1])], axis=1)
+    return (warped + rng.normal(0, 2, warped.shape)).astype(np.float32)
+
+
+def ReadFeatures(filename: str) -> np.ndarray:
+    """The feature columns of an Identifier::WriteOutput csv, without its frame column"""
+    df = pd.read_csv(filename)
+    df = df.drop(columns=[column for column in df.columns if column == "frame"])
+    return df.to_numpy(dtype=np.float32)
+
+
+def Time(function) -> tuple:
+    """The result of function and its median time (ms) over 5 runs, after one warm-up run"""
+    result = function()
+    times = []
+    for _ in range(5):
+        start = time.perf_counter()
+        function()
+        times.append((time.perf_counter() - start) * 1e3)
+    return result, statistics.median(times)
+
+
+def ResampledLcss(s1: np.ndarray, s2: np.ndarray, eps: float) -> float:
+    """Analysize.BvhAnalyzePreprocess & BvhAnalyze on one column, through tslearn only"""
+    num_frame = max(len(s1), len(s2))
+    scaler = TimeSeriesScalerMeanVariance(mu=0, std=1)
+    ts1 = scaler.fit_transform(TimeSeriesResampler(sz=num_frame).fit_transform(s1))
+    ts2 = scaler.fit_transform(TimeSeriesResampler(sz=num_frame).fit_transform(s2))
+    return lcss_path(ts1[0], ts2[0], eps=eps)[1]
+
+
+def Band(radius: int) -> dict:
+    return {} if radius < 0 else {"global_constraint": "sakoe_chiba", "sakoe_chiba_radius": radius}
+
+
+def Record(target: np.ndarray, reference: np.ndarray, output: str):
+    cases = []
+    # The two columns' frames compared one to one as BvhAnalyze does, then the whole clips
+    for channel in range(target.shape[1]):
+        value, ms = Time(lambda: ResampledLcss(target[:, channel], reference[:, channel], 0.5))
+        cases.append(("resampled_lcss", channel, 0.5, -1, value, ms))
+    for radius in (-1, 0):
+        value, ms = Time(lambda: lcss(target, reference, eps=10, **Band(radius)))
+        cases.append(("lcss", -1, 10, radius, value, ms))
+    for radius in (-1, 10, 0):
+        value, ms = Time(lambda: dtw(target, reference, **Band(radius)))
+        cases.append(("dtw", -1, 0, radius, value, ms))
+
+    with open(output, "w") as file:
+        file.write(f"tslearn {tslearn.__version__.replace(' ', '_')}\n")
+        for name, series in (("target", target), ("reference", reference)):
+            file.write(f"series {name} {series.shape[0]} {series.shape[1]}\n")
+            file.write(" ".join(f"{value:.9g}" for value in series.reshape(-1)) + "\n")
+        for kind, channel, eps, radius, value, ms in cases:
+            file.write(f"{kind} target reference {channel} {eps} {radius} {value:.17g} {ms:.6g}\n")
+    print(f"{len(cases)} cases written to {output}, python "
+          f"{sum(case[5] for case in cases if case[0] == 'resampled_lcss'):.3g} ms for the "
+          f"{target.shape[1]} resampled columns")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Record tslearn's similarities for the native engine's parity check")
+    parser.add_argument("output", nargs="?", default=OUTPUT)
+    parser.add_argument("--target", help="features of a clip (Identifier::WriteOutput csv)")
+    parser.add_argument("--reference", help="features of the clip it is compared with")
+    args = parser.parse_args()
+
+    if args.target and args.reference:
+        Record(ReadFeatures(args.target), ReadFeatures(args.reference), args.output)
+    else:
+        user = MakeClip(240, 22, 1)
+        Record(user, Warp(user, 300, 2), args.output)
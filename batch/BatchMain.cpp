@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <pybind11/embed.h>
+
+#include "BatchAnalysis.h"
+#include "ClassifierSession.h"
+#include "ExpertIndex.h"
+#include "PoseIndex.h"
+
+namespace py = pybind11;
+using namespace batchAnalysis;
+
+namespace {
+    void PrintUsage() {
+        std::cout << "Usage: testbed_batch <manifest> [--workers N] [--output results.csv] [--model model.bin]"
+                  << " [--precision fp32|fp16|int8]" << std::endl;
+        std::cout << "       testbed_batch <expert manifest> --build-expert-index experts.idx [--workers N]"
+                  << std::endl;
+        std::cout << "       testbed_batch <expert manifest> --build-pose-index poses.idx" << std::endl;
+    }
+
+    /// The expert library manifest (ExpertIndex::ReadManifest) indexed & saved, no analysis
+    int BuildExpertIndex(const std::string &manifest, const std::string &index_path, int num_worker) {
+        std::vector<expertIndex::ExpertClip> clips;
+        if (!expertIndex::ExpertIndex::ReadManifest(manifest, clips))
+            return 1;
+        const auto start = std::chrono::high_resolution_clock::now();
+        expertIndex::ExpertIndex index;
+        if (!index.Build(clips, expertIndex::IndexConfig(), num_worker))
+            return 1;
+        if (!index.Save(index_path)) {
+            std::cout << "Cannot write the expert index " << index_path << std::endl;
+            return 1;
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Saved " << index_path << " in " << std::chrono::duration<double>(end - start).count()
+                  << " s" << std::endl;
+        return 0;
+    }
+
+    /// Every frame of the clips of the expert library manifest indexed & saved, no analysis
+    int BuildPoseIndex(const std::string &manifest, const std::string &index_path) {
+        std::vector<expertIndex::ExpertClip> clips;
+        if (!expertIndex::ExpertIndex::ReadManifest(manifest, clips))
+            return 1;
+        const auto start = std::chrono::high_resolution_clock::now();
+        const poseIndex::PoseIndexConfig config;
+        const expertIndex::IndexConfig expert_config;
+        poseIndex::PoseIndex index(config);
+        for (const auto &clip: clips) {
+            FeatureMatrix features;
+            std::vector<strokeSegmenter::StrokeSegment> strokes;
+            if (!expertIndex::ExpertIndex::LoadClip(clip.bvh_path, config.target_list, expert_config.segmenter_config,
+                                                    features, strokes)) {
+                std::cout << "Cannot load the clip " << clip.bvh_path << std::endl;
+                continue;
+            }
+            index.AddClip(clip.bvh_path, features);
+        }
+        if (index.IsEmpty()) {
+            std::cout << "No pose to index" << std::endl;
+            return 1;
+        }
+        if (!index.Save(index_path)) {
+            std::cout << "Cannot write the pose index " << index_path << std::endl;
+            return 1;
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Saved " << index.GetNumEntry() << " poses to " << index_path << " in "
+                  << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+        return 0;
+    }
+
+    /// Latency (ms) below which the given fraction of the clips finished, nearest rank
+    double Percentile(const std::vector<double> &sorted_latency, double fraction) {
+        if (sorted_latency.empty())
+            return 0;
+        const size_t rank = std::min(sorted_latency.size() - 1,
+                                     static_cast<size_t>(fraction * sorted_latency.size()));
+        return sorted_latency[rank];
+    }
+}
+
+/**
+ * Headless forehand analysis of many (BVH, OpenPose csv) pairs, see BatchAnalysis::ReadManifest for the manifest.
+ * Workers default to one per core. The native classifier (--model, ExportLstm.py) keeps every core busy, without it
+ * the Python classifier is used and the predictions take turns on the GIL.
+ * With --build-expert-index the manifest lists expert clips instead, they are indexed for the viewer's expert matching.
+ * --build-pose-index indexes every frame of them for the viewer's pose search.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+    std::string manifest = argv[1], output = "batch_results.csv", expert_index_path, pose_index_path;
+    int num_worker = 0;
+    auto &session = classifierSession::ClassifierSession::Instance();
+    for (int i = 2; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--workers") == 0 && has_value) {
+            num_worker = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--output") == 0 && has_value) {
+            output = argv[++i];
+        } else if (std::strcmp(argv[i], "--build-expert-index") == 0 && has_value) {
+            expert_index_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--build-pose-index") == 0 && has_value) {
+            pose_index_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--model") == 0 && has_value) {
+            session.SetNativeModelPath(argv[++i]);
+        } else if (std::strcmp(argv[i], "--precision") == 0 && has_value) {
+            const std::string precision = argv[++i];
+            session.SetPrecision(precision == "int8" ? lstmEngine::INT8 :
+                                 (precision == "fp16" ? lstmEngine::FP16 : lstmEngine::FP32));
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (!expert_index_path.empty())
+        return BuildExpertIndex(manifest, expert_index_path, num_worker);
+    if (!pose_index_path.empty())
+        return BuildPoseIndex(manifest, pose_index_path);
+
+    std::vector<BatchInput> inputs;
+    if (!BatchAnalysis::ReadManifest(manifest, inputs))
+        return 1;
+
+    // Initialize the Python interpreter, the workers take the GIL only for the Python classifier
+    py::initialize_interpreter();
+    std::vector<ClipResult> results;
+    double wall_time;
+    {
+        py::gil_scoped_release release;
+        const auto start = std::chrono::high_resolution_clock::now();
+        results = BatchAnalysis::Run(inputs, num_worker);
+        const auto end = std::chrono::high_resolution_clock::now();
+        wall_time = std::chrono::duration<double>(end - start).count();
+    }
+
+    if (!BatchAnalysis::WriteResults(output, results)) {
+        std::cout << "Cannot open the results file " << output << std::endl;
+        py::finalize_interpreter();
+        return 1;
+    }
+
+    std::vector<double> latency;
+    for (const auto &result: results) {
+        if (result.isSuccess)
+            latency.push_back(result.timings.total);
+        else
+            std::cout << result.input.bvh_path << ": " << result.error << std::endl;
+    }
+    std::sort(latency.begin(), latency.end());
+    const auto metrics = session.GetMetrics();
+    std::cout << "Classifier: " << (session.IsNative() ? lstmEngine::PrecisionName(session.GetPrecision()) : "python")
+              << ", model load " << metrics.warm_up_time + metrics.model_load_time << " ms" << std::endl;
+    std::cout << latency.size() << " / " << results.size() << " clips in " << wall_time << " s, "
+              << results.size() / wall_time << " clips/s" << std::endl;
+    std::cout << "Latency (ms): p50 " << Percentile(latency, 0.5) << ", p95 " << Percentile(latency, 0.95)
+              << ", p99 " << Percentile(latency, 0.99) << ", max " << (latency.empty() ? 0 : latency.back())
+              << std::endl;
+    std::cout << "Results: " << output << std::endl;
+
+    py::finalize_interpreter();
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Bench.h"
+#include "AnalyzerSpec.h"
+
+using namespace bench;
+using namespace analyzerSpec;
+
+namespace {
+
+    /// Every check read on its own: one traversal of its column per check, what hardcoded identifiers do
+    float NaiveEvaluate(const AnalyzerSpec &spec, const FeatureMatrix &features) {
+        const int num_frame = features.GetNumFrame();
+        float num_pass = 0;
+        for (const auto &identifier: spec.identifiers) {
+            for (const auto &check: identifier.checks) {
+                const float *column = features.Column(features.GetSchema().FindColumn(check.feature));
+                float low = column[0], high = column[0];
+                double sum = 0;
+                for (int f = 0; f < num_frame; f++) {
+                    low = std::min(low, column[f]);
+                    high = std::max(high, column[f]);
+                    sum += column[f];
+                }
+                float value = check.aggregate == MIN ? low : check.aggregate == MAX ? high :
+                                                             check.aggregate == MEAN ? sum / num_frame : high - low;
+                num_pass += check.op == '<' ? value < check.threshold : value > check.threshold;
+            }
+        }
+        return num_pass;
+    }
+
+    /**
+     * Specs of 2 to 32 identifiers with 4 checks each over a synthetic 20-joint feature matrix, the identifiers
+     * sharing the columns of the racket arm & the trunk like stroke analyzers do. The fused plan reads each distinct
+     * column once, its time stays flat as identifiers are added; the per-check traversal grows with them.
+     */
+    BenchRegistrar analyzer_plan("analyzer/plan", [] {
+        const int num_frame = 20000, num_joint = 20;
+        std::vector<std::string> target_list;
+        std::vector<FeatureColumn> columns;
+        for (int joint = 0; joint < num_joint; joint++) {
+            const std::string name = "joint" + std::to_string(joint);
+            target_list.push_back(name);
+            for (const auto &[suffix, kind]: {std::pair<const char *, FeatureKind>{"_x", SELF_X}, {"_y", SELF_Y},
+                                              {"_z", SELF_Z}, {"_parent", PARENT}})
+                columns.push_back({name + suffix, kind, joint, -1});
+        }
+        const FeatureSchema schema(target_list, columns);
+        FeatureMatrix features(schema, num_frame);
+        for (int column = 0; column < schema.GetNumColumn(); column++) {
+            float *values = features.Column(column);
+            for (int f = 0; f < num_frame; f++)
+                values[f] = 90 * std::sin(0.01f * f + column);
+        }
+
+        // 6 joints x 4 columns shared by every analyzer size
+        const AggregateKind aggregates[] = {MIN, MAX, MEAN, RANGE};
+        const char *suffixes[] = {"_x", "_y", "_z", "_parent"};
+        for (int num_identifier: {2, 8, 32}) {
+            AnalyzerSpec spec;
+            spec.name = "synthetic";
+            for (int i = 0; i < num_identifier; i++) {
+                IdentifierSpec identifier;
+                identifier.name = "identifier" + std::to_string(i);
+                identifier.targets = {"joint" + std::to_string(i % 6)};
+                for (int c = 0; c < 4; c++) {
+                    CheckSpec check;
+                    check.feature = "joint" + std::to_string((i + c) % 6) + suffixes[(i * 3 + c) % 4];
+                    check.aggregate = aggregates[(i + c) % 4];
+                    check.op = c % 2 == 0 ? '>' : '<';
+                    check.threshold = 10.0f * c;
+                    check.suggestion = "check " + std::to_string(c);
+                    identifier.checks.push_back(check);
+                }
+                spec.identifiers.push_back(identifier);
+            }
+            AnalysisPlan plan;
+            if (!plan.Compile(spec, schema, nullptr)) {
+                std::cout << "cannot compile the synthetic spec" << std::endl;
+                return;
+            }
+
+            // Same verdicts both ways
+            const PlanResult fused = plan.Evaluate(features, FeatureMatrix(), FrameRange());
+            float fused_pass = 0;
+            for (const auto &identifier: fused.isPass)
+                fused_pass += std::count(identifier.begin(), identifier.end(), 1);
+            const float naive_pass = NaiveEvaluate(spec, features);
+
+            auto fused_ns = MeasureNs([&]() {
+                auto result = plan.Evaluate(features, FeatureMatrix(), FrameRange());
+                DoNotOptimize(result);
+            }, 50);
+            auto naive_ns = MeasureNs([&]() {
+                auto num_pass = NaiveEvaluate(spec, features);
+                DoNotOptimize(num_pass);
+            }, 50);
+            std::cout << num_identifier << " identifiers, " << num_identifier * 4 << " checks over "
+                      << plan.GetNumColumn() << " columns: fused " << fused_ns * 1e-6 << " ms, per check "
+                      << naive_ns * 1e-6 << " ms, passed " << fused_pass << " / " << naive_pass << std::endl;
+        }
+    });
+}
@@ -0,0 +1,93 @@
+#include <random>
+#include <cmath>
+
+#include "Bench.h"
+#include "AngleTool.h"
+#include "AngleKernel.h"
+
+using namespace angleTool;
+
+namespace {
+
+    void QuaternionToEulerBench() {
+        const size_t n = 1 << 20;
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> angle_dist(-M_PI, M_PI);
+        QuaternionArray q;
+        q.resize(n);
+        std::vector<float> x(n), y(n), z(n);
+        for (size_t i = 0; i < n; i++)
+            q.Set(i, rp3d::Quaternion::fromEulerAngles(angle_dist(rng), angle_dist(rng) / 2, angle_dist(rng)));
+
+        auto scalar_ns = bench::MeasureNs([&]() {
+            for (size_t i = 0; i < n; i++)
+                bench::DoNotOptimize(AngleTool::QuaternionToEulerAngles(q.Get(i)));
+        }, 5);
+        auto kernel_ns = bench::MeasureNs([&]() {
+            AngleKernel::QuaternionToEulerAngles(q.x.data(), q.y.data(), q.z.data(), q.w.data(), x.data(), y.data(),
+                                                 z.data(), n);
+            bench::DoNotOptimize(z[n - 1]);
+        }, 5);
+
+        double max_error = 0;
+        for (size_t i = 0; i < n; i++) {
+            auto ref = AngleTool::QuaternionToEulerAngles(q.Get(i));
+            max_error = std::max(max_error, (double) std::abs(std::remainder(ref.x - x[i], 2 * M_PI)));
+            max_error = std::max(max_error, (double) std::abs(ref.y - y[i]));
+            max_error = std::max(max_error, (double) std::abs(std::remainder(ref.z - z[i], 2 * M_PI)));
+        }
+
+        std::cout << "quaternion -> euler, single core" << std::endl;
+        std::cout << "scalar  " << 1e3 * n / scalar_ns << " M rotations/s" << std::endl;
+        std::cout << "kernel  " << 1e3 * n / kernel_ns << " M rotations/s, max error vs scalar " << max_error
+                  << " rad" << std::endl;
+    }
+
+    void EulerToQuaternionBench() {
+        const size_t n = 1 << 20;
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> angle_dist(-M_PI, M_PI);
+        std::vector<float> x(n), y(n), z(n);
+        QuaternionArray q;
+        q.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            x[i] = angle_dist(rng);
+            y[i] = angle_dist(rng);
+            z[i] = angle_dist(rng);
+        }
+
+        auto scalar_ns = bench::MeasureNs([&]() {
+            for (size_t i = 0; i < n; i++)
+                bench::DoNotOptimize(rp3d::Quaternion::fromEulerAngles(x[i], y[i], z[i]));
+        }, 5);
+        auto kernel_ns = bench::MeasureNs([&]() {
+            AngleKernel::EulerAnglesToQuaternion(x.data(), y.data(), z.data(), q.x.data(), q.y.data(), q.z.data(),
+                                                 q.w.data(), n);
+            bench::DoNotOptimize(q.w[n - 1]);
+        }, 5);
+
+        double max_error = 0;
+        for (size_t i = 0; i < n; i++) {
+            auto ref = rp3d::Quaternion::fromEulerAngles(x[i], y[i], z[i]);
+            max_error = std::max(max_error, (double) std::abs(ref.x - q.x[i]));
+            max_error = std::max(max_error, (double) std::abs(ref.y - q.y[i]));
+            max_error = std::max(max_error, (double) std::abs(ref.z - q.z[i]));
+            max_error = std::max(max_error, (double) std::abs(ref.w - q.w[i]));
+        }
+
+        std::cout << "euler -> quaternion, single core" << std::endl;
+        std::cout << "scalar  " << 1e3 * n / scalar_ns << " M rotations/s" << std::endl;
+        std::cout << "kernel  " << 1e3 * n / kernel_ns << " M rotations/s, max error vs scalar " << max_error
+                  << std::endl;
+
+        std::vector<float> degree(n);
+        auto degree_ns = bench::MeasureNs([&]() {
+            AngleKernel::EulerAnglesToDegree(x.data(), degree.data(), n);
+            bench::DoNotOptimize(degree[n - 1]);
+        }, 5);
+        std::cout << "radian -> degree  " << 1e3 * n / degree_ns << " M angles/s" << std::endl;
+    }
+
+    bench::BenchRegistrar quaternion_to_euler("angle_kernel/quaternion_to_euler", QuaternionToEulerBench);
+    bench::BenchRegistrar euler_to_quaternion("angle_kernel/euler_to_quaternion", EulerToQuaternionBench);
+}
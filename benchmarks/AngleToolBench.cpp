@@ -0,0 +1,83 @@
+#include <random>
+#include <cmath>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include "Bench.h"
+#include "AngleTool.h"
+
+using namespace angleTool;
+
+namespace {
+
+    /// Reference: compose the three local axis rotations with double precision axis-angle matrices
+    glm::dquat ReferenceRotateLocal(double angleX, double angleY, double angleZ, const rp3d::Quaternion &local) {
+        auto axis_x = local * AngleTool::default_axis_x;
+        auto axis_y = local * AngleTool::default_axis_y;
+        auto axis_z = local * AngleTool::default_axis_z;
+        auto rotate_x = glm::rotate(glm::dmat4(1.0), angleX, glm::dvec3(axis_x.x, axis_x.y, axis_x.z));
+        auto rotate_y = glm::rotate(glm::dmat4(1.0), angleY, glm::dvec3(axis_y.x, axis_y.y, axis_y.z));
+        auto rotate_z = glm::rotate(glm::dmat4(1.0), angleZ, glm::dvec3(axis_z.x, axis_z.y, axis_z.z));
+        return glm::normalize(glm::quat_cast(rotate_z * rotate_y * rotate_x));
+    }
+
+    /// Angle (degree) of the rotation that takes q to the reference
+    double ErrorDeg(const rp3d::Quaternion &q, const glm::dquat &ref) {
+        double dot = std::abs(q.x * ref.x + q.y * ref.y + q.z * ref.z + q.w * ref.w);
+        return 2 * std::acos(std::min(1.0, dot)) * 180 / M_PI;
+    }
+
+    void RotateLocalBench() {
+        const size_t n = 100000;
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> angle_dist(-M_PI, M_PI);
+        std::vector<float> angleX(n), angleY(n), angleZ(n);
+        QuaternionArray locals, result;
+        locals.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            angleX[i] = angle_dist(rng);
+            angleY[i] = angle_dist(rng);
+            angleZ[i] = angle_dist(rng);
+            locals.Set(i, rp3d::Quaternion::fromEulerAngles(angle_dist(rng), angle_dist(rng), angle_dist(rng)));
+        }
+
+        // ---------------- Accuracy ---------------- //
+        double euler_max = 0, euler_sum = 0, quatern_max = 0, quatern_sum = 0, batch_max = 0, batch_sum = 0;
+        AngleTool::rotate_local_quatern_batch(angleX.data(), angleY.data(), angleZ.data(), locals, result);
+        for (size_t i = 0; i < n; i++) {
+            auto ref = ReferenceRotateLocal(angleX[i], angleY[i], angleZ[i], locals.Get(i));
+            double e = ErrorDeg(AngleTool::rotate_local(angleX[i], angleY[i], angleZ[i], locals.Get(i)), ref);
+            euler_max = std::max(euler_max, e);
+            euler_sum += e;
+            e = ErrorDeg(AngleTool::rotate_local_quatern(angleX[i], angleY[i], angleZ[i], locals.Get(i)), ref);
+            quatern_max = std::max(quatern_max, e);
+            quatern_sum += e;
+            e = ErrorDeg(result.Get(i), ref);
+            batch_max = std::max(batch_max, e);
+            batch_sum += e;
+        }
+        std::cout << "error (deg)            max        mean" << std::endl;
+        std::cout << "rotate_local        " << euler_max << "  " << euler_sum / n << std::endl;
+        std::cout << "rotate_local_quatern " << quatern_max << "  " << quatern_sum / n << std::endl;
+        std::cout << "batch               " << batch_max << "  " << batch_sum / n << std::endl;
+
+        // ---------------- Speed ---------------- //
+        auto euler_ns = bench::MeasureNs([&]() {
+            for (size_t i = 0; i < n; i++)
+                bench::DoNotOptimize(AngleTool::rotate_local(angleX[i], angleY[i], angleZ[i], locals.Get(i)));
+        }, 5);
+        auto quatern_ns = bench::MeasureNs([&]() {
+            for (size_t i = 0; i < n; i++)
+                bench::DoNotOptimize(
+                        AngleTool::rotate_local_quatern(angleX[i], angleY[i], angleZ[i], locals.Get(i)));
+        }, 5);
+        auto batch_ns = bench::MeasureNs([&]() {
+            AngleTool::rotate_local_quatern_batch(angleX.data(), angleY.data(), angleZ.data(), locals, result);
+            bench::DoNotOptimize(result.w[n - 1]);
+        }, 5);
+        std::cout << "ns / rotation: rotate_local " << euler_ns / n << ", rotate_local_quatern " << quatern_ns / n
+                  << ", batch " << batch_ns / n << std::endl;
+    }
+
+    bench::BenchRegistrar registrar("angle_tool/rotate_local", RotateLocalBench);
+}
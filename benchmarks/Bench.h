@@ -0,0 +1,47 @@
+#ifndef TESTBED_BENCH_H
+#define TESTBED_BENCH_H
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+    using clock = std::chrono::high_resolution_clock;
+
+    struct BenchCase {
+        std::string name;
+        std::function<void()> run;
+    };
+
+    std::vector<BenchCase> &Registry();
+
+    /// Register a benchmark case at static initialization time
+    struct BenchRegistrar {
+        BenchRegistrar(const std::string &name, std::function<void()> run);
+    };
+
+    /**
+     * Run fn repeat times (after one warm-up call) and return the mean wall time in nanoseconds.
+     */
+    template<typename Fn>
+    double MeasureNs(Fn &&fn, int repeat) {
+        fn();
+        auto start = clock::now();
+        for (int i = 0; i < repeat; i++)
+            fn();
+        auto end = clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / repeat;
+    }
+
+    /// Keep the optimizer from discarding a benchmarked result
+    template<typename T>
+    inline void DoNotOptimize(const T &value) {
+        static const void *volatile sink;
+        sink = &value;
+    }
+}
+
+#endif //TESTBED_BENCH_H
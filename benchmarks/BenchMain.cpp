@@ -0,0 +1,29 @@
+#include <cstring>
+
+#include "Bench.h"
+
+using namespace bench;
+
+std::vector<BenchCase> &bench::Registry() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+BenchRegistrar::BenchRegistrar(const std::string &name, std::function<void()> run) {
+    Registry().push_back({name, std::move(run)});
+}
+
+/**
+ * Usage: testbed_bench [case name prefix]
+ * Without an argument every registered case is run.
+ */
+int main(int argc, char **argv) {
+    const char *filter = argc > 1 ? argv[1] : "";
+    for (const auto &bench_case: Registry()) {
+        if (bench_case.name.rfind(filter, 0) != 0)
+            continue;
+        std::cout << "==================== " << bench_case.name << " ====================" << std::endl;
+        bench_case.run();
+    }
+    return 0;
+}
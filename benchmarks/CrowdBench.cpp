@@ -0,0 +1,200 @@
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+
+#include <glm/gtc/quaternion.hpp>
+#include <nanogui/opengl.h>
+
+#include "Bench.h"
+#include "Crowd.h"
+
+using namespace bench;
+
+namespace {
+
+    const char *ClipPath() {
+        const char *path = std::getenv("TESTBED_BENCH_BVH");
+        return path != nullptr ? path : "static/front_bigman_pose_22_segment.bvh";
+    }
+
+    /// Same passes as SceneDemo::render: two shadow map passes with the depth shader & the final phong pass
+    void RenderFrame(crowd::Crowd &crowd, openglframework::Shader &depth_shader, openglframework::Shader &phong_shader,
+                     const openglframework::Matrix4 &projection, const openglframework::Matrix4 &world_to_camera) {
+        for (int pass = 0; pass < 2; pass++) {
+            depth_shader.bind();
+            depth_shader.setMatrix4x4Uniform("projectionMatrix", projection);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            crowd.render(depth_shader, world_to_camera);
+        }
+        phong_shader.bind();
+        phong_shader.setMatrix4x4Uniform("projectionMatrix", projection);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        crowd.render(phong_shader, world_to_camera);
+        glFinish();
+    }
+
+    /**
+     * The CPU half of Crowd::UpdateInstances (forward kinematics & instance matrices of every member) as a function
+     * of the number of skeletons, without OpenGL: the bound on the frame time when the GPU is not the bottleneck.
+     * crowd/frame_time adds the upload & the draw calls where a context exists.
+     * It is linear in the members, about 5 us each for the 22 bones on one core (-O3): 0.05 ms for 10, 0.5 ms for
+     * 100, 2.5 ms for 500, a sixth of a 60 Hz frame.
+     */
+    BenchRegistrar crowd_fk("crowd/fk", [] {
+        const int num_frame = 30;
+        BVH bvh(ClipPath());
+        if (!bvh.IsLoadSuccess()) {
+            std::cout << "skipped: cannot load " << ClipPath() << std::endl;
+            return;
+        }
+        auto *motion = bvh.GetMotions();
+        bvh.PushBackMotion(motion->begin(), motion->end());
+        std::vector<int> bone_joints;
+        for (const auto &bone_name: TARGET_BONE_NAMES) {
+            if (bvh.GetJoint(bone_name) == nullptr) {
+                std::cout << "skipped: no joint " << bone_name << " in " << ClipPath() << std::endl;
+                return;
+            }
+            bone_joints.push_back(bvh.GetJoint(bone_name)->index);
+        }
+        const int num_bone = bone_joints.size();
+
+        std::cout << std::setw(8) << "members" << std::setw(9) << "threads" << std::setw(10) << "fk ms"
+                  << std::setw(14) << "us / member" << std::endl;
+        for (int num_member: {1, 10, 50, 100, 200, 500}) {
+            for (size_t num_thread: {size_t(1), size_t(0)}) {
+                threadPool::ThreadPool thread_pool(num_thread);
+                std::vector<PoseBuffer> poses(num_member);
+                std::vector<glm::mat4> matrices(static_cast<size_t>(num_member) * num_bone);
+                int frame = 0;
+                const double fk_ns = MeasureNs([&]() {
+                    frame = (frame + 1) % bvh.GetNumModifiedFrame();
+                    thread_pool.ParallelFor(0, num_member, [&](size_t begin, size_t end) {
+                        for (size_t m = begin; m < end; m++) {
+                            poses[m].BuildFrame(&bvh, frame, glm::vec3(m * 10.0f, 0, 0));
+                            for (int b = 0; b < num_bone; b++) {
+                                auto q = poses[m].GetOrientation(bone_joints[b], 0);
+                                matrices[m * num_bone + b] = glm::scale(
+                                        glm::translate(glm::mat4(1.0f), poses[m].GetPosition(bone_joints[b], 0)) *
+                                        glm::mat4_cast(glm::quat(q.w, q.x, q.y, q.z)), glm::vec3(0.15f));
+                            }
+                        }
+                    });
+                    DoNotOptimize(matrices);
+                }, num_frame);
+
+                std::cout << std::setw(8) << num_member << std::setw(9)
+                          << (num_thread == 0 ? std::thread::hardware_concurrency() : num_thread)
+                          << std::fixed << std::setprecision(3) << std::setw(10) << fk_ns * 1e-6
+                          << std::setw(14) << fk_ns * 1e-3 / num_member << std::endl;
+            }
+        }
+    });
+
+    /**
+     * Frame time of the crowd mode as a function of the number of skeletons.
+     * It needs an OpenGL 3.3 context but no screen, e.g. with Mesa's software rasterizer:
+     *     LIBGL_ALWAYS_SOFTWARE=1 xvfb-run -a ./testbed_bench crowd
+     * Run it from the build directory (shaders/, meshes/ & static/ are copied there),
+     * TESTBED_BENCH_BVH selects another clip.
+     */
+    BenchRegistrar crowd_frame_time("crowd/frame_time", [] {
+        const int width = 1280, height = 720, num_frame = 30;
+
+        if (!glfwInit()) {
+            std::cout << "skipped: cannot initialize GLFW" << std::endl;
+            return;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        GLFWwindow *window = glfwCreateWindow(width, height, "testbed_bench", nullptr, nullptr);
+        if (window == nullptr) {
+            std::cout << "skipped: cannot create an OpenGL 3.3 context" << std::endl;
+            glfwTerminate();
+            return;
+        }
+        glfwMakeContextCurrent(window);
+#if defined(NANOGUI_GLAD)
+        if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+            std::cout << "skipped: cannot load OpenGL" << std::endl;
+            glfwTerminate();
+            return;
+        }
+#endif
+        std::cout << "renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+        glViewport(0, 0, width, height);
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+
+        {
+            openglframework::Shader depth_shader("shaders/depth.vert", "shaders/depth.frag");
+            openglframework::Shader phong_shader("shaders/phong.vert", "shaders/phong.frag");
+
+            // 60 degree perspective, looking at the grid from above & behind
+            const float f = 1.0f / std::tan(30.0f * 3.14159265f / 180.0f), near = 1.0f, far = 2000.0f;
+            const openglframework::Matrix4 projection(f * height / width, 0, 0, 0,
+                                                      0, f, 0, 0,
+                                                      0, 0, (far + near) / (near - far),
+                                                      2 * far * near / (near - far),
+                                                      0, 0, -1, 0);
+            const openglframework::Matrix4 world_to_camera(1, 0, 0, 0,
+                                                           0, 1, 0, -20,
+                                                           0, 0, 1, -150,
+                                                           0, 0, 0, 1);
+
+            rp3d::PhysicsCommon physics_common;
+            rp3d::PhysicsWorld *world = physics_common.createPhysicsWorld();
+
+            std::cout << std::setw(8) << "members" << std::setw(9) << "threads" << std::setw(10) << "fk ms"
+                      << std::setw(12) << "upload ms" << std::setw(12) << "render ms" << std::setw(11) << "frame ms"
+                      << std::setw(12) << "draw calls" << std::endl;
+            for (int num_member: {1, 10, 50, 100, 200, 500}) {
+                for (size_t num_thread: {size_t(1), size_t(0)}) {
+                    crowd::Crowd crowd(physics_common, world, "meshes/", num_thread);
+                    const int num_column = std::ceil(std::sqrt(num_member));
+                    for (int i = 0; i < num_member; i++)
+                        crowd.AddMember(ClipPath(), rp3d::Vector3((i % num_column - num_column * 0.5f) * 10, 0,
+                                                                  -(i / num_column) * 10.0f));
+                    if (crowd.GetNumMember() == 0) {
+                        std::cout << "skipped: cannot load " << ClipPath() << std::endl;
+                        physics_common.destroyPhysicsWorld(world);
+                        glfwTerminate();
+                        return;
+                    }
+                    crowd.ApplyBvhMotion(0);
+
+                    double fk = 0, upload = 0, render = 0, frame = 0;
+                    RenderFrame(crowd, depth_shader, phong_shader, projection, world_to_camera);
+                    for (int i = 0; i < num_frame; i++) {
+                        auto start = clock::now();
+                        crowd.NextBvhMotion();
+                        auto updated = clock::now();
+                        RenderFrame(crowd, depth_shader, phong_shader, projection, world_to_camera);
+                        auto end = clock::now();
+
+                        fk += crowd.GetLastFkTime();
+                        upload += crowd.GetLastUploadTime();
+                        render += std::chrono::duration<double, std::milli>(end - updated).count();
+                        frame += std::chrono::duration<double, std::milli>(end - start).count();
+                    }
+
+                    std::cout << std::setw(8) << num_member << std::setw(9)
+                              << (num_thread == 0 ? std::thread::hardware_concurrency() : num_thread)
+                              << std::fixed << std::setprecision(3)
+                              << std::setw(10) << fk / num_frame << std::setw(12) << upload / num_frame
+                              << std::setw(12) << render / num_frame << std::setw(11) << frame / num_frame
+                              << std::setw(12) << crowd.GetNumDrawCall() << std::endl;
+                }
+            }
+
+            physics_common.destroyPhysicsWorld(world);
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    });
+}
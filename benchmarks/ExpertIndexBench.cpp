@@ -0,0 +1,122 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "Bench.h"
+#include "ExpertIndex.h"
+
+using namespace bench;
+using namespace expertIndex;
+
+namespace {
+
+    const int num_column = 30;
+
+    /**
+     * A synthetic library: strokes of a few families (the same per-column curve shapes), each stroke with its own
+     * length, amplitude, phase jitter & noise, like a coach's recordings of the same few shots
+     */
+    struct SyntheticLibrary {
+        FeatureSchema schema;
+        std::vector<ExpertClip> clips;
+        std::vector<FeatureMatrix> features;
+        std::vector<std::vector<FrameRange>> strokes;
+        std::vector<std::vector<float>> family_frequency;
+
+        SyntheticLibrary(int num_stroke, int num_family) {
+            std::vector<FeatureColumn> columns;
+            for (int c = 0; c < num_column; c++)
+                columns.push_back({"joint" + std::to_string(c / 5) + "_" + std::to_string(c % 5), SELF_X, c / 5, -1});
+            schema = FeatureSchema({}, columns);
+
+            std::mt19937 rng(42);
+            std::uniform_real_distribution<float> frequency(0.5f, 3.0f);
+            family_frequency.resize(num_family);
+            for (auto &frequencies: family_frequency)
+                for (int c = 0; c < num_column; c++)
+                    frequencies.push_back(frequency(rng));
+
+            for (int s = 0; s < num_stroke; s++) {
+                clips.push_back({"expert_" + std::to_string(s) + ".bvh", ""});
+                features.push_back(Stroke(s % num_family, rng));
+                strokes.emplace_back();
+            }
+        }
+
+        FeatureMatrix Stroke(int family, std::mt19937 &rng) const {
+            std::uniform_int_distribution<int> length(60, 150);
+            std::uniform_real_distribution<float> jitter(-0.3f, 0.3f), amplitude(20, 60);
+            std::normal_distribution<float> noise(0, 2);
+            FeatureMatrix stroke(schema, length(rng));
+            for (int c = 0; c < num_column; c++) {
+                const float phase = jitter(rng), scale = amplitude(rng);
+                float *column = stroke.Column(c);
+                for (int f = 0; f < stroke.GetNumFrame(); f++) {
+                    const float t = static_cast<float>(f) / stroke.GetNumFrame();
+                    column[f] = scale * std::sin(2 * static_cast<float>(M_PI) * family_frequency[family][c] * t +
+                                                 phase) + noise(rng);
+                }
+            }
+            return stroke;
+        }
+    };
+
+    /**
+     * k-NN of student strokes in a library of expert strokes: the pruned search against full DTW on every entry,
+     * same neighbours expected. Then the index saved & mapped back.
+     */
+    BenchRegistrar expert_search("expert/search", [] {
+        const int num_stroke = 500, num_family = 25, num_query = 20, k = 3;
+        SyntheticLibrary library(num_stroke, num_family);
+        ExpertIndex index;
+        index.Build(library.clips, library.features, library.strokes);
+
+        std::mt19937 rng(7);
+        std::vector<std::vector<float>> queries;
+        for (int q = 0; q < num_query; q++) {
+            queries.emplace_back(index.GetEmbeddingSize());
+            index.Embed(library.Stroke(q % num_family, rng), FrameRange(), queries.back().data());
+        }
+
+        int mismatch = 0;
+        long num_dtw = 0;
+        for (const auto &query: queries) {
+            SearchStats stats;
+            const auto matches = index.Search(query.data(), k, &stats);
+            const auto reference = index.SearchExhaustive(query.data(), k);
+            num_dtw += stats.num_dtw;
+            for (int i = 0; i < k; i++)
+                mismatch += matches[i].entry != reference[i].entry;
+        }
+        std::cout << num_stroke << " strokes x " << index.GetEmbeddingSize() << " floats, " << num_query
+                  << " queries, k = " << k << ": " << static_cast<double>(num_dtw) / num_query
+                  << " DTW per query, " << mismatch << " neighbours differ from the exhaustive search" << std::endl;
+
+        size_t next_query = 0;
+        auto pruned_ns = MeasureNs([&]() {
+            DoNotOptimize(index.Search(queries[next_query++ % num_query].data(), k));
+        }, num_query);
+        auto exhaustive_ns = MeasureNs([&]() {
+            DoNotOptimize(index.SearchExhaustive(queries[next_query++ % num_query].data(), k));
+        }, 5);
+        std::cout << "LB_Keogh pruned      " << pruned_ns * 1e-6 << " ms" << std::endl;
+        std::cout << "exhaustive DTW       " << exhaustive_ns * 1e-6 << " ms" << std::endl;
+
+        const std::string filename = "expert_bench.idx";
+        index.Save(filename);
+        ExpertIndex mapped;
+        auto load_ns = MeasureNs([&]() {
+            mapped.Load(filename);
+            DoNotOptimize(mapped);
+        }, 10);
+        int loaded_mismatch = 0;
+        for (const auto &query: queries) {
+            const auto matches = index.Search(query.data(), k), loaded = mapped.Search(query.data(), k);
+            for (int i = 0; i < k; i++)
+                loaded_mismatch += matches[i].entry != loaded[i].entry || matches[i].distance != loaded[i].distance;
+        }
+        std::cout << "mmap load            " << load_ns * 1e-3 << " us, " << loaded_mismatch
+                  << " neighbours differ once loaded" << std::endl;
+        std::remove(filename.c_str());
+    });
+}
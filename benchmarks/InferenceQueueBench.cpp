@@ -0,0 +1,134 @@
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <random>
+#include <thread>
+
+#include "Bench.h"
+#include "InferenceQueue.h"
+#include "LstmEngine.h"
+
+using namespace bench;
+using namespace inferenceQueue;
+using namespace lstmEngine;
+
+namespace {
+
+    /// The forehand classifier's shape, as in LstmBench
+    LstmModel MakeModel(int num_input, int hidden_size) {
+        std::mt19937 rng(3);
+        const auto random_matrix = [&rng](size_t size, float scale) {
+            std::uniform_real_distribution<float> dist(-scale, scale);
+            std::vector<float> matrix(size);
+            for (auto &value: matrix)
+                value = dist(rng);
+            return matrix;
+        };
+
+        std::vector<LstmLayer> lstm_layers;
+        for (int input_size: {num_input, hidden_size}) {
+            const float scale = 1.0f / std::sqrt(static_cast<float>(hidden_size));
+            lstm_layers.push_back({input_size, hidden_size,
+                                   random_matrix(4 * hidden_size * input_size, scale),
+                                   random_matrix(4 * hidden_size * hidden_size, scale),
+                                   random_matrix(4 * hidden_size, scale)});
+        }
+        std::vector<DenseLayer> dense_layers;
+        dense_layers.push_back({hidden_size, 64, RELU, random_matrix(64 * hidden_size, 0.2f),
+                                random_matrix(64, 0.2f)});
+        dense_layers.push_back({64, 6, SIGMOID, random_matrix(6 * 64, 0.2f), random_matrix(6, 0.2f)});
+        return LstmModel(InputSpec(), lstm_layers, dense_layers);
+    }
+
+    std::vector<float> RandomSequence(int num_frame, int num_input, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> dist;
+        std::vector<float> sequence(static_cast<size_t>(num_frame) * num_input);
+        for (auto &value: sequence)
+            value = dist(rng);
+        return sequence;
+    }
+
+    void PrintStats(const char *label, int num_clip, double elapsed_ms, const QueueStats &stats) {
+        std::cout << label << num_clip / (elapsed_ms * 1e-3) << " clips/s, batch " << stats.GetMeanBatch()
+                  << ", wait mean " << stats.GetMeanWait() << " ms max " << stats.max_wait << " ms, padding "
+                  << stats.GetPaddingRatio() * 100 << " %" << std::endl;
+    }
+
+    /**
+     * Clips of 60 to 240 frames through the queue against one Predict each:
+     * a burst (every clip submitted before any is awaited, a batch run or the strokes of a session) for several
+     * max_batch, the added latency of a lone request, and 8 callers that each wait for their clip before the next
+     * (the batch workers), whose batches can't exceed 8.
+     */
+    BenchRegistrar lstm_queue("lstm/queue", [] {
+        const int num_input = 110, hidden_size = 128, num_clip = 256;
+        const LstmModel model = MakeModel(num_input, hidden_size);
+        const BatchForward forward = [&model](const std::vector<const float *> &inputs,
+                                              const std::vector<int> &num_frames) {
+            return model.PredictBatch(inputs, num_frames);
+        };
+
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> length(60, 240);
+        std::vector<std::vector<float>> clips;
+        std::vector<int> num_frames;
+        for (int c = 0; c < num_clip; c++) {
+            num_frames.push_back(length(rng));
+            clips.push_back(RandomSequence(num_frames.back(), num_input, c));
+        }
+
+        const auto start = clock::now();
+        for (int c = 0; c < num_clip; c++)
+            DoNotOptimize(model.Predict(clips[c].data(), num_frames[c]));
+        const double direct_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        std::cout << "direct        " << num_clip / (direct_ms * 1e-3) << " clips/s" << std::endl;
+
+        for (int max_batch: {1, 4, 16, 64}) {
+            QueueConfig config;
+            config.max_batch = max_batch;
+            config.num_worker = 1;
+            InferenceQueue queue(forward, config);
+            const auto burst_start = clock::now();
+            std::vector<std::future<std::vector<float>>> outputs;
+            for (int c = 0; c < num_clip; c++)
+                outputs.push_back(queue.Submit(clips[c], num_frames[c]));
+            for (auto &output: outputs)
+                DoNotOptimize(output.get());
+            const double elapsed_ms = std::chrono::duration<double, std::milli>(clock::now() - burst_start).count();
+            const std::string label = "burst max " + std::to_string(max_batch) + std::string(4 - std::to_string(
+                    max_batch).size(), ' ');
+            PrintStats(label.c_str(), num_clip, elapsed_ms, queue.GetStats());
+        }
+
+        // Alone, a request waits max_wait for company
+        {
+            InferenceQueue queue(forward);
+            const double direct_ns = MeasureNs([&]() {
+                DoNotOptimize(model.Predict(clips[0].data(), num_frames[0]));
+            }, 20);
+            const double queued_ns = MeasureNs([&]() {
+                DoNotOptimize(queue.Submit(clips[0], num_frames[0]).get());
+            }, 20);
+            std::cout << "lone request  " << direct_ns * 1e-6 << " ms direct, " << queued_ns * 1e-6
+                      << " ms queued (max_wait " << queue.GetConfig().max_wait << " ms)" << std::endl;
+        }
+
+        {
+            const int num_caller = 8;
+            InferenceQueue queue(forward);
+            const auto callers_start = clock::now();
+            std::vector<std::thread> callers;
+            for (int t = 0; t < num_caller; t++) {
+                callers.emplace_back([&, t]() {
+                    for (int c = t; c < num_clip; c += num_caller)
+                        DoNotOptimize(queue.Submit(clips[c], num_frames[c]).get());
+                });
+            }
+            for (auto &caller: callers)
+                caller.join();
+            const double elapsed_ms = std::chrono::duration<double, std::milli>(clock::now() - callers_start).count();
+            PrintStats("8 callers     ", num_clip, elapsed_ms, queue.GetStats());
+        }
+    });
+}
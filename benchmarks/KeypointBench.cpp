@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+#include "Bench.h"
+#include "KeypointKernel.h"
+#include "Similarity.h"
+
+using namespace bench;
+using namespace keypointKernel;
+
+namespace {
+
+    const char *keypoint_names[] = {"nose", "neck", "rshoulder", "relbow", "rwrist", "lshoulder", "lelbow", "lwrist",
+                                    "midhip", "rhip", "rknee", "rankle", "lhip", "lknee", "lankle", "reye", "leye",
+                                    "rear", "lear", "lbigtoe", "lsmalltoe", "lheel", "rbigtoe", "rsmalltoe", "rheel"};
+
+    /// An OpenPose export: frame index, then x, y & confidence of the 25 BODY_25 keypoints, some keypoints missing
+    std::string WriteOpenPoseCsv(int num_frame) {
+        const std::string filename = "keypoint_bench.csv";
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> position(0, 1920), confidence(0, 1), missing(0, 1);
+        std::ofstream file(filename);
+        file << "frame";
+        for (const char *name: keypoint_names)
+            file << ",2DX_" << name << ",2DY_" << name << ",2DC_" << name;
+        file << "\n";
+        char cell[32];
+        for (int f = 0; f < num_frame; f++) {
+            file << f;
+            for (size_t k = 0; k < std::size(keypoint_names); k++) {
+                if (missing(rng) < 0.02f) {
+                    file << ",,,";
+                    continue;
+                }
+                for (float value: {position(rng), position(rng), confidence(rng)}) {
+                    std::snprintf(cell, sizeof(cell), ",%.3f", value);
+                    file << cell;
+                }
+            }
+            file << "\n";
+        }
+        return filename;
+    }
+
+    /// The previous loader: getline, strtof on every cell, row-major then transposed. The reference
+    void ReferenceLoad(const std::string &filename, std::vector<std::string> &column_names, int &num_frame,
+                       std::vector<float> &data) {
+        std::ifstream input_file(filename);
+        std::string line, cell;
+        column_names.clear();
+        std::getline(input_file, line);
+        std::stringstream header(line);
+        while (std::getline(header, cell, ','))
+            column_names.push_back(cell);
+
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        std::vector<float> rows;
+        num_frame = 0;
+        while (std::getline(input_file, line)) {
+            if (line.empty())
+                continue;
+            size_t row_begin = rows.size();
+            rows.resize(row_begin + column_names.size(), nan);
+            const char *cursor = line.c_str();
+            for (size_t c = 0; c < column_names.size() && *cursor != '\0'; c++) {
+                char *parsed_end;
+                float value = std::strtof(cursor, &parsed_end);
+                if (parsed_end != cursor && (*parsed_end == ',' || *parsed_end == '\0'))
+                    rows[row_begin + c] = value;
+                while (*cursor != ',' && *cursor != '\0')
+                    cursor++;
+                if (*cursor == ',')
+                    cursor++;
+            }
+            num_frame++;
+        }
+        const size_t num_column = column_names.size();
+        data.resize(num_column * num_frame);
+        for (int f = 0; f < num_frame; f++)
+            for (size_t c = 0; c < num_column; c++)
+                data[c * num_frame + f] = rows[f * num_column + c];
+    }
+
+    BenchRegistrar openpose_load("openpose/load", [] {
+        const int num_frame = 10000;
+        const std::string filename = WriteOpenPoseCsv(num_frame);
+
+        std::vector<std::string> reference_names;
+        std::vector<float> reference_data;
+        int reference_frames;
+        ReferenceLoad(filename, reference_names, reference_frames, reference_data);
+        OpenPoseData openpose;
+        openpose.Load(filename);
+
+        // Same cells, NaN where the reference has NaN
+        int mismatch = 0;
+        for (size_t i = 0; i < reference_data.size() && reference_data.size() == openpose.GetData().size(); i++) {
+            const float expected = reference_data[i], value = openpose.GetData()[i];
+            mismatch += !(expected == value || (std::isnan(expected) && std::isnan(value)));
+        }
+        std::cout << num_frame << " frames x " << openpose.GetNumColumn() << " columns, "
+                  << (openpose.GetColumnNames() == reference_names && openpose.GetNumFrame() == reference_frames ?
+                      "same shape" : "SHAPE MISMATCH")
+                  << ", " << mismatch << " cells differ from strtof" << std::endl;
+
+        auto reference_ns = MeasureNs([&]() {
+            ReferenceLoad(filename, reference_names, reference_frames, reference_data);
+            DoNotOptimize(reference_data);
+        }, 3);
+        auto load_ns = MeasureNs([&]() {
+            openpose.Load(filename);
+            DoNotOptimize(openpose);
+        }, 10);
+        const std::vector<std::string> shoulders = {"2DX_rshoulder", "2DX_lshoulder"};
+        auto select_ns = MeasureNs([&]() {
+            openpose.Load(filename, shoulders);
+            DoNotOptimize(openpose);
+        }, 10);
+        std::cout << "getline + strtof    " << reference_ns * 1e-6 << " ms" << std::endl;
+        std::cout << "mmap, all columns   " << load_ns * 1e-6 << " ms" << std::endl;
+        std::cout << "mmap, 2 columns     " << select_ns * 1e-6 << " ms" << std::endl;
+        std::remove(filename.c_str());
+    });
+
+    BenchRegistrar keypoint_features("openpose/features", [] {
+        const int num_frame = 10000;
+        const std::string filename = WriteOpenPoseCsv(num_frame);
+        OpenPoseData openpose;
+        openpose.Load(filename);
+        std::remove(filename.c_str());
+
+        const float *sx, *sy, *ex, *ey, *wx, *wy;
+        openpose.GetKeypoint("rshoulder", sx, sy);
+        openpose.GetKeypoint("relbow", ex, ey);
+        openpose.GetKeypoint("rwrist", wx, wy);
+        std::vector<float> out(num_frame);
+
+        // Elbow angle against double precision acos
+        KeypointKernel::Angle(sx, sy, ex, ey, wx, wy, out.data(), num_frame);
+        double max_error = 0;
+        for (int i = 0; i < num_frame; i++) {
+            const double ux = sx[i] - ex[i], uy = sy[i] - ey[i], vx = wx[i] - ex[i], vy = wy[i] - ey[i];
+            const double norm = std::sqrt((ux * ux + uy * uy) * (vx * vx + vy * vy));
+            if (std::isnan(norm) || norm == 0)
+                continue;
+            const double expected = std::acos(std::clamp((ux * vx + uy * vy) / norm, -1.0, 1.0)) * 180 / M_PI;
+            max_error = std::max(max_error, std::abs(expected - out[i]));
+        }
+        std::cout << "angle: max error " << max_error << " degree" << std::endl;
+
+        auto distance_ns = MeasureNs([&]() {
+            KeypointKernel::Distance(sx, sy, wx, wy, out.data(), num_frame);
+            DoNotOptimize(out);
+        }, 100);
+        auto angle_ns = MeasureNs([&]() {
+            KeypointKernel::Angle(sx, sy, ex, ey, wx, wy, out.data(), num_frame);
+            DoNotOptimize(out);
+        }, 100);
+        auto waist_ns = MeasureNs([&]() {
+            auto rotation = KeypointKernel::WaistRotation(openpose);
+            DoNotOptimize(similarity::Similarity::Resample(rotation, 1, 2 * num_frame));
+        }, 100);
+        std::cout << "distance            " << distance_ns * 1e-3 << " us" << std::endl;
+        std::cout << "angle               " << angle_ns * 1e-3 << " us" << std::endl;
+        std::cout << "waist + resample    " << waist_ns * 1e-3 << " us" << std::endl;
+    });
+}
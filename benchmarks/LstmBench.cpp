@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+#include "Bench.h"
+#include "LstmEngine.h"
+#include "LiveClassifier.h"
+#include "BoneNames.h"
+
+using namespace bench;
+using namespace lstmEngine;
+
+namespace {
+
+    /// Same shape as the forehand classifier: 2 LSTM layers, a hidden dense layer and 6 sigmoid outputs
+    LstmModel MakeModel(int num_input, int hidden_size, const InputSpec &input_spec = InputSpec()) {
+        std::mt19937 rng(3);
+        const auto random_matrix = [&rng](size_t size, float scale) {
+            std::uniform_real_distribution<float> dist(-scale, scale);
+            std::vector<float> matrix(size);
+            for (auto &value: matrix)
+                value = dist(rng);
+            return matrix;
+        };
+
+        std::vector<LstmLayer> lstm_layers;
+        for (int input_size: {num_input, hidden_size}) {
+            const float scale = 1.0f / std::sqrt(static_cast<float>(hidden_size));
+            lstm_layers.push_back({input_size, hidden_size,
+                                   random_matrix(4 * hidden_size * input_size, scale),
+                                   random_matrix(4 * hidden_size * hidden_size, scale),
+                                   random_matrix(4 * hidden_size, scale)});
+        }
+        std::vector<DenseLayer> dense_layers;
+        dense_layers.push_back({hidden_size, 64, RELU, random_matrix(64 * hidden_size, 0.2f),
+                                random_matrix(64, 0.2f)});
+        dense_layers.push_back({64, 6, SIGMOID, random_matrix(6 * 64, 0.2f), random_matrix(6, 0.2f)});
+        return LstmModel(input_spec, lstm_layers, dense_layers);
+    }
+
+    double Sigmoid(double x) {
+        return 1 / (1 + std::exp(-x));
+    }
+
+    /// Straightforward double precision forward pass (torch.nn.LSTM equations), the parity reference
+    std::vector<double> ReferencePredict(const LstmModel &model, const float *input, int num_frame) {
+        std::vector<double> x(input, input + static_cast<size_t>(num_frame) * model.GetNumInput());
+        int input_size = model.GetNumInput();
+        for (const auto &layer: model.GetLstmLayers()) {
+            const int hidden_size = layer.hidden_size;
+            std::vector<double> h(hidden_size, 0), c(hidden_size, 0), output;
+            for (int t = 0; t < num_frame; t++) {
+                std::vector<double> gates(4 * hidden_size);
+                for (int r = 0; r < 4 * hidden_size; r++) {
+                    double sum = layer.bias[r];
+                    for (int k = 0; k < input_size; k++)
+                        sum += layer.weight_ih[r * input_size + k] * x[t * input_size + k];
+                    for (int k = 0; k < hidden_size; k++)
+                        sum += layer.weight_hh[r * hidden_size + k] * h[k];
+                    gates[r] = sum;
+                }
+                for (int j = 0; j < hidden_size; j++) {
+                    c[j] = Sigmoid(gates[hidden_size + j]) * c[j] +
+                           Sigmoid(gates[j]) * std::tanh(gates[2 * hidden_size + j]);
+                    h[j] = Sigmoid(gates[3 * hidden_size + j]) * std::tanh(c[j]);
+                }
+                output.insert(output.end(), h.begin(), h.end());
+            }
+            x = output;
+            input_size = hidden_size;
+        }
+
+        std::vector<double> y(x.end() - input_size, x.end());
+        for (const auto &layer: model.GetDenseLayers()) {
+            std::vector<double> next(layer.output_size);
+            for (int r = 0; r < layer.output_size; r++) {
+                double sum = layer.bias[r];
+                for (int k = 0; k < layer.input_size; k++)
+                    sum += layer.weight[r * layer.input_size + k] * y[k];
+                next[r] = layer.activation == RELU ? std::max(sum, 0.0) :
+                          layer.activation == SIGMOID ? Sigmoid(sum) : sum;
+            }
+            y = next;
+        }
+        return y;
+    }
+
+    std::vector<float> RandomSequence(int num_frame, int num_input, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> dist;
+        std::vector<float> sequence(static_cast<size_t>(num_frame) * num_input);
+        for (auto &value: sequence)
+            value = dist(rng);
+        return sequence;
+    }
+
+    /**
+     * With an exported model, TESTBED_BENCH_LSTM=model.bin TESTBED_BENCH_LSTM_REFERENCE=reference.bin
+     * (ExportLstm.py --reference) compares the engine with PyTorch's output
+     */
+    void PyTorchParity() {
+        const char *model_path = std::getenv("TESTBED_BENCH_LSTM");
+        const char *reference_path = std::getenv("TESTBED_BENCH_LSTM_REFERENCE");
+        if (model_path == nullptr || reference_path == nullptr) {
+            std::cout << "pytorch parity skipped: TESTBED_BENCH_LSTM / TESTBED_BENCH_LSTM_REFERENCE not set"
+                      << std::endl;
+            return;
+        }
+
+        LstmModel model;
+        std::ifstream file(reference_path, std::ios::binary);
+        uint32_t num_frame, num_input, num_output;
+        if (!model.Load(model_path) || !file.read(reinterpret_cast<char *>(&num_frame), 4) ||
+            !file.read(reinterpret_cast<char *>(&num_input), 4) || static_cast<int>(num_input) != model.GetNumInput()) {
+            std::cout << "pytorch parity skipped: cannot read the model or the reference" << std::endl;
+            return;
+        }
+        std::vector<float> sequence(static_cast<size_t>(num_frame) * num_input);
+        file.read(reinterpret_cast<char *>(sequence.data()), sequence.size() * sizeof(float));
+        file.read(reinterpret_cast<char *>(&num_output), 4);
+        std::vector<float> expected(num_output);
+        file.read(reinterpret_cast<char *>(expected.data()), expected.size() * sizeof(float));
+
+        auto output = model.Predict(sequence.data(), num_frame);
+        double max_error = 0;
+        for (size_t i = 0; i < std::min(output.size(), expected.size()); i++)
+            max_error = std::max(max_error, (double) std::abs(output[i] - expected[i]));
+        std::cout << "pytorch parity: " << output.size() << " outputs, max error " << max_error << std::endl;
+    }
+
+    BenchRegistrar lstm_inference("lstm/inference", [] {
+        const int num_input = 110, hidden_size = 128, num_frame = 120;
+        const LstmModel model = MakeModel(num_input, hidden_size);
+
+        // Parity with the reference on a few clips of different lengths, batched together
+        std::vector<std::vector<float>> clips;
+        std::vector<const float *> inputs;
+        std::vector<int> num_frames;
+        for (int b = 0; b < 4; b++) {
+            num_frames.push_back(num_frame - 17 * b);
+            clips.push_back(RandomSequence(num_frames.back(), num_input, b));
+            inputs.push_back(clips.back().data());
+        }
+        auto batch_output = model.PredictBatch(inputs, num_frames);
+        double max_error = 0;
+        for (int b = 0; b < 4; b++) {
+            auto reference = ReferencePredict(model, inputs[b], num_frames[b]);
+            for (int i = 0; i < model.GetNumOutput(); i++)
+                max_error = std::max(max_error, std::abs(reference[i] - batch_output[b * model.GetNumOutput() + i]));
+        }
+        std::cout << "parity vs double reference (batch of 4, ragged lengths): max error " << max_error << std::endl;
+        PyTorchParity();
+
+        std::cout << num_input << " inputs, 2 x " << hidden_size << " LSTM, " << num_frame << " frames" << std::endl;
+        const auto clip = RandomSequence(num_frame, num_input, 7);
+        auto reference_ns = MeasureNs([&]() {
+            DoNotOptimize(ReferencePredict(model, clip.data(), num_frame));
+        }, 3);
+        auto latency_ns = MeasureNs([&]() {
+            DoNotOptimize(model.Predict(clip.data(), num_frame));
+        }, 20);
+        std::cout << "reference  " << reference_ns * 1e-6 << " ms / clip" << std::endl;
+        std::cout << "engine     " << latency_ns * 1e-6 << " ms / clip (latency)" << std::endl;
+
+        for (int batch: {8, 32, 128}) {
+            std::vector<const float *> batch_inputs(batch, clip.data());
+            std::vector<int> batch_frames(batch, num_frame);
+            auto batch_ns = MeasureNs([&]() {
+                DoNotOptimize(model.PredictBatch(batch_inputs, batch_frames));
+            }, 5);
+            std::cout << "batch " << batch << "   " << batch / (batch_ns * 1e-9) << " clips/s" << std::endl;
+        }
+    });
+
+    /**
+     * Input sequences of the clips of a manifest (bvh_path,openpose_path per line, relative to the manifest, like
+     * testbed_batch's), built the way BatchAnalysis builds them for the model
+     */
+    std::vector<std::vector<float>> LoadManifestClips(const std::string &filename, const LstmModel &model,
+                                                      std::vector<int> &num_frames) {
+        std::vector<std::vector<float>> clips;
+        std::ifstream file(filename);
+        const auto slash = filename.find_last_of("/\\");
+        const std::string directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+        std::string line;
+        while (std::getline(file, line)) {
+            const auto comma = line.find(',');
+            if (line.empty() || line[0] == '#' || comma == std::string::npos)
+                continue;
+            const std::string bvh_path = line.substr(0, comma), openpose_path = line.substr(comma + 1);
+            BVH bvh((bvh_path[0] == '/' ? bvh_path : directory + bvh_path).c_str());
+            OpenPoseData openpose;
+            if (!bvh.IsLoadSuccess() ||
+                !openpose.Load(openpose_path[0] == '/' ? openpose_path : directory + openpose_path))
+                continue;
+            auto *motion = bvh.GetMotions();
+            bvh.PushBackMotion(motion->begin(), motion->end());
+            PoseBuffer pose;
+            pose.Build(&bvh, glm::vec3(0.0f));
+            const FeatureSchema schema(&bvh, skeleton::TARGET_BONE_NAMES, skeleton::TARGET_BONE_NAMES);
+            std::vector<float> input;
+            int num_frame;
+            if (!model.BuildInput(FeatureExtractor::Extract(schema, &bvh, pose), openpose, input, num_frame) ||
+                num_frame <= 0)
+                continue;
+            clips.push_back(std::move(input));
+            num_frames.push_back(num_frame);
+        }
+        return clips;
+    }
+
+    /**
+     * Each weight precision against FP32 on the same clips: output delta, decisions (p > 0.5) that change, packed
+     * weight size and batch throughput. INT8 is measured before & after Calibrate on other clips.
+     * The exported classifier is used if TESTBED_BENCH_LSTM is set, and the clips of the manifest
+     * TESTBED_BENCH_LSTM_CLIPS with it (every other clip calibrates): without labels, the accuracy of a precision
+     * is how many of FP32's decisions it keeps.
+     */
+    BenchRegistrar lstm_precision("lstm/precision", [] {
+        const int num_frame = 120, num_clip = 64, batch = 32;
+        LstmModel model = MakeModel(110, 128);
+        const char *model_path = std::getenv("TESTBED_BENCH_LSTM");
+        const bool isExported = model_path != nullptr && model.Load(model_path);
+        if (isExported)
+            std::cout << "model " << model_path << std::endl;
+
+        std::vector<std::vector<float>> clips, calibration_clips;
+        std::vector<int> num_frames, calibration_frames;
+        const char *manifest_path = std::getenv("TESTBED_BENCH_LSTM_CLIPS");
+        if (isExported && manifest_path != nullptr) {
+            std::vector<int> manifest_frames;
+            auto manifest_clips = LoadManifestClips(manifest_path, model, manifest_frames);
+            for (size_t c = 0; c < manifest_clips.size(); c++) {
+                (c % 2 == 0 ? clips : calibration_clips).push_back(std::move(manifest_clips[c]));
+                (c % 2 == 0 ? num_frames : calibration_frames).push_back(manifest_frames[c]);
+            }
+            std::cout << clips.size() + calibration_clips.size() << " clips of " << manifest_path << std::endl;
+        }
+        if (clips.empty() || calibration_clips.empty()) {
+            clips.clear();
+            num_frames.clear();
+            calibration_clips.clear();
+            calibration_frames.clear();
+            for (int b = 0; b < 2 * num_clip; b++) {
+                (b < num_clip ? clips : calibration_clips).push_back(
+                        RandomSequence(num_frame, model.GetNumInput(), 100 + b));
+                (b < num_clip ? num_frames : calibration_frames).push_back(num_frame);
+            }
+            std::cout << "random clips" << std::endl;
+        }
+        const auto pointers = [](const std::vector<std::vector<float>> &sequences) {
+            std::vector<const float *> result;
+            for (const auto &sequence: sequences)
+                result.push_back(sequence.data());
+            return result;
+        };
+        const auto inputs = pointers(clips), calibration_inputs = pointers(calibration_clips);
+        const auto expected = model.PredictBatch(inputs, num_frames);
+
+        const auto report = [&](const std::string &label) {
+            const auto output = model.PredictBatch(inputs, num_frames);
+            double max_delta = 0;
+            int kept = 0;
+            for (size_t i = 0; i < output.size(); i++) {
+                max_delta = std::max(max_delta, (double) std::abs(output[i] - expected[i]));
+                kept += (output[i] > 0.5f) == (expected[i] > 0.5f);
+            }
+
+            const int batch_size = std::min<int>(batch, inputs.size());
+            const std::vector<const float *> batch_inputs(inputs.begin(), inputs.begin() + batch_size);
+            const std::vector<int> batch_frames(num_frames.begin(), num_frames.begin() + batch_size);
+            auto batch_ns = MeasureNs([&]() {
+                DoNotOptimize(model.PredictBatch(batch_inputs, batch_frames));
+            }, 5);
+            std::cout << label << "weights " << model.GetWeightBytes() / 1024.0 << " KiB, max delta " << max_delta
+                      << ", decisions kept " << kept << " / " << output.size() << ", "
+                      << batch_size / (batch_ns * 1e-9) << " clips/s" << std::endl;
+        };
+        for (Precision precision: {FP32, FP16, INT8}) {
+            model.SetPrecision(precision);
+            report(std::string(PrecisionName(precision)) + "            ");
+        }
+        model.Calibrate(calibration_inputs, calibration_frames);
+        report("int8 calibrated ");
+    });
+
+    /// p-th quantile of the latencies (ms)
+    double Percentile(std::vector<double> latencies, double p) {
+        auto nth = latencies.begin() + static_cast<size_t>(p * (latencies.size() - 1));
+        std::nth_element(latencies.begin(), nth, latencies.end());
+        return *nth;
+    }
+
+    /**
+     * Live classification during playback: one LSTM step per frame from the carried state against re-running the
+     * last window from scratch every frame, then LiveClassifier over a clip (features of the frame included).
+     * The clip is TESTBED_BENCH_BVH or the default expert, run from the build directory.
+     */
+    BenchRegistrar lstm_streaming("lstm/streaming", [] {
+        const int num_input = 110, hidden_size = 128, num_frame = 600, window = 120;
+        const LstmModel model = MakeModel(num_input, hidden_size);
+        const auto clip = RandomSequence(num_frame, num_input, 11);
+
+        // Fed in uneven pieces, the stream must end where the whole clip does
+        LstmState state;
+        model.ResetState(state);
+        for (int t = 0, piece = 1; t < window; t += piece, piece = piece % 7 + 1)
+            model.Advance(clip.data() + static_cast<size_t>(t) * num_input, std::min(piece, window - t), state);
+        const auto streamed = model.Output(state), expected = model.Predict(clip.data(), window);
+        double max_error = 0;
+        for (size_t i = 0; i < expected.size(); i++)
+            max_error = std::max(max_error, (double) std::abs(streamed[i] - expected[i]));
+        std::cout << "streamed vs whole clip (" << window << " frames): max error " << max_error << std::endl;
+
+        // Per frame: one step + the dense layers, or the last window again
+        std::vector<double> step_latencies, window_latencies;
+        model.ResetState(state);
+        for (int t = 0; t < num_frame; t++) {
+            const float *frame = clip.data() + static_cast<size_t>(t) * num_input;
+            auto start = clock::now();
+            model.Advance(frame, 1, state);
+            DoNotOptimize(model.Output(state));
+            step_latencies.push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+
+            const int begin = std::max(0, t + 1 - window);
+            start = clock::now();
+            DoNotOptimize(model.Predict(clip.data() + static_cast<size_t>(begin) * num_input, t + 1 - begin));
+            window_latencies.push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+        }
+        std::cout << "incremental step     p50 " << Percentile(step_latencies, 0.5) << " ms, p99 "
+                  << Percentile(step_latencies, 0.99) << " ms" << std::endl;
+        std::cout << window << "-frame recompute  p50 " << Percentile(window_latencies, 0.5) << " ms, p99 "
+                  << Percentile(window_latencies, 0.99) << " ms" << std::endl;
+
+        const char *bvh_path = std::getenv("TESTBED_BENCH_BVH");
+        BVH bvh(bvh_path != nullptr ? bvh_path : "static/front_bigman_pose_22_segment.bvh");
+        if (!bvh.IsLoadSuccess() || bvh.GetNumModifiedFrame() == 0) {
+            std::cout << "live classifier skipped: cannot load the clip" << std::endl;
+            return;
+        }
+        // A model that reads every angle feature of the body, the classifier's size
+        const FeatureSchema schema(&bvh, skeleton::TARGET_BONE_NAMES, skeleton::TARGET_BONE_NAMES);
+        InputSpec input_spec;
+        for (const auto &column: schema.GetColumns())
+            input_spec.column_names.push_back(column.name);
+        input_spec.mean.assign(input_spec.column_names.size(), 0.0f);
+        input_spec.std.assign(input_spec.column_names.size(), 30.0f);
+        liveClassifier::LiveClassifier live(liveClassifier::LiveConfig(),
+                                            MakeModel(static_cast<int>(input_spec.column_names.size()), hidden_size,
+                                                      input_spec));
+        if (!live.Start(&bvh))
+            return;
+        // Three loops of playback
+        int num_output = 0;
+        for (int f = 0; f < 3 * bvh.GetNumModifiedFrame(); f++)
+            num_output += live.Step(f % bvh.GetNumModifiedFrame());
+        const auto stats = live.GetLatencyStats();
+        std::cout << "live classifier (" << input_spec.column_names.size() << " features, "
+                  << bvh.GetNumModifiedFrame() << " frames x 3): " << num_output << " classifications, p50 "
+                  << stats.p50 << " ms, p99 " << stats.p99 << " ms, " << stats.num_over_budget << " over budget"
+                  << std::endl;
+        live.Stop();
+    });
+}
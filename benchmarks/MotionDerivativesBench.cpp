@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include "Bench.h"
+#include "BoneNames.h"
+#include "MotionDerivatives.h"
+
+using namespace bench;
+using namespace motionDerivatives;
+
+namespace {
+
+    /**
+     * The kernels on signals with known derivatives (a cubic trajectory, a steady spin stored with flipping
+     * quaternion signs), their throughput on long series, then the derivatives of a real clip against the forward
+     * kinematics that produce their input. The clip is TESTBED_BENCH_BVH or the default expert, run from the build
+     * directory.
+     */
+    BenchRegistrar motion_derivatives("motion/derivatives", [] {
+        const int num_frame = 100000;
+        const float frame_time = 1.0f / 60;
+
+        // x = t^3: the central differences of velocity are exact up to the stencil (3 t^2 + dt^2)
+        std::vector<float> position(num_frame), velocity(num_frame);
+        for (int t = 0; t < num_frame; t++)
+            position[t] = std::pow(t * frame_time, 3.0f) * 1e-3f;
+        MotionDerivatives::Gradient(position.data(), 200, frame_time, velocity.data());
+        double velocity_error = 0;
+        for (int t = 1; t < 199; t++) {
+            const double time = t * frame_time;
+            velocity_error = std::max(velocity_error, std::abs(velocity[t] - 1e-3 * (3 * time * time +
+                                                                                  frame_time * frame_time)));
+        }
+        std::cout << "gradient of a cubic  max error " << velocity_error << std::endl;
+
+        // 90 degree / s about (0, 0.6, 0.8), every other quaternion negated
+        std::vector<float> qx(num_frame), qy(num_frame), qz(num_frame), qw(num_frame);
+        for (int t = 0; t < num_frame; t++) {
+            const float half_angle = 0.5f * (M_PI / 2) * t * frame_time, sign = t % 2 == 0 ? 1.0f : -1.0f;
+            qx[t] = 0;
+            qy[t] = sign * 0.6f * std::sin(half_angle);
+            qz[t] = sign * 0.8f * std::sin(half_angle);
+            qw[t] = sign * std::cos(half_angle);
+        }
+        std::vector<float> wx(num_frame), wy(num_frame), wz(num_frame);
+        MotionDerivatives::AngularVelocity(qx.data(), qy.data(), qz.data(), qw.data(), 2000, frame_time,
+                                           wx.data(), wy.data(), wz.data());
+        double angular_error = 0;
+        for (int t = 0; t < 2000; t++)
+            angular_error = std::max({angular_error, (double) std::abs(wx[t]), std::abs(wy[t] - 54.0),
+                                      std::abs(wz[t] - 72.0)});
+        std::cout << "steady spin          max error " << angular_error << " degree / s" << std::endl;
+
+        auto gradient_ns = MeasureNs([&]() {
+            MotionDerivatives::Gradient(position.data(), num_frame, frame_time, velocity.data());
+            DoNotOptimize(velocity);
+        }, 50);
+        auto angular_ns = MeasureNs([&]() {
+            MotionDerivatives::AngularVelocity(qx.data(), qy.data(), qz.data(), qw.data(), num_frame, frame_time,
+                                               wx.data(), wy.data(), wz.data());
+            DoNotOptimize(wx);
+        }, 50);
+        std::cout << "gradient             " << gradient_ns / num_frame << " ns / frame" << std::endl;
+        std::cout << "angular velocity     " << angular_ns / num_frame << " ns / frame" << std::endl;
+
+        const char *bvh_path = std::getenv("TESTBED_BENCH_BVH");
+        BVH bvh(bvh_path != nullptr ? bvh_path : "static/front_bigman_pose_22_segment.bvh");
+        if (!bvh.IsLoadSuccess()) {
+            std::cout << "clip skipped: cannot load the clip" << std::endl;
+            return;
+        }
+        if (bvh.GetNumModifiedFrame() == 0) {
+            auto *motion = bvh.GetMotions();
+            bvh.PushBackMotion(motion->begin(), motion->end());
+        }
+        PoseBuffer pose;
+        auto kinematics_ns = MeasureNs([&]() {
+            pose.Build(&bvh, glm::vec3(0.0f));
+        }, 5);
+        DerivativeBuffer derivatives;
+        auto single_ns = MeasureNs([&]() {
+            derivatives.Build(pose, bvh.GetInterval(), {}, 1);
+        }, 20);
+        auto parallel_ns = MeasureNs([&]() {
+            derivatives.Build(pose, bvh.GetInterval());
+        }, 20);
+        std::vector<float> speed(pose.GetNumFrame());
+        derivatives.GetMagnitude(VELOCITY, bvh.GetJoint("rHand")->index, speed.data());
+        std::cout << pose.GetNumJoint() << " joints x " << pose.GetNumFrame() << " frames, peak hand speed "
+                  << *std::max_element(speed.begin(), speed.end()) << " units / s" << std::endl;
+        std::cout << "forward kinematics   " << kinematics_ns * 1e-6 << " ms" << std::endl;
+        std::cout << "derivatives 1 thread " << single_ns * 1e-6 << " ms" << std::endl;
+        std::cout << "derivatives auto     " << parallel_ns * 1e-6 << " ms" << std::endl;
+    });
+}
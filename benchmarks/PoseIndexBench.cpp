@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "Bench.h"
+#include "PoseIndex.h"
+
+using namespace bench;
+using namespace poseIndex;
+
+namespace {
+
+    /**
+     * Clips of synthetic motion: 40 angle columns driven by a 4-dimensional latent pose that drifts smoothly, like
+     * the few degrees of freedom a stroke really moves. Column c is 90 sin(w_c . latent + phase_c) degrees.
+     */
+    class SyntheticMotion {
+    private:
+        static const int num_latent = 4;
+        FeatureSchema schema;
+        std::vector<std::array<float, num_latent>> weights;
+        std::vector<float> phases;
+        std::mt19937 generator{7};
+
+    public:
+        explicit SyntheticMotion(int num_column) {
+            std::vector<std::string> target_list;
+            std::vector<FeatureColumn> columns;
+            std::normal_distribution<float> normal(0.0f, 1.0f);
+            std::uniform_real_distribution<float> uniform(0.0f, 6.2831853f);
+            for (int c = 0; c < num_column; c++) {
+                target_list.push_back("joint" + std::to_string(c));
+                columns.push_back({target_list.back() + "_x", SELF_X, c, -1});
+                weights.push_back({normal(generator), normal(generator), normal(generator), normal(generator)});
+                phases.push_back(uniform(generator));
+            }
+            schema = FeatureSchema(target_list, columns);
+        }
+
+        FeatureMatrix Clip(int num_frame) {
+            FeatureMatrix features(schema, num_frame);
+            std::normal_distribution<float> step(0.0f, 0.02f);
+            std::uniform_real_distribution<float> start(-3.0f, 3.0f);
+            std::array<float, num_latent> latent{}, velocity{};
+            for (auto &value: latent)
+                value = start(generator);
+            for (int f = 0; f < num_frame; f++) {
+                for (int i = 0; i < num_latent; i++) {
+                    velocity[i] = 0.95f * velocity[i] + step(generator);
+                    latent[i] += velocity[i];
+                }
+                for (int c = 0; c < schema.GetNumColumn(); c++) {
+                    float angle = phases[c];
+                    for (int i = 0; i < num_latent; i++)
+                        angle += weights[c][i] * latent[i];
+                    features.Column(c)[f] = 90 * std::sin(angle);
+                }
+            }
+            return features;
+        }
+    };
+
+    double Percentile(std::vector<double> values, double fraction) {
+        std::sort(values.begin(), values.end());
+        return values[std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()))];
+    }
+
+    /**
+     * Insertion rate, query latency & recall@10 against the exhaustive search for several ef_search, the occurrence
+     * search of indexed poses (FindSimilarPoses) at the default ef_search, then the same queries on the saved & mapped
+     * index, and a clip added to it. TESTBED_BENCH_POSES sets the number of poses (200000 by default, about an
+     * hour per million poses on one core).
+     */
+    BenchRegistrar pose_index("pose/index", [] {
+        const char *num_pose_text = std::getenv("TESTBED_BENCH_POSES");
+        const int num_pose = num_pose_text != nullptr ? std::max(std::atoi(num_pose_text), 2000) : 200000;
+        const int clip_frames = 2000, k = 10, num_query = 200;
+
+        SyntheticMotion motion(40);
+        PoseIndex index;
+        double insert_ns = 0;
+        for (int added = 0; added < num_pose; added += clip_frames) {
+            const FeatureMatrix clip = motion.Clip(clip_frames);
+            const auto start = std::chrono::high_resolution_clock::now();
+            index.AddClip("clip" + std::to_string(added / clip_frames), clip);
+            insert_ns += std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start)
+                    .count();
+        }
+        std::cout << index.GetNumEntry() << " poses of " << index.GetDimension() << " floats, " << index.GetMaxLevel()
+                  << " levels, " << insert_ns / index.GetNumEntry() * 1e-3 << " us / insertion" << std::endl;
+
+        // Poses of a clip that was not indexed
+        const FeatureMatrix query_clip = motion.Clip(num_query * 10);
+        std::vector<std::vector<float>> queries(num_query, std::vector<float>(index.GetDimension()));
+        std::vector<std::vector<PoseMatch>> truth(num_query);
+        std::vector<double> exhaustive_ns;
+        for (int q = 0; q < num_query; q++) {
+            index.Embed(query_clip, q * 10, queries[q].data());
+            const auto start = std::chrono::high_resolution_clock::now();
+            truth[q] = index.SearchExhaustive(queries[q].data(), k);
+            exhaustive_ns.push_back(std::chrono::duration<double, std::nano>(
+                    std::chrono::high_resolution_clock::now() - start).count());
+        }
+        std::cout << "exhaustive           " << Percentile(exhaustive_ns, 0.5) * 1e-6 << " ms / query" << std::endl;
+
+        const int default_ef = PoseIndexConfig().ef_search;
+        const auto run = [&](const PoseIndex &searched, int ef, const char *label) {
+            std::vector<double> latency;
+            int num_found = 0, num_distance = 0;
+            for (int q = 0; q < num_query; q++) {
+                PoseSearchStats stats;
+                const auto start = std::chrono::high_resolution_clock::now();
+                const auto matches = searched.Search(queries[q].data(), k, ef, &stats);
+                latency.push_back(std::chrono::duration<double, std::nano>(
+                        std::chrono::high_resolution_clock::now() - start).count());
+                num_distance += stats.num_distance;
+                for (const auto &match: matches) {
+                    num_found += std::any_of(truth[q].begin(), truth[q].end(), [&](const PoseMatch &exact) {
+                        return exact.entry == match.entry;
+                    });
+                }
+            }
+            std::cout << label << " ef " << ef << ": recall@" << k << " "
+                      << static_cast<double>(num_found) / (num_query * k) << ", p50 "
+                      << Percentile(latency, 0.5) * 1e-3 << " us, p99 " << Percentile(latency, 0.99) * 1e-3
+                      << " us, " << num_distance / num_query << " distances" << std::endl;
+        };
+        for (int ef: {64, 128, 160, 256})
+            run(index, ef, "hnsw  ");
+
+        // Other occurrences of indexed poses, a window of a tenth of a clip around the pose & each match
+        {
+            const int window = clip_frames / 20;
+            std::mt19937 generator(11);
+            std::uniform_int_distribution<int> pick(0, index.GetNumEntry() - 1);
+            std::vector<double> latency;
+            int num_found = 0, num_match = 0, num_distance = 0;
+            for (int q = 0; q < num_query; q++) {
+                const int entry = pick(generator);
+                const auto exact = index.SearchExhaustive(entry, k, window);
+                PoseSearchStats stats;
+                const auto start = std::chrono::high_resolution_clock::now();
+                const auto matches = index.Search(entry, k, window, 0, &stats);
+                latency.push_back(std::chrono::duration<double, std::nano>(
+                        std::chrono::high_resolution_clock::now() - start).count());
+                num_distance += stats.num_distance;
+                num_match += exact.size();
+                for (const auto &match: matches) {
+                    num_found += std::any_of(exact.begin(), exact.end(), [&](const PoseMatch &other) {
+                        return other.entry == match.entry;
+                    });
+                }
+            }
+            std::cout << "occurrences ef " << default_ef << ", window " << window << ": recall@" << k << " "
+                      << static_cast<double>(num_found) / num_match << ", p50 " << Percentile(latency, 0.5) * 1e-3
+                      << " us, p99 " << Percentile(latency, 0.99) * 1e-3 << " us, " << num_distance / num_query
+                      << " distances" << std::endl;
+        }
+
+        const std::string path = "pose_index_bench.idx";
+        if (!index.Save(path)) {
+            std::cout << "save skipped: cannot write " << path << std::endl;
+            return;
+        }
+        PoseIndex loaded;
+        auto load_ns = MeasureNs([&]() {
+            loaded.Load(path);
+        }, 3);
+        std::cout << "load (mapped)        " << load_ns * 1e-6 << " ms" << std::endl;
+        run(loaded, default_ef, "mapped");
+
+        // An insertion copies the mapped index into memory first
+        const FeatureMatrix new_clip = motion.Clip(clip_frames);
+        const int clip = loaded.AddClip("new clip", new_clip);
+        std::vector<float> pose(loaded.GetDimension());
+        loaded.Embed(new_clip, clip_frames / 2, pose.data());
+        const auto matches = loaded.Search(pose.data(), 1);
+        std::cout << "added clip found itself: " << (clip >= 0 && !matches.empty() && matches[0].distance == 0)
+                  << std::endl;
+        std::remove(path.c_str());
+    });
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "Bench.h"
+#include "SignalFilter.h"
+
+using namespace bench;
+using namespace signalFilter;
+
+namespace {
+
+    /// A MocapNET-like clip: slow joint motion plus jitter, the first channels hip positions, the rest angles
+    std::vector<double> MakeNoisyClip(int num_frame, int num_channel, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<double> phase_dist(0, 2 * M_PI), freq_dist(0.3, 2);
+        std::normal_distribution<double> jitter(0, 3);
+        std::vector<double> clip(static_cast<size_t>(num_frame) * num_channel);
+        for (int c = 0; c < num_channel; c++) {
+            const double phase = phase_dist(rng), freq = freq_dist(rng);
+            for (int t = 0; t < num_frame; t++)
+                clip[static_cast<size_t>(t) * num_channel + c] =
+                        90 * std::sin(2 * M_PI * freq * t / 30 + phase) + jitter(rng);
+        }
+        return clip;
+    }
+
+    MotionClip MakeMotionClip(std::vector<double> &motion, int num_channel) {
+        MotionClip clip;
+        clip.motion = motion.data();
+        clip.num_channel = num_channel;
+        clip.num_frame = static_cast<int>(motion.size() / num_channel);
+        for (int c = 3; c < num_channel; c++)
+            clip.rotation_channels.push_back(c);
+        return clip;
+    }
+
+    /// Amplitude left of a sine of the given frequency (Hz, 30 fps) in the middle of the filtered clip
+    double Gain(const FilterConfig &config, double frequency) {
+        const int num_frame = 600;
+        std::vector<double> motion(num_frame);
+        for (int t = 0; t < num_frame; t++)
+            motion[t] = std::sin(2 * M_PI * frequency * t / 30);
+        MotionClip clip;
+        clip.motion = motion.data();
+        clip.num_frame = num_frame;
+        clip.num_channel = 1;
+        SignalFilter::Filter(clip, config);
+        double amplitude = 0;
+        for (int t = num_frame / 4; t < 3 * num_frame / 4; t++)
+            amplitude = std::max(amplitude, std::abs(motion[t]));
+        return amplitude;
+    }
+
+    /// Largest distance between two angles (degree), modulo 360
+    double AngleError(double a, double b) {
+        return std::abs(std::remainder(a - b, 360.0));
+    }
+
+    /**
+     * The three filters checked on known signals (the pass & stop bands of Butterworth, Savitzky-Golay keeping
+     * a cubic, an angle wrapping at +-180 not turned into a spin, the whole-clip One-Euro equal to the streaming
+     * one), then their throughput in channel-samples per second on one clip and on many clips across threads.
+     */
+    BenchRegistrar signal_filters("signal/filters", [] {
+        FilterConfig butterworth;
+        std::cout << "butterworth gain     1 Hz " << Gain(butterworth, 1) << ", 12 Hz " << Gain(butterworth, 12)
+                  << std::endl;
+
+        FilterConfig savgol;
+        savgol.kind = SAVITZKY_GOLAY;
+        {
+            const int num_frame = 100;
+            std::vector<double> cubic(num_frame), motion(num_frame);
+            for (int t = 0; t < num_frame; t++)
+                cubic[t] = motion[t] = 1e-4 * (t - 50) * (t - 50) * (t - 20) + 0.5 * t;
+            MotionClip clip;
+            clip.motion = motion.data();
+            clip.num_frame = num_frame;
+            clip.num_channel = 1;
+            SignalFilter::Filter(clip, savgol);
+            double error = 0;
+            for (int t = 0; t < num_frame; t++)
+                error = std::max(error, std::abs(motion[t] - cubic[t]));
+            std::cout << "savitzky-golay       cubic kept to " << error << std::endl;
+        }
+
+        // A steady spin of 4 degrees per frame, stored in [-180, 180): every filter should follow it
+        for (FilterKind kind: {BUTTERWORTH, SAVITZKY_GOLAY, ONE_EURO}) {
+            const int num_frame = 300;
+            std::vector<double> motion(num_frame);
+            for (int t = 0; t < num_frame; t++)
+                motion[t] = std::remainder(4.0 * t, 360.0);
+            MotionClip clip;
+            clip.motion = motion.data();
+            clip.num_frame = num_frame;
+            clip.num_channel = 1;
+            clip.rotation_channels = {0};
+            FilterConfig config;
+            config.kind = kind;
+            // Past the One-Euro's warm-up, it lags a ramp
+            SignalFilter::Filter(clip, config);
+            double error = 0;
+            for (int t = 30; t < num_frame - 30; t++)
+                error = std::max(error, AngleError(motion[t], 4.0 * t));
+            std::cout << FilterName(kind) << " over a wrapping angle: " << error << " degree off" << std::endl;
+        }
+
+        const int num_frame = 10000, num_channel = 66;
+        const auto source = MakeNoisyClip(num_frame, num_channel, 3);
+        {
+            FilterConfig one_euro;
+            one_euro.kind = ONE_EURO;
+            auto whole = source, streamed = source;
+            SignalFilter::Filter(MakeMotionClip(whole, num_channel), one_euro);
+            StreamingFilter stream(one_euro, num_channel, 1.0 / 30, MakeMotionClip(streamed, num_channel).rotation_channels);
+            for (int t = 0; t < num_frame; t++)
+                stream.Push(streamed.data() + static_cast<size_t>(t) * num_channel);
+            double error = 0;
+            for (size_t i = 0; i < whole.size(); i++)
+                error = std::max(error, std::abs(whole[i] - streamed[i]));
+            std::cout << "one-euro             streaming vs whole clip max error " << error << std::endl;
+        }
+
+        std::cout << num_frame << " frames x " << num_channel << " channels" << std::endl;
+        for (FilterKind kind: {BUTTERWORTH, SAVITZKY_GOLAY, ONE_EURO}) {
+            FilterConfig config;
+            config.kind = kind;
+            std::vector<double> motion;
+            auto ns = MeasureNs([&]() {
+                motion = source;
+                SignalFilter::Filter(MakeMotionClip(motion, num_channel), config);
+                DoNotOptimize(motion);
+            }, 10);
+            std::cout << FilterName(kind) << ": " << ns * 1e-6 << " ms, "
+                      << static_cast<double>(num_frame) * num_channel / (ns * 1e-9) * 1e-6 << " M channel-samples/s"
+                      << std::endl;
+        }
+
+        const int num_clip = 64, clip_frames = 3000;
+        std::vector<std::vector<double>> sources;
+        for (int i = 0; i < num_clip; i++)
+            sources.push_back(MakeNoisyClip(clip_frames, num_channel, 100 + i));
+        std::cout << num_clip << " clips x " << clip_frames << " frames, butterworth" << std::endl;
+        for (int num_worker: {1, 0}) {
+            std::vector<std::vector<double>> motions;
+            auto ns = MeasureNs([&]() {
+                motions = sources;
+                std::vector<MotionClip> clips;
+                for (auto &motion: motions)
+                    clips.push_back(MakeMotionClip(motion, num_channel));
+                SignalFilter::FilterAll(clips, butterworth, num_worker);
+                DoNotOptimize(motions);
+            }, 5);
+            std::cout << (num_worker == 1 ? "1 thread             " : "all cores            ") << ns * 1e-6 << " ms, "
+                      << static_cast<double>(num_clip) * clip_frames * num_channel / (ns * 1e-9) * 1e-6
+                      << " M channel-samples/s" << std::endl;
+        }
+    });
+}
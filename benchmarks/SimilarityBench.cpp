@@ -0,0 +1,470 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <random>
+#include <sstream>
+
+#include "Bench.h"
+#include "Similarity.h"
+
+using namespace bench;
+using namespace similarity;
+
+namespace {
+
+    /// 22 angle-like channels, time-major: a few slow sines per channel plus noise
+    std::vector<float> MakeClip(int num_frame, int num_channel, unsigned seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> phase_dist(0, 2 * M_PI), freq_dist(1, 4);
+        std::normal_distribution<float> noise(0, 2);
+        std::vector<float> clip(static_cast<size_t>(num_frame) * num_channel);
+        for (int c = 0; c < num_channel; c++) {
+            const float phase = phase_dist(rng), freq = freq_dist(rng);
+            for (int t = 0; t < num_frame; t++)
+                clip[static_cast<size_t>(t) * num_channel + c] =
+                        60 * std::sin(freq * 2 * M_PI * t / num_frame + phase) + noise(rng);
+        }
+        return clip;
+    }
+
+    /**
+     * The full-matrix double precision algorithms of tslearn (_njit_dtw / _njit_lcss_accumulated_matrix with
+     * sakoe_chiba_mask), the reference for the results and the baseline for the speed.
+     */
+    bool InBand(int i, int j, int n1, int n2, int radius) {
+        if (radius < 0)
+            return true;
+        if (n1 > n2)
+            return i >= std::max(0, j - radius) && i <= std::min(n1, j + n1 - n2 + radius);
+        return j >= std::max(0, i - radius) && j <= std::min(n2, i + n2 - n1 + radius);
+    }
+
+    double SquaredDistance(const float *a, const float *b, int num_channel) {
+        double sum = 0;
+        for (int c = 0; c < num_channel; c++)
+            sum += (static_cast<double>(a[c]) - b[c]) * (static_cast<double>(a[c]) - b[c]);
+        return sum;
+    }
+
+    double ReferenceDtw(const float *s1, int n1, const float *s2, int n2, int d, int radius) {
+        std::vector<double> cum(static_cast<size_t>(n1 + 1) * (n2 + 1), std::numeric_limits<double>::infinity());
+        const auto at = [n2](int i, int j) { return static_cast<size_t>(i) * (n2 + 1) + j; };
+        cum[0] = 0;
+        for (int i = 0; i < n1; i++)
+            for (int j = 0; j < n2; j++)
+                if (InBand(i, j, n1, n2, radius))
+                    cum[at(i + 1, j + 1)] = SquaredDistance(s1 + i * d, s2 + j * d, d) +
+                                            std::min({cum[at(i, j + 1)], cum[at(i + 1, j)], cum[at(i, j)]});
+        return std::sqrt(cum[at(n1, n2)]);
+    }
+
+    double ReferenceLcss(const float *s1, int n1, const float *s2, int n2, int d, double eps, int radius) {
+        std::vector<int> acc(static_cast<size_t>(n1 + 1) * (n2 + 1), 0);
+        const auto at = [n2](int i, int j) { return static_cast<size_t>(i) * (n2 + 1) + j; };
+        for (int i = 1; i <= n1; i++)
+            for (int j = 1; j <= n2; j++)
+                if (InBand(i - 1, j - 1, n1, n2, radius)) {
+                    if (std::sqrt(SquaredDistance(s1 + (i - 1) * d, s2 + (j - 1) * d, d)) <= eps)
+                        acc[at(i, j)] = acc[at(i - 1, j - 1)] + 1;
+                    else
+                        acc[at(i, j)] = std::max(acc[at(i, j - 1)], acc[at(i - 1, j)]);
+                }
+        return static_cast<double>(acc[at(n1, n2)]) / std::min(n1, n2);
+    }
+
+    /**
+     * DtwPath's band (a radius around the diagonal of the n1 x n2 matrix) over the full matrix in double precision,
+     * with the same preference between equal steps (diagonal, up, left): the reference path of DtwPath & FastDtwPath
+     */
+    double ReferenceDtwPath(const float *s1, int n1, const float *s2, int n2, int d, int radius,
+                            std::vector<std::pair<int, int>> &path) {
+        const double inf = std::numeric_limits<double>::infinity();
+        const double slope = n1 > 1 ? static_cast<double>(n2 - 1) / (n1 - 1) : 0.0;
+        radius = n1 == 1 ? std::max(radius, n2 - 1) : std::max(radius, static_cast<int>(std::ceil(slope)));
+        std::vector<double> cum(static_cast<size_t>(n1) * n2, inf);
+        const auto at = [n2](int i, int j) { return static_cast<size_t>(i) * n2 + j; };
+        for (int i = 0; i < n1; i++) {
+            const int center = static_cast<int>(std::lround(i * slope));
+            for (int j = std::max(center - radius, 0); j < std::min(center + radius + 1, n2); j++) {
+                double best = i == 0 && j == 0 ? 0 : inf;
+                if (i > 0 && j > 0)
+                    best = std::min(best, cum[at(i - 1, j - 1)]);
+                if (i > 0)
+                    best = std::min(best, cum[at(i - 1, j)]);
+                if (j > 0)
+                    best = std::min(best, cum[at(i, j - 1)]);
+                cum[at(i, j)] = SquaredDistance(s1 + i * d, s2 + j * d, d) + best;
+            }
+        }
+        path.assign(1, {n1 - 1, n2 - 1});
+        for (int i = n1 - 1, j = n2 - 1; i > 0 || j > 0;) {
+            const double diagonal = i > 0 && j > 0 ? cum[at(i - 1, j - 1)] : inf;
+            const double up = i > 0 ? cum[at(i - 1, j)] : inf;
+            const double left = j > 0 ? cum[at(i, j - 1)] : inf;
+            if (diagonal <= up && diagonal <= left) {
+                i--;
+                j--;
+            } else if (up <= left) {
+                i--;
+            } else {
+                j--;
+            }
+            path.emplace_back(i, j);
+        }
+        std::reverse(path.begin(), path.end());
+        return std::sqrt(cum[at(n1 - 1, n2 - 1)]);
+    }
+
+    /// Analysize.BvhAnalyze on a whole clip: every one of the 22 columns resampled, z-normalized, then LCSS
+    BenchRegistrar similarity_lcss("similarity/lcss", [] {
+        const int num_channel = 22, n1 = 240, n2 = 300;
+        const auto target = MakeClip(n1, num_channel, 1), expert = MakeClip(n2, num_channel, 2);
+        std::vector<float> column1(n1), column2(n2), r1(n2), r2(n2);
+
+        double reference_ns = 0, native_ns = 0, max_error = 0;
+        for (int c = 0; c < num_channel; c++) {
+            for (int t = 0; t < n1; t++)
+                column1[t] = target[t * num_channel + c];
+            for (int t = 0; t < n2; t++)
+                column2[t] = expert[t * num_channel + c];
+            Similarity::Resample(column1.data(), n1, 1, r1.data(), n2);
+            Similarity::Resample(column2.data(), n2, 1, r2.data(), n2);
+            Similarity::ZNormalize(r1.data(), n2, 1);
+            Similarity::ZNormalize(r2.data(), n2, 1);
+
+            double reference = 0;
+            float native = 0;
+            reference_ns += MeasureNs([&]() {
+                reference = ReferenceLcss(r1.data(), n2, r2.data(), n2, 1, 0.5, Similarity::no_constraint);
+            }, 5);
+            native_ns += MeasureNs([&]() {
+                native = Similarity::ResampledLcss(column1.data(), n1, column2.data(), n2, 0.5f);
+            }, 20);
+            max_error = std::max(max_error, std::abs(reference - native));
+        }
+
+        std::cout << "lcss of " << num_channel << " columns, " << n1 << " vs " << n2 << " frames" << std::endl;
+        std::cout << "reference  " << reference_ns * 1e-6 << " ms (lcss only)" << std::endl;
+        std::cout << "native     " << native_ns * 1e-6 << " ms (resample + z-norm + lcss), max error "
+                  << max_error << std::endl;
+
+        // All 22 channels as one multichannel series, with & without a band
+        for (int radius: {Similarity::no_constraint, 30}) {
+            double reference = 0;
+            float native = 0;
+            auto ref_ns = MeasureNs([&]() {
+                reference = ReferenceLcss(target.data(), n1, expert.data(), n2, num_channel, 20, radius);
+            }, 3);
+            auto nat_ns = MeasureNs([&]() {
+                native = Similarity::Lcss(target.data(), n1, expert.data(), n2, num_channel, 20, radius);
+            }, 10);
+            std::cout << num_channel << "-channel lcss, radius " << radius << ": reference " << ref_ns * 1e-6
+                      << " ms, native " << nat_ns * 1e-6 << " ms, error " << std::abs(reference - native)
+                      << std::endl;
+        }
+    });
+
+    BenchRegistrar similarity_dtw("similarity/dtw", [] {
+        const int num_channel = 22, n1 = 240, n2 = 300;
+        const auto target = MakeClip(n1, num_channel, 1), expert = MakeClip(n2, num_channel, 2);
+
+        std::cout << num_channel << "-channel dtw, " << n1 << " vs " << n2 << " frames" << std::endl;
+        for (int radius: {Similarity::no_constraint, 30, 10}) {
+            double reference = 0;
+            float native = 0;
+            auto ref_ns = MeasureNs([&]() {
+                reference = ReferenceDtw(target.data(), n1, expert.data(), n2, num_channel, radius);
+            }, 3);
+            auto nat_ns = MeasureNs([&]() {
+                native = Similarity::Dtw(target.data(), n1, expert.data(), n2, num_channel, radius);
+            }, 10);
+            std::cout << "radius " << radius << ": reference " << ref_ns * 1e-6 << " ms, native "
+                      << nat_ns * 1e-6 << " ms, relative error " << std::abs(reference - native) / reference
+                      << std::endl;
+        }
+    });
+
+    /// A series of the tslearn fixture, time-major
+    struct FixtureSeries {
+        int num_frame = 0;
+        int num_channel = 0;
+        std::vector<float> values;
+
+        std::vector<float> Channel(int channel) const {
+            std::vector<float> column(num_frame);
+            for (int t = 0; t < num_frame; t++)
+                column[t] = values[static_cast<size_t>(t) * num_channel + channel];
+            return column;
+        }
+    };
+
+    /**
+     * Parity with tslearn & speedup over the Python path: the series & the results recorded by
+     * Py_package/PyAnalysizer/RecordSimilarityFixtures.py (resampled_lcss as BvhAnalyze does it on one column, lcss &
+     * dtw on all channels), recomputed natively. The Python time is the one recorded with the fixture.
+     * TESTBED_BENCH_SIMILARITY_FIXTURE replaces the checked-in benchmarks/fixtures/similarity_tslearn.txt.
+     */
+    BenchRegistrar similarity_tslearn("similarity/tslearn", [] {
+        const char *fixture_path = std::getenv("TESTBED_BENCH_SIMILARITY_FIXTURE");
+#ifdef TESTBED_BENCH_FIXTURES
+        const std::string path = fixture_path != nullptr ? fixture_path
+                                                         : TESTBED_BENCH_FIXTURES "/similarity_tslearn.txt";
+#else
+        const std::string path = fixture_path != nullptr ? fixture_path : "benchmarks/fixtures/similarity_tslearn.txt";
+#endif
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cout << "skipped: cannot open " << path << std::endl;
+            return;
+        }
+
+        struct KindStats {
+            int num_case = 0;
+            int num_mismatch = 0;
+            double max_error = 0;
+            double python_ms = 0;
+            double native_ms = 0;
+        };
+        std::map<std::string, FixtureSeries> series;
+        std::map<std::string, KindStats> kinds;
+        std::string line, recorded_with;
+        while (std::getline(file, line)) {
+            std::istringstream fields(line);
+            std::string kind;
+            fields >> kind;
+            if (kind == "tslearn") {
+                fields >> recorded_with;
+            } else if (kind == "series") {
+                std::string name;
+                FixtureSeries read;
+                fields >> name >> read.num_frame >> read.num_channel;
+                read.values.resize(static_cast<size_t>(read.num_frame) * read.num_channel);
+                for (auto &value: read.values)
+                    file >> value;
+                file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                series[name] = std::move(read);
+            } else if (kind == "resampled_lcss" || kind == "lcss" || kind == "dtw") {
+                std::string name1, name2;
+                int channel, radius;
+                double eps, expected, python_ms;
+                fields >> name1 >> name2 >> channel >> eps >> radius >> expected >> python_ms;
+                const auto &s1 = series.at(name1), &s2 = series.at(name2);
+                float native = 0;
+                double native_ns;
+                if (kind == "resampled_lcss") {
+                    const auto column1 = s1.Channel(channel), column2 = s2.Channel(channel);
+                    native_ns = MeasureNs([&]() {
+                        native = Similarity::ResampledLcss(column1.data(), s1.num_frame, column2.data(), s2.num_frame,
+                                                           static_cast<float>(eps));
+                    }, 20);
+                } else if (kind == "lcss") {
+                    native_ns = MeasureNs([&]() {
+                        native = Similarity::Lcss(s1.values.data(), s1.num_frame, s2.values.data(), s2.num_frame,
+                                                  s1.num_channel, static_cast<float>(eps), radius);
+                    }, 10);
+                } else {
+                    native_ns = MeasureNs([&]() {
+                        native = Similarity::Dtw(s1.values.data(), s1.num_frame, s2.values.data(), s2.num_frame,
+                                                 s1.num_channel, radius);
+                    }, 10);
+                }
+                // LCSS counts matches, it may only differ by a frame matched at exactly eps; DTW is a float sum
+                const double error = kind == "dtw" ? std::abs(native - expected) / expected
+                                                   : std::abs(native - expected);
+                auto &stats = kinds[kind];
+                stats.num_case++;
+                stats.num_mismatch += error > (kind == "dtw" ? 1e-5 : 1e-6);
+                stats.max_error = std::max(stats.max_error, error);
+                stats.python_ms += python_ms;
+                stats.native_ms += native_ns * 1e-6;
+            }
+        }
+
+        std::cout << "against tslearn " << recorded_with << " (" << path << ")" << std::endl;
+        for (const auto &[kind, stats]: kinds) {
+            std::cout << kind << ": " << stats.num_case << " cases, " << stats.num_mismatch << " mismatches, max "
+                      << (kind == "dtw" ? "relative " : "") << "error " << stats.max_error << ", python "
+                      << stats.python_ms << " ms, native " << stats.native_ms << " ms, speedup "
+                      << stats.python_ms / stats.native_ms << "x" << std::endl;
+        }
+    });
+
+    /**
+     * The user's clip played with a time warp & resampled to n2 frames: expert frame j plays user time
+     * warp(j / (n2 - 1)) * (n1 - 1), kept in true_user_frame
+     */
+    template<typename Warp>
+    std::vector<float> WarpClip(const std::vector<float> &user, int n1, int n2, int num_channel, Warp warp,
+                                std::vector<double> &true_user_frame) {
+        std::vector<float> expert(static_cast<size_t>(n2) * num_channel);
+        true_user_frame.resize(n2);
+        for (int j = 0; j < n2; j++) {
+            const double position = warp(static_cast<double>(j) / (n2 - 1)) * (n1 - 1);
+            const int f = std::min(static_cast<int>(position), n1 - 2);
+            const double alpha = position - f;
+            true_user_frame[j] = position;
+            for (int c = 0; c < num_channel; c++)
+                expert[static_cast<size_t>(j) * num_channel + c] = static_cast<float>(
+                        (1 - alpha) * user[static_cast<size_t>(f) * num_channel + c] +
+                        alpha * user[static_cast<size_t>(f + 1) * num_channel + c]);
+        }
+        return expert;
+    }
+
+    /// Largest distance between the matched user frame & the true one
+    double MaxPathError(const std::vector<std::pair<int, int>> &path, const std::vector<double> &true_user_frame) {
+        double max_error = 0;
+        for (const auto &[i, j]: path)
+            max_error = std::max(max_error, std::abs(i - true_user_frame[j]));
+        return max_error;
+    }
+
+    /**
+     * Playback alignment: the expert is the user's clip played with a known time warp (slow start, fast swing),
+     * DtwPath should find the warp back. The band keeps it linear, the full matrix would be n1 x n2 cells.
+     */
+    BenchRegistrar similarity_dtw_path("similarity/dtw_path", [] {
+        const int num_channel = 16, n1 = 1800, n2 = 2400;
+        const auto user = MakeClip(n1, num_channel, 3);
+        std::vector<double> true_user_frame;
+        const auto expert = WarpClip(user, n1, n2, num_channel, [](double t) {
+            return t - 0.12 * std::sin(2 * M_PI * t) / (2 * M_PI);
+        }, true_user_frame);
+
+        std::cout << num_channel << "-channel clips, " << n1 << " vs " << n2 << " frames" << std::endl;
+        for (int radius: {60, 180}) {
+            std::vector<std::pair<int, int>> path;
+            float distance = 0;
+            auto path_ns = MeasureNs([&]() {
+                distance = Similarity::DtwPath(user.data(), n1, expert.data(), n2, num_channel, radius, path);
+            }, 3);
+            std::cout << "radius " << radius << ": " << path_ns * 1e-6 << " ms, "
+                      << (static_cast<double>(n1) * (2 * radius + 1)) / (1 << 20) << " MB of steps, distance "
+                      << distance << ", max error " << MaxPathError(path, true_user_frame) << " frames" << std::endl;
+        }
+        auto full_ns = MeasureNs([&]() {
+            DoNotOptimize(Similarity::Dtw(user.data(), n1, expert.data(), n2, num_channel));
+        }, 1);
+        std::cout << "unconstrained Dtw (distance only) " << full_ns * 1e-6 << " ms" << std::endl;
+    });
+
+    /// Largest number of rows between a cell of path & the reference path's cells of the same column
+    int MaxPathDeviation(const std::vector<std::pair<int, int>> &path,
+                         const std::vector<std::pair<int, int>> &reference, int n2) {
+        std::vector<std::pair<int, int>> rows(n2, {std::numeric_limits<int>::max(), -1});
+        for (const auto &[i, j]: reference)
+            rows[j] = {std::min(rows[j].first, i), std::max(rows[j].second, i)};
+        int max_deviation = 0;
+        for (const auto &[i, j]: path)
+            max_deviation = std::max({max_deviation, rows[j].first - i, i - rows[j].second});
+        return max_deviation;
+    }
+
+    /**
+     * FastDtwPath against ReferenceDtwPath with the same global band, on fixed fixtures: a hand-checked 8 x 6 series
+     * (distance sqrt(2), path (0,0) (1,0) (2,1) (3,2) (4,3) (5,4) (6,4) (7,5)), then warped session clips of fixed
+     * seeds. With a single level FastDtwPath is the banded DtwPath and must give the reference path; with more, the
+     * distance ratio, the cells off the reference path & how far they are tell how good the approximation is.
+     */
+    BenchRegistrar similarity_fast_dtw_parity("similarity/fast_dtw_parity", [] {
+        const std::vector<float> s1 = {0, 0, 1, 2, 3, 2, 1, 0}, s2 = {0, 1, 3, 3, 2, 0};
+        const std::vector<std::pair<int, int>> expected = {{0, 0}, {1, 0}, {2, 1}, {3, 2}, {4, 3}, {5, 4}, {6, 4},
+                                                           {7, 5}};
+        std::vector<std::pair<int, int>> path, reference_path;
+        const double reference = ReferenceDtwPath(s1.data(), 8, s2.data(), 6, 1, 6, reference_path);
+        const float fast = Similarity::FastDtwPath(MotionPyramid(s1.data(), 8, 1, 1), MotionPyramid(s2.data(), 6, 1, 1),
+                                                   6, 4, path);
+        std::cout << "8 x 6 fixture: reference " << (reference_path == expected ? "matches" : "differs from")
+                  << " the expected path, distance error " << std::abs(reference - std::sqrt(2.0))
+                  << "; FastDtwPath " << (path == expected ? "matches" : "differs from") << " it, distance error "
+                  << std::abs(fast - std::sqrt(2.0)) << std::endl;
+
+        const int num_channel = 9, refine_radius = 4;
+        for (const auto &fixture: std::vector<std::pair<int, unsigned>>{{300, 11}, {600, 12}, {1200, 13}}) {
+            const int n1 = fixture.first, n2 = n1 * 6 / 5, radius = n2 / 10;
+            const auto user = MakeClip(n1, num_channel, fixture.second);
+            std::vector<double> true_user_frame;
+            const auto expert = WarpClip(user, n1, n2, num_channel, [](double t) {
+                return t - 0.1 * std::sin(4 * M_PI * t) / (4 * M_PI);
+            }, true_user_frame);
+
+            double reference_distance = 0;
+            const double reference_ns = MeasureNs([&]() {
+                reference_distance = ReferenceDtwPath(user.data(), n1, expert.data(), n2, num_channel, radius,
+                                                      reference_path);
+            }, 1);
+            std::cout << n1 << " vs " << n2 << " frames, band " << radius << ": reference " << reference_ns * 1e-6
+                      << " ms" << std::endl;
+            for (int num_level: {1, 2, 4}) {
+                float distance = 0;
+                const double fast_ns = MeasureNs([&]() {
+                    const MotionPyramid user_pyramid(user.data(), n1, num_channel, num_level);
+                    const MotionPyramid expert_pyramid(expert.data(), n2, num_channel, num_level);
+                    distance = Similarity::FastDtwPath(user_pyramid, expert_pyramid, radius, refine_radius, path);
+                }, 5);
+                const auto num_shared = std::count_if(path.begin(), path.end(), [&](const std::pair<int, int> &cell) {
+                    return std::binary_search(reference_path.begin(), reference_path.end(), cell);
+                });
+                std::cout << "    " << num_level << " level" << (num_level > 1 ? "s" : " ") << ": "
+                          << fast_ns * 1e-6 << " ms, distance ratio " << distance / reference_distance << ", "
+                          << path.size() - num_shared << " / " << path.size() << " cells off the reference path, "
+                          << "at most " << MaxPathDeviation(path, reference_path, n2) << " rows away" << std::endl;
+            }
+        }
+    });
+
+    /**
+     * Long practice sessions: strokes every 60 to 200 frames, the expert drifting in & out of phase over the
+     * session. FastDtwPath over 4-level pyramids against the banded DtwPath with the same global band (10 % of the
+     * longer clip, what PlaybackAligner uses), then the time of FastDtwPath as the clips grow.
+     */
+    BenchRegistrar similarity_fast_dtw("similarity/fast_dtw", [] {
+        const int num_channel = 9, refine_radius = 4, num_level = 4;
+        const auto session = [num_channel](int num_frame, unsigned seed) {
+            std::mt19937 rng(seed);
+            std::uniform_real_distribution<float> phase_dist(0, 2 * M_PI), period_dist(60, 200);
+            std::normal_distribution<float> noise(0, 2);
+            std::vector<float> clip(static_cast<size_t>(num_frame) * num_channel);
+            for (int c = 0; c < num_channel; c++) {
+                const float phase = phase_dist(rng), period = period_dist(rng), slow = period_dist(rng) * 7;
+                for (int t = 0; t < num_frame; t++)
+                    clip[static_cast<size_t>(t) * num_channel + c] = 50 * std::sin(2 * M_PI * t / period + phase) +
+                                                                     30 * std::sin(2 * M_PI * t / slow) + noise(rng);
+            }
+            return clip;
+        };
+        const auto warp = [](double t) {
+            return t - 0.03 * std::sin(6 * M_PI * t) / (6 * M_PI);
+        };
+
+        for (int n1: {1250, 2500, 5000, 10000, 20000}) {
+            const int n2 = n1 * 6 / 5, radius = n2 / 10;
+            const auto user = session(n1, 5);
+            std::vector<double> true_user_frame;
+            const auto expert = WarpClip(user, n1, n2, num_channel, warp, true_user_frame);
+
+            std::vector<std::pair<int, int>> path;
+            float fast_distance = 0;
+            auto fast_ns = MeasureNs([&]() {
+                const MotionPyramid user_pyramid(user.data(), n1, num_channel, num_level);
+                const MotionPyramid expert_pyramid(expert.data(), n2, num_channel, num_level);
+                fast_distance = Similarity::FastDtwPath(user_pyramid, expert_pyramid, radius, refine_radius, path);
+            }, 3);
+            std::cout << n1 << " vs " << n2 << " frames: FastDtwPath " << fast_ns * 1e-6 << " ms (pyramids included)"
+                      << ", max error " << MaxPathError(path, true_user_frame) << " frames";
+            if (n1 <= 10000) {
+                float distance = 0;
+                auto banded_ns = MeasureNs([&]() {
+                    distance = Similarity::DtwPath(user.data(), n1, expert.data(), n2, num_channel, radius, path);
+                }, 1);
+                std::cout << "; banded DtwPath " << banded_ns * 1e-6 << " ms, max error "
+                          << MaxPathError(path, true_user_frame) << " frames, distance ratio "
+                          << fast_distance / distance;
+            }
+            std::cout << std::endl;
+        }
+    });
+}
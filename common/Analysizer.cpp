@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "Analysizer.h"
 
 using namespace analysizer;
@@ -8,48 +10,375 @@ Analysizer::Analysizer(Skeleton *target_skeleton, const std::string &analysizer_
         : target_skeleton(target_skeleton), analysizer_name(analysizer_name) {
     output_identifier = new Identifier(0, "whole_body", {target_skeleton->GetTargetBoneNames()}, target_skeleton);
 
-    if (analysizer_name == "forehand_stroke") {
-        for (const auto &[identifier_name, target_list]: identifier_target_list.at(analysizer_name)) {
-            auto identifier = new Identifier(identifiers.size() + 1, identifier_name, {target_list}, target_skeleton);
-            identifiers[identifier_name] = identifier;
-        }
+    spec.name = analysizer_name;
+    if (analysizer_name != "whole_body" && !AnalyzerSpec::Load("static/analyzers/" + analysizer_name + ".spec", spec) &&
+        analysizer_name == "forehand_stroke") {
+        cout << "The built-in forehand analyzer is used" << endl;
+        spec = AnalyzerSpec::Forehand();
+    }
+    for (const auto &identifier_spec: spec.identifiers) {
+        auto identifier = new Identifier(identifiers.size() + 1, identifier_spec.name, identifier_spec.targets,
+                                         target_skeleton);
+        identifiers[identifier_spec.name] = identifier;
     }
+    // A spec with a feature the clip lacks keeps its scorers, its checks are skipped
+    if (!plan.Compile(spec, output_identifier->GetSchema(), target_skeleton->GetBvh()))
+        cout << "The checks of " << analysizer_name << " are disabled" << endl;
 }
 
 void Analysizer::_Analyse(map<string, Identifier *> &identifier_list, const string &openposePath) {
-    mSuggestion = "";
-    // Analyze the skeleton
-    for (int curr_frame = 0; curr_frame < target_skeleton->GetBvh()->GetNumModifiedFrame(); curr_frame++) {
-        for_each(identifier_list.begin(), identifier_list.end(), [curr_frame](pair<string, Identifier *> element) {
-            element.second->Identify(curr_frame);
-        });
-        output_identifier->Identify(curr_frame);
-        target_skeleton->NextBvhMotion();
-    }
-    // Write the output & analyze
-    output_filename = "output/" + analysizer_name + ".csv";
-    output_identifier->WriteOutput(output_filename);
-    for_each(identifier_list.begin(), identifier_list.end(),
-             [&](pair<string, Identifier *> element) {
-                 identifier_pass_list[element.first] = element.second->Py_SimilarityScore(output_filename,
-                                                                                          openposePath);
-             });
+    if (IsRunning()) {
+        cout << "An analysis is already running" << endl;
+        return;
+    }
+    // Snapshot: the forward kinematics of the whole clip (shared by all identifiers) & the motion it was built from,
+    // the clip can be edited while the job runs
+    const rp3d::Vector3 &skeleton_position = target_skeleton->GetSkeletonPosition();
+    job_pose.Build(target_skeleton->GetBvh(),
+                   glm::vec3(skeleton_position.x, skeleton_position.y, skeleton_position.z));
+    job_motion = *target_skeleton->GetBvh()->GetModifiedMotions();
+    job_identifiers = identifier_list;
+    job_openpose_path = openposePath;
+    job_result.clear();
+    job_derived = FeatureMatrix();
+    job_checks = PlanResult();
+    job_strokes.clear();
+    isJobCached = false;
+    isJobSegmented = isSegmenting;
+
+    job_hash = resultCache::ContentHash();
+    job_hash.Add(job_motion);
+    job_hash.Add(target_skeleton->GetTargetBoneNames());
+    const float position[3] = {skeleton_position.x, skeleton_position.y, skeleton_position.z};
+    job_hash.Add(position, sizeof(position));
+
+    isCancelRequested = false;
+    job_progress = 0;
+    job_stage = LOADING_KEYPOINTS;
+    job_thread = std::thread(&Analysizer::RunJob, this);
+}
+
+void Analysizer::RunJob() {
+    try {
+        RunStages();
+    } catch (const std::exception &e) {
+        cout << "The analysis failed: " << e.what() << endl;
+        job_stage = FAILED;
+    } catch (...) {
+        cout << "The analysis failed" << endl;
+        job_stage = FAILED;
+    }
+}
+
+void Analysizer::RunStages() {
+    const auto cancelled = [this]() {
+        if (isCancelRequested)
+            job_stage = CANCELLED;
+        return isCancelRequested.load();
+    };
+
+    OpenPoseData openpose;
+    if (!openpose.Load(job_openpose_path)) {
+        cout << "Cannot open the openpose file " << job_openpose_path << endl;
+        job_stage = FAILED;
+        return;
+    }
+    if (cancelled())
+        return;
+
+    // Same clip, keypoints, identifiers & model as an earlier analysis: its result is served from the cache.
+    // Only whole-clip results are cached
+    std::string cache_key;
+    const bool isCached = isCacheEnabled && !isJobSegmented;
+    if (isCached) {
+        cache_key = CacheKey(openpose);
+        resultCache::CacheEntry entry;
+        if (resultCache::ResultCache::Instance().Load(cache_key, entry) && RestoreCached(entry)) {
+            EvaluateChecks();
+            isJobCached = true;
+            job_progress = 1;
+            job_stage = DONE;
+            return;
+        }
+    }
+
+    job_stage = EXTRACTING_FEATURES;
+    job_progress = 0.1f;
+    ExtractFeatures();
+    // Analyze, the features & keypoints go to Python in memory
+    if (isWriteOutput) {
+        output_filename = "output/" + analysizer_name + ".csv";
+        if (!output_identifier->WriteOutput(output_filename)) {
+            job_stage = FAILED;
+            return;
+        }
+    }
+    if (cancelled())
+        return;
+
+    job_stage = CLASSIFYING;
+    job_progress = 0.5f;
+    if (isJobSegmented)
+        ScoreStrokes(openpose);
+    else
+        job_result = Score(openpose, FrameRange());
+    if (cancelled())
+        return;
+
+    if (isCached)
+        resultCache::ResultCache::Instance().Store(cache_key, {output_identifier->GetFeatures(), job_result});
+    job_progress = 1;
+    job_stage = DONE;
+}
+
+void Analysizer::ExtractFeatures() {
+    // One pass over the pose for the whole body, every identifier reads its targets from it
+    output_identifier->Identify(job_pose, job_motion);
+    job_progress = 0.4f;
+    EvaluateChecks();
+}
+
+void Analysizer::EvaluateChecks() {
+    if (!plan.IsCompiled())
+        return;
+    job_derived = plan.ExtractDerived(target_skeleton->GetBvh(), job_motion, job_pose);
+    job_checks = plan.Evaluate(output_identifier->GetFeatures(), job_derived, FrameRange());
+}
+
+int Analysizer::SpecIndex(const std::string &identifier_name) const {
+    const auto *identifier_spec = spec.Find(identifier_name);
+    return identifier_spec == nullptr ? -1 : static_cast<int>(identifier_spec - spec.identifiers.data());
+}
+
+PendingScores Analysizer::SubmitScores(const OpenPoseData &openpose, const FrameRange &range) {
+    // One task per scorer, in identifier order; an identifier without a scorer only has its checks
+    PendingScores pending;
+    std::vector<std::string> scorer_list;
+    for (auto &[identifier_name, pIdentifier]: job_identifiers) {
+        const auto *identifier_spec = spec.Find(identifier_name);
+        if (identifier_spec == nullptr || identifier_spec->scorer.empty())
+            continue;
+        auto task = std::find(scorer_list.begin(), scorer_list.end(), identifier_spec->scorer);
+        if (task == scorer_list.end()) {
+            scorer_list.push_back(identifier_spec->scorer);
+            task = scorer_list.end() - 1;
+        }
+        pending.identifier_task[identifier_name] = task - scorer_list.begin();
+    }
+
+    // Each task has its own future, the merge does not depend on which batch finished first
+    for (const auto &scorer: scorer_list) {
+        if (scorer == "forehand_classifier") {
+            pending.tasks.push_back(ClassifierSession::Instance().PredictAsync(output_identifier->GetFeatures(),
+                                                                               openpose, range));
+        } else {
+            cout << "No such scorer " << scorer << endl;
+            std::promise<std::vector<float>> none;
+            pending.tasks.push_back(none.get_future());
+            none.set_value({});
+        }
+    }
+    return pending;
+}
+
+std::map<std::string, std::vector<float>> Analysizer::CollectScores(PendingScores &pending) {
+    // A scorer that failed has no output, like one that found nothing
+    std::vector<std::vector<float>> task_result;
+    for (auto &task: pending.tasks) {
+        try {
+            task_result.push_back(task.get());
+        } catch (const std::exception &error) {
+            cout << "Scorer failed: " << error.what() << endl;
+            task_result.emplace_back();
+        }
+    }
+
+    std::map<std::string, std::vector<float>> result;
+    for (auto &[identifier_name, task]: pending.identifier_task)
+        result[identifier_name] = task_result[task];
+    return result;
+}
+
+std::map<std::string, std::vector<float>> Analysizer::Score(const OpenPoseData &openpose, const FrameRange &range) {
+    auto pending = SubmitScores(openpose, range);
+    return CollectScores(pending);
+}
+
+void Analysizer::ScoreStrokes(const OpenPoseData &openpose) {
+    const auto segments = StrokeSegmenter::Segment(target_skeleton->GetBvh(), job_pose, segmenter_config);
+    if (segments.empty()) {
+        cout << "No stroke found, the clip is analyzed as one stroke" << endl;
+        job_result = Score(openpose, FrameRange());
+        return;
+    }
+
+    // The strokes are views on the whole clip's features. Parallel, every stroke is queued before any is waited
+    // for, so they run as a few batches; otherwise one stroke at a time
+    // Read once, SetParallel during the job must not change the mode half-way
+    const bool parallel = isParallel;
+    job_strokes.resize(segments.size());
+    std::vector<PendingScores> pending(segments.size());
+    if (parallel) {
+        for (size_t i = 0; i < segments.size(); i++)
+            pending[i] = SubmitScores(openpose, segments[i].frames);
+    }
+    const auto score = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !isCancelRequested; i++) {
+            job_strokes[i].segment = segments[i];
+            if (!parallel)
+                pending[i] = SubmitScores(openpose, segments[i].frames);
+            job_strokes[i].results = CollectScores(pending[i]);
+            if (plan.IsCompiled())
+                job_strokes[i].checks = plan.Evaluate(output_identifier->GetFeatures(), job_derived,
+                                                      segments[i].frames);
+        }
+    };
+    if (parallel)
+        thread_pool.ParallelFor(0, segments.size(), score);
+    else
+        score(0, segments.size());
+
+    // The skeleton shows the session's mean, per identifier over the strokes its scorer gave an output for
+    std::map<std::string, int> num_scored;
+    for (const auto &stroke: job_strokes) {
+        for (const auto &[identifier_name, prob_result]: stroke.results) {
+            if (prob_result.empty())
+                continue;
+            auto &sum = job_result[identifier_name];
+            sum.resize(std::max(sum.size(), prob_result.size()), 0.0f);
+            for (size_t i = 0; i < prob_result.size(); i++)
+                sum[i] += prob_result[i];
+            num_scored[identifier_name]++;
+        }
+    }
+    for (auto &[identifier_name, mean]: job_result) {
+        for (auto &value: mean)
+            value /= num_scored[identifier_name];
+    }
+}
+
+std::string Analysizer::CacheKey(const OpenPoseData &openpose) {
+    resultCache::ContentHash hash = job_hash;
+    hash.Add(openpose.GetColumnNames());
+    hash.Add(openpose.GetData());
+
+    hash.Add(analysizer_name);
+    for (auto &[identifier_name, pIdentifier]: job_identifiers) {
+        hash.Add(identifier_name);
+        if (const auto *identifier_spec = spec.Find(identifier_name)) {
+            hash.Add(identifier_spec->scorer);
+            hash.Add(identifier_spec->targets);
+        }
+    }
+    hash.Add(ClassifierSession::Instance().GetModelVersion());
+    return hash.GetHex();
+}
+
+bool Analysizer::RestoreCached(const resultCache::CacheEntry &entry) {
+    if (!output_identifier->Identify(entry.features))
+        return false;
+    for (auto &[identifier_name, pIdentifier]: job_identifiers) {
+        const auto *identifier_spec = spec.Find(identifier_name);
+        if (identifier_spec != nullptr && !identifier_spec->scorer.empty() && !entry.results.count(identifier_name))
+            return false;
+    }
+    job_result = entry.results;
+    return true;
+}
+
+void Analysizer::FinishJob() {
+    for (auto &[identifier_name, prob_result]: job_result)
+        identifier_pass_list[identifier_name] = prob_result;
+    identifier_checks = job_checks;
+
+    auto &session = ClassifierSession::Instance();
+    const auto metrics = session.GetMetrics();
+    cout << "Classifier (" << (session.IsNative() ? PrecisionName(session.GetPrecision()) : "python")
+         << "): warm-up " << metrics.warm_up_time << " ms, model load " << metrics.model_load_time
+         << " ms, inference " << metrics.last_inference_time << " ms" << endl;
+    if (isCacheEnabled) {
+        const auto stats = resultCache::ResultCache::Instance().GetStats();
+        cout << "Result cache " << (isJobCached ? "hit" : "miss") << ": " << stats.num_hit << " hits, "
+             << stats.num_miss << " misses (" << stats.GetHitRate() * 100 << "%), " << stats.num_entry
+             << " entries, " << stats.num_byte / 1024 << " KiB, " << stats.num_eviction << " evicted" << endl;
+    }
 
     // Show the result
+    mSuggestion = "";
     target_skeleton->ClearAnalyzeResult();
-    for (auto &[identifier_name, pIdentifier]: identifier_list) {
+    for (auto &[identifier_name, pIdentifier]: job_identifiers) {
         ShowAnalysisResult_Skeleton(identifier_name);
-        mSuggestion += Suggest_str(identifier_name);
+        if (job_strokes.empty())
+            mSuggestion += Suggest_str(identifier_name);
+    }
+    // A segmented session: the advice stroke by stroke
+    stroke_results = job_strokes;
+    if (!stroke_results.empty())
+        mSuggestion = std::to_string(stroke_results.size()) + " strokes\n";
+    for (size_t i = 0; i < stroke_results.size(); i++) {
+        const auto &frames = stroke_results[i].segment.frames;
+        mSuggestion += "Stroke " + std::to_string(i + 1) + " (frame " + std::to_string(frames.begin) + "-" +
+                       std::to_string(frames.end - 1) + "):\n";
+        for (auto &[identifier_name, pIdentifier]: job_identifiers) {
+            const int index = SpecIndex(identifier_name);
+            if (index < 0)
+                continue;
+            const auto result = stroke_results[i].results.find(identifier_name);
+            if (result != stroke_results[i].results.end())
+                mSuggestion += spec.identifiers[index].Suggest(result->second);
+            mSuggestion += stroke_results[i].checks.Suggest(spec, index);
+        }
     }
     // Remove the last '\n'
-    mSuggestion.pop_back();
+    if (!mSuggestion.empty())
+        mSuggestion.pop_back();
 
     cout << "Analyze done" << endl;
     analysize_done.fire();
 }
 
+void Analysizer::Update() {
+    const AnalysisStage stage = job_stage;
+    if (!IsRunning() || (stage != DONE && stage != CANCELLED && stage != FAILED))
+        return;
+
+    job_thread.join();
+    if (stage == DONE)
+        FinishJob();
+    else if (stage == CANCELLED)
+        cout << "Analyze cancelled" << endl;
+    job_stage = IDLE;
+}
+
+void Analysizer::Cancel() {
+    if (IsRunning())
+        isCancelRequested = true;
+}
+
+std::string Analysizer::GetStageName() const {
+    switch (job_stage.load()) {
+        case LOADING_KEYPOINTS:
+            return "Loading keypoints";
+        case EXTRACTING_FEATURES:
+            return "Extracting features";
+        case CLASSIFYING:
+            return "Classifying";
+        case DONE:
+            return "Done";
+        case CANCELLED:
+            return "Cancelled";
+        case FAILED:
+            return "Failed";
+        default:
+            return "Idle";
+    }
+}
 
 Analysizer::~Analysizer() {
+    // The job uses the identifiers & the skeleton's bvh
+    Cancel();
+    if (job_thread.joinable())
+        job_thread.join();
     identifiers.clear();
 
     delete output_identifier;
@@ -67,70 +396,33 @@ void Analysizer::Analyze(Identifier *identifier, const string &openposePath) {
 }
 
 void Analysizer::ShowAnalysisResult_Skeleton(const string &identifier_name) {
-    if (analysizer_name == analyzer_name_list[0]) {
-        auto prob_vtr = identifier_pass_list[identifier_name];
-        string bone_name = identifier_target_list.at(analysizer_name).at(identifier_name)[0];
-        if (identifier_name == "rotation") {
-            if (prob_vtr[0] < 0.5) {
-                target_skeleton->ShowAnalyzeResult(bone_name);
-            }
-        }
-        if (identifier_name == "fore_arm") {
-            if (prob_vtr[3] < 0.5) {
-                target_skeleton->ShowAnalyzeResult(bone_name);
-            }
-        }
-    }
+    const int index = SpecIndex(identifier_name);
+    if (index < 0)
+        return;
+    const auto &identifier_spec = spec.identifiers[index];
+    // The scorer's verdict (the mean over the strokes when segmented) & the checks, an identifier without scorer
+    // output only has its checks
+    const auto prob_result = identifier_pass_list.find(identifier_name);
+    if ((prob_result != identifier_pass_list.end() && !identifier_spec.IsPass(prob_result->second)) ||
+        !identifier_checks.IsPass(index))
+        target_skeleton->ShowAnalyzeResult(identifier_spec.GetBone());
 }
 
 string Analysizer::Suggest_str(const string &identifier_name) {
-    string suggestion;
-    if (analysizer_name == analyzer_name_list[0]) {
-        string forehand_stroke_suggestion;
-        /// VTR: 0,1,2: rotation, 3,4,5: fore_arm
-        auto prob_vtr = identifier_pass_list[identifier_name];
-        if (identifier_name == "rotation") {
-            if (prob_vtr[0] >= 0.5) {
-                forehand_stroke_suggestion += "Your hip rotation motion is correct.\n";
-            } else {
-                if (prob_vtr[1] >= 0.5) {
-                    forehand_stroke_suggestion += "Rotate your waist less.\n";
-                } else if (prob_vtr[2] >= 0.5) {
-                    forehand_stroke_suggestion += "Rotate your waist more.\n";
-                } else {
-                    forehand_stroke_suggestion += "Your hip rotation motion is wrong.\nPlease see our expert motion and try to mimic it.\n";
-                }
-            }
-        }
-        if (identifier_name == "fore_arm") {
-            if (prob_vtr[3] >= 0.5) {
-                forehand_stroke_suggestion += "Your swing motion is correct.\n";
-            } else {
-                if (prob_vtr[4] >= 0.5) {
-                    forehand_stroke_suggestion += "Wave your arm less.\n";
-                } else if (prob_vtr[5] >= 0.5) {
-                    forehand_stroke_suggestion += "Wave your arm more.\n";
-                } else {
-                    forehand_stroke_suggestion += "Your swing motion is wrong.\nPlease see our expert motion and try to mimic it.\n";
-                }
-            }
-        }
-
-        suggestion += forehand_stroke_suggestion;
-    }
-
-    return suggestion;
+    const int index = SpecIndex(identifier_name);
+    if (index < 0)
+        return "";
+    // The scorer's advice, then the failed checks'
+    return spec.identifiers[index].Suggest(identifier_pass_list[identifier_name]) +
+           identifier_checks.Suggest(spec, index);
 }
 
 string Analysizer::Suggest_str() {
-    string suggestion, tmp_suggestion;
-    for (const auto &[identifier_name, isPass]: identifier_pass_list) {
-        if (identifier_name == "rotation" || identifier_name == "fore_arm") {
-            tmp_suggestion = Suggest_str(identifier_name);
-        }
-        suggestion += tmp_suggestion + "\n";
-    }
+    string suggestion;
+    for (const auto &identifier_spec: spec.identifiers)
+        suggestion += Suggest_str(identifier_spec.name);
     // Remove the last '\n'
-    suggestion.pop_back();
+    if (!suggestion.empty())
+        suggestion.pop_back();
     return suggestion;
 }
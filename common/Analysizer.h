@@ -1,35 +1,66 @@
 #ifndef TESTBED_ANALYSIZER_H
 #define TESTBED_ANALYSIZER_H
 
+#include <atomic>
+#include <future>
 #include <map>
+#include <thread>
 #include <vector>
 
 #include "Identifier.h"
 #include "Skeleton.h"
 #include "SceneDemo.h"
 #include "Event.h"
+#include "ThreadPool.h"
+#include "AnalyzerSpec.h"
+#include "ResultCache.h"
+#include "StrokeSegmenter.h"
 
 using namespace identifier;
 using namespace skeleton;
+using namespace analyzerSpec;
+using namespace strokeSegmenter;
 
 namespace analysizer {
-    class Analysizer {
-    private:
-        // ------------------------- Constants ----------------------- //
-        const std::vector<std::string> analyzer_name_list = {"forehand_stroke"};
 
-        const std::map<std::string, std::map<std::string, std::vector<std::string>>> identifier_target_list = {
-                {analyzer_name_list[0], {{"rotation", {"hip"}}, {"fore_arm", {"rForeArm"}}}},
-        };
+    /// Where an analysis job is, in order
+    enum AnalysisStage {
+        IDLE, LOADING_KEYPOINTS, EXTRACTING_FEATURES, CLASSIFYING, DONE, CANCELLED, FAILED
+    };
 
-        const std::map<std::string, std::map<std::string, std::string>> identifier_notPass_suggestions = {
-                {"forehand_stroke",
-                 {{"rotation", "Twist your waist correctly."}, {"fore_arm", "Wave your arm correctly."}}},
-        };
+    /// The model outputs & feature checks of one stroke of a segmented session
+    struct StrokeResult {
+        StrokeSegment segment;
+        std::map<std::string, std::vector<float>> results;
+        PlanResult checks;
+    };
 
+    /// Model calls of a part of the clip in the classifier queue, one per scorer
+    struct PendingScores {
+        std::map<std::string, size_t> identifier_task;
+        std::vector<std::future<std::vector<float>>> tasks;
+    };
+
+    /**
+     * Analyze runs as a background job so the render loop keeps its frame rate:
+     * the main thread takes a snapshot of the clip (forward kinematics of every frame & a copy of the motion), a
+     * worker thread loads the keypoints, extracts the features and runs the classifier, and Update (called every
+     * frame by the scene) hands the result back on the main thread, where analysize_done fires.
+     * The worker only holds the GIL while the Python classifier runs. Cancel is checked between the stages, a
+     * running Python call is not interrupted.
+     */
+    class Analysizer {
+    private:
         // ------------------------- Attributes ----------------------- //
         std::string analysizer_name;
 
+        /// The identifiers, their targets, scorers, checks & advice: static/analyzers/<analysizer_name>.spec.
+        /// Identifiers with the same scorer read the same model output, it is computed once per job
+        AnalyzerSpec spec;
+
+        /// The checks of every identifier, evaluated in one pass over the features
+        AnalysisPlan plan;
+
         Skeleton *target_skeleton;
 
         std::map<std::string, Identifier *> identifiers;
@@ -38,15 +69,101 @@ namespace analysizer {
 
         std::string output_filename;
 
+        /// Write the whole body features to output_filename, for debugging only: Python reads them from memory
+        bool isWriteOutput = false;
+
+        /// The strokes of a segmented job are scored together (one batch of the classifier queue) & their checks
+        /// run concurrently on thread_pool
+        std::atomic<bool> isParallel{true};
+
+        threadPool::ThreadPool thread_pool;
+
         std::vector<std::string> identifier_name_list;
 
         std::map<std::string, std::vector<float>> identifier_pass_list;
 
+        /// The checks of the last analysis, whole clip
+        PlanResult identifier_checks;
+
         std::string mSuggestion;
 
+        /// Cut the clip into strokes (StrokeSegmenter) and score each one, for long practice sessions
+        std::atomic<bool> isSegmenting{false};
+        SegmenterConfig segmenter_config;
+
+        /// The strokes of the last segmented analysis, empty for a single-stroke analysis
+        std::vector<StrokeResult> stroke_results;
+
+        // ------------------------- Job ----------------------- //
+        std::thread job_thread;
+        std::atomic<AnalysisStage> job_stage{IDLE};
+        /// 0 to 1 over all the stages
+        std::atomic<float> job_progress{0};
+        std::atomic<bool> isCancelRequested{false};
+
+        /// The inputs of the running job, untouched by the main thread until it is over
+        map<string, Identifier *> job_identifiers;
+        PoseBuffer job_pose;
+        std::vector<double> job_motion;
+        std::string job_openpose_path;
+        /// The clip part of the result cache key, the worker adds the keypoints & the model
+        resultCache::ContentHash job_hash;
+        std::map<std::string, std::vector<float>> job_result;
+        /// The derivative columns the checks read & the checks over the whole clip
+        FeatureMatrix job_derived;
+        PlanResult job_checks;
+        /// Whether job_result came from the result cache
+        bool isJobCached = false;
+        bool isJobSegmented = false;
+        /// One per stroke if the job is segmented, job_result is then their mean
+        std::vector<StrokeResult> job_strokes;
+
+        /// Analyses already done on the same clip, keypoints & model are served from here
+        bool isCacheEnabled = true;
+
         // ------------------------- Methods ----------------------- //
+        /// Take the snapshot and start the job, on the main thread
         void _Analyse(map<string, Identifier *> &identifier_list, const string &openposePath);
 
+        /// The job, on the worker thread: anything it throws (Python, the model) fails the job
+        void RunJob();
+
+        /// The stages of the job
+        void RunStages();
+
+        /// Show the result of a finished job, on the main thread
+        void FinishJob();
+
+        /// The whole-body features (output_identifier's) & the checks over them
+        void ExtractFeatures();
+
+        /// job_derived & job_checks from the whole-body features
+        void EvaluateChecks();
+
+        /// Index of the identifier in spec, -1 if it has none
+        int SpecIndex(const std::string &identifier_name) const;
+
+        /**
+         * Queue the model calls of job_identifiers on a part of the clip, one per scorer (none for the identifiers
+         * without one); the scorers batch with each other and with the other pending calls
+         */
+        PendingScores SubmitScores(const OpenPoseData &openpose, const FrameRange &range);
+
+        /// The model outputs of submitted scores, per identifier
+        std::map<std::string, std::vector<float>> CollectScores(PendingScores &pending);
+
+        /// Submit & collect at once
+        std::map<std::string, std::vector<float>> Score(const OpenPoseData &openpose, const FrameRange &range);
+
+        /// Segment the clip, score the strokes into job_strokes & their mean into job_result
+        void ScoreStrokes(const OpenPoseData &openpose);
+
+        /// Key of the job in the result cache, everything its result depends on
+        std::string CacheKey(const OpenPoseData &openpose);
+
+        /// Features & job_result from a cached entry, false if it does not fit the job's identifiers
+        bool RestoreCached(const resultCache::CacheEntry &entry);
+
     public:
         // ------------------------- Events ----------------------- //
         event::Event<> analysize_done;
@@ -54,12 +171,16 @@ namespace analysizer {
         // ------------------------- Methods ----------------------- //
         Analysizer(Skeleton *skeleton);
 
+        /**
+         * The identifiers come from static/analyzers/<analysizer_name>.spec (AnalyzerSpec::Load), the forehand
+         * analyzer falls back to its built-in spec
+         */
         Analysizer(Skeleton *target_skeleton, const std::string &analysizer_name);
 
         ~Analysizer();
 
         /**
-         * Analyze the skeleton with all the identifiers
+         * Start analyzing the skeleton with all the identifiers, nothing happens if a job is running
          */
         void Analyze(const string &openposePath);
 
@@ -75,14 +196,90 @@ namespace analysizer {
 
         void ShowAnalysisResult_Skeleton(const string &identifier_name);
 
+        /**
+         * Deliver the result of a finished job (analysize_done), call it every frame from the main thread
+         */
+        void Update();
+
+        /// Ask the running job to stop after its current stage
+        void Cancel();
+
         // ------------------------- Getters & Setters ----------------------- //
         std::string GetSuggestion();
+
+        bool IsRunning() const;
+
+        AnalysisStage GetStage() const;
+
+        /// e.g. "Extracting features", for the progress display
+        std::string GetStageName() const;
+
+        float GetProgress() const;
+
+        void SetWriteOutput(bool isWriteOutput);
+
+        /// Strokes scored one at a time (false) or together, read once per job when its strokes are scored
+        void SetParallel(bool isParallel);
+
+        /// Look analyses up in (and store them to) resultCache::ResultCache, takes effect from the next job
+        void SetCacheEnabled(bool isCacheEnabled);
+
+        /// Analyze every stroke of the clip (true) or the clip as one stroke, takes effect from the next job
+        void SetSegmenting(bool isSegmenting);
+
+        /// Only effective when no job is running
+        void SetSegmenterConfig(const SegmenterConfig &segmenter_config);
+
+        const std::vector<StrokeResult> &GetStrokeResults() const;
+
+        const AnalyzerSpec &GetSpec() const;
     };
 
     inline std::string Analysizer::GetSuggestion() {
         return mSuggestion;
     }
 
+    inline void Analysizer::SetWriteOutput(bool isWriteOutput) {
+        this->isWriteOutput = isWriteOutput;
+    }
+
+    inline void Analysizer::SetParallel(bool isParallel) {
+        this->isParallel = isParallel;
+    }
+
+    inline void Analysizer::SetCacheEnabled(bool isCacheEnabled) {
+        this->isCacheEnabled = isCacheEnabled;
+    }
+
+    inline void Analysizer::SetSegmenting(bool isSegmenting) {
+        this->isSegmenting = isSegmenting;
+    }
+
+    inline void Analysizer::SetSegmenterConfig(const SegmenterConfig &segmenter_config) {
+        if (!IsRunning())
+            this->segmenter_config = segmenter_config;
+    }
+
+    inline const std::vector<StrokeResult> &Analysizer::GetStrokeResults() const {
+        return stroke_results;
+    }
+
+    inline const AnalyzerSpec &Analysizer::GetSpec() const {
+        return spec;
+    }
+
+    inline bool Analysizer::IsRunning() const {
+        return job_thread.joinable();
+    }
+
+    inline AnalysisStage Analysizer::GetStage() const {
+        return job_stage;
+    }
+
+    inline float Analysizer::GetProgress() const {
+        return job_progress;
+    }
+
 }
 
 
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "AnalyzerSpec.h"
+
+using namespace analyzerSpec;
+
+namespace {
+    std::string Trim(const std::string &text) {
+        const auto begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos)
+            return "";
+        return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+    }
+
+    /// "\n" in the file is a line break of the advice
+    std::string Unescape(const std::string &text) {
+        std::string result;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '\\' && i + 1 < text.size() && text[i + 1] == 'n') {
+                result += '\n';
+                i++;
+            } else {
+                result += text[i];
+            }
+        }
+        return result;
+    }
+
+    bool ParseAggregate(const std::string &name, AggregateKind &aggregate) {
+        static const std::pair<const char *, AggregateKind> names[] = {{"min",   MIN},
+                                                                       {"max",   MAX},
+                                                                       {"mean",  MEAN},
+                                                                       {"range", RANGE}};
+        for (const auto &[aggregate_name, kind]: names) {
+            if (name == aggregate_name) {
+                aggregate = kind;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// The joint of a derivative feature name (joint_speed...), empty if it is not one
+    std::string DerivativeJoint(const std::string &feature) {
+        // Longest suffix first, _angular_speed ends with _speed
+        for (const std::string suffix: {"_angular_speed", "_acceleration", "_speed", "_jerk"}) {
+            if (feature.size() > suffix.size() &&
+                feature.compare(feature.size() - suffix.size(), suffix.size(), suffix) == 0)
+                return feature.substr(0, feature.size() - suffix.size());
+        }
+        return "";
+    }
+}
+
+bool IdentifierSpec::IsPass(const std::vector<float> &prob_vtr) const {
+    if (scorer.empty())
+        return true;
+    return first_class >= 0 && first_class < prob_vtr.size() && prob_vtr[first_class] >= pass_threshold;
+}
+
+std::string IdentifierSpec::Suggest(const std::vector<float> &prob_vtr) const {
+    if (scorer.empty() || first_class < 0 || first_class + 2 >= prob_vtr.size())
+        return "";
+    if (prob_vtr[first_class] >= pass_threshold)
+        return suggest_pass + "\n";
+    if (prob_vtr[first_class + 1] >= pass_threshold)
+        return suggest_too_much + "\n";
+    if (prob_vtr[first_class + 2] >= pass_threshold)
+        return suggest_too_little + "\n";
+    return suggest_wrong + "\n";
+}
+
+bool AnalyzerSpec::Load(const std::string &filename, AnalyzerSpec &spec) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cout << "Cannot open the analyzer spec " << filename << std::endl;
+        return false;
+    }
+    AnalyzerSpec loaded;
+    std::string line;
+    int line_number = 0;
+    const auto fail = [&](const std::string &message) {
+        std::cout << filename << ":" << line_number << ": " << message << std::endl;
+        return false;
+    };
+    while (std::getline(file, line)) {
+        line_number++;
+        // A comment is a '#' starting the line or following a blank
+        for (size_t hash = line.find('#'); hash != std::string::npos; hash = line.find('#', hash + 1)) {
+            if (hash == 0 || line[hash - 1] == ' ' || line[hash - 1] == '\t') {
+                line.erase(hash);
+                break;
+            }
+        }
+        line = Trim(line);
+        if (line.empty())
+            continue;
+        const auto blank = line.find_first_of(" \t");
+        const std::string key = line.substr(0, blank);
+        const std::string value = blank == std::string::npos ? "" : Trim(line.substr(blank));
+
+        if (key == "analyzer") {
+            loaded.name = value;
+            continue;
+        }
+        if (key == "identifier") {
+            if (value.empty())
+                return fail("an identifier needs a name");
+            if (loaded.Find(value) != nullptr)
+                return fail("identifier " + value + " is declared twice");
+            loaded.identifiers.emplace_back();
+            loaded.identifiers.back().name = value;
+            continue;
+        }
+        if (loaded.identifiers.empty())
+            return fail("\"" + key + "\" before the first identifier");
+        auto &identifier = loaded.identifiers.back();
+
+        if (key == "target") {
+            identifier.targets.push_back(value);
+        } else if (key == "scorer") {
+            identifier.scorer = value;
+        } else if (key == "first_class") {
+            std::istringstream stream(value);
+            if (!(stream >> identifier.first_class))
+                return fail("first_class expects an integer");
+        } else if (key == "pass_threshold") {
+            std::istringstream stream(value);
+            if (!(stream >> identifier.pass_threshold))
+                return fail("pass_threshold expects a number");
+        } else if (key == "suggest_pass") {
+            identifier.suggest_pass = Unescape(value);
+        } else if (key == "suggest_too_much") {
+            identifier.suggest_too_much = Unescape(value);
+        } else if (key == "suggest_too_little") {
+            identifier.suggest_too_little = Unescape(value);
+        } else if (key == "suggest_wrong") {
+            identifier.suggest_wrong = Unescape(value);
+        } else if (key == "check") {
+            CheckSpec check;
+            std::string aggregate, op;
+            std::istringstream stream(value);
+            if (!(stream >> check.feature >> aggregate >> op >> check.threshold) ||
+                !ParseAggregate(aggregate, check.aggregate) || (op != "<" && op != ">"))
+                return fail("expected: check feature min|max|mean|range <|> threshold advice");
+            check.op = op[0];
+            std::getline(stream, check.suggestion);
+            check.suggestion = Unescape(Trim(check.suggestion));
+            identifier.checks.push_back(check);
+        } else {
+            return fail("unknown key \"" + key + "\"");
+        }
+    }
+    for (const auto &identifier: loaded.identifiers) {
+        if (identifier.targets.empty()) {
+            std::cout << filename << ": identifier " << identifier.name << " has no target" << std::endl;
+            return false;
+        }
+    }
+    spec = std::move(loaded);
+    return true;
+}
+
+AnalyzerSpec AnalyzerSpec::Forehand() {
+    AnalyzerSpec spec;
+    spec.name = "forehand_stroke";
+
+    IdentifierSpec rotation;
+    rotation.name = "rotation";
+    rotation.targets = {"hip"};
+    rotation.scorer = "forehand_classifier";
+    rotation.first_class = 0;
+    rotation.suggest_pass = "Your hip rotation motion is correct.";
+    rotation.suggest_too_much = "Rotate your waist less.";
+    rotation.suggest_too_little = "Rotate your waist more.";
+    rotation.suggest_wrong = "Your hip rotation motion is wrong.\nPlease see our expert motion and try to mimic it.";
+
+    IdentifierSpec fore_arm;
+    fore_arm.name = "fore_arm";
+    fore_arm.targets = {"rForeArm"};
+    fore_arm.scorer = "forehand_classifier";
+    fore_arm.first_class = 3;
+    fore_arm.suggest_pass = "Your swing motion is correct.";
+    fore_arm.suggest_too_much = "Wave your arm less.";
+    fore_arm.suggest_too_little = "Wave your arm more.";
+    fore_arm.suggest_wrong = "Your swing motion is wrong.\nPlease see our expert motion and try to mimic it.";
+
+    // In name order, like the maps the viewer iterated
+    spec.identifiers = {fore_arm, rotation};
+    return spec;
+}
+
+const IdentifierSpec *AnalyzerSpec::Find(const std::string &identifier_name) const {
+    for (const auto &identifier: identifiers) {
+        if (identifier.name == identifier_name)
+            return &identifier;
+    }
+    return nullptr;
+}
+
+std::string PlanResult::Suggest(const AnalyzerSpec &spec, int identifier) const {
+    std::string suggestion;
+    if (identifier < 0 || identifier >= isPass.size())
+        return suggestion;
+    for (size_t check = 0; check < isPass[identifier].size(); check++) {
+        if (!isPass[identifier][check])
+            suggestion += spec.identifiers[identifier].checks[check].suggestion + "\n";
+    }
+    return suggestion;
+}
+
+bool PlanResult::IsPass(int identifier) const {
+    if (identifier < 0 || identifier >= isPass.size())
+        return true;
+    const auto &checks = isPass[identifier];
+    return std::all_of(checks.begin(), checks.end(), [](char isCheckPass) { return isCheckPass != 0; });
+}
+
+bool AnalysisPlan::Compile(const AnalyzerSpec &spec, const FeatureSchema &whole_body, const BVH *bvh) {
+    sources.clear();
+    check_slots.clear();
+    checks.clear();
+    derived_schema = FeatureSchema();
+    isCompiled = false;
+
+    std::vector<std::string> derived_joints;
+    for (const auto &identifier: spec.identifiers) {
+        check_slots.emplace_back();
+        checks.emplace_back();
+        for (const auto &check: identifier.checks) {
+            int source = whole_body.FindColumn(check.feature);
+            if (source < 0) {
+                const std::string joint = DerivativeJoint(check.feature);
+                if (joint.empty() || bvh == nullptr || bvh->GetJoint(joint) == nullptr) {
+                    std::cout << "Analyzer " << spec.name << ": identifier " << identifier.name
+                              << " checks the unknown feature " << check.feature << std::endl;
+                    return false;
+                }
+                // Every derivative of a joint comes from the same differentiation
+                if (std::find(derived_joints.begin(), derived_joints.end(), joint) == derived_joints.end()) {
+                    derived_joints.push_back(joint);
+                    derived_schema.AddDerivativeColumns(bvh, {joint});
+                }
+                source = -1 - derived_schema.FindColumn(check.feature);
+            }
+            // A column is read once, whoever checks it
+            auto slot = std::find(sources.begin(), sources.end(), source);
+            if (slot == sources.end()) {
+                sources.push_back(source);
+                slot = sources.end() - 1;
+            }
+            check_slots.back().push_back(static_cast<int>(slot - sources.begin()));
+            checks.back().push_back(check);
+        }
+    }
+    isCompiled = true;
+    return true;
+}
+
+FeatureMatrix AnalysisPlan::ExtractDerived(const BVH *bvh, const std::vector<double> &motion,
+                                           const PoseBuffer &pose) const {
+    if (derived_schema.GetNumColumn() == 0)
+        return FeatureMatrix();
+    return FeatureExtractor::Extract(derived_schema, bvh, motion, pose);
+}
+
+PlanResult AnalysisPlan::Evaluate(const FeatureMatrix &whole_body, const FeatureMatrix &derived,
+                                  const FrameRange &range) const {
+    const FrameRange frames = range.Clamp(whole_body.GetNumFrame());
+    const int num_frame = frames.GetNumFrame();
+
+    // The single pass: min, max & sum of every distinct column together
+    std::vector<float> mins(sources.size(), 0.0f), maxs(sources.size(), 0.0f), means(sources.size(), 0.0f);
+    for (size_t slot = 0; slot < sources.size() && num_frame > 0; slot++) {
+        const float *__restrict column = (sources[slot] >= 0 ? whole_body.Column(sources[slot])
+                                                             : derived.Column(-1 - sources[slot])) + frames.begin;
+        float low = column[0], high = column[0];
+        double sum = 0;
+        for (int f = 0; f < num_frame; f++) {
+            low = std::min(low, column[f]);
+            high = std::max(high, column[f]);
+            sum += column[f];
+        }
+        mins[slot] = low;
+        maxs[slot] = high;
+        means[slot] = static_cast<float>(sum / num_frame);
+    }
+
+    PlanResult result;
+    for (size_t identifier = 0; identifier < check_slots.size(); identifier++) {
+        result.values.emplace_back();
+        result.isPass.emplace_back();
+        for (size_t i = 0; i < check_slots[identifier].size(); i++) {
+            const int slot = check_slots[identifier][i];
+            const CheckSpec &check = checks[identifier][i];
+            float value = 0;
+            switch (check.aggregate) {
+                case MIN:
+                    value = mins[slot];
+                    break;
+                case MAX:
+                    value = maxs[slot];
+                    break;
+                case MEAN:
+                    value = means[slot];
+                    break;
+                case RANGE:
+                    value = maxs[slot] - mins[slot];
+                    break;
+            }
+            result.values.back().push_back(value);
+            result.isPass.back().push_back(check.op == '<' ? value < check.threshold : value > check.threshold);
+        }
+    }
+    return result;
+}
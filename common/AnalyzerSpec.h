@@ -0,0 +1,172 @@
+#ifndef TESTBED_ANALYZERSPEC_H
+#define TESTBED_ANALYZERSPEC_H
+
+#include <string>
+#include <vector>
+
+#include "BVH.h"
+#include "PoseBuffer.h"
+#include "FeatureExtractor.h"
+
+using namespace bvh;
+using namespace poseBuffer;
+using namespace featureExtractor;
+
+namespace analyzerSpec {
+
+    /// What a check reads of a feature column over the analyzed frames
+    enum AggregateKind {
+        MIN, MAX, MEAN, RANGE
+    };
+
+    /// A threshold on one feature: it passes when aggregate(feature) op threshold holds
+    struct CheckSpec {
+        /// A column of the whole-body features (e.g. rForeArm_parent) or a derivative (e.g. rHand_speed)
+        std::string feature;
+        AggregateKind aggregate = MAX;
+        /// '<' or '>'
+        char op = '>';
+        float threshold = 0;
+        /// Shown when the check fails
+        std::string suggestion;
+    };
+
+    /**
+     * An identifier of an analyzer: which bones it looks at, how its scorer's output reads and the feature checks
+     * it runs natively.
+     */
+    struct IdentifierSpec {
+        std::string name;
+        std::vector<std::string> targets;
+        /// The model whose output the identifier reads ("forehand_classifier"), empty for checks only
+        std::string scorer;
+        /// Index of the identifier's "correct" class in the scorer output, followed by "too much" & "too little"
+        int first_class = 0;
+        float pass_threshold = 0.5f;
+        /// The advice for the correct, too much, too little & none-of-them outputs
+        std::string suggest_pass, suggest_too_much, suggest_too_little, suggest_wrong;
+        std::vector<CheckSpec> checks;
+
+        /// Whether the scorer output says correct, true without a scorer
+        bool IsPass(const std::vector<float> &prob_vtr) const;
+
+        /// The advice for the scorer output, one or two lines ending with '\n', empty without a scorer
+        std::string Suggest(const std::vector<float> &prob_vtr) const;
+
+        /// The bone tinted when the identifier fails: its first target
+        const std::string &GetBone() const;
+    };
+
+    /**
+     * An analyzer described as data: its identifiers, their targets, scorers, checks & advice. Adding a stroke
+     * type is a new spec file, no code.
+     * The file is read line by line, "key value" with '#' comments and "\n" for a line break in the advice:
+     *
+     *     analyzer forehand_stroke
+     *     identifier rotation              # starts an identifier, the keys below are its own
+     *     target hip                       # one per target
+     *     scorer forehand_classifier
+     *     first_class 0
+     *     pass_threshold 0.5
+     *     suggest_pass Your hip rotation motion is correct.
+     *     suggest_too_much / suggest_too_little / suggest_wrong ...
+     *     check rHand_speed max > 150 Swing faster.     # feature aggregate op threshold advice
+     */
+    struct AnalyzerSpec {
+        std::string name;
+        std::vector<IdentifierSpec> identifiers;
+
+        /**
+         * @return false (with a message) if the file cannot be read or a line is malformed
+         */
+        static bool Load(const std::string &filename, AnalyzerSpec &spec);
+
+        /// The forehand analyzer the viewer always had, for when static/analyzers/forehand_stroke.spec is missing
+        static AnalyzerSpec Forehand();
+
+        /// The identifier named so, nullptr if there is none
+        const IdentifierSpec *Find(const std::string &identifier_name) const;
+    };
+
+    /// The checks of every identifier on some frames
+    struct PlanResult {
+        /// [identifier][check]: the aggregate the check read, & whether it passed
+        std::vector<std::vector<float>> values;
+        std::vector<std::vector<char>> isPass;
+
+        /// The advice of the identifier's failed checks, one line each
+        std::string Suggest(const AnalyzerSpec &spec, int identifier) const;
+
+        /// Whether every check of the identifier passed
+        bool IsPass(int identifier) const;
+    };
+
+    /**
+     * The checks of all the identifiers of a spec compiled into one evaluation: every feature column any check
+     * reads is listed once, however many identifiers & checks read it, and Evaluate reads each of them in a single
+     * pass over the frames that computes min, max & sum together. The checks then only look their aggregate up.
+     * The cost grows with the distinct columns, not with the identifiers.
+     * Angle columns come from the whole-body features the classifier reads anyway; derivative columns
+     * (FeatureSchema::AddDerivativeColumns) are extracted together in one FeatureExtractor call.
+     */
+    class AnalysisPlan {
+    private:
+        /// One per distinct column: from the whole-body features (column index) or the derived ones (-1 - index)
+        std::vector<int> sources;
+        /// [identifier][check] -> index in sources, & the check itself
+        std::vector<std::vector<int>> check_slots;
+        std::vector<std::vector<CheckSpec>> checks;
+        FeatureSchema derived_schema;
+        bool isCompiled = false;
+
+    public:
+        /**
+         * Resolve every check's feature
+         * @param whole_body the schema of the features Evaluate gets
+         * @param bvh the clip's hierarchy, for the derivative features (may be nullptr if no check needs one)
+         * @return false (with a message) if a feature is neither a whole-body column nor a derivative of a joint
+         */
+        bool Compile(const AnalyzerSpec &spec, const FeatureSchema &whole_body, const BVH *bvh);
+
+        /**
+         * The derivative columns the checks read, over a whole clip: one extraction for every Evaluate of it
+         * @param motion, pose the snapshot the whole-body features were extracted from
+         * @return an empty matrix if no check reads a derivative
+         */
+        FeatureMatrix ExtractDerived(const BVH *bvh, const std::vector<double> &motion, const PoseBuffer &pose) const;
+
+        /**
+         * Evaluate every check on frames [range) of a clip
+         * @param derived ExtractDerived's matrix of the same clip
+         */
+        PlanResult Evaluate(const FeatureMatrix &whole_body, const FeatureMatrix &derived,
+                            const FrameRange &range) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        bool IsCompiled() const;
+
+        /// Distinct columns read by Evaluate
+        int GetNumColumn() const;
+
+        const FeatureSchema &GetDerivedSchema() const;
+    };
+
+    inline const std::string &IdentifierSpec::GetBone() const {
+        static const std::string none;
+        return targets.empty() ? none : targets[0];
+    }
+
+    inline bool AnalysisPlan::IsCompiled() const {
+        return isCompiled;
+    }
+
+    inline int AnalysisPlan::GetNumColumn() const {
+        return static_cast<int>(sources.size());
+    }
+
+    inline const FeatureSchema &AnalysisPlan::GetDerivedSchema() const {
+        return derived_schema;
+    }
+}
+
+#endif //TESTBED_ANALYZERSPEC_H
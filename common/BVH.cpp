@@ -4,6 +4,11 @@
 
 #include "BVH.h"
 
+// strtok keeps its position in a global, several clips may load at once
+#ifdef _WIN32
+#define strtok_r strtok_s
+#endif
+
 using namespace bvh;
 
 BVH::BVH() {
@@ -58,6 +63,7 @@ void BVH::Load(const char *bvh_file_name) {
     ifstream file;
     char line[BUFFER_LENGTH];
     char *token;
+    char *save_pointer = nullptr;
     char separater[] = " :,\t";
     vector<Joint *> joint_stack;
     Joint *joint = nullptr;
@@ -90,7 +96,7 @@ void BVH::Load(const char *bvh_file_name) {
             goto bvh_error;
 
         file.getline(line, BUFFER_LENGTH);
-        token = strtok(line, separater);
+        token = strtok_r(line, separater, &save_pointer);
 
         if (token == nullptr) continue;
 
@@ -125,7 +131,7 @@ void BVH::Load(const char *bvh_file_name) {
             if (joint)
                 joint->children.push_back(new_joint);
 
-            token = strtok(nullptr, "");
+            token = strtok_r(nullptr, "", &save_pointer);
             while (*token == ' ') token++;
             new_joint->name = token;
 
@@ -140,11 +146,11 @@ void BVH::Load(const char *bvh_file_name) {
         }
 
         if (strcmp(token, "OFFSET") == 0) {
-            token = strtok(nullptr, separater);
+            token = strtok_r(nullptr, separater, &save_pointer);
             x = token ? atof(token) : 0.0;
-            token = strtok(nullptr, separater);
+            token = strtok_r(nullptr, separater, &save_pointer);
             y = token ? atof(token) : 0.0;
-            token = strtok(nullptr, separater);
+            token = strtok_r(nullptr, separater, &save_pointer);
             z = token ? atof(token) : 0.0;
 
             if (is_site) {
@@ -161,7 +167,7 @@ void BVH::Load(const char *bvh_file_name) {
         }
 
         if (strcmp(token, "CHANNELS") == 0) {
-            token = strtok(nullptr, separater);
+            token = strtok_r(nullptr, separater, &save_pointer);
             joint->channels.resize(token ? atoi(token) : 0);
 
             rotationOrder.push_back(vector<ChannelEnum>());
@@ -172,7 +178,7 @@ void BVH::Load(const char *bvh_file_name) {
                 channels.push_back(channel);
                 joint->channels[i] = channel;
 
-                token = strtok(nullptr, separater);
+                token = strtok_r(nullptr, separater, &save_pointer);
                 if (strcmp(token, "Xrotation") == 0) {
                     channel->type = X_ROTATION;
                     rotationOrder.back().push_back(channel->type);
@@ -196,19 +202,19 @@ void BVH::Load(const char *bvh_file_name) {
     }
 
     file.getline(line, BUFFER_LENGTH);
-    token = strtok(line, separater);
+    token = strtok_r(line, separater, &save_pointer);
     if (strcmp(token, "Frames") != 0)
         goto bvh_error;
-    token = strtok(nullptr, separater);
+    token = strtok_r(nullptr, separater, &save_pointer);
     if (token == nullptr)
         goto bvh_error;
     num_frame = atoi(token);
 
     file.getline(line, BUFFER_LENGTH);
-    token = strtok(line, ":");
+    token = strtok_r(line, ":", &save_pointer);
     if (strcmp(token, "Frame Time") != 0)
         goto bvh_error;
-    token = strtok(nullptr, separater);
+    token = strtok_r(nullptr, separater, &save_pointer);
     if (token == nullptr)
         goto bvh_error;
     interval = atof(token);
@@ -219,12 +225,12 @@ void BVH::Load(const char *bvh_file_name) {
 
     for (i = 0; i < num_frame; i++) {
         file.getline(line, BUFFER_LENGTH);
-        token = strtok(line, separater);
+        token = strtok_r(line, separater, &save_pointer);
         for (j = 0; j < num_channel; j++) {
             if (token == nullptr)
                 goto bvh_error;
             motion->at(i * num_channel + j) = atof(token);
-            token = strtok(nullptr, separater);
+            token = strtok_r(nullptr, separater, &save_pointer);
         }
     }
 
@@ -119,13 +119,13 @@ namespace bvh {
 
         void SetMotion(int f, int c, double v);
 
-        vector<double> *GetModifiedMotions();
+        vector<double> *GetModifiedMotions() const;
 
         double GetModifiedMotion(int f, int c) const;
 
         glm::vec3 GetInitRootPos();
 
-        const vector<ChannelEnum> &GetRotationOrder(int index);
+        const vector<ChannelEnum> &GetRotationOrder(int index) const;
 
         const vector<glm::vec3> &GetCurrentFramePositions();
 
@@ -174,13 +174,13 @@ namespace bvh {
 
     inline void BVH::SetMotion(int f, int c, double v) { motion->at(f * num_channel + c) = v; }
 
-    inline vector<double> *BVH::GetModifiedMotions() { return modified_motion; }
+    inline vector<double> *BVH::GetModifiedMotions() const { return modified_motion; }
 
     inline double BVH::GetModifiedMotion(int f, int c) const {
         return modified_motion->at(f * num_channel + c);
     }
 
-    inline const vector<ChannelEnum> &BVH::GetRotationOrder(int index) {
+    inline const vector<ChannelEnum> &BVH::GetRotationOrder(int index) const {
         return rotationOrder[index];
     }
 
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+#include "BatchAnalysis.h"
+#include "BoneNames.h"
+#include "BVH.h"
+#include "ClassifierSession.h"
+#include "FeatureExtractor.h"
+#include "ForehandSuggestion.h"
+#include "MotionDerivatives.h"
+#include "OpenPoseData.h"
+#include "PoseBuffer.h"
+
+using namespace batchAnalysis;
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    double Milliseconds(Clock::time_point begin, Clock::time_point end) {
+        return std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+
+    std::string Trim(const std::string &text) {
+        const auto begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos)
+            return "";
+        return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+    }
+
+    /// Quoted csv field, the suggestion has commas & line breaks
+    std::string CsvField(const std::string &text) {
+        std::string field = "\"";
+        for (char c: text) {
+            if (c == '"')
+                field += "\"\"";
+            else if (c == '\n')
+                field += ' ';
+            else
+                field += c;
+        }
+        return field + "\"";
+    }
+}
+
+bool BatchAnalysis::ReadManifest(const std::string &filename, std::vector<BatchInput> &inputs) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cout << "Cannot open the manifest " << filename << std::endl;
+        return false;
+    }
+    const auto slash = filename.find_last_of("/\\");
+    const std::string directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+    const auto resolve = [&directory](const std::string &path) {
+        const bool is_absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || path.find(':') == 1);
+        return is_absolute ? path : directory + path;
+    };
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        line = Trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        const auto comma = line.find(',');
+        if (comma == std::string::npos) {
+            std::cout << filename << ":" << line_number << ": expected bvh_path,openpose_path" << std::endl;
+            return false;
+        }
+        inputs.push_back({resolve(Trim(line.substr(0, comma))), resolve(Trim(line.substr(comma + 1)))});
+    }
+    return true;
+}
+
+ClipResult BatchAnalysis::AnalyzeClip(const BatchInput &input) {
+    ClipResult result;
+    result.input = input;
+    const auto start = Clock::now();
+
+    BVH bvh(input.bvh_path.c_str());
+    OpenPoseData openpose;
+    if (!bvh.IsLoadSuccess()) {
+        result.error = "cannot load the bvh";
+        return result;
+    }
+    if (!openpose.Load(input.openpose_path)) {
+        result.error = "cannot load the openpose csv";
+        return result;
+    }
+    // The viewer fills the modified motion while the clip plays, here the clip is analyzed whole
+    auto *motion = bvh.GetMotions();
+    bvh.PushBackMotion(motion->begin(), motion->end());
+    // The features & the swing speed need these joints, a rig without one fails this clip only
+    for (const auto &joint_name: skeleton::TARGET_BONE_NAMES) {
+        if (bvh.GetJoint(joint_name) == nullptr) {
+            result.error = "no joint " + joint_name + " in the bvh";
+            return result;
+        }
+    }
+    const auto *hand_joint = bvh.GetJoint("rHand");
+    if (hand_joint == nullptr) {
+        result.error = "no joint rHand in the bvh";
+        return result;
+    }
+    const auto loaded = Clock::now();
+
+    // The angle features do not depend on where the skeleton stands
+    PoseBuffer pose;
+    pose.Build(&bvh, glm::vec3(0.0f));
+    const auto posed = Clock::now();
+
+    // The clips already run in parallel, one thread here
+    const int hand = hand_joint->index;
+    motionDerivatives::DerivativeBuffer derivatives;
+    derivatives.Build(pose, bvh.GetInterval(), {hand}, 1);
+    std::vector<float> magnitude(pose.GetNumFrame());
+    derivatives.GetMagnitude(motionDerivatives::VELOCITY, hand, magnitude.data());
+    result.swing_speed = magnitude.empty() ? 0 : *std::max_element(magnitude.begin(), magnitude.end());
+    derivatives.GetMagnitude(motionDerivatives::ANGULAR_VELOCITY, hand, magnitude.data());
+    result.wrist_snap = magnitude.empty() ? 0 : *std::max_element(magnitude.begin(), magnitude.end());
+    const auto differentiated = Clock::now();
+
+    const FeatureSchema schema(&bvh, skeleton::TARGET_BONE_NAMES, skeleton::TARGET_BONE_NAMES);
+    const FeatureMatrix features = FeatureExtractor::Extract(schema, &bvh, pose);
+    const auto extracted = Clock::now();
+
+    // Queued, the clips the other workers classify at the same time share its forward pass
+    try {
+        result.probabilities = classifierSession::ClassifierSession::Instance().PredictAsync(features, openpose).get();
+    } catch (const std::exception &error) {
+        result.error = std::string("classifier failed: ") + error.what();
+        return result;
+    }
+    const auto predicted = Clock::now();
+
+    for (const auto &identifier_name: {"rotation", "fore_arm"})
+        result.suggestion += forehandSuggestion::ForehandSuggestion::Suggest(identifier_name, result.probabilities);
+    if (!result.suggestion.empty())
+        result.suggestion.pop_back();
+    result.isSuccess = !result.probabilities.empty();
+    if (!result.isSuccess)
+        result.error = "no classifier output";
+
+    result.timings.load = Milliseconds(start, loaded);
+    result.timings.kinematics = Milliseconds(loaded, posed);
+    result.timings.derivatives = Milliseconds(posed, differentiated);
+    result.timings.features = Milliseconds(differentiated, extracted);
+    result.timings.inference = Milliseconds(extracted, predicted);
+    result.timings.total = Milliseconds(start, predicted);
+    return result;
+}
+
+std::vector<ClipResult> BatchAnalysis::Run(const std::vector<BatchInput> &inputs, int num_worker) {
+    if (num_worker <= 0)
+        num_worker = std::max(1u, std::thread::hardware_concurrency());
+    num_worker = std::min<int>(num_worker, std::max<size_t>(inputs.size(), 1));
+
+    // Load the model once before the workers race for it. A batch is complete once every worker queued its clip,
+    // it does not wait for more
+    auto &session = classifierSession::ClassifierSession::Instance();
+    if (!session.IsWarm()) {
+        inferenceQueue::QueueConfig queue_config;
+        queue_config.max_batch = num_worker;
+        session.SetQueueConfig(queue_config);
+    }
+    session.WarmUp();
+
+    // Clips differ in length, the workers take the next clip when they are free
+    std::vector<ClipResult> results(inputs.size());
+    std::atomic<size_t> next_clip{0};
+    const auto work = [&]() {
+        for (size_t clip = next_clip++; clip < inputs.size(); clip = next_clip++)
+            results[clip] = AnalyzeClip(inputs[clip]);
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_worker; i++)
+        workers.emplace_back(work);
+    work();
+    for (auto &worker: workers)
+        worker.join();
+    return results;
+}
+
+bool BatchAnalysis::WriteResults(const std::string &filename, const std::vector<ClipResult> &results) {
+    std::ofstream file(filename);
+    if (!file.is_open())
+        return false;
+
+    file << "bvh,openpose,status,p0,p1,p2,p3,p4,p5,suggestion,swing_speed,wrist_snap,load_ms,kinematics_ms,"
+         << "derivatives_ms,features_ms,inference_ms,total_ms\n";
+    for (const auto &result: results) {
+        file << CsvField(result.input.bvh_path) << "," << CsvField(result.input.openpose_path) << ","
+             << CsvField(result.isSuccess ? "ok" : result.error);
+        for (size_t i = 0; i < 6; i++) {
+            file << ",";
+            if (i < result.probabilities.size())
+                file << result.probabilities[i];
+        }
+        const auto &timings = result.timings;
+        file << "," << CsvField(result.suggestion) << "," << result.swing_speed << "," << result.wrist_snap << ","
+             << timings.load << "," << timings.kinematics << "," << timings.derivatives << "," << timings.features
+             << "," << timings.inference << "," << timings.total << "\n";
+    }
+    return true;
+}
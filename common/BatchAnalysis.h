@@ -0,0 +1,78 @@
+#ifndef TESTBED_BATCHANALYSIS_H
+#define TESTBED_BATCHANALYSIS_H
+
+#include <string>
+#include <vector>
+
+namespace batchAnalysis {
+
+    /// One clip of the manifest
+    struct BatchInput {
+        std::string bvh_path;
+        std::string openpose_path;
+    };
+
+    /// Wall-clock time of each stage of a clip (ms)
+    struct ClipTimings {
+        /// Parsing the BVH & the OpenPose csv
+        double load = 0;
+        /// Forward kinematics of every frame
+        double kinematics = 0;
+        /// Velocities & co of the racket arm
+        double derivatives = 0;
+        double features = 0;
+        double inference = 0;
+        double total = 0;
+    };
+
+    struct ClipResult {
+        BatchInput input;
+        bool isSuccess = false;
+        std::string error;
+        /// The classifier's 6-way output (0,1,2: rotation, 3,4,5: fore_arm)
+        std::vector<float> probabilities;
+        /// The advice the viewer shows, one line per identifier
+        std::string suggestion;
+        /// Peak speed of the right hand (BVH units / s)
+        float swing_speed = 0;
+        /// Peak angular speed of the right hand (degree / s)
+        float wrist_snap = 0;
+        ClipTimings timings;
+    };
+
+    /**
+     * The forehand analysis of the viewer (Analysizer) without a window: no skeleton, physics world or GL, the
+     * whole-body features come straight from the BVH and go to the process' ClassifierSession.
+     * Clips are independent, Run spreads them over worker threads; with the native classifier the workers'
+     * predictions are batched (ClassifierSession::PredictAsync), one forward pass for the clips classified together.
+     */
+    class BatchAnalysis {
+    public:
+        /**
+         * One clip per line: "bvh_path,openpose_path". Empty lines & lines starting with '#' are skipped,
+         * relative paths are taken relative to the manifest's directory.
+         * @return false (with a message) if the file cannot be read or a line has no openpose path
+         */
+        static bool ReadManifest(const std::string &filename, std::vector<BatchInput> &inputs);
+
+        /// Analyze one clip, a failure is reported in the result
+        static ClipResult AnalyzeClip(const BatchInput &input);
+
+        /**
+         * Analyze all the clips on num_worker threads (0: one per core)
+         * @return the results in manifest order
+         */
+        static std::vector<ClipResult> Run(const std::vector<BatchInput> &inputs, int num_worker);
+
+        /**
+         * Write the results as csv
+         * the Format is:
+         * bvh, openpose, status, p0, ..., p5, suggestion, swing_speed, wrist_snap, load_ms, kinematics_ms,
+         * derivatives_ms, features_ms, inference_ms, total_ms
+         * @return false if the file cannot be opened
+         */
+        static bool WriteResults(const std::string &filename, const std::vector<ClipResult> &results);
+    };
+}
+
+#endif //TESTBED_BATCHANALYSIS_H
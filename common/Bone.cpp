@@ -24,49 +24,15 @@ void Bone::SetJointRotation_local(rp3d::Vector3 &angle) {
 
 
 void Bone::SetJointRotation_local(rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ) {
-    auto q = AngleTool::rotate_local(angleX, angleY, angleZ, local_coordinate_quatern);
-    auto new_quatern = q * origin_quatern;
-
-    bone_object->setTransform({position, new_quatern});
+    bone_object->setTransform({position, GetJointRotation_local(angleX, angleY, angleZ)});
 }
 
-void Bone::UpdateChild(const rp3d::Quaternion &changedQuatern) {
-    for (auto &[key, cBone]: children) {
-        /// rotation
-        // add later
-
-        auto new_quatern = cBone->GetPhysicsObject()->getTransform().getOrientation();
-
-        /// translation
-        rp3d::Vector3 pos;
-        auto cObject = cBone->GetPhysicsObject();
-
-        // If the shape cBone is sphere, need offset
-        float offset = 0;
-        if (cBone->GetBoneType() == SPHERE) {
-            offset = ((Sphere *) cObject)->GetRadius();
-        }
-
-        switch (boneType) { // check parent boneType
-            case SPHERE:
-                pos = position + bone_object->getTransform().getOrientation() * default_orientation *
-                                 (((Sphere *) bone_object)->GetRadius() + offset);
-                break;
-            default:
-            case CONE:
-                pos = position + bone_object->getTransform().getOrientation() * default_orientation *
-                                 (((ConvexMesh *) bone_object)->GetSize().y + offset);
-        }
-
-        cBone->SetPosition(pos); // The position is for the object bone, not physic object
-        cBone->GetPhysicsObject()->setTransform(rp3d::Transform(pos, new_quatern));
-
-        // right now it is no good for manipulate skeleton. this is only for bvh
-        cBone->UpdateChild(rp3d::Quaternion::identity());
-    }
+rp3d::Quaternion Bone::GetJointRotation_local(rp3d::decimal angleX, rp3d::decimal angleY,
+                                              rp3d::decimal angleZ) const {
+    auto q = AngleTool::rotate_local_quatern(angleX, angleY, angleZ, local_coordinate_quatern);
+    return q * origin_quatern;
 }
 
-
 float Bone::AngleBetweenTwo(const rp3d::Vector3 &v1, const rp3d::Vector3 &v2) {
     auto angle = acos(v1.dot(v2));
     if (isnan(angle))
@@ -37,6 +37,8 @@ namespace bone {
         rp3d::Quaternion local_coordinate_quatern;
         Bone *parent;
         std::map<std::string, Bone *> children;
+        /// Length along the default orientation (cone) or radius (sphere)
+        float length = 0;
 
         std::list<PhysicsObject *> &mPhysicsObjects;
 
@@ -60,7 +62,9 @@ namespace bone {
 
         void SetJointRotation_local(rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ);
 
-        void UpdateChild(const rp3d::Quaternion &changedQuatern);
+        /// The orientation SetJointRotation_local gives, without setting it
+        rp3d::Quaternion GetJointRotation_local(rp3d::decimal angleX, rp3d::decimal angleY,
+                                                rp3d::decimal angleZ) const;
 
         std::map<std::string, float> GetAngleWithNeighbor();
 
@@ -73,8 +77,18 @@ namespace bone {
         map<string, float> GetAngleInfo();
 
         // -------------------- Getter & Setter -------------------- //
+        static const rp3d::Vector3 &GetDefaultOrientation();
+
         const std::string &GetBoneName();
 
+        Bone *GetParent() const;
+
+        const std::map<std::string, Bone *> &GetChildren() const;
+
+        float GetLength() const;
+
+        void SetLength(float length);
+
         PhysicsObject *GetPhysicsObject();
 
         rp3d::Vector3 &GetPosition();
@@ -104,10 +118,30 @@ namespace bone {
         children[child->bone_name] = child;
     };
 
+    inline const rp3d::Vector3 &Bone::GetDefaultOrientation() {
+        return default_orientation;
+    }
+
     inline const std::string &Bone::GetBoneName() {
         return bone_name;
     }
 
+    inline Bone *Bone::GetParent() const {
+        return parent;
+    }
+
+    inline const std::map<std::string, Bone *> &Bone::GetChildren() const {
+        return children;
+    }
+
+    inline float Bone::GetLength() const {
+        return length;
+    }
+
+    inline void Bone::SetLength(float length) {
+        this->length = length;
+    }
+
     inline PhysicsObject *Bone::GetPhysicsObject() {
         return bone_object;
     };
@@ -0,0 +1,20 @@
+#ifndef TESTBED_BONENAMES_H
+#define TESTBED_BONENAMES_H
+
+#include <string>
+#include <vector>
+
+/// Scale from BVH units to the scene
+#define SCALE 0.1f
+
+namespace skeleton {
+
+    /// The joints of the BVH that are shown & analyzed as bones, parents come before their children
+    inline const std::vector<std::string> TARGET_BONE_NAMES{"hip", "abdomen", "chest", "neck", "neck1", "head",
+                                                            "rCollar", "rShldr", "rForeArm", "rHand", "lCollar",
+                                                            "lShldr", "lForeArm", "lHand", "rButtock", "rThigh",
+                                                            "rShin", "rFoot", "lButtock", "lThigh", "lShin",
+                                                            "lFoot"};
+}
+
+#endif //TESTBED_BONENAMES_H
@@ -0,0 +1,201 @@
+#include <chrono>
+#include <fstream>
+#include <iterator>
+
+#include <pybind11/stl.h>
+#include <pybind11/numpy.h>
+
+#include "ClassifierSession.h"
+#include "ResultCache.h"
+
+using namespace classifierSession;
+
+namespace {
+    /**
+     * A read-only (num_frame, num_column) NumPy view of a column-major float matrix, pandas takes it without a copy.
+     * The no-op capsule as base keeps pybind11 from copying (and from freeing) the data.
+     * @param column_stride the number of frames of the whole matrix when viewing a part of its frames
+     */
+    py::array ColumnMajorView(const float *data, int num_frame, int num_column, int column_stride) {
+        const py::ssize_t item_size = sizeof(float);
+        py::array_t<float> view({static_cast<py::ssize_t>(num_frame), static_cast<py::ssize_t>(num_column)},
+                                {item_size, item_size * column_stride}, data, py::capsule(data, [](void *) {}));
+        view.attr("setflags")(py::arg("write") = false);
+        return view;
+    }
+
+    py::list ColumnNames(const FeatureSchema &schema) {
+        py::list names;
+        for (const auto &column: schema.GetColumns())
+            names.append(column.name);
+        return names;
+    }
+}
+
+ClassifierSession &ClassifierSession::Instance() {
+    // Leaked on purpose: destroying it after py::finalize_interpreter would release Python objects without Python
+    static auto *instance = new ClassifierSession();
+    return *instance;
+}
+
+void ClassifierSession::WarmUp() {
+    std::lock_guard<std::shared_mutex> lock(mutex);
+    LoadModel();
+}
+
+void ClassifierSession::LoadModel() {
+    if (IsWarm())
+        return;
+
+    // The native engine needs no Python at all, the Python classifier stays the reference
+    if (std::ifstream(native_model_path).good()) {
+        auto start = std::chrono::high_resolution_clock::now();
+        is_native = native_model.Load(native_model_path);
+        auto end = std::chrono::high_resolution_clock::now();
+        metrics.warm_up_time = 0;
+        metrics.model_load_time = std::chrono::duration<double, std::milli>(end - start).count();
+        if (is_native) {
+            std::ifstream model_file(native_model_path, std::ios::binary);
+            resultCache::ContentHash hash;
+            hash.Add(std::string(std::istreambuf_iterator<char>(model_file), std::istreambuf_iterator<char>()));
+            native_model_hash = hash.GetHex();
+            batch_queue = std::make_unique<inferenceQueue::InferenceQueue>(
+                    [this](const std::vector<const float *> &inputs, const std::vector<int> &num_frames) {
+                        return PredictBatch(inputs, num_frames);
+                    }, queue_config);
+            return;
+        }
+    }
+
+    py::gil_scoped_acquire acquire;
+    auto start = std::chrono::high_resolution_clock::now();
+    py::module_ PyAnalysizer = py::module_::import("Py_package.PyAnalysizer.Analysize");
+    py::object loaded_session = PyAnalysizer.attr("ForehandSession")();
+    auto imported = std::chrono::high_resolution_clock::now();
+    loaded_session.attr("Load")();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    session = loaded_session;
+    metrics.warm_up_time = std::chrono::duration<double, std::milli>(imported - start).count();
+    metrics.model_load_time = std::chrono::duration<double, std::milli>(end - imported).count();
+}
+
+std::vector<float> ClassifierSession::Predict(const FeatureMatrix &angles, const OpenPoseData &openpose,
+                                             const FrameRange &range) {
+    {
+        std::lock_guard<std::shared_mutex> lock(mutex);
+        LoadModel();
+        if (is_native)
+            native_model.SetPrecision(precision);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<float> prob_result;
+    if (is_native) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        std::vector<float> input;
+        int num_frame;
+        if (native_model.BuildInput(angles, openpose, input, num_frame, range))
+            prob_result = native_model.Predict(input.data(), num_frame);
+    } else {
+        const FrameRange angle_range = range.Clamp(angles.GetNumFrame());
+        const FrameRange openpose_range = angle_range.Rescale(angles.GetNumFrame(), openpose.GetNumFrame());
+        std::lock_guard<std::shared_mutex> lock(mutex);
+        py::gil_scoped_acquire acquire;
+        py::object result = session.attr("Predict")(
+                ColumnMajorView(openpose.GetData().data() + openpose_range.begin, openpose_range.GetNumFrame(),
+                                openpose.GetNumColumn(), openpose.GetNumFrame()),
+                openpose.GetColumnNames(),
+                ColumnMajorView(angles.GetData().data() + angle_range.begin, angle_range.GetNumFrame(),
+                                angles.GetNumColumn(), angles.GetNumFrame()),
+                ColumnNames(angles.GetSchema()));
+        prob_result = result.cast<std::vector<float>>();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::lock_guard<std::shared_mutex> lock(mutex);
+    metrics.last_inference_time = std::chrono::duration<double, std::milli>(end - start).count();
+    metrics.total_inference_time += metrics.last_inference_time;
+    metrics.num_inference++;
+    return prob_result;
+}
+
+std::future<std::vector<float>> ClassifierSession::PredictAsync(const FeatureMatrix &angles,
+                                                                const OpenPoseData &openpose,
+                                                                const FrameRange &range) {
+    // A model or Python error reaches the future's reader, like the batch's
+    bool isQueued;
+    try {
+        std::lock_guard<std::shared_mutex> lock(mutex);
+        LoadModel();
+        isQueued = is_native;
+    } catch (...) {
+        std::promise<std::vector<float>> prob_result;
+        prob_result.set_exception(std::current_exception());
+        return prob_result.get_future();
+    }
+    if (!isQueued) {
+        std::promise<std::vector<float>> prob_result;
+        try {
+            prob_result.set_value(Predict(angles, openpose, range));
+        } catch (...) {
+            prob_result.set_exception(std::current_exception());
+        }
+        return prob_result.get_future();
+    }
+
+    // The input is the request's own copy, the clip may be gone before its batch runs
+    std::vector<float> input;
+    int num_frame;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (!native_model.BuildInput(angles, openpose, input, num_frame, range)) {
+            std::promise<std::vector<float>> prob_result;
+            prob_result.set_value({});
+            return prob_result.get_future();
+        }
+    }
+    return batch_queue->Submit(std::move(input), num_frame);
+}
+
+std::vector<float> ClassifierSession::PredictBatch(const std::vector<const float *> &inputs,
+                                                   const std::vector<int> &num_frames) {
+    {
+        std::lock_guard<std::shared_mutex> lock(mutex);
+        native_model.SetPrecision(precision);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<float> prob_result;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        prob_result = native_model.PredictBatch(inputs, num_frames);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::lock_guard<std::shared_mutex> lock(mutex);
+    metrics.last_inference_time = std::chrono::duration<double, std::milli>(end - start).count();
+    metrics.total_inference_time += metrics.last_inference_time;
+    metrics.num_inference += static_cast<int>(inputs.size());
+    return prob_result;
+}
+
+SessionMetrics ClassifierSession::GetMetrics() {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return metrics;
+}
+
+inferenceQueue::QueueStats ClassifierSession::GetQueueStats() {
+    std::lock_guard<std::shared_mutex> lock(mutex);
+    return batch_queue != nullptr ? batch_queue->GetStats() : inferenceQueue::QueueStats();
+}
+
+std::string ClassifierSession::GetModelVersion() {
+    std::lock_guard<std::shared_mutex> lock(mutex);
+    LoadModel();
+    if (is_native)
+        return "native:" + native_model_hash + ":" + PrecisionName(precision);
+
+    py::gil_scoped_acquire acquire;
+    return "python:" + session.attr("Version")().cast<std::string>();
+}
@@ -0,0 +1,162 @@
+#ifndef TESTBED_CLASSIFIERSESSION_H
+#define TESTBED_CLASSIFIERSESSION_H
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include <pybind11/embed.h>
+
+#include "FeatureExtractor.h"
+#include "OpenPoseData.h"
+#include "LstmEngine.h"
+#include "InferenceQueue.h"
+
+using namespace featureExtractor;
+using namespace openPoseData;
+using namespace lstmEngine;
+namespace py = pybind11;
+
+namespace classifierSession {
+
+    /// Latency of the session (ms)
+    struct SessionMetrics {
+        /// Importing Analysize (and with it torch & the classifier package), once. 0 for the native engine
+        double warm_up_time = 0;
+        /// Loading the checkpoint, once
+        double model_load_time = 0;
+        /// One Predict call, inputs handed over included, or one batch of the queue (PredictAsync)
+        double last_inference_time = 0;
+        double total_inference_time = 0;
+        int num_inference = 0;
+    };
+
+    /**
+     * The long-lived forehand classifier of the process.
+     * The model is loaded once, every prediction after that only runs the forward pass. One prediction gives the
+     * 6-way output read by all the forehand identifiers.
+     * If the exported weights (ExportLstm.py) are at the native model path, the native LstmModel runs the
+     * classifier without Python. Otherwise the Python module is imported and the checkpoint loaded once
+     * (Analysize.ForehandSession).
+     * The session is never destroyed: its Python objects must not outlive the interpreter's finalization.
+     * Thread-safe: the Python path takes the GIL itself, the caller must not hold it. Native predictions from
+     * several threads run in parallel.
+     * Many clips (a batch run, the strokes of a session) go through PredictAsync: the native predictions are
+     * batched by an InferenceQueue, one forward pass for up to max_batch clips instead of one each.
+     */
+    class ClassifierSession {
+    private:
+        py::object session;
+        SessionMetrics metrics;
+
+        std::string native_model_path = "static/forehand_lstm.bin";
+        LstmModel native_model;
+        std::atomic<bool> is_native{false};
+        /// Content hash of the exported weights, read once at load
+        std::string native_model_hash;
+        /// Applied to native_model by the next Predict, so the GUI never waits for a running prediction
+        std::atomic<Precision> precision{FP32};
+
+        /// Loading, repacking & the Python path are exclusive, native predictions run concurrently (shared)
+        std::shared_mutex mutex;
+
+        /// The native predictions of PredictAsync, created with the native model
+        inferenceQueue::QueueConfig queue_config;
+        std::unique_ptr<inferenceQueue::InferenceQueue> batch_queue;
+
+        ClassifierSession() = default;
+
+        /// WarmUp with the mutex held
+        void LoadModel();
+
+        /// One forward pass of batch_queue, on its worker
+        std::vector<float> PredictBatch(const std::vector<const float *> &inputs, const std::vector<int> &num_frames);
+
+    public:
+        static ClassifierSession &Instance();
+
+        ClassifierSession(const ClassifierSession &) = delete;
+
+        ClassifierSession &operator=(const ClassifierSession &) = delete;
+
+        /// Load the model (native or Python) if not done yet, Predict does it on the first call
+        void WarmUp();
+
+        /**
+         * Probabilities of the forehand classes (0,1,2: rotation, 3,4,5: fore_arm)
+         * @param angles the features of the whole body
+         * @param range the frames of the clip to classify (e.g. one stroke), read in place
+         */
+        std::vector<float> Predict(const FeatureMatrix &angles, const OpenPoseData &openpose,
+                                   const FrameRange &range = FrameRange());
+
+        /**
+         * Same, batched with the other pending predictions: the input is built now (angles & openpose may go once
+         * it returns), the output comes when its batch ran, at most QueueConfig::max_wait after a lone request.
+         * The Python classifier predicts at once, its future is ready when it returns. A failure (loading, Python) is
+         * the future's exception, get() rethrows it.
+         */
+        std::future<std::vector<float>> PredictAsync(const FeatureMatrix &angles, const OpenPoseData &openpose,
+                                                     const FrameRange &range = FrameRange());
+
+        /**
+         * Identifies the model the predictions come from (loads it if needed): the native weights' content hash
+         * with the precision, or the Python checkpoint's path, size & modification time.
+         * Part of the result cache key, a retrained or re-exported model never hits an older entry.
+         */
+        std::string GetModelVersion();
+
+        // -------------------- Getter & Setter -------------------- //
+        bool IsWarm() const;
+
+        /// Whether the predictions come from the native engine
+        bool IsNative() const;
+
+        /// Where WarmUp looks for the exported weights, only effective before the session is warm
+        void SetNativeModelPath(const std::string &native_model_path);
+
+        /// Weight storage of the native engine, can change at any time and applies from the next prediction
+        void SetPrecision(Precision precision);
+
+        Precision GetPrecision() const;
+
+        /// A copy, the predictions update them from their own threads
+        SessionMetrics GetMetrics();
+
+        /// Batch size & wait of PredictAsync, only effective before the session is warm
+        void SetQueueConfig(const inferenceQueue::QueueConfig &queue_config);
+
+        /// What the batching did so far, zero with the Python classifier
+        inferenceQueue::QueueStats GetQueueStats();
+    };
+
+    inline bool ClassifierSession::IsWarm() const {
+        return is_native || static_cast<bool>(session);
+    }
+
+    inline bool ClassifierSession::IsNative() const {
+        return is_native;
+    }
+
+    inline void ClassifierSession::SetNativeModelPath(const std::string &native_model_path) {
+        this->native_model_path = native_model_path;
+    }
+
+    inline void ClassifierSession::SetPrecision(Precision precision) {
+        this->precision = precision;
+    }
+
+    inline Precision ClassifierSession::GetPrecision() const {
+        return precision;
+    }
+
+    inline void ClassifierSession::SetQueueConfig(const inferenceQueue::QueueConfig &queue_config) {
+        this->queue_config = queue_config;
+    }
+}
+
+#endif //TESTBED_CLASSIFIERSESSION_H
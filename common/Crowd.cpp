@@ -0,0 +1,237 @@
+#include <chrono>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Crowd.h"
+
+using namespace crowd;
+
+Crowd::Crowd(rp3d::PhysicsCommon &mPhysicsCommon, rp3d::PhysicsWorld *mPhysicsWorld,
+             const std::string &mMeshFolderPath, size_t num_thread)
+        : mPhysicsCommon(mPhysicsCommon), mPhysicsWorld(mPhysicsWorld), thread_pool(num_thread) {
+    cone_mesh = new InstancedMesh(mMeshFolderPath + "cone_offset.obj", {objectColor, pickedColor});
+    sphere_mesh = new InstancedMesh(mMeshFolderPath + "sphere.obj", {objectColor, pickedColor});
+}
+
+Crowd::~Crowd() {
+    DestroyPickBodies();
+
+    delete cone_mesh;
+    delete sphere_mesh;
+
+    for (auto &clip: clips)
+        delete clip.bvh;
+}
+
+int Crowd::LoadClip(const std::string &bvh_path) {
+    auto found = clip_index.find(bvh_path);
+    if (found != clip_index.end())
+        return found->second;
+
+    auto bvh = new BVH(bvh_path.c_str());
+    if (!bvh->IsLoadSuccess()) {
+        std::cout << "Cannot load the crowd clip " << bvh_path << std::endl;
+        delete bvh;
+        return -1;
+    }
+
+    CrowdClip clip{bvh};
+    for (const auto &bone_name: TARGET_BONE_NAMES) {
+        auto joint = bvh->GetJoint(bone_name);
+        if (joint == nullptr) {
+            std::cout << "No joint " << bone_name << " in the crowd clip " << bvh_path << std::endl;
+            delete bvh;
+            return -1;
+        }
+        // Same bone length as Skeleton
+        float length = glm::length(glm::vec3{joint->offset[0], joint->offset[1], joint->offset[2]});
+        if (length == 0)
+            length = 0.1;
+        clip.bone_joints.push_back(joint->index);
+        clip.bone_lengths.push_back(length * SCALE);
+    }
+    bvh->SetPositionScale(SCALE);
+    // The members play the modified motion, nothing fills it while the crowd plays
+    auto *motion = bvh->GetMotions();
+    bvh->PushBackMotion(motion->begin(), motion->end());
+    if (bvh->GetNumModifiedFrame() == 0) {
+        std::cout << "No frame in the crowd clip " << bvh_path << std::endl;
+        delete bvh;
+        return -1;
+    }
+
+    clips.push_back(clip);
+    clip_index[bvh_path] = clips.size() - 1;
+    return clips.size() - 1;
+}
+
+int Crowd::AddMember(const std::string &bvh_path, const rp3d::Vector3 &position) {
+    int clip = LoadClip(bvh_path);
+    if (clip < 0)
+        return -1;
+
+    if (is_picking_enabled)
+        DestroyPickBodies();
+
+    CrowdMember member;
+    member.clip = clip;
+    member.position = position;
+    members.push_back(member);
+
+    cone_matrices.resize(members.size() * (num_bone - 1));
+    cone_colors.resize(members.size() * (num_bone - 1), OBJECT_COLOR);
+    sphere_matrices.resize(members.size());
+    sphere_colors.resize(members.size(), OBJECT_COLOR);
+
+    if (is_picking_enabled)
+        CreatePickBodies();
+
+    return members.size() - 1;
+}
+
+void Crowd::NextBvhMotion() {
+    for (auto &member: members)
+        member.frame = (member.frame + 1) % clips[member.clip].bvh->GetNumModifiedFrame();
+    UpdateInstances();
+}
+
+void Crowd::ApplyBvhMotion(int frame) {
+    for (auto &member: members)
+        member.frame = frame % clips[member.clip].bvh->GetNumModifiedFrame();
+    UpdateInstances();
+}
+
+void Crowd::UpdateInstances() {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Members are independent, every thread writes its own members' instances only
+    thread_pool.ParallelFor(0, members.size(), [this](size_t begin, size_t end) {
+        for (size_t m = begin; m < end; m++) {
+            auto &member = members[m];
+            const auto &clip = clips[member.clip];
+            member.pose.BuildFrame(clip.bvh, member.frame,
+                                   glm::vec3(member.position.x, member.position.y, member.position.z));
+
+            for (int b = 0; b < num_bone; b++) {
+                const int joint = clip.bone_joints[b];
+                auto q = member.pose.GetOrientation(joint, 0);
+                glm::mat4 matrix = glm::translate(glm::mat4(1.0f), member.pose.GetPosition(joint, 0)) *
+                                   glm::mat4_cast(glm::quat(q.w, q.x, q.y, q.z));
+                if (b == 0)
+                    sphere_matrices[m] = glm::scale(matrix, glm::vec3(hip_radius));
+                else
+                    cone_matrices[m * (num_bone - 1) + b - 1] =
+                            glm::scale(matrix, glm::vec3(bone_width, clip.bone_lengths[b], bone_width));
+            }
+        }
+    });
+
+    auto fk_end = std::chrono::high_resolution_clock::now();
+
+    cone_mesh->SetInstances(cone_matrices, cone_colors);
+    sphere_mesh->SetInstances(sphere_matrices, sphere_colors);
+
+    // rp3d is not thread safe, the bodies are moved here
+    if (is_picking_enabled) {
+        for (size_t m = 0; m < members.size(); m++) {
+            const auto &member = members[m];
+            const auto &clip = clips[member.clip];
+            for (int b = 0; b < num_bone; b++) {
+                const int joint = clip.bone_joints[b];
+                auto position = member.pose.GetPosition(joint, 0);
+                pick_bodies[m * num_bone + b]->setTransform(
+                        {{position.x, position.y, position.z}, member.pose.GetOrientation(joint, 0)});
+            }
+        }
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    last_fk_time = std::chrono::duration<double, std::milli>(fk_end - start).count();
+    last_upload_time = std::chrono::duration<double, std::milli>(end - fk_end).count();
+}
+
+void Crowd::render(openglframework::Shader &shader, const openglframework::Matrix4 &worldToCameraMatrix) {
+    cone_mesh->render(shader, worldToCameraMatrix);
+    sphere_mesh->render(shader, worldToCameraMatrix);
+}
+
+void Crowd::SetPickingEnabled(bool enabled) {
+    if (enabled == is_picking_enabled)
+        return;
+    is_picking_enabled = enabled;
+    if (enabled) {
+        CreatePickBodies();
+        UpdateInstances();
+    } else {
+        DestroyPickBodies();
+    }
+}
+
+void Crowd::CreatePickBodies() {
+    for (const auto &clip: clips) {
+        for (int b = 0; b < num_bone; b++) {
+            if (b == 0)
+                pick_shapes.push_back(mPhysicsCommon.createSphereShape(hip_radius));
+            else
+                pick_shapes.push_back(mPhysicsCommon.createBoxShape(
+                        {bone_width * 0.5f, clip.bone_lengths[b] * 0.5f, bone_width * 0.5f}));
+        }
+    }
+
+    for (size_t m = 0; m < members.size(); m++) {
+        const auto &clip = clips[members[m].clip];
+        for (int b = 0; b < num_bone; b++) {
+            auto body = mPhysicsWorld->createCollisionBody(rp3d::Transform::identity());
+            // The cone mesh starts at the joint and goes along +y
+            rp3d::Vector3 shape_center(0, b == 0 ? 0 : clip.bone_lengths[b] * 0.5f, 0);
+            body->addCollider(pick_shapes[members[m].clip * num_bone + b],
+                              rp3d::Transform(shape_center, rp3d::Quaternion::identity()));
+            pick_bodies.push_back(body);
+            pick_instance[body] = m * num_bone + b;
+        }
+    }
+}
+
+void Crowd::DestroyPickBodies() {
+    for (auto body: pick_bodies)
+        mPhysicsWorld->destroyCollisionBody(body);
+    pick_bodies.clear();
+    pick_instance.clear();
+
+    for (auto shape: pick_shapes) {
+        if (shape->getName() == rp3d::CollisionShapeName::SPHERE)
+            mPhysicsCommon.destroySphereShape(static_cast<rp3d::SphereShape *>(shape));
+        else
+            mPhysicsCommon.destroyBoxShape(static_cast<rp3d::BoxShape *>(shape));
+    }
+    pick_shapes.clear();
+}
+
+bool Crowd::Pick(rp3d::CollisionBody *body) {
+    auto found = pick_instance.find(body);
+    if (found == pick_instance.end())
+        return false;
+
+    const auto set_color = [this](int instance, int color) {
+        const int member = instance / num_bone, bone = instance % num_bone;
+        if (bone == 0)
+            sphere_colors[member] = color;
+        else
+            cone_colors[member * (num_bone - 1) + bone - 1] = color;
+    };
+    if (picked_instance >= 0)
+        set_color(picked_instance, OBJECT_COLOR);
+    picked_instance = found->second;
+    set_color(picked_instance, PICKED_COLOR);
+
+    cone_mesh->SetInstances(cone_matrices, cone_colors);
+    sphere_mesh->SetInstances(sphere_matrices, sphere_colors);
+    return true;
+}
+
+void Crowd::GetPicked(int &member, std::string &bone_name) const {
+    member = picked_instance < 0 ? -1 : picked_instance / num_bone;
+    bone_name = picked_instance < 0 ? "" : TARGET_BONE_NAMES[picked_instance % num_bone];
+}
@@ -0,0 +1,174 @@
+#ifndef TESTBED_CROWD_H
+#define TESTBED_CROWD_H
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <reactphysics3d/reactphysics3d.h>
+#include <glm/glm.hpp>
+
+#include "openglframework.h"
+#include "BVH.h"
+#include "BoneNames.h"
+#include "PoseBuffer.h"
+#include "InstancedMesh.h"
+#include "ThreadPool.h"
+
+using namespace bvh;
+using namespace poseBuffer;
+using namespace instancedMesh;
+
+namespace crowd {
+
+    /// A loaded clip with the joint index & length of every bone, shared by the members playing it
+    struct CrowdClip {
+        BVH *bvh;
+        std::vector<int> bone_joints;
+        std::vector<float> bone_lengths;
+    };
+
+    struct CrowdMember {
+        int clip;
+        rp3d::Vector3 position;
+        int frame = 0;
+        /// The forward kinematics of the current frame
+        PoseBuffer pose;
+    };
+
+    /**
+     * Many skeletons, each playing its own clip, for reviewing a whole class side by side.
+     * Unlike Skeleton, the bones are no PhysicsObject: the forward kinematics of the members runs in parallel
+     * on a thread pool and the bones are drawn instanced (one draw call per mesh & color, whatever the
+     * number of members). Collision bodies for picking exist only while picking is enabled.
+     */
+    class Crowd {
+    private:
+        // -------------------- Attributes -------------------- //
+        rp3d::PhysicsCommon &mPhysicsCommon;
+        rp3d::PhysicsWorld *mPhysicsWorld;
+
+        threadPool::ThreadPool thread_pool;
+
+        std::vector<CrowdClip> clips;
+        std::map<std::string, int> clip_index;
+        std::vector<CrowdMember> members;
+
+        /// Same shapes & colors as Skeleton
+        const float hip_radius = 0.2f;
+        const float bone_width = 0.15f;
+        openglframework::Color objectColor = openglframework::Color(0.0f, 0.68f, 0.99f, 1.0f);
+        openglframework::Color pickedColor = openglframework::Color(1.0f, 0.918f, 0.0f, 1.0f);
+        enum ColorIndex {
+            OBJECT_COLOR, PICKED_COLOR
+        };
+
+        /// Bone b of member m is instance m * num_bone + b, bone 0 (the hip) is a sphere, the others are cones
+        const int num_bone = TARGET_BONE_NAMES.size();
+        InstancedMesh *cone_mesh;
+        InstancedMesh *sphere_mesh;
+        std::vector<glm::mat4> cone_matrices, sphere_matrices;
+        std::vector<int> cone_colors, sphere_colors;
+        int picked_instance = -1;
+
+        /// Picking
+        bool is_picking_enabled = false;
+        std::vector<rp3d::CollisionBody *> pick_bodies;
+        std::unordered_map<rp3d::CollisionBody *, int> pick_instance;
+        /// Shape of bone b of clip c at c * num_bone + b
+        std::vector<rp3d::CollisionShape *> pick_shapes;
+
+        /// Timing of the last update (ms)
+        double last_fk_time = 0;
+        double last_upload_time = 0;
+
+        // -------------------- Methods -------------------- //
+        int LoadClip(const std::string &bvh_path);
+
+        void UpdateInstances();
+
+        void CreatePickBodies();
+
+        void DestroyPickBodies();
+
+    public:
+        /**
+         * @param num_thread threads of the forward kinematics, 0 means one per hardware thread
+         */
+        Crowd(rp3d::PhysicsCommon &mPhysicsCommon, rp3d::PhysicsWorld *mPhysicsWorld, const std::string &mMeshFolderPath,
+              size_t num_thread = 0);
+
+        ~Crowd();
+
+        /**
+         * Add a skeleton playing the clip, the clip is only loaded once for all its members.
+         * The pose is computed by the next NextBvhMotion / ApplyBvhMotion, so adding many members stays O(n)
+         * @return the member index, -1 if the clip cannot be loaded
+         */
+        int AddMember(const std::string &bvh_path, const rp3d::Vector3 &position);
+
+        /// Move every member to the next frame of its clip
+        void NextBvhMotion();
+
+        /// Move every member to the frame and recompute the poses
+        void ApplyBvhMotion(int frame);
+
+        /// Draw all the bones, one instanced draw call per mesh and color
+        void render(openglframework::Shader &shader, const openglframework::Matrix4 &worldToCameraMatrix);
+
+        /**
+         * Create (or destroy) a collision body per bone so the bones can be raycasted.
+         * The bodies are kept in sync with the poses only while enabled.
+         */
+        void SetPickingEnabled(bool enabled);
+
+        /**
+         * Highlight the bone of the body if it belongs to the crowd
+         * @return false if the body is not a bone of the crowd
+         */
+        bool Pick(rp3d::CollisionBody *body);
+
+        // -------------------- Getter & Setter -------------------- //
+        int GetNumMember() const;
+
+        const CrowdMember &GetMember(int member) const;
+
+        bool IsPickingEnabled() const;
+
+        /// Member & bone name of the highlighted bone, member is -1 if none
+        void GetPicked(int &member, std::string &bone_name) const;
+
+        double GetLastFkTime() const;
+
+        double GetLastUploadTime() const;
+
+        int GetNumDrawCall() const;
+    };
+
+    inline int Crowd::GetNumMember() const {
+        return members.size();
+    }
+
+    inline const CrowdMember &Crowd::GetMember(int member) const {
+        return members[member];
+    }
+
+    inline bool Crowd::IsPickingEnabled() const {
+        return is_picking_enabled;
+    }
+
+    inline double Crowd::GetLastFkTime() const {
+        return last_fk_time;
+    }
+
+    inline double Crowd::GetLastUploadTime() const {
+        return last_upload_time;
+    }
+
+    inline int Crowd::GetNumDrawCall() const {
+        return cone_mesh->GetNumDrawCall() + sphere_mesh->GetNumDrawCall();
+    }
+}
+
+#endif //TESTBED_CROWD_H
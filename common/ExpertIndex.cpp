@@ -0,0 +1,442 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <thread>
+
+#include "ExpertIndex.h"
+#include "BoneNames.h"
+#include "PoseBuffer.h"
+#include "Similarity.h"
+
+using namespace expertIndex;
+using similarity::Similarity;
+using strokeSegmenter::StrokeSegment;
+using strokeSegmenter::StrokeSegmenter;
+
+namespace {
+    /**
+     * The file: magic, then int32 embedding_frames, radius, num_column, num_clip, num_entry, then the column names,
+     * the clips' bvh & video paths (uint32 length + bytes each), the entries (int32 clip, begin, end), zero padding
+     * to a multiple of float_alignment bytes, and finally the float arrays embeddings, upper & lower
+     * (num_entry x embedding size each). Native byte order.
+     */
+    const char index_magic[8] = {'T', 'B', 'E', 'X', 'P', 'I', 'X', '1'};
+    const size_t float_alignment = 64;
+
+    template<typename T>
+    void Write(std::ofstream &file, const T &value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void WriteString(std::ofstream &file, const std::string &text) {
+        Write<uint32_t>(file, text.size());
+        file.write(text.data(), text.size());
+    }
+
+    /// Reads the header of a mapped index, every read is checked against the end of the file
+    class HeaderReader {
+    private:
+        const char *cursor;
+        const char *end;
+
+    public:
+        HeaderReader(const char *begin, const char *end) : cursor(begin), end(end) {}
+
+        template<typename T>
+        bool Read(T &value) {
+            if (static_cast<size_t>(end - cursor) < sizeof(T))
+                return false;
+            std::memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return true;
+        }
+
+        bool ReadString(std::string &text) {
+            uint32_t length;
+            if (!Read(length) || static_cast<size_t>(end - cursor) < length)
+                return false;
+            text.assign(cursor, length);
+            cursor += length;
+            return true;
+        }
+
+        const char *GetCursor() const {
+            return cursor;
+        }
+    };
+
+    std::string Trim(const std::string &text) {
+        const auto begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string::npos)
+            return "";
+        return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+    }
+
+    const int num_lane = 8;
+    /// Elements summed between two checks of the bound
+    const int check_interval = 32 * num_lane;
+
+    /**
+     * LB_Keogh: the squared distance from the series to the envelope, zero inside it. Every frame of the series
+     * is on the DTW path at least once, against a frame within the band, so it is a lower bound of the squared DTW.
+     * The sum runs in num_lane independent lanes so that the compiler vectorizes it, and stops once it exceeds bound.
+     */
+    float LbKeogh(const float *__restrict series, const float *__restrict upper_envelope,
+                  const float *__restrict lower_envelope, int size, float bound) {
+        float lanes[num_lane] = {};
+        float sum = 0;
+        int i = 0;
+        while (i + num_lane <= size && sum <= bound) {
+            const int block_end = std::min(i + check_interval, size - size % num_lane);
+            for (; i < block_end; i += num_lane) {
+                for (int l = 0; l < num_lane; l++) {
+                    const float above = std::max(series[i + l] - upper_envelope[i + l], 0.0f);
+                    const float below = std::max(lower_envelope[i + l] - series[i + l], 0.0f);
+                    lanes[l] += above * above + below * below;
+                }
+            }
+            sum = 0;
+            for (float lane: lanes)
+                sum += lane;
+        }
+        for (; i < size && sum <= bound; i++) {
+            const float above = std::max(series[i] - upper_envelope[i], 0.0f);
+            const float below = std::max(lower_envelope[i] - series[i], 0.0f);
+            sum += above * above + below * below;
+        }
+        return sum;
+    }
+
+    /// Keeps the k smallest distances, sorted
+    void InsertMatch(std::vector<ExpertMatch> &matches, int k, const ExpertMatch &match) {
+        if (static_cast<int>(matches.size()) == k && match.distance >= matches.back().distance)
+            return;
+        auto position = std::upper_bound(matches.begin(), matches.end(), match,
+                                         [](const ExpertMatch &a, const ExpertMatch &b) {
+                                             return a.distance < b.distance;
+                                         });
+        matches.insert(position, match);
+        if (static_cast<int>(matches.size()) > k)
+            matches.pop_back();
+    }
+}
+
+bool ExpertIndex::ReadManifest(const std::string &filename, std::vector<ExpertClip> &clips) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cout << "Cannot open the expert manifest " << filename << std::endl;
+        return false;
+    }
+    const auto slash = filename.find_last_of("/\\");
+    const std::string directory = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
+    const auto resolve = [&directory](const std::string &path) {
+        const bool is_absolute = !path.empty() && (path[0] == '/' || path[0] == '\\' || path.find(':') == 1);
+        return is_absolute || path.empty() ? path : directory + path;
+    };
+
+    std::string line;
+    while (std::getline(file, line)) {
+        line = Trim(line);
+        if (line.empty() || line[0] == '#')
+            continue;
+        const auto comma = line.find(',');
+        if (comma == std::string::npos)
+            clips.push_back({resolve(line), ""});
+        else
+            clips.push_back({resolve(Trim(line.substr(0, comma))), resolve(Trim(line.substr(comma + 1)))});
+    }
+    return true;
+}
+
+bool ExpertIndex::LoadClip(const std::string &bvh_path, const std::vector<std::string> &target_list,
+                           const strokeSegmenter::SegmenterConfig &segmenter_config, FeatureMatrix &features,
+                           std::vector<StrokeSegment> &strokes) {
+    BVH bvh(bvh_path.c_str());
+    if (!bvh.IsLoadSuccess())
+        return false;
+    // The whole clip, as the viewer has it once played through
+    auto *motion = bvh.GetMotions();
+    bvh.PushBackMotion(motion->begin(), motion->end());
+
+    // The angles do not depend on where the skeleton stands
+    PoseBuffer pose;
+    pose.Build(&bvh, glm::vec3(0.0f));
+    const FeatureSchema schema(&bvh, target_list, skeleton::TARGET_BONE_NAMES);
+    features = FeatureExtractor::Extract(schema, &bvh, pose);
+    strokes = StrokeSegmenter::Segment(&bvh, pose, segmenter_config);
+    return true;
+}
+
+bool ExpertIndex::Build(const std::vector<ExpertClip> &expert_clips, const IndexConfig &config, int num_worker) {
+    // Clips are independent, the workers take the next clip when they are free
+    std::vector<FeatureMatrix> clip_features(expert_clips.size());
+    std::vector<std::vector<FrameRange>> clip_strokes(expert_clips.size());
+    if (num_worker <= 0)
+        num_worker = std::max(1u, std::thread::hardware_concurrency());
+    num_worker = std::min<int>(num_worker, std::max<size_t>(expert_clips.size(), 1));
+    std::atomic<size_t> next_clip{0};
+    const auto work = [&]() {
+        std::vector<StrokeSegment> strokes;
+        for (size_t clip = next_clip++; clip < expert_clips.size(); clip = next_clip++) {
+            if (!LoadClip(expert_clips[clip].bvh_path, config.target_list, config.segmenter_config,
+                          clip_features[clip], strokes)) {
+                std::cout << "Cannot load the expert clip " << expert_clips[clip].bvh_path << std::endl;
+                continue;
+            }
+            for (const auto &stroke: strokes)
+                clip_strokes[clip].push_back(stroke.frames);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_worker; i++)
+        workers.emplace_back(work);
+    work();
+    for (auto &worker: workers)
+        worker.join();
+
+    return Build(expert_clips, clip_features, clip_strokes, config);
+}
+
+bool ExpertIndex::Build(const std::vector<ExpertClip> &expert_clips, const std::vector<FeatureMatrix> &clip_features,
+                        const std::vector<std::vector<FrameRange>> &clip_strokes, const IndexConfig &config) {
+    *this = ExpertIndex();
+    clips = expert_clips;
+    embedding_frames = std::max(config.embedding_frames, 2);
+    radius = std::max(config.radius, 0);
+
+    // The first clip with features fixes the columns
+    for (const auto &features: clip_features) {
+        if (features.GetNumColumn() == 0)
+            continue;
+        for (const auto &column: features.GetSchema().GetColumns())
+            columns.push_back(column.name);
+        break;
+    }
+    if (columns.empty()) {
+        std::cout << "No expert clip to index" << std::endl;
+        return false;
+    }
+
+    const int embedding_size = GetEmbeddingSize();
+    std::vector<float> clip_embeddings;
+    for (size_t clip = 0; clip < clips.size() && clip < clip_features.size(); clip++) {
+        const auto &features = clip_features[clip];
+        if (features.GetNumColumn() == 0)
+            continue;
+        std::vector<FrameRange> ranges;
+        if (clip < clip_strokes.size())
+            ranges = clip_strokes[clip];
+        if (ranges.empty())
+            ranges.emplace_back();
+        for (const auto &range: ranges) {
+            clip_embeddings.resize(clip_embeddings.size() + embedding_size);
+            if (Embed(features, range, clip_embeddings.data() + clip_embeddings.size() - embedding_size)) {
+                entries.push_back({static_cast<int>(clip), range.Clamp(features.GetNumFrame())});
+            } else {
+                clip_embeddings.resize(clip_embeddings.size() - embedding_size);
+                std::cout << clips[clip].bvh_path << ": no embedding (missing column or empty stroke)" << std::endl;
+            }
+        }
+    }
+
+    // Embeddings, then the envelopes of each
+    const size_t array_size = clip_embeddings.size();
+    storage = std::move(clip_embeddings);
+    storage.resize(3 * array_size);
+    embeddings = storage.data();
+    upper = storage.data() + array_size;
+    lower = storage.data() + 2 * array_size;
+    for (size_t e = 0; e < entries.size(); e++)
+        Envelope(embeddings + e * embedding_size, storage.data() + array_size + e * embedding_size,
+                 storage.data() + 2 * array_size + e * embedding_size);
+
+    std::cout << "Expert index: " << entries.size() << " strokes of " << clips.size() << " clips, "
+              << columns.size() << " columns" << std::endl;
+    return !entries.empty();
+}
+
+bool ExpertIndex::Save(const std::string &filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    file.write(index_magic, sizeof(index_magic));
+    Write<int32_t>(file, embedding_frames);
+    Write<int32_t>(file, radius);
+    Write<int32_t>(file, static_cast<int32_t>(columns.size()));
+    Write<int32_t>(file, static_cast<int32_t>(clips.size()));
+    Write<int32_t>(file, static_cast<int32_t>(entries.size()));
+    for (const auto &column: columns)
+        WriteString(file, column);
+    for (const auto &clip: clips) {
+        WriteString(file, clip.bvh_path);
+        WriteString(file, clip.video_path);
+    }
+    for (const auto &entry: entries) {
+        Write<int32_t>(file, entry.clip);
+        Write<int32_t>(file, entry.frames.begin);
+        Write<int32_t>(file, entry.frames.end);
+    }
+
+    // The floats start aligned, they are used in place once mapped
+    const size_t padding = (float_alignment - static_cast<size_t>(file.tellp()) % float_alignment) % float_alignment;
+    const char zeros[float_alignment] = {};
+    file.write(zeros, padding);
+    const size_t array_size = entries.size() * GetEmbeddingSize();
+    for (const float *array: {embeddings, upper, lower})
+        file.write(reinterpret_cast<const char *>(array), array_size * sizeof(float));
+    return static_cast<bool>(file);
+}
+
+bool ExpertIndex::Load(const std::string &filename) {
+    auto file = std::make_unique<mappedFile::MappedFile>(filename, false);
+    if (!file->IsOpen()) {
+        std::cout << "Cannot open the expert index " << filename << std::endl;
+        return false;
+    }
+
+    ExpertIndex index;
+    HeaderReader reader(file->Begin(), file->End());
+    char magic[sizeof(index_magic)];
+    int32_t num_column, num_clip, num_entry;
+    bool isValid = reader.Read(magic) && std::memcmp(magic, index_magic, sizeof(magic)) == 0 &&
+                   reader.Read(index.embedding_frames) && reader.Read(index.radius) && reader.Read(num_column) &&
+                   reader.Read(num_clip) && reader.Read(num_entry) && index.embedding_frames > 0 &&
+                   num_column >= 0 && num_clip >= 0 && num_entry >= 0;
+    for (int32_t c = 0; isValid && c < num_column; c++) {
+        index.columns.emplace_back();
+        isValid = reader.ReadString(index.columns.back());
+    }
+    for (int32_t c = 0; isValid && c < num_clip; c++) {
+        index.clips.emplace_back();
+        isValid = reader.ReadString(index.clips.back().bvh_path) && reader.ReadString(index.clips.back().video_path);
+    }
+    for (int32_t e = 0; isValid && e < num_entry; e++) {
+        ExpertEntry entry;
+        isValid = reader.Read(entry.clip) && reader.Read(entry.frames.begin) && reader.Read(entry.frames.end) &&
+                  entry.clip >= 0 && entry.clip < num_clip;
+        index.entries.push_back(entry);
+    }
+
+    const size_t header_size = reader.GetCursor() - file->Begin();
+    const size_t float_begin = (header_size + float_alignment - 1) / float_alignment * float_alignment;
+    const size_t array_size = static_cast<size_t>(num_entry) * index.GetEmbeddingSize();
+    isValid = isValid && file->GetSize() == float_begin + 3 * array_size * sizeof(float);
+    if (!isValid) {
+        std::cout << filename << " is not an expert index" << std::endl;
+        return false;
+    }
+
+    const auto *floats = reinterpret_cast<const float *>(file->Begin() + float_begin);
+    index.embeddings = floats;
+    index.upper = floats + array_size;
+    index.lower = floats + 2 * array_size;
+    index.mapped_file = std::move(file);
+    *this = std::move(index);
+    return true;
+}
+
+bool ExpertIndex::Embed(const FeatureMatrix &features, const FrameRange &range, float *embedding) const {
+    const FrameRange frames = range.Clamp(features.GetNumFrame());
+    const int num_frame = frames.GetNumFrame();
+    const int num_channel = GetNumChannel();
+    if (num_frame < 2 || num_channel == 0)
+        return false;
+
+    std::vector<float> resampled(embedding_frames);
+    for (int c = 0; c < num_channel; c++) {
+        const int column = features.GetSchema().FindColumn(columns[c]);
+        if (column < 0)
+            return false;
+        Similarity::Resample(features.Column(column) + frames.begin, num_frame, 1, resampled.data(),
+                             embedding_frames);
+        for (int t = 0; t < embedding_frames; t++)
+            embedding[t * num_channel + c] = resampled[t];
+    }
+    Similarity::ZNormalize(embedding, embedding_frames, num_channel);
+    return true;
+}
+
+void ExpertIndex::Envelope(const float *embedding, float *upper_envelope, float *lower_envelope) const {
+    const int num_channel = GetNumChannel();
+    for (int t = 0; t < embedding_frames; t++) {
+        const int first = std::max(t - radius, 0), last = std::min(t + radius, embedding_frames - 1);
+        float *row_upper = upper_envelope + t * num_channel, *row_lower = lower_envelope + t * num_channel;
+        std::copy(embedding + first * num_channel, embedding + (first + 1) * num_channel, row_upper);
+        std::copy(embedding + first * num_channel, embedding + (first + 1) * num_channel, row_lower);
+        for (int s = first + 1; s <= last; s++) {
+            const float *row = embedding + s * num_channel;
+            for (int c = 0; c < num_channel; c++) {
+                row_upper[c] = std::max(row_upper[c], row[c]);
+                row_lower[c] = std::min(row_lower[c], row[c]);
+            }
+        }
+    }
+}
+
+std::vector<ExpertMatch> ExpertIndex::Search(const float *embedding, int k, SearchStats *stats) const {
+    std::vector<ExpertMatch> matches;
+    const int num_entry = GetNumEntry(), num_channel = GetNumChannel(), embedding_size = GetEmbeddingSize();
+    k = std::min(k, num_entry);
+    if (k <= 0)
+        return matches;
+
+    // Rank the entries by their lower bound, the nearest is likely among the first few
+    const float inf = std::numeric_limits<float>::infinity();
+    std::vector<float> bounds(num_entry);
+    for (int e = 0; e < num_entry; e++)
+        bounds[e] = LbKeogh(embedding, upper + e * embedding_size, lower + e * embedding_size, embedding_size, inf);
+    std::vector<int> order(num_entry);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&bounds](int a, int b) {
+        return bounds[a] < bounds[b];
+    });
+
+    // The query's own envelope gives the reverse bound, LB_Keogh is not symmetric
+    std::vector<float> query_upper(embedding_size), query_lower(embedding_size);
+    Envelope(embedding, query_upper.data(), query_lower.data());
+
+    int num_dtw = 0;
+    for (int e: order) {
+        // Squared, like the bounds
+        const float worst = static_cast<int>(matches.size()) == k ? matches.back().distance *
+                                                                     matches.back().distance : inf;
+        if (bounds[e] > worst)
+            break;
+        const float *candidate = embeddings + e * embedding_size;
+        if (LbKeogh(candidate, query_upper.data(), query_lower.data(), embedding_size, worst) > worst)
+            continue;
+        num_dtw++;
+        InsertMatch(matches, k, {e, Similarity::Dtw(embedding, embedding_frames, candidate, embedding_frames,
+                                                    num_channel, radius)});
+    }
+
+    if (stats != nullptr) {
+        stats->num_entry = num_entry;
+        stats->num_dtw = num_dtw;
+    }
+    return matches;
+}
+
+std::vector<ExpertMatch> ExpertIndex::Search(const FeatureMatrix &features, const FrameRange &range, int k,
+                                             SearchStats *stats) const {
+    std::vector<float> embedding(GetEmbeddingSize());
+    if (IsEmpty() || !Embed(features, range, embedding.data()))
+        return {};
+    return Search(embedding.data(), k, stats);
+}
+
+std::vector<ExpertMatch> ExpertIndex::SearchExhaustive(const float *embedding, int k) const {
+    std::vector<ExpertMatch> matches;
+    const int embedding_size = GetEmbeddingSize();
+    k = std::min(k, GetNumEntry());
+    for (int e = 0; e < GetNumEntry() && k > 0; e++)
+        InsertMatch(matches, k, {e, Similarity::Dtw(embedding, embedding_frames, embeddings + e * embedding_size,
+                                                    embedding_frames, GetNumChannel(), radius)});
+    return matches;
+}
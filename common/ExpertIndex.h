@@ -0,0 +1,208 @@
+#ifndef TESTBED_EXPERTINDEX_H
+#define TESTBED_EXPERTINDEX_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FeatureExtractor.h"
+#include "MappedFile.h"
+#include "StrokeSegmenter.h"
+
+using namespace featureExtractor;
+
+namespace expertIndex {
+
+    /// One expert recording of the library manifest
+    struct ExpertClip {
+        std::string bvh_path;
+        /// May be empty, not every recording has its video
+        std::string video_path;
+    };
+
+    /// One expert stroke of the index: a stroke of one of the clips
+    struct ExpertEntry {
+        int clip = 0;
+        /// Frames of the stroke in the clip's BVH
+        FrameRange frames;
+    };
+
+    struct ExpertMatch {
+        int entry = -1;
+        /// DTW distance between the embeddings
+        float distance = 0;
+    };
+
+    /// Work done by one Search
+    struct SearchStats {
+        int num_entry = 0;
+        /// Entries that needed the full DTW, the others were pruned by their lower bound
+        int num_dtw = 0;
+    };
+
+    struct IndexConfig {
+        /// Joints whose angle features (FeatureSchema columns) make up the embedding
+        std::vector<std::string> target_list = {"chest", "rCollar", "rShldr", "rForeArm", "rHand", "lShldr",
+                                                "lForeArm", "hip", "rThigh", "lThigh"};
+        /// Every stroke is resampled to this many frames
+        int embedding_frames = 64;
+        /// Sakoe-Chiba band of the DTW & width of the LB_Keogh envelopes, in embedding frames
+        int radius = 6;
+        /// How the expert clips are cut into strokes, a clip without any stroke is one entry
+        strokeSegmenter::SegmenterConfig segmenter_config;
+    };
+
+    /**
+     * Library of expert strokes for nearest-neighbour search over motion features.
+     *
+     * Every stroke gets a fixed-length embedding: its angle feature columns resampled to embedding_frames frames
+     * and z-normalized per column, time-major like Similarity's series (embedding_frames x num_channel). The upper
+     * and lower LB_Keogh envelopes of each embedding (running max & min over +-radius frames) are precomputed too.
+     *
+     * Search is an exact k-NN under Similarity::Dtw with the same band: the entries are ranked by
+     * LB_Keogh, a lower bound of that DTW, and the full DTW only runs while the bound is below the k-th best
+     * distance found so far. Strokes of similar length & shape give a tight bound, so a handful of DTWs remain
+     * per query whatever the library size.
+     *
+     * Save writes the index to one file (TBEXPIX1, see ExpertIndex.cpp) and Load maps it: the embeddings and
+     * envelopes are used in place, only the paths & entries are read into memory.
+     */
+    class ExpertIndex {
+    private:
+        std::vector<std::string> columns;
+        std::vector<ExpertClip> clips;
+        std::vector<ExpertEntry> entries;
+        int embedding_frames = 0;
+        int radius = 0;
+
+        /// Built in memory: owns embeddings, upper & lower, one after the other
+        std::vector<float> storage;
+        /// Loaded: the mapped file they point into
+        std::unique_ptr<mappedFile::MappedFile> mapped_file;
+
+        /// entry e's embedding & envelopes start at e * GetEmbeddingSize()
+        const float *embeddings = nullptr;
+        const float *upper = nullptr;
+        const float *lower = nullptr;
+
+        // -------------------- Methods -------------------- //
+        /// Upper & lower envelope of one embedding
+        void Envelope(const float *embedding, float *upper_envelope, float *lower_envelope) const;
+
+    public:
+        ExpertIndex() = default;
+
+        ExpertIndex(ExpertIndex &&) = default;
+
+        ExpertIndex &operator=(ExpertIndex &&) = default;
+
+        /**
+         * One clip per line: "bvh_path[,video_path]". Empty lines & lines starting with '#' are skipped,
+         * relative paths are taken relative to the manifest's directory.
+         * @return false (with a message) if the file cannot be read
+         */
+        static bool ReadManifest(const std::string &filename, std::vector<ExpertClip> &clips);
+
+        /**
+         * The whole-clip angle features of a BVH file & its strokes, what Build indexes and what a query is cut from
+         * @return false if the file cannot be loaded
+         */
+        static bool LoadClip(const std::string &bvh_path, const std::vector<std::string> &target_list,
+                             const strokeSegmenter::SegmenterConfig &segmenter_config, FeatureMatrix &features,
+                             std::vector<strokeSegmenter::StrokeSegment> &strokes);
+
+        /**
+         * Index every stroke of the clips, the clips are loaded on num_worker threads (0: one per core)
+         * @return false (with a message) if no clip could be indexed
+         */
+        bool Build(const std::vector<ExpertClip> &expert_clips, const IndexConfig &config = IndexConfig(),
+                   int num_worker = 0);
+
+        /**
+         * Same with the clips' features already extracted (LoadClip) & their strokes, no strokes for the whole clip.
+         * The embedding columns are the first clip's, a clip without features or that lacks one of them is skipped.
+         */
+        bool Build(const std::vector<ExpertClip> &expert_clips, const std::vector<FeatureMatrix> &clip_features,
+                   const std::vector<std::vector<FrameRange>> &clip_strokes, const IndexConfig &config = IndexConfig());
+
+        /// @return false if the file cannot be written
+        bool Save(const std::string &filename) const;
+
+        /// @return false (with a message) if the file cannot be opened or is not an index
+        bool Load(const std::string &filename);
+
+        /**
+         * The embedding of frames range of a clip's features, GetEmbeddingSize() floats
+         * @return false if the features lack one of the index's columns or the range is empty
+         */
+        bool Embed(const FeatureMatrix &features, const FrameRange &range, float *embedding) const;
+
+        /// The k nearest entries of an embedding, nearest first
+        std::vector<ExpertMatch> Search(const float *embedding, int k, SearchStats *stats = nullptr) const;
+
+        /// Same with the embedding of frames range of a clip's features, empty if it has no embedding
+        std::vector<ExpertMatch> Search(const FeatureMatrix &features, const FrameRange &range, int k,
+                                        SearchStats *stats = nullptr) const;
+
+        /// The k nearest entries by full DTW against every entry, no pruning: the reference for Search
+        std::vector<ExpertMatch> SearchExhaustive(const float *embedding, int k) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        bool IsEmpty() const;
+
+        int GetNumEntry() const;
+
+        const ExpertEntry &GetEntry(int entry) const;
+
+        const ExpertClip &GetClip(int entry) const;
+
+        const std::vector<std::string> &GetColumns() const;
+
+        int GetEmbeddingFrames() const;
+
+        int GetNumChannel() const;
+
+        /// Floats per embedding
+        int GetEmbeddingSize() const;
+
+        int GetRadius() const;
+    };
+
+    inline bool ExpertIndex::IsEmpty() const {
+        return entries.empty();
+    }
+
+    inline int ExpertIndex::GetNumEntry() const {
+        return static_cast<int>(entries.size());
+    }
+
+    inline const ExpertEntry &ExpertIndex::GetEntry(int entry) const {
+        return entries[entry];
+    }
+
+    inline const ExpertClip &ExpertIndex::GetClip(int entry) const {
+        return clips[entries[entry].clip];
+    }
+
+    inline const std::vector<std::string> &ExpertIndex::GetColumns() const {
+        return columns;
+    }
+
+    inline int ExpertIndex::GetEmbeddingFrames() const {
+        return embedding_frames;
+    }
+
+    inline int ExpertIndex::GetNumChannel() const {
+        return static_cast<int>(columns.size());
+    }
+
+    inline int ExpertIndex::GetEmbeddingSize() const {
+        return embedding_frames * GetNumChannel();
+    }
+
+    inline int ExpertIndex::GetRadius() const {
+        return radius;
+    }
+}
+
+#endif //TESTBED_EXPERTINDEX_H
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include "FeatureExtractor.h"
+#include "AngleKernel.h"
+#include "MotionDerivatives.h"
+
+using namespace featureExtractor;
+using namespace angleTool;
+using namespace motionDerivatives;
+
+FeatureSchema::FeatureSchema(const BVH *bvh, const std::vector<std::string> &target_list,
+                             const std::vector<std::string> &bone_names) : target_list(target_list) {
+    const auto is_bone = [&](const std::string &name) {
+        return std::find(bone_names.begin(), bone_names.end(), name) != bone_names.end();
+    };
+    const auto is_target = [&](const std::string &name) {
+        return std::find(target_list.begin(), target_list.end(), name) != target_list.end();
+    };
+
+    for (const auto &target_name: target_list) {
+        auto joint = bvh->GetJoint(target_name);
+
+        columns.push_back({target_name + "_x", SELF_X, joint->index, -1});
+        columns.push_back({target_name + "_y", SELF_Y, joint->index, -1});
+        columns.push_back({target_name + "_z", SELF_Z, joint->index, -1});
+
+        int parent = -1;
+        if (!joint->parents.empty() && is_bone(joint->parents.back()->name))
+            parent = joint->parents.back()->index;
+        columns.push_back({target_name + "_parent", PARENT, joint->index, parent});
+
+        // Only the target children, in name order
+        std::map<std::string, int> children;
+        for (auto child: joint->children) {
+            if (is_bone(child->name) && is_target(child->name))
+                children[child->name] = child->index;
+        }
+        for (const auto &[child_name, child_index]: children)
+            columns.push_back({target_name + "_" + child_name, CHILD, joint->index, child_index});
+    }
+}
+
+FeatureSchema::FeatureSchema(const std::vector<std::string> &target_list, const std::vector<FeatureColumn> &columns)
+        : target_list(target_list), columns(columns) {}
+
+bool FeatureSchema::AddDerivativeColumns(const BVH *bvh, const std::vector<std::string> &joint_names) {
+    bool isComplete = true;
+    for (const auto &joint_name: joint_names) {
+        const auto *bvh_joint = bvh->GetJoint(joint_name);
+        if (bvh_joint == nullptr) {
+            std::cout << "No joint " << joint_name << ", its derivative columns are skipped" << std::endl;
+            isComplete = false;
+            continue;
+        }
+        const int joint = bvh_joint->index;
+        columns.push_back({joint_name + "_speed", SPEED, joint, -1});
+        columns.push_back({joint_name + "_acceleration", ACCELERATION_NORM, joint, -1});
+        columns.push_back({joint_name + "_jerk", JERK_NORM, joint, -1});
+        columns.push_back({joint_name + "_angular_speed", ANGULAR_SPEED, joint, -1});
+    }
+    return isComplete;
+}
+
+int FeatureSchema::FindColumn(const std::string &name) const {
+    for (int i = 0; i < columns.size(); i++) {
+        if (columns[i].name == name)
+            return i;
+    }
+    return -1;
+}
+
+FeatureMatrix::FeatureMatrix(const FeatureSchema &schema, int num_frame)
+        : schema(schema), num_frame(num_frame), data(static_cast<size_t>(schema.GetNumColumn()) * num_frame) {}
+
+FeatureMatrix FeatureExtractor::Extract(const FeatureSchema &schema, const BVH *bvh, const PoseBuffer &pose) {
+    return Extract(schema, bvh, *bvh->GetModifiedMotions(), pose);
+}
+
+FeatureMatrix FeatureExtractor::Extract(const FeatureSchema &schema, const BVH *bvh, const std::vector<double> &motion,
+                                        const PoseBuffer &pose) {
+    const int num_frame = pose.GetNumFrame();
+    FeatureMatrix features(schema, num_frame);
+
+    // Unit bone directions (default orientation (0, 1, 0) rotated), computed once per joint that needs them
+    std::vector<std::vector<float>> directions(pose.GetNumJoint());
+    const auto direction = [&](int joint) -> const float * {
+        auto &dir = directions[joint];
+        if (dir.empty()) {
+            dir.resize(3 * static_cast<size_t>(num_frame));
+            const auto &q = pose.GetOrientations();
+            const size_t begin = pose.Index(joint, 0);
+            const float *__restrict qx = q.x.data() + begin, *__restrict qy = q.y.data() + begin;
+            const float *__restrict qz = q.z.data() + begin, *__restrict qw = q.w.data() + begin;
+            float *__restrict dx = dir.data(), *__restrict dy = dx + num_frame, *__restrict dz = dy + num_frame;
+            for (int f = 0; f < num_frame; f++) {
+                float x = 2 * (qx[f] * qy[f] - qw[f] * qz[f]);
+                float y = 1 - 2 * (qx[f] * qx[f] + qz[f] * qz[f]);
+                float z = 2 * (qy[f] * qz[f] + qw[f] * qx[f]);
+                float inv_length = 1 / std::sqrt(x * x + y * y + z * z);
+                dx[f] = x * inv_length;
+                dy[f] = y * inv_length;
+                dz[f] = z * inv_length;
+            }
+        }
+        return dir.data();
+    };
+
+    // The derivatives of the joints some column asks for, all in one pass
+    std::vector<int> derivative_joints;
+    for (const auto &column: schema.GetColumns()) {
+        if (column.kind >= SPEED &&
+            std::find(derivative_joints.begin(), derivative_joints.end(), column.joint) == derivative_joints.end())
+            derivative_joints.push_back(column.joint);
+    }
+    DerivativeBuffer derivatives;
+    if (!derivative_joints.empty())
+        derivatives.Build(pose, bvh->GetInterval(), derivative_joints);
+
+    const int num_channel = bvh->GetNumChannel();
+    for (int c = 0; c < schema.GetNumColumn(); c++) {
+        const auto &column = schema.GetColumns()[c];
+        float *out = features.Column(c);
+
+        switch (column.kind) {
+            case SELF_X:
+            case SELF_Y:
+            case SELF_Z: {
+                // The local angle straight from the motion, 0 if the joint has no such channel
+                const ChannelEnum type = column.kind == SELF_X ? X_ROTATION : (column.kind == SELF_Y ? Y_ROTATION
+                                                                                                   : Z_ROTATION);
+                int channel_index = -1;
+                for (auto channel: bvh->GetJoint(column.joint)->channels) {
+                    if (channel->type == type)
+                        channel_index = channel->index;
+                }
+                if (channel_index < 0) {
+                    std::fill(out, out + num_frame, 0.0f);
+                    break;
+                }
+                for (int f = 0; f < num_frame; f++)
+                    out[f] = motion[static_cast<size_t>(f) * num_channel + channel_index];
+                break;
+            }
+            case PARENT:
+            case CHILD: {
+                if (column.other_joint < 0) {
+                    std::fill(out, out + num_frame, 0.0f);
+                    break;
+                }
+                const float *a = direction(column.joint), *b = direction(column.other_joint);
+                const float *__restrict ax = a, *__restrict ay = a + num_frame, *__restrict az = a + 2 * num_frame;
+                const float *__restrict bx = b, *__restrict by = b + num_frame, *__restrict bz = b + 2 * num_frame;
+                for (int f = 0; f < num_frame; f++) {
+                    float dot = ax[f] * bx[f] + ay[f] * by[f] + az[f] * bz[f];
+                    // acos is NaN out of [-1, 1], and Bone::AngleBetweenTwo takes that as 0
+                    out[f] = dot > 1 || dot < -1 ? 0.0f : AngleKernel::Acos(dot) * AngleKernel::rad_to_deg;
+                }
+                break;
+            }
+            case SPEED:
+            case ACCELERATION_NORM:
+            case JERK_NORM:
+            case ANGULAR_SPEED: {
+                const DerivativeKind kind = column.kind == SPEED ? VELOCITY : (
+                        column.kind == ACCELERATION_NORM ? ACCELERATION : (
+                                column.kind == JERK_NORM ? JERK : ANGULAR_VELOCITY));
+                derivatives.GetMagnitude(kind, column.joint, out);
+                break;
+            }
+        }
+    }
+    return features;
+}
+
+bool FeatureExtractor::Select(const FeatureSchema &schema, const FeatureMatrix &source, FeatureMatrix &features) {
+    const int num_frame = source.GetNumFrame();
+    FeatureMatrix selected(schema, num_frame);
+    for (int c = 0; c < schema.GetNumColumn(); c++) {
+        const int column = source.GetSchema().FindColumn(schema.GetColumns()[c].name);
+        if (column < 0)
+            return false;
+        std::copy(source.Column(column), source.Column(column) + num_frame, selected.Column(c));
+    }
+    features = std::move(selected);
+    return true;
+}
+
+bool FeatureExtractor::WriteCsv(const FeatureMatrix &features, const std::string &output_filename) {
+    std::ofstream output_file(output_filename);
+    if (!output_file.is_open())
+        return false;
+
+    /// Write the header
+    output_file << "frame,";
+    for (const auto &column: features.GetSchema().GetColumns())
+        output_file << column.name << ",";
+    output_file << "\n";
+
+    /// Write the data
+    for (int frame = 0; frame < features.GetNumFrame(); frame++) {
+        output_file << frame << ",";
+        for (int c = 0; c < features.GetNumColumn(); c++)
+            output_file << features.At(frame, c) << ",";
+        output_file << "\n";
+    }
+    output_file.close();
+    return true;
+}
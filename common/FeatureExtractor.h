@@ -0,0 +1,209 @@
+#ifndef TESTBED_FEATUREEXTRACTOR_H
+#define TESTBED_FEATUREEXTRACTOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "BVH.h"
+#include "PoseBuffer.h"
+
+using namespace bvh;
+using namespace poseBuffer;
+
+namespace featureExtractor {
+
+    enum FeatureKind {
+        SELF_X, SELF_Y, SELF_Z, PARENT, CHILD,
+        /// Lengths of the joint's world derivatives (motionDerivatives::DerivativeBuffer)
+        SPEED, ACCELERATION_NORM, JERK_NORM, ANGULAR_SPEED
+    };
+
+    struct FeatureColumn {
+        std::string name;
+        FeatureKind kind;
+        /// The target joint
+        int joint;
+        /// The parent / child joint for PARENT & CHILD, -1 if the target has no parent bone
+        int other_joint;
+    };
+
+    /// Frames [begin, end) of a clip, the whole clip by default
+    struct FrameRange {
+        int begin = 0;
+        /// -1 for the end of the clip
+        int end = -1;
+
+        /// Within a clip of num_frame frames
+        FrameRange Clamp(int num_frame) const;
+
+        /// The same part of the clip on another time base, e.g. the video's frames for the BVH's
+        FrameRange Rescale(int from_num_frame, int to_num_frame) const;
+
+        int GetNumFrame() const;
+    };
+
+    /**
+     * The fixed column layout of the joint-angle features, named once.
+     * For every target: target_x, target_y, target_z (local angles), target_parent, then target_child for the
+     * children that are targets too, in name order. It is the same layout Identifier::WriteOutput always had.
+     */
+    class FeatureSchema {
+    private:
+        std::vector<std::string> target_list;
+        std::vector<FeatureColumn> columns;
+
+    public:
+        FeatureSchema() = default;
+
+        /**
+         * @param bone_names the bones of the skeleton, only they count as parent or child
+         */
+        FeatureSchema(const BVH *bvh, const std::vector<std::string> &target_list,
+                      const std::vector<std::string> &bone_names);
+
+        /// A layout read back from storage (e.g. the result cache)
+        FeatureSchema(const std::vector<std::string> &target_list, const std::vector<FeatureColumn> &columns);
+
+        /**
+         * Append the derivative columns of the joints after the angle ones: joint_speed, joint_acceleration,
+         * joint_jerk, joint_angular_speed
+         * @return false if a joint is not in the bvh (its columns are skipped)
+         */
+        bool AddDerivativeColumns(const BVH *bvh, const std::vector<std::string> &joint_names);
+
+        /// Index of the column, -1 if there is none
+        int FindColumn(const std::string &name) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        const std::vector<std::string> &GetTargetList() const;
+
+        const std::vector<FeatureColumn> &GetColumns() const;
+
+        int GetNumColumn() const;
+    };
+
+    /**
+     * Column-major float matrix of features, column c of frame f is at c * num_frame + f.
+     */
+    class FeatureMatrix {
+    private:
+        FeatureSchema schema;
+        int num_frame = 0;
+        std::vector<float> data;
+
+    public:
+        FeatureMatrix() = default;
+
+        FeatureMatrix(const FeatureSchema &schema, int num_frame);
+
+        const float *Column(int column) const;
+
+        float *Column(int column);
+
+        float At(int frame, int column) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        const FeatureSchema &GetSchema() const;
+
+        int GetNumFrame() const;
+
+        int GetNumColumn() const;
+
+        const std::vector<float> &GetData() const;
+    };
+
+    class FeatureExtractor {
+    public:
+        /**
+         * Compute every column of the schema for every frame in one pass over the pose buffer.
+         * The values are the ones Bone::GetSelfAngle(frame) & Bone::GetAngleWithNeighbor give per frame (degree).
+         * The derivative columns are differentiated over the pose buffer's frames (BVH units / s^n, degree / s).
+         */
+        static FeatureMatrix Extract(const FeatureSchema &schema, const BVH *bvh, const PoseBuffer &pose);
+
+        /**
+         * Same with a copy of the motion (bvh->GetModifiedMotions()) taken with the pose buffer, the bvh only gives
+         * the hierarchy: safe off the main thread while the clip is being edited
+         */
+        static FeatureMatrix Extract(const FeatureSchema &schema, const BVH *bvh, const std::vector<double> &motion,
+                                     const PoseBuffer &pose);
+
+        /**
+         * The columns of schema copied by name from a matrix that has them all (e.g. the whole body's), so several
+         * schemas of one clip share a single extraction
+         * @return false if source lacks one of them
+         */
+        static bool Select(const FeatureSchema &schema, const FeatureMatrix &source, FeatureMatrix &features);
+
+        /**
+         * Write the matrix as csv
+         * the Format is:
+         * frame, column1, column2, ...
+         * @return false if the file cannot be opened
+         */
+        static bool WriteCsv(const FeatureMatrix &features, const std::string &output_filename);
+    };
+
+    inline const std::vector<std::string> &FeatureSchema::GetTargetList() const {
+        return target_list;
+    }
+
+    inline const std::vector<FeatureColumn> &FeatureSchema::GetColumns() const {
+        return columns;
+    }
+
+    inline FrameRange FrameRange::Clamp(int num_frame) const {
+        const int clamped_begin = std::min(std::max(begin, 0), num_frame);
+        const int clamped_end = end < 0 ? num_frame : std::min(std::max(end, clamped_begin), num_frame);
+        return {clamped_begin, clamped_end};
+    }
+
+    inline FrameRange FrameRange::Rescale(int from_num_frame, int to_num_frame) const {
+        const FrameRange clamped = Clamp(from_num_frame);
+        if (from_num_frame == to_num_frame || from_num_frame == 0)
+            return clamped.Clamp(to_num_frame);
+        const double scale = static_cast<double>(to_num_frame) / from_num_frame;
+        return FrameRange{static_cast<int>(clamped.begin * scale), static_cast<int>(std::ceil(clamped.end * scale))}
+                .Clamp(to_num_frame);
+    }
+
+    inline int FrameRange::GetNumFrame() const {
+        return end - begin;
+    }
+
+    inline int FeatureSchema::GetNumColumn() const {
+        return columns.size();
+    }
+
+    inline const float *FeatureMatrix::Column(int column) const {
+        return data.data() + static_cast<size_t>(column) * num_frame;
+    }
+
+    inline float *FeatureMatrix::Column(int column) {
+        return data.data() + static_cast<size_t>(column) * num_frame;
+    }
+
+    inline float FeatureMatrix::At(int frame, int column) const {
+        return data[static_cast<size_t>(column) * num_frame + frame];
+    }
+
+    inline const FeatureSchema &FeatureMatrix::GetSchema() const {
+        return schema;
+    }
+
+    inline int FeatureMatrix::GetNumFrame() const {
+        return num_frame;
+    }
+
+    inline int FeatureMatrix::GetNumColumn() const {
+        return schema.GetNumColumn();
+    }
+
+    inline const std::vector<float> &FeatureMatrix::GetData() const {
+        return data;
+    }
+}
+
+#endif //TESTBED_FEATUREEXTRACTOR_H
@@ -0,0 +1,45 @@
+#include "ForehandSuggestion.h"
+
+using namespace forehandSuggestion;
+
+namespace {
+    /// Index of the identifier's "correct" class, -1 if the classifier does not answer it
+    int FirstClass(const std::string &identifier_name) {
+        if (identifier_name == "rotation")
+            return 0;
+        if (identifier_name == "fore_arm")
+            return 3;
+        return -1;
+    }
+}
+
+const std::vector<std::string> ForehandSuggestion::identifier_names = {"fore_arm", "rotation"};
+
+bool ForehandSuggestion::IsPass(const std::string &identifier_name, const std::vector<float> &prob_vtr) {
+    const int first = FirstClass(identifier_name);
+    return first >= 0 && first < prob_vtr.size() && prob_vtr[first] >= 0.5;
+}
+
+std::string ForehandSuggestion::Suggest(const std::string &identifier_name, const std::vector<float> &prob_vtr) {
+    const int first = FirstClass(identifier_name);
+    if (first < 0 || first + 2 >= prob_vtr.size())
+        return "";
+
+    if (identifier_name == "rotation") {
+        if (prob_vtr[0] >= 0.5)
+            return "Your hip rotation motion is correct.\n";
+        if (prob_vtr[1] >= 0.5)
+            return "Rotate your waist less.\n";
+        if (prob_vtr[2] >= 0.5)
+            return "Rotate your waist more.\n";
+        return "Your hip rotation motion is wrong.\nPlease see our expert motion and try to mimic it.\n";
+    }
+
+    if (prob_vtr[3] >= 0.5)
+        return "Your swing motion is correct.\n";
+    if (prob_vtr[4] >= 0.5)
+        return "Wave your arm less.\n";
+    if (prob_vtr[5] >= 0.5)
+        return "Wave your arm more.\n";
+    return "Your swing motion is wrong.\nPlease see our expert motion and try to mimic it.\n";
+}
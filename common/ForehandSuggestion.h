@@ -0,0 +1,26 @@
+#ifndef TESTBED_FOREHANDSUGGESTION_H
+#define TESTBED_FOREHANDSUGGESTION_H
+
+#include <string>
+#include <vector>
+
+namespace forehandSuggestion {
+
+    /**
+     * Reading of the forehand classifier's 6-way output (0,1,2: rotation, 3,4,5: fore_arm; correct, too much,
+     * too little), shared by the viewer's Analysizer and the headless batch analysis.
+     */
+    class ForehandSuggestion {
+    public:
+        /// The identifiers the classifier answers
+        static const std::vector<std::string> identifier_names;
+
+        /// Whether the identifier's motion is correct (p >= 0.5), false for an unknown identifier
+        static bool IsPass(const std::string &identifier_name, const std::vector<float> &prob_vtr);
+
+        /// The advice for the identifier, one or two lines ending with '\n', empty for an unknown identifier
+        static std::string Suggest(const std::string &identifier_name, const std::vector<float> &prob_vtr);
+    };
+}
+
+#endif //TESTBED_FOREHANDSUGGESTION_H
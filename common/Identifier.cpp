@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "Identifier.h"
 
 using namespace identifier;
@@ -5,83 +7,71 @@ using namespace identifier;
 Identifier::Identifier(int id, const std::string &identifier_name, const std::vector<std::string> &target_list,
                        Skeleton *target_skeleton)
         : identifier_id(id), identifier_name(identifier_name), target_list(target_list),
-          target_skeleton(target_skeleton) {
-    result_list.resize(target_skeleton->GetBvh()->GetNumModifiedFrame());
-}
+          target_skeleton(target_skeleton),
+          schema(target_skeleton->GetBvh(), target_list, target_skeleton->GetTargetBoneNames()) {}
 
-Identifier::~Identifier() {
-    result_list.clear();
-}
+Identifier::~Identifier() {}
 
-void Identifier::Identify(int frame) {
-    result_list.resize(target_skeleton->GetBvh()->GetNumModifiedFrame());
-
-    for (const auto &target_name: target_list) {
-        auto target_bone = target_skeleton->FindBone(target_name);
+void Identifier::Identify(const PoseBuffer &pose) {
+    features = FeatureExtractor::Extract(schema, target_skeleton->GetBvh(), pose);
+}
 
-        auto angle_info = target_bone->GetAngleWithNeighbor();
-        auto angle_info_local = target_bone->GetSelfAngle(frame);
-        for (const auto &angle: angle_info_local)
-            angle_info[angle.first] = angle.second;
+void Identifier::Identify(const PoseBuffer &pose, const std::vector<double> &motion) {
+    features = FeatureExtractor::Extract(schema, target_skeleton->GetBvh(), motion, pose);
+}
 
-        result_list[frame][target_name] = angle_info;
-    }
+bool Identifier::Identify(const FeatureMatrix &whole_body) {
+    return FeatureExtractor::Select(schema, whole_body, features);
 }
 
-void Identifier::WriteOutput(const string &output_filename) {
-    std::ofstream output_file;
+bool Identifier::WriteOutput(const string &output_filename) {
     this->output_filename = output_filename;
-    output_file.open(output_filename);
-    if (!output_file.is_open()) {
-        cout << "CANNOT OPEN" << endl;
-        exit(1);
+    if (!FeatureExtractor::WriteCsv(features, output_filename)) {
+        cout << "Cannot open " << output_filename << endl;
+        return false;
     }
+    return true;
+}
 
-    /// Write the header
-    output_file << "frame,";
-    for (const auto &target_name: target_list) {
-        output_file << target_name << "_x," << target_name << "_y," << target_name << "_z," << target_name
-                    << "_parent,";
-        for (const auto &[child_name, child_angle]: result_list[0][target_name]) {
-            // Already handled above
-            if (child_name.find("self") == std::string::npos && child_name.find("parent") == std::string::npos)
-                // Only write the target child
-                if (std::find(target_list.begin(), target_list.end(), child_name) != target_list.end())
-                    output_file << target_name << "_" << child_name << ",";
-        }
-    }
-    output_file << std::endl;
-
-    /// Write the data
-    int frame = 0;
-    for (auto &angle_info_list: result_list) {
-        output_file << frame << ",";
-        for (const auto &target_name: target_list) {
-            output_file << angle_info_list[target_name]["self x"] << "," << angle_info_list[target_name]["self y"]
-                        << "," << angle_info_list[target_name]["self z"] << ","
-                        << angle_info_list[target_name]["parent"] << ",";
-            for (const auto &[child_name, child_angle]: angle_info_list[target_name]) {
-                // Already handled above
-                if (child_name.find("self") == std::string::npos && child_name.find("parent") == std::string::npos)
-                    // Only write the target child
-                    if (std::find(target_list.begin(), target_list.end(), child_name) != target_list.end())
-                        output_file << child_angle << ",";
-            }
-        }
-        output_file << std::endl;
-        frame++;
+bool Identifier::WriteOutput() {
+    output_filename = "output/" + identifier_name + ".csv";
+    return WriteOutput(output_filename);
+}
+
+std::map<std::string, float> Identifier::SimilarityScore(const FeatureMatrix &reference, float eps) const {
+    std::map<std::string, float> result;
+    // Empty until Identify has run
+    const auto &feature_schema = features.GetSchema();
+    const auto &reference_schema = reference.GetSchema();
+    for (int column = 0; column < feature_schema.GetNumColumn(); column++) {
+        const auto &name = feature_schema.GetColumns()[column].name;
+        int reference_column = reference_schema.FindColumn(name);
+        if (reference_column < 0)
+            continue;
+        result[name] = similarity::Similarity::ResampledLcss(features.Column(column), features.GetNumFrame(),
+                                                             reference.Column(reference_column),
+                                                             reference.GetNumFrame(), eps);
     }
-    output_file.close();
+    return result;
 }
 
-void Identifier::WriteOutput() {
-    output_filename = "output/" + identifier_name + ".csv";
-    WriteOutput(output_filename);
+float Identifier::WaistRotationScore(const OpenPoseData &target, const OpenPoseData &reference, float eps) {
+    const auto target_rotation = keypointKernel::KeypointKernel::WaistRotation(target);
+    const auto reference_rotation = keypointKernel::KeypointKernel::WaistRotation(reference);
+    if (target_rotation.empty() || reference_rotation.empty())
+        return 0;
+
+    const int num_frame = std::max(target_rotation.size(), reference_rotation.size());
+    const auto resampled_target = similarity::Similarity::Resample(target_rotation, 1, num_frame);
+    const auto resampled_reference = similarity::Similarity::Resample(reference_rotation, 1, num_frame);
+    return similarity::Similarity::Lcss(resampled_target.data(), num_frame, resampled_reference.data(), num_frame, 1,
+                                        eps);
 }
 
 vector<float>
 Identifier::Py_SimilarityScore(const string &target_filename, const string &openpose_target_filename) {
     this->output_filename = target_filename;
+    py::gil_scoped_acquire acquire;
     py::module_ PyAnalysizer = py::module_::import("Py_package.PyAnalysizer.Analysize");
     if (identifier_name == "rotation" || identifier_name == "fore_arm") {
         py::object result = PyAnalysizer.attr("ForehandStrokeAnalysis")(openpose_target_filename, target_filename);
@@ -94,6 +84,15 @@ Identifier::Py_SimilarityScore(const string &target_filename, const string &open
     return {};
 }
 
+vector<float> Identifier::Py_SimilarityScore(const FeatureMatrix &angles, const OpenPoseData &openpose,
+                                             const FrameRange &range) {
+    if (identifier_name == "rotation" || identifier_name == "fore_arm")
+        return ClassifierSession::Instance().Predict(angles, openpose, range);
+
+    std::cout << "No such identifier" << std::endl;
+    return {};
+}
+
 vector<float> Identifier::Py_SimilarityScore() {
     return Py_SimilarityScore(output_filename, openpose_target_filename);
 }
\ No newline at end of file
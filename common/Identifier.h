@@ -9,8 +9,17 @@
 #include <pybind11/stl.h>
 
 #include "Skeleton.h"
+#include "PoseBuffer.h"
+#include "FeatureExtractor.h"
+#include "Similarity.h"
+#include "OpenPoseData.h"
+#include "KeypointKernel.h"
+#include "ClassifierSession.h"
 
 using namespace skeleton;
+using namespace featureExtractor;
+using namespace openPoseData;
+using namespace classifierSession;
 namespace py = pybind11;
 
 namespace identifier {
@@ -22,7 +31,8 @@ namespace identifier {
         std::string output_filename;
         std::string openpose_target_filename = "output/openposeTest.csv";
         const std::vector<std::string> target_list;
-        std::vector<std::map<std::string, std::map<std::string, float>>> result_list;
+        FeatureSchema schema;
+        FeatureMatrix features;
         bool isWriteToFile = false;
         Skeleton *target_skeleton;
 
@@ -32,28 +42,81 @@ namespace identifier {
 
         ~Identifier();
 
-        void Identify(int frame);
+        /**
+         * Extract the features of the targets over the whole clip
+         * @param pose the forward kinematics of target_skeleton's clip
+         */
+        void Identify(const PoseBuffer &pose);
+
+        /**
+         * Same on a snapshot of the clip, safe on a worker thread
+         * @param motion the modified motion the pose buffer was built from
+         */
+        void Identify(const PoseBuffer &pose, const std::vector<double> &motion);
+
+        /**
+         * Take the features from the whole body's (same clip), no extraction
+         * @return false if whole_body lacks a column of the targets
+         */
+        bool Identify(const FeatureMatrix &whole_body);
 
         /**
          * Write the result to a csv file
          * the Format is:
          * frame, target_name_x, target_name_y, target_name_z, target_name_parent, target_name_child1, target_name_child2, ...
          */
-        void WriteOutput();
+        bool WriteOutput();
+
+        /// @return false (with a message) if the file cannot be written
+        bool WriteOutput(const std::string &output_filename);
 
-        void WriteOutput(const std::string &output_filename);
+        /**
+         * LCSS similarity of every feature column with the same column of a reference clip (e.g. the expert's),
+         * computed natively the way Analysize.BvhAnalyze does: resampled to the longer clip, z-normalized, eps 0.5.
+         * Columns the reference does not have are skipped.
+         */
+        std::map<std::string, float> SimilarityScore(const FeatureMatrix &reference, float eps = 0.5f) const;
+
+        /**
+         * LCSS similarity of the waist rotation (KeypointKernel::WaistRotation) of two clips' keypoints, natively
+         * the way Analysize.OpenPoseAnalysize_Waist does: resampled to the longer clip, eps 0.5.
+         * @return 0 if a clip lacks the shoulder columns
+         */
+        static float WaistRotationScore(const OpenPoseData &target, const OpenPoseData &reference, float eps = 0.5f);
 
         vector<float> Py_SimilarityScore();
 
+        /**
+         * Same as Py_SimilarityScore(target_filename, openpose_target_filename) without the files, through the
+         * process' warm ClassifierSession: the angle matrix and the keypoints are handed to Python as read-only
+         * NumPy views of the C++ memory (buffer protocol, no copy and no csv).
+         * @param angles the features of the whole body (the matrix WriteOutput would write)
+         * @param range the frames to score, e.g. one stroke of a practice session (a view, nothing is copied)
+         */
+        vector<float> Py_SimilarityScore(const FeatureMatrix &angles, const OpenPoseData &openpose,
+                                         const FrameRange &range = FrameRange());
+
         vector<float> Py_SimilarityScore(const string &target_filename, const string &openpose_target_filename);
 
         // ------------------------- Getters & Setter ----------------------- //
         const string &GetIdentifierName() const;
+
+        const FeatureSchema &GetSchema() const;
+
+        const FeatureMatrix &GetFeatures() const;
     };
 
     inline const string &Identifier::GetIdentifierName() const {
         return identifier_name;
     }
+
+    inline const FeatureSchema &Identifier::GetSchema() const {
+        return schema;
+    }
+
+    inline const FeatureMatrix &Identifier::GetFeatures() const {
+        return features;
+    }
 }
 
 #endif //TESTBED_IDENTIFIER_H
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+
+#include "InferenceQueue.h"
+
+using namespace inferenceQueue;
+
+InferenceQueue::InferenceQueue(BatchForward forward, const QueueConfig &config)
+        : forward(std::move(forward)), config(config) {
+    this->config.max_batch = std::max(this->config.max_batch, 1);
+    this->config.max_wait = std::max(this->config.max_wait, 0.0);
+    int num_worker = this->config.num_worker;
+    if (num_worker <= 0)
+        num_worker = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < num_worker; i++)
+        workers.emplace_back(&InferenceQueue::WorkerLoop, this);
+}
+
+InferenceQueue::~InferenceQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isStopping = true;
+    }
+    request_ready.notify_all();
+    for (auto &worker: workers)
+        worker.join();
+}
+
+std::future<std::vector<float>> InferenceQueue::Submit(std::vector<float> input, int num_frame) {
+    Request request;
+    auto output = request.output.get_future();
+    // A sequence without a frame has no output, it never joins a batch
+    if (num_frame <= 0) {
+        request.output.set_value({});
+        return output;
+    }
+    request.input = std::move(input);
+    request.num_frame = num_frame;
+    request.submit_time = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(request));
+    }
+    // A worker may be waiting for the first request or for a full batch
+    request_ready.notify_all();
+    return output;
+}
+
+void InferenceQueue::WorkerLoop() {
+    const auto max_wait = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(config.max_wait));
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        request_ready.wait(lock, [this]() { return isStopping || !pending.empty(); });
+        if (pending.empty())
+            return;
+        // A full batch, or whatever is pending once the oldest waited long enough. Stopping runs the rest at once
+        const auto deadline = pending.front().submit_time + max_wait;
+        request_ready.wait_until(lock, deadline, [this]() {
+            return isStopping || pending.empty() || static_cast<int>(pending.size()) >= config.max_batch;
+        });
+        // Another worker took them
+        if (pending.empty())
+            continue;
+        auto batch = TakeBatch();
+        lock.unlock();
+        RunBatch(batch);
+        lock.lock();
+    }
+}
+
+std::vector<InferenceQueue::Request> InferenceQueue::TakeBatch() {
+    // The oldest, then the nearest in length, the older first among equals
+    const int oldest_frame = pending.front().num_frame;
+    std::vector<size_t> order(pending.size() - 1);
+    std::iota(order.begin(), order.end(), 1);
+    const size_t num_other = std::min(order.size(), static_cast<size_t>(config.max_batch - 1));
+    std::partial_sort(order.begin(), order.begin() + num_other, order.end(), [&](size_t a, size_t b) {
+        const int distance_a = std::abs(pending[a].num_frame - oldest_frame);
+        const int distance_b = std::abs(pending[b].num_frame - oldest_frame);
+        return distance_a < distance_b || (distance_a == distance_b && a < b);
+    });
+    order.resize(num_other);
+    order.insert(order.begin(), 0);
+
+    std::vector<char> isTaken(pending.size(), 0);
+    std::vector<Request> batch;
+    for (size_t index: order) {
+        isTaken[index] = 1;
+        batch.push_back(std::move(pending[index]));
+    }
+    std::deque<Request> rest;
+    for (size_t index = 0; index < pending.size(); index++) {
+        if (!isTaken[index])
+            rest.push_back(std::move(pending[index]));
+    }
+    pending.swap(rest);
+    return batch;
+}
+
+void InferenceQueue::RunBatch(std::vector<Request> &batch) {
+    std::vector<const float *> inputs;
+    std::vector<int> num_frames;
+    for (const auto &request: batch) {
+        inputs.push_back(request.input.data());
+        num_frames.push_back(request.num_frame);
+    }
+
+    const auto start = Clock::now();
+    std::vector<float> outputs;
+    bool isFailed = false;
+    try {
+        outputs = forward(inputs, num_frames);
+    } catch (...) {
+        // The worker goes on, every request of the batch gets the exception from its future
+        isFailed = true;
+        const auto error = std::current_exception();
+        for (auto &request: batch)
+            request.output.set_exception(error);
+    }
+    const auto end = Clock::now();
+
+    // Scatter the rows, a forward pass that gave no output gives every request an empty output
+    const size_t num_output = outputs.size() % batch.size() == 0 ? outputs.size() / batch.size() : 0;
+    for (size_t b = 0; b < batch.size() && !isFailed; b++) {
+        batch[b].output.set_value(std::vector<float>(outputs.begin() + b * num_output,
+                                                     outputs.begin() + (b + 1) * num_output));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.num_request += static_cast<int>(batch.size());
+    stats.num_batch++;
+    stats.total_forward += std::chrono::duration<double, std::milli>(end - start).count();
+    const int max_frame = *std::max_element(num_frames.begin(), num_frames.end());
+    for (size_t b = 0; b < batch.size(); b++) {
+        const double wait = std::chrono::duration<double, std::milli>(start - batch[b].submit_time).count();
+        stats.total_wait += wait;
+        stats.max_wait = std::max(stats.max_wait, wait);
+        stats.num_step_frame += max_frame;
+        stats.num_frame += num_frames[b];
+    }
+}
+
+QueueStats InferenceQueue::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
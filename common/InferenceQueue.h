@@ -0,0 +1,130 @@
+#ifndef TESTBED_INFERENCEQUEUE_H
+#define TESTBED_INFERENCEQUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace inferenceQueue {
+
+    /**
+     * One forward pass over a batch of sequences of different lengths (LstmModel::PredictBatch)
+     * @return the outputs of sequence b at b * num_output
+     */
+    using BatchForward = std::function<std::vector<float>(const std::vector<const float *> &inputs,
+                                                          const std::vector<int> &num_frames)>;
+
+    struct QueueConfig {
+        /// A batch runs as soon as it has this many sequences...
+        int max_batch = 16;
+        /// ...or once its oldest sequence waited this long (ms), the latency a lone request pays
+        double max_wait = 2;
+        /// Threads running batches at the same time (0: one per core)
+        int num_worker = 0;
+    };
+
+    /// What the queue did since it started
+    struct QueueStats {
+        int num_request = 0;
+        int num_batch = 0;
+        /// Time from Submit to the start of the request's forward pass, summed over the requests (ms)
+        double total_wait = 0;
+        double max_wait = 0;
+        /// Forward passes, summed over the batches (ms)
+        double total_forward = 0;
+        /// Frames run by the forward passes, the clips that ended early of a batch included, & the clips' own
+        long long num_step_frame = 0;
+        long long num_frame = 0;
+
+        double GetMeanBatch() const;
+
+        double GetMeanWait() const;
+
+        /// Frames run for nothing because a batch's clips differ in length, 0 to 1
+        double GetPaddingRatio() const;
+    };
+
+    /**
+     * Dynamic batching of sequence classifications: Submit hands over one sequence and gets a future of its output
+     * at once, the workers collect the pending sequences into batches & run one forward pass per batch.
+     * A batch starts with the oldest pending sequence and takes the pending ones nearest to it in length, so the
+     * batch's clips end together and the shorter ones waste few steps; the oldest is always in the next batch, no
+     * request waits longer than max_wait plus the batches ahead of it.
+     * The destructor runs what is still pending before it returns. Thread-safe.
+     */
+    class InferenceQueue {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Request {
+            std::vector<float> input;
+            int num_frame = 0;
+            Clock::time_point submit_time;
+            std::promise<std::vector<float>> output;
+        };
+
+        BatchForward forward;
+        QueueConfig config;
+
+        std::mutex mutex;
+        std::condition_variable request_ready;
+        /// Oldest first
+        std::deque<Request> pending;
+        bool isStopping = false;
+        QueueStats stats;
+        std::vector<std::thread> workers;
+
+        // -------------------- Methods -------------------- //
+        void WorkerLoop();
+
+        /// The oldest pending request & the ones nearest to it in length, mutex must be held
+        std::vector<Request> TakeBatch();
+
+        /// Run a batch & fulfil its futures
+        void RunBatch(std::vector<Request> &batch);
+
+    public:
+        explicit InferenceQueue(BatchForward forward, const QueueConfig &config = QueueConfig());
+
+        ~InferenceQueue();
+
+        InferenceQueue(const InferenceQueue &) = delete;
+
+        InferenceQueue &operator=(const InferenceQueue &) = delete;
+
+        /**
+         * Queue one sequence, time-major (frame, input)
+         * @return its output: empty at once if num_frame <= 0, empty if the forward pass gave no output; get()
+         * rethrows what the forward pass threw
+         */
+        std::future<std::vector<float>> Submit(std::vector<float> input, int num_frame);
+
+        // -------------------- Getter & Setter -------------------- //
+        QueueStats GetStats();
+
+        const QueueConfig &GetConfig() const;
+    };
+
+    inline double QueueStats::GetMeanBatch() const {
+        return num_batch > 0 ? static_cast<double>(num_request) / num_batch : 0;
+    }
+
+    inline double QueueStats::GetMeanWait() const {
+        return num_request > 0 ? total_wait / num_request : 0;
+    }
+
+    inline double QueueStats::GetPaddingRatio() const {
+        return num_step_frame > 0 ? 1 - static_cast<double>(num_frame) / num_step_frame : 0;
+    }
+
+    inline const QueueConfig &InferenceQueue::GetConfig() const {
+        return config;
+    }
+}
+
+#endif //TESTBED_INFERENCEQUEUE_H
@@ -0,0 +1,142 @@
+#include <glm/gtc/type_ptr.hpp>
+
+#include "InstancedMesh.h"
+
+using namespace instancedMesh;
+
+InstancedMesh::InstancedMesh(const std::string &mesh_path, const std::vector<openglframework::Color> &palette)
+        : mVBOVertices(GL_ARRAY_BUFFER), mVBONormals(GL_ARRAY_BUFFER), mVBOIndices(GL_ELEMENT_ARRAY_BUFFER),
+          mVBOInstances(GL_ARRAY_BUFFER), palette(palette), group_begin(palette.size() + 1, 0) {
+    openglframework::MeshReaderWriter::loadMeshFromFile(mesh_path, *this);
+    if (mNormals.empty())
+        calculateNormals();
+
+    CreateVBOAndVAO();
+}
+
+InstancedMesh::~InstancedMesh() {
+    mVBOVertices.destroy();
+    mVBONormals.destroy();
+    mVBOIndices.destroy();
+    mVBOInstances.destroy();
+    mVAO.destroy();
+}
+
+void InstancedMesh::CreateVBOAndVAO() {
+    mVBOVertices.create();
+    mVBOVertices.bind();
+    mVBOVertices.copyDataIntoVBO(mVertices.size() * sizeof(openglframework::Vector3), getVerticesPointer(),
+                                 GL_STATIC_DRAW);
+    mVBOVertices.unbind();
+
+    mVBONormals.create();
+    mVBONormals.bind();
+    mVBONormals.copyDataIntoVBO(mNormals.size() * sizeof(openglframework::Vector3), getNormalsPointer(),
+                                GL_STATIC_DRAW);
+    mVBONormals.unbind();
+
+    mVBOIndices.create();
+    mVBOIndices.bind();
+    mVBOIndices.copyDataIntoVBO(mIndices[0].size() * sizeof(unsigned int), getIndicesPointer(), GL_STATIC_DRAW);
+    mVBOIndices.unbind();
+
+    mVBOInstances.create();
+
+    mVAO.create();
+    mVAO.bind();
+    mVBOVertices.bind();
+    mVBONormals.bind();
+    mVBOIndices.bind();
+    mVAO.unbind();
+}
+
+void InstancedMesh::SetInstances(const std::vector<glm::mat4> &matrices, const std::vector<int> &color_index) {
+    // Counting sort by color so every color is one contiguous range
+    std::fill(group_begin.begin(), group_begin.end(), 0);
+    for (auto index: color_index)
+        group_begin[index + 1]++;
+    for (size_t g = 1; g < group_begin.size(); g++)
+        group_begin[g] += group_begin[g - 1];
+
+    std::vector<int> cursor(group_begin.begin(), group_begin.end() - 1);
+    instance_data.resize(matrices.size() * 16);
+    for (size_t i = 0; i < matrices.size(); i++) {
+        const float *matrix = glm::value_ptr(matrices[i]);
+        std::copy(matrix, matrix + 16, instance_data.begin() + static_cast<size_t>(cursor[color_index[i]]++) * 16);
+    }
+    is_instance_dirty = true;
+}
+
+void InstancedMesh::render(openglframework::Shader &shader, const openglframework::Matrix4 &worldToCameraMatrix) {
+    num_draw_call = 0;
+    if (GetNumInstance() == 0)
+        return;
+
+    // The shadow passes and the final pass render the same instances, upload them once
+    if (is_instance_dirty) {
+        mVBOInstances.bind();
+        mVBOInstances.copyDataIntoVBO(instance_data.size() * sizeof(float), instance_data.data(), GL_DYNAMIC_DRAW);
+        mVBOInstances.unbind();
+        is_instance_dirty = false;
+    }
+
+    shader.bind();
+    shader.setMatrix4x4Uniform("worldToCameraMatrix", worldToCameraMatrix);
+    shader.setIntUniform("isInstanced", 1, false);
+
+    mVAO.bind();
+
+    mVBOVertices.bind();
+    GLint vertexPositionLoc = shader.getAttribLocation("vertexPosition");
+    glEnableVertexAttribArray(vertexPositionLoc);
+    glVertexAttribPointer(vertexPositionLoc, 3, GL_FLOAT, GL_FALSE, 0, (char *) nullptr);
+
+    mVBONormals.bind();
+    GLint vertexNormalLoc = shader.getAttribLocation("vertexNormal", false);
+    if (vertexNormalLoc != -1) {
+        glEnableVertexAttribArray(vertexNormalLoc);
+        glVertexAttribPointer(vertexNormalLoc, 3, GL_FLOAT, GL_FALSE, 0, (char *) nullptr);
+    }
+
+    // A mat4 attribute takes 4 consecutive locations, one column each
+    mVBOInstances.bind();
+    GLint instanceMatrixLoc = shader.getAttribLocation("instanceLocalToWorldMatrix");
+    for (int column = 0; column < 4; column++) {
+        glEnableVertexAttribArray(instanceMatrixLoc + column);
+        glVertexAttribDivisor(instanceMatrixLoc + column, 1);
+    }
+
+    for (size_t g = 0; g < palette.size(); g++) {
+        const int count = group_begin[g + 1] - group_begin[g];
+        if (count == 0)
+            continue;
+
+        for (int column = 0; column < 4; column++) {
+            const size_t offset = (static_cast<size_t>(group_begin[g]) * 16 + column * 4) * sizeof(float);
+            glVertexAttribPointer(instanceMatrixLoc + column, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float),
+                                  (char *) nullptr + offset);
+        }
+        const auto &color = palette[g];
+        shader.setVector4Uniform("globalVertexColor", openglframework::Vector4(color.r, color.g, color.b, color.a),
+                                 false);
+
+        glDrawElementsInstanced(GL_TRIANGLES, getNbFaces(0) * 3, GL_UNSIGNED_INT, (char *) nullptr, count);
+        num_draw_call++;
+    }
+
+    for (int column = 0; column < 4; column++) {
+        glVertexAttribDivisor(instanceMatrixLoc + column, 0);
+        glDisableVertexAttribArray(instanceMatrixLoc + column);
+    }
+    glDisableVertexAttribArray(vertexPositionLoc);
+    if (vertexNormalLoc != -1) glDisableVertexAttribArray(vertexNormalLoc);
+
+    mVBOInstances.unbind();
+    mVBONormals.unbind();
+    mVBOVertices.unbind();
+
+    mVAO.unbind();
+
+    shader.setIntUniform("isInstanced", 0, false);
+    shader.unbind();
+}
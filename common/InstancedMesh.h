@@ -0,0 +1,71 @@
+#ifndef TESTBED_INSTANCEDMESH_H
+#define TESTBED_INSTANCEDMESH_H
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "openglframework.h"
+
+namespace instancedMesh {
+
+    /**
+     * A mesh drawn many times with one draw call per color.
+     * The local-to-world matrix of every instance goes into a per-instance vertex attribute
+     * (instanceLocalToWorldMatrix with isInstanced set in the phong / depth / color shaders),
+     * so the number of draw calls does not depend on the number of instances.
+     */
+    class InstancedMesh : public openglframework::Mesh {
+    private:
+        openglframework::VertexBufferObject mVBOVertices;
+        openglframework::VertexBufferObject mVBONormals;
+        openglframework::VertexBufferObject mVBOIndices;
+        openglframework::VertexBufferObject mVBOInstances;
+        openglframework::VertexArrayObject mVAO;
+
+        std::vector<openglframework::Color> palette;
+
+        /// Column-major matrices of the instances sorted by color, group g is [group_begin[g], group_begin[g + 1])
+        std::vector<float> instance_data;
+        std::vector<int> group_begin;
+        bool is_instance_dirty = false;
+
+        int num_draw_call = 0;
+
+        // -------------------- Methods -------------------- //
+        void CreateVBOAndVAO();
+
+    public:
+        /**
+         * @param palette the colors the instances can take, SetInstances refers to them by index
+         */
+        InstancedMesh(const std::string &mesh_path, const std::vector<openglframework::Color> &palette);
+
+        ~InstancedMesh() override;
+
+        /**
+         * Replace all the instances, the buffer is uploaded at the next render
+         * @param color_index index into the palette for each matrix
+         */
+        void SetInstances(const std::vector<glm::mat4> &matrices, const std::vector<int> &color_index);
+
+        void render(openglframework::Shader &shader, const openglframework::Matrix4 &worldToCameraMatrix);
+
+        // -------------------- Getter & Setter -------------------- //
+        int GetNumInstance() const;
+
+        /// Draw calls issued by the last render
+        int GetNumDrawCall() const;
+    };
+
+    inline int InstancedMesh::GetNumInstance() const {
+        return group_begin.empty() ? 0 : group_begin.back();
+    }
+
+    inline int InstancedMesh::GetNumDrawCall() const {
+        return num_draw_call;
+    }
+}
+
+#endif //TESTBED_INSTANCEDMESH_H
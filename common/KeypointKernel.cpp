@@ -0,0 +1,73 @@
+#include <cmath>
+
+#include "KeypointKernel.h"
+#include "AngleKernel.h"
+
+using namespace keypointKernel;
+using angleTool::AngleKernel;
+
+void KeypointKernel::Distance(const float *ax, const float *ay, const float *bx, const float *by, float *out,
+                              size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const float dx = bx[i] - ax[i], dy = by[i] - ay[i];
+        out[i] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+void KeypointKernel::AbsDifference(const float *a, const float *b, float *out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = std::fabs(a[i] - b[i]);
+}
+
+void KeypointKernel::Angle(const float *ax, const float *ay, const float *bx, const float *by,
+                           const float *cx, const float *cy, float *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const float ux = ax[i] - bx[i], uy = ay[i] - by[i];
+        const float vx = cx[i] - bx[i], vy = cy[i] - by[i];
+        // atan2(|u x v|, u . v) stays accurate near 0 and 180 degree, unlike acos of the normalized dot product
+        const float cross = std::fabs(ux * vy - uy * vx), dot = ux * vx + uy * vy;
+        out[i] = AngleKernel::Atan2(cross, dot) * AngleKernel::rad_to_deg;
+    }
+}
+
+void KeypointKernel::Orientation(const float *ax, const float *ay, const float *bx, const float *by, float *out,
+                                 size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = AngleKernel::Atan2(by[i] - ay[i], bx[i] - ax[i]) * AngleKernel::rad_to_deg;
+}
+
+void KeypointKernel::ZNormalize(float *series, size_t n, int ddof) {
+    // Two passes in double, NaN frames masked out of the sums
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        const bool valid = series[i] == series[i];
+        sum += valid ? series[i] : 0.0;
+        count += valid;
+    }
+    if (count == 0)
+        return;
+    const double mean = sum / count;
+
+    double squared_sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        const double deviation = series[i] - mean;
+        squared_sum += series[i] == series[i] ? deviation * deviation : 0.0;
+    }
+    const double deviation = count > static_cast<size_t>(ddof) ? std::sqrt(squared_sum / (count - ddof)) : 0.0;
+    const float scale = deviation > 0 ? static_cast<float>(1 / deviation) : 1.0f;
+    const float offset = static_cast<float>(mean);
+    for (size_t i = 0; i < n; i++)
+        series[i] = (series[i] - offset) * scale;
+}
+
+std::vector<float> KeypointKernel::WaistRotation(const OpenPoseData &openpose) {
+    const int rshoulder = openpose.FindColumn("2DX_rshoulder"), lshoulder = openpose.FindColumn("2DX_lshoulder");
+    if (rshoulder < 0 || lshoulder < 0)
+        return {};
+
+    std::vector<float> rotation(openpose.GetNumFrame());
+    AbsDifference(openpose.Column(rshoulder), openpose.Column(lshoulder), rotation.data(), rotation.size());
+    ZNormalize(rotation.data(), rotation.size());
+    return rotation;
+}
@@ -0,0 +1,58 @@
+#ifndef TESTBED_KEYPOINTKERNEL_H
+#define TESTBED_KEYPOINTKERNEL_H
+
+#include <cstddef>
+#include <vector>
+
+#include "OpenPoseData.h"
+
+using namespace openPoseData;
+
+namespace keypointKernel {
+
+    /**
+     * Batch 2D features of OpenPose keypoints, one value per frame.
+     * Inputs are the columns of OpenPoseData (structure of arrays), every loop is branch-free over contiguous
+     * float arrays so the compiler vectorizes it. A missing keypoint (NaN) gives NaN for that frame.
+     * Resampling is Similarity::Resample.
+     */
+    class KeypointKernel {
+    public:
+        /// Euclidean distance between keypoints a & b
+        static void Distance(const float *ax, const float *ay, const float *bx, const float *by, float *out,
+                             size_t n);
+
+        /// |a - b|, the distance along one axis (e.g. 2DX_rshoulder & 2DX_lshoulder)
+        static void AbsDifference(const float *a, const float *b, float *out, size_t n);
+
+        /**
+         * Angle (degree, [0, 180]) at the joint b between the segments b->a and b->c, e.g. the elbow angle of
+         * shoulder, elbow, wrist. Max error 1.2e-4 degree (AngleKernel::Atan2). 0 if a segment has no length.
+         */
+        static void Angle(const float *ax, const float *ay, const float *bx, const float *by,
+                          const float *cx, const float *cy, float *out, size_t n);
+
+        /**
+         * Direction (degree, (-180, 180]) of the segment a->b in the image, from the x axis towards the y axis
+         * (downwards, the image y axis points down). Max error 1.2e-4 degree.
+         */
+        static void Orientation(const float *ax, const float *ay, const float *bx, const float *by, float *out,
+                                size_t n);
+
+        /**
+         * Scale the series in place to mean 0 and standard deviation 1 like pandas, (x - x.mean()) / x.std():
+         * NaN frames are skipped by the statistics and stay NaN, the standard deviation has ddof degrees of
+         * freedom removed (pandas: 1). A constant series only gets centered.
+         */
+        static void ZNormalize(float *series, size_t n, int ddof = 1);
+
+        /**
+         * The waist rotation feature of Analysize.WaistRotationRead: the z-normalized horizontal distance between
+         * the shoulders, |2DX_rshoulder - 2DX_lshoulder|
+         * @return empty if a shoulder column is missing
+         */
+        static std::vector<float> WaistRotation(const OpenPoseData &openpose);
+    };
+}
+
+#endif //TESTBED_KEYPOINTKERNEL_H
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstring>
+
+#include <pybind11/embed.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "KeypointKernel.h"
+
+namespace py = pybind11;
+using namespace keypointKernel;
+
+namespace {
+    using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+    /// All the arrays as 1d series of the same length
+    size_t GetLength(std::initializer_list<const FloatArray *> series_list) {
+        const size_t n = (*series_list.begin())->size();
+        for (const auto *series: series_list) {
+            if (series->ndim() != 1 || static_cast<size_t>(series->size()) != n)
+                throw py::value_error("expect 1d arrays of the same length");
+        }
+        return n;
+    }
+
+    /// (num_frame, num_column) Fortran-ordered copy of the column-major matrix, no transpose
+    py::array ToArray(const OpenPoseData &openpose) {
+        py::array_t<float, py::array::f_style> array({openpose.GetNumFrame(), openpose.GetNumColumn()});
+        std::memcpy(array.mutable_data(), openpose.GetData().data(), openpose.GetData().size() * sizeof(float));
+        return array;
+    }
+
+    OpenPoseData LoadOrThrow(const std::string &filename, const std::vector<std::string> &columns) {
+        OpenPoseData openpose;
+        bool isLoaded;
+        {
+            py::gil_scoped_release release;
+            isLoaded = openpose.Load(filename, columns);
+        }
+        if (!isLoaded)
+            throw py::value_error("cannot open the openpose file " + filename);
+        return openpose;
+    }
+}
+
+/**
+ * The native OpenPose csv loader & 2D keypoint kernels for the Python analysis (Py_package.PyAnalysizer.Analysize).
+ * It only exists inside the testbed's interpreter, the Python code falls back to pandas elsewhere.
+ */
+PYBIND11_EMBEDDED_MODULE(native_keypoints, m) {
+    m.doc() = "Native OpenPose csv loading & 2D keypoint features";
+
+    m.def("load_csv", [](const std::string &filename, const std::vector<std::string> &columns) {
+        const OpenPoseData openpose = LoadOrThrow(filename, columns);
+        return py::make_tuple(openpose.GetColumnNames(), ToArray(openpose));
+    }, py::arg("filename"), py::arg("columns") = std::vector<std::string>(),
+          "(column names, (frame, column) float32 array), only the given columns if any");
+
+    m.def("distance", [](const FloatArray &ax, const FloatArray &ay, const FloatArray &bx, const FloatArray &by) {
+        const size_t n = GetLength({&ax, &ay, &bx, &by});
+        FloatArray result(n);
+        {
+            py::gil_scoped_release release;
+            KeypointKernel::Distance(ax.data(), ay.data(), bx.data(), by.data(), result.mutable_data(), n);
+        }
+        return result;
+    }, py::arg("ax"), py::arg("ay"), py::arg("bx"), py::arg("by"));
+
+    m.def("angle", [](const FloatArray &ax, const FloatArray &ay, const FloatArray &bx, const FloatArray &by,
+                      const FloatArray &cx, const FloatArray &cy) {
+        const size_t n = GetLength({&ax, &ay, &bx, &by, &cx, &cy});
+        FloatArray result(n);
+        {
+            py::gil_scoped_release release;
+            KeypointKernel::Angle(ax.data(), ay.data(), bx.data(), by.data(), cx.data(), cy.data(),
+                                  result.mutable_data(), n);
+        }
+        return result;
+    }, py::arg("ax"), py::arg("ay"), py::arg("bx"), py::arg("by"), py::arg("cx"), py::arg("cy"));
+
+    m.def("orientation", [](const FloatArray &ax, const FloatArray &ay, const FloatArray &bx, const FloatArray &by) {
+        const size_t n = GetLength({&ax, &ay, &bx, &by});
+        FloatArray result(n);
+        {
+            py::gil_scoped_release release;
+            KeypointKernel::Orientation(ax.data(), ay.data(), bx.data(), by.data(), result.mutable_data(), n);
+        }
+        return result;
+    }, py::arg("ax"), py::arg("ay"), py::arg("bx"), py::arg("by"));
+
+    m.def("znormalize", [](const FloatArray &series, int ddof) {
+        const size_t n = GetLength({&series});
+        FloatArray result(n);
+        std::copy(series.data(), series.data() + n, result.mutable_data());
+        {
+            py::gil_scoped_release release;
+            KeypointKernel::ZNormalize(result.mutable_data(), n, ddof);
+        }
+        return result;
+    }, py::arg("series"), py::arg("ddof") = 1);
+
+    m.def("waist_rotation", [](const std::string &filename) {
+        const OpenPoseData openpose = LoadOrThrow(filename, {"2DX_rshoulder", "2DX_lshoulder"});
+        auto rotation = KeypointKernel::WaistRotation(openpose);
+        if (rotation.empty())
+            throw py::value_error("no 2DX_rshoulder / 2DX_lshoulder column in " + filename);
+        return FloatArray(rotation.size(), rotation.data());
+    }, py::arg("filename"), "Same as Analysize.WaistRotationRead");
+}
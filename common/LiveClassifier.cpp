@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "LiveClassifier.h"
+#include "BoneNames.h"
+#include "ForehandSuggestion.h"
+
+using namespace liveClassifier;
+
+LiveClassifier::LiveClassifier(const LiveConfig &config) : config(config) {}
+
+LiveClassifier::LiveClassifier(const LiveConfig &config, const LstmModel &model)
+        : config(config), model(model), isModelLoaded(model.IsLoaded()) {}
+
+bool LiveClassifier::Start(const BVH *new_bvh, const std::string &openpose_path) {
+    Stop();
+    if (new_bvh == nullptr)
+        return false;
+    if (!isModelLoaded) {
+        isModelLoaded = model.Load(config.model_path);
+        if (!isModelLoaded) {
+            std::cout << "Live classification needs the exported model " << config.model_path << std::endl;
+            return false;
+        }
+    }
+
+    // The model's columns: the angle features it reads, the others are keypoints
+    const FeatureSchema body_schema(new_bvh, skeleton::TARGET_BONE_NAMES, skeleton::TARGET_BONE_NAMES);
+    const auto &column_names = model.GetInputSpec().column_names;
+    std::vector<FeatureColumn> columns;
+    std::vector<std::string> keypoint_names;
+    input_columns.assign(column_names.size(), -1);
+    keypoint_columns.assign(column_names.size(), -1);
+    for (size_t i = 0; i < column_names.size(); i++) {
+        const int column = body_schema.FindColumn(column_names[i]);
+        if (column >= 0) {
+            input_columns[i] = static_cast<int>(columns.size());
+            columns.push_back(body_schema.GetColumns()[column]);
+        } else {
+            keypoint_names.push_back(column_names[i]);
+        }
+    }
+    openpose = OpenPoseData();
+    if (!keypoint_names.empty() && (openpose_path.empty() || !openpose.Load(openpose_path, keypoint_names))) {
+        std::cout << "Live classification needs the keypoints of the clip (" << keypoint_names.size()
+                  << " model inputs)" << std::endl;
+        return false;
+    }
+    for (size_t i = 0; i < column_names.size(); i++) {
+        if (input_columns[i] >= 0)
+            continue;
+        keypoint_columns[i] = openpose.FindColumn(column_names[i]);
+        if (keypoint_columns[i] < 0) {
+            std::cout << "The model input " << column_names[i] << " is missing" << std::endl;
+            return false;
+        }
+    }
+
+    bvh = new_bvh;
+    schema = FeatureSchema(body_schema.GetTargetList(), columns);
+    input.assign(column_names.size(), 0.0f);
+    previous_input = step_input = input;
+    model.ResetState(state);
+    last_frame = -1;
+    num_since_output = 0;
+
+    // The window resampled to sequence_length spans the same [0, 1] as the clips BuildInput resamples
+    window_frames = bvh->GetInterval() > 0 ? std::max(
+            static_cast<int>(std::lround(config.window_seconds / bvh->GetInterval())), 1) : 1;
+    const int sequence_length = model.GetInputSpec().sequence_length;
+    num_window_step = sequence_length > 0 ? sequence_length : window_frames;
+    step_frames = num_window_step > 1 ? (window_frames - 1.0) / (num_window_step - 1) : 1.0;
+    window_begin = 0;
+    num_fed_step = 0;
+    probabilities.clear();
+    latencies.clear();
+    next_latency = 0;
+    num_step = 0;
+    num_over_budget = 0;
+    return true;
+}
+
+void LiveClassifier::Stop() {
+    if (bvh == nullptr)
+        return;
+    const auto stats = GetLatencyStats();
+    std::cout << "Live classification: " << num_step << " steps, p50 " << stats.p50 << " ms, p99 " << stats.p99
+              << " ms, max " << stats.max << " ms, " << stats.num_over_budget << " over the " << config.budget_ms
+              << " ms budget" << std::endl;
+    bvh = nullptr;
+    probabilities.clear();
+}
+
+bool LiveClassifier::Step(int frame) {
+    if (bvh == nullptr || frame < 0 || frame >= bvh->GetNumModifiedFrame())
+        return false;
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    // Playback jumped (seek, loop) or the window is over: a new stream
+    if (frame != last_frame + 1 || frame - window_begin >= window_frames) {
+        model.ResetState(state);
+        window_begin = frame;
+        num_fed_step = 0;
+        num_since_output = 0;
+    }
+    last_frame = frame;
+
+    // The steps in (frame - 1, frame] of the window, the first one is on its first frame
+    std::swap(input, previous_input);
+    BuildFrameInput(frame);
+    const int window_frame = frame - window_begin;
+    for (; num_fed_step < num_window_step; num_fed_step++) {
+        const double position = num_fed_step * step_frames;
+        if (position > window_frame + 1e-6)
+            break;
+        const float alpha = std::min(static_cast<float>(position - (window_frame - 1)), 1.0f);
+        for (size_t i = 0; i < input.size(); i++)
+            step_input[i] = previous_input[i] + alpha * (input[i] - previous_input[i]);
+        model.Advance(step_input.data(), 1, state);
+    }
+    const bool isOutput = ++num_since_output >= config.hop && num_fed_step > 0;
+    if (isOutput) {
+        probabilities = model.Output(state);
+        num_since_output = 0;
+    }
+
+    const float latency = std::chrono::duration<float, std::milli>(
+            std::chrono::high_resolution_clock::now() - start).count();
+    if (static_cast<int>(latencies.size()) < latency_capacity)
+        latencies.push_back(latency);
+    else
+        latencies[next_latency] = latency;
+    next_latency = (next_latency + 1) % latency_capacity;
+    num_step++;
+    num_over_budget += latency > config.budget_ms;
+    return isOutput;
+}
+
+void LiveClassifier::BuildFrameInput(int frame) {
+    // Forward kinematics & features of this frame only, the angles do not depend on where the skeleton stands
+    const int num_channel = bvh->GetNumChannel();
+    const auto &motion = *bvh->GetModifiedMotions();
+    frame_motion.assign(motion.begin() + static_cast<size_t>(frame) * num_channel,
+                        motion.begin() + static_cast<size_t>(frame + 1) * num_channel);
+    pose.BuildFrame(bvh, frame, glm::vec3(0.0f));
+    const FeatureMatrix features = FeatureExtractor::Extract(schema, bvh, frame_motion, pose);
+
+    const auto &input_spec = model.GetInputSpec();
+    const int openpose_frame = openpose.GetNumFrame() > 0 ? std::min(
+            FrameRange{frame, frame + 1}.Rescale(bvh->GetNumModifiedFrame(), openpose.GetNumFrame()).begin,
+            openpose.GetNumFrame() - 1) : 0;
+    for (size_t i = 0; i < input.size(); i++) {
+        const float raw = input_columns[i] >= 0 ? features.At(0, input_columns[i])
+                                                : openpose.Column(keypoint_columns[i])[openpose_frame];
+        const float mean = input_spec.mean[i], std = input_spec.std[i] != 0 ? input_spec.std[i] : 1.0f;
+        // A missing keypoint (NaN) becomes the mean
+        const float value = (raw - mean) / std;
+        input[i] = std::isnan(value) ? 0.0f : value;
+    }
+}
+
+std::vector<std::string> LiveClassifier::GetFailedBones() const {
+    std::vector<std::string> bones;
+    if (probabilities.empty())
+        return bones;
+    for (const auto &[identifier_name, bone_name]: config.identifier_bones) {
+        if (!forehandSuggestion::ForehandSuggestion::IsPass(identifier_name, probabilities))
+            bones.push_back(bone_name);
+    }
+    return bones;
+}
+
+LatencyStats LiveClassifier::GetLatencyStats() const {
+    LatencyStats stats;
+    stats.num_step = num_step;
+    stats.num_over_budget = num_over_budget;
+    if (latencies.empty())
+        return stats;
+
+    std::vector<float> sorted = latencies;
+    const auto percentile = [&sorted](double p) {
+        auto nth = sorted.begin() + static_cast<size_t>(p * (sorted.size() - 1));
+        std::nth_element(sorted.begin(), nth, sorted.end());
+        return static_cast<double>(*nth);
+    };
+    stats.p50 = percentile(0.5);
+    stats.p99 = percentile(0.99);
+    stats.max = *std::max_element(sorted.begin(), sorted.end());
+    return stats;
+}
@@ -0,0 +1,157 @@
+#ifndef TESTBED_LIVECLASSIFIER_H
+#define TESTBED_LIVECLASSIFIER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BVH.h"
+#include "PoseBuffer.h"
+#include "FeatureExtractor.h"
+#include "OpenPoseData.h"
+#include "LstmEngine.h"
+
+using namespace bvh;
+using namespace poseBuffer;
+using namespace featureExtractor;
+using namespace openPoseData;
+using namespace lstmEngine;
+
+namespace liveClassifier {
+
+    struct LiveConfig {
+        /// The weights exported by ExportLstm.py, the same file as the classifier session's
+        std::string model_path = "static/forehand_lstm.bin";
+        /// A new classification every hop frames of playback, from the state the window reached
+        int hop = 5;
+        /**
+         * Length of the clips the model was trained on (s): playback is cut into windows of this length, each fed
+         * on the model's time scale (resampled to sequence_length steps like LstmModel::BuildInput resamples a clip,
+         * at the BVH's rate if the model has none), the recurrent state starts over with every window
+         */
+        double window_seconds = 1.5;
+        /// Latency budget of one Step (ms), longer steps are counted
+        double budget_ms = 4.0;
+        /// The bone tinted when an identifier fails, like Analysizer's forehand identifiers
+        std::map<std::string, std::string> identifier_bones = {{"rotation", "hip"}, {"fore_arm", "rForeArm"}};
+    };
+
+    /// Latency of the last steps (ms)
+    struct LatencyStats {
+        int num_step = 0;
+        double p50 = 0;
+        double p99 = 0;
+        double max = 0;
+        /// Steps over LiveConfig::budget_ms, since Start
+        int num_over_budget = 0;
+    };
+
+    /**
+     * Posture classification that follows playback frame by frame, for live coaching.
+     * Every Step handles only the frame just shown: the forward kinematics & the model's feature columns of that
+     * frame (PoseBuffer::BuildFrame, FeatureExtractor on one frame), then the LSTM steps that fall between the
+     * previous frame & this one on the model's time scale, interpolated between the two frames, from the recurrent
+     * state the previous frame left (LstmModel::Advance). Every hop frames the dense layers read the state, giving
+     * the classification of the window so far; nothing is recomputed over the clip.
+     * The state starts over with every window (window_seconds) and when playback jumps (a seek, the clip looping).
+     *
+     * Runs on the main thread, the BVH is read as it is edited. Step's latency (ms) is kept over the last steps,
+     * GetLatencyStats gives its p50 & p99.
+     */
+    class LiveClassifier {
+    private:
+        LiveConfig config;
+        LstmModel model;
+        bool isModelLoaded = false;
+
+        // -------------------- Stream -------------------- //
+        const BVH *bvh = nullptr;
+        /// Only the feature columns the model reads
+        FeatureSchema schema;
+        /// Model input i comes from schema column input_columns[i], or if -1 from openpose column keypoint_columns[i]
+        std::vector<int> input_columns, keypoint_columns;
+        OpenPoseData openpose;
+
+        PoseBuffer pose;
+        std::vector<double> frame_motion;
+        /// The model input of the frame & of the previous one, the steps between them interpolate
+        std::vector<float> input, previous_input, step_input;
+        LstmState state;
+        int last_frame = -1;
+        int num_since_output = 0;
+        /// Frames of a window, frames of playback per LSTM step & steps per window
+        int window_frames = 1;
+        double step_frames = 1;
+        int num_window_step = 1;
+        /// The current window's first frame & the steps fed since
+        int window_begin = 0;
+        int num_fed_step = 0;
+
+        std::vector<float> probabilities;
+
+        // -------------------- Latency -------------------- //
+        /// The last latency_capacity step latencies (ms), a ring
+        static constexpr int latency_capacity = 1024;
+        std::vector<float> latencies;
+        int next_latency = 0;
+        int num_step = 0;
+        int num_over_budget = 0;
+
+        // -------------------- Methods -------------------- //
+        /// The model input of one frame, standardized like LstmModel::BuildInput
+        void BuildFrameInput(int frame);
+
+    public:
+        LiveClassifier() = default;
+
+        explicit LiveClassifier(const LiveConfig &config);
+
+        /// With a model already in memory (e.g. a benchmark's), model_path is not read
+        LiveClassifier(const LiveConfig &config, const LstmModel &model);
+
+        /**
+         * Follow a clip from its next Step, the model is loaded on the first call.
+         * The BVH must outlive the stream: Stop before deleting it.
+         * @param openpose_path the clip's keypoints, only read if the model takes keypoint columns
+         * @return false (with a message) if the model cannot be loaded or one of its inputs is missing
+         */
+        bool Start(const BVH *new_bvh, const std::string &openpose_path = "");
+
+        /// Stop following the clip, the latency of the stream is printed
+        void Stop();
+
+        /**
+         * The frame playback just showed (the modified motion's)
+         * @return true if a new classification is out (GetProbabilities)
+         */
+        bool Step(int frame);
+
+        /// The bones of the identifiers the last classification failed, to tint with Skeleton::ShowAnalyzeResult
+        std::vector<std::string> GetFailedBones() const;
+
+        /// p50 & p99 over the last steps
+        LatencyStats GetLatencyStats() const;
+
+        // -------------------- Getter & Setter -------------------- //
+        bool IsRunning() const;
+
+        /// The last classification, empty before the first window
+        const std::vector<float> &GetProbabilities() const;
+
+        const LiveConfig &GetConfig() const;
+    };
+
+    inline bool LiveClassifier::IsRunning() const {
+        return bvh != nullptr;
+    }
+
+    inline const std::vector<float> &LiveClassifier::GetProbabilities() const {
+        return probabilities;
+    }
+
+    inline const LiveConfig &LiveClassifier::GetConfig() const {
+        return config;
+    }
+}
+
+#endif //TESTBED_LIVECLASSIFIER_H
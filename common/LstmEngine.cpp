@@ -0,0 +1,589 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include "LstmEngine.h"
+#include "Similarity.h"
+
+using namespace lstmEngine;
+
+namespace {
+    const char model_magic[8] = {'T', 'B', 'L', 'S', 'T', 'M', '1', '\0'};
+
+    /// exp for x in [-87, 88] (clamped): 2^k * e^f with |f| <= ln(2) / 2, relative error 3e-7
+    inline float Exp(float x) {
+        x = x > 88.0f ? 88.0f : (x < -87.0f ? -87.0f : x);
+        const float t = x * 1.44269504088896341f;
+        const int k = static_cast<int>(t + (t < 0 ? -0.5f : 0.5f));
+        // x - k ln(2) with ln(2) split in two so the reduction stays exact for large k
+        const float f = (x - static_cast<float>(k) * 0.693145751953125f) - static_cast<float>(k) * 1.428606765330187e-6f;
+        // Taylor series of e^f, |f| <= 0.347
+        const float p = 1.0f + f * (1.0f + f * (0.5f + f * (1.6666667e-1f + f * (4.1666667e-2f +
+                        f * (8.3333333e-3f + f * 1.3888889e-3f)))));
+        const int32_t bits = (k + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(float));
+        return p * scale;
+    }
+
+    inline float Sigmoid(float x) {
+        return 1.0f / (1.0f + Exp(-x));
+    }
+
+    inline float Tanh(float x) {
+        return 2.0f / (1.0f + Exp(-2.0f * x)) - 1.0f;
+    }
+
+    const int gemm_block = 32;
+    const int gemm_rows = 4;
+
+    inline float Decode(float w) {
+        return w;
+    }
+
+    inline float Decode(int8_t w) {
+        return static_cast<float>(w);
+    }
+
+    /// Half to float without branches (no inf / NaN in weights): the exponent is rebased by a multiplication
+    inline float Decode(uint16_t w) {
+        const uint32_t magnitude = static_cast<uint32_t>(w & 0x7fff) << 13;
+        float value;
+        std::memcpy(&value, &magnitude, sizeof(float));
+        value *= 5.192296858534828e+33f; // 2^112
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        bits |= static_cast<uint32_t>(w & 0x8000) << 16;
+        std::memcpy(&value, &bits, sizeof(float));
+        return value;
+    }
+
+    /// Round to nearest even, values out of the half range saturate, the tiny ones become subnormal or 0
+    uint16_t EncodeHalf(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(float));
+        const uint16_t sign = (bits >> 16) & 0x8000;
+        const float magnitude = std::min(std::abs(value), 65504.0f);
+        if (magnitude < 6.103515625e-05f) // Subnormal: multiple of 2^-24
+            return sign | static_cast<uint16_t>(std::nearbyint(magnitude * 16777216.0f));
+        std::memcpy(&bits, &magnitude, sizeof(float));
+        // Drop 13 mantissa bits with rounding to nearest even, then rebase the exponent
+        bits += 0xfff + ((bits >> 13) & 1);
+        return sign | static_cast<uint16_t>((bits >> 13) - ((127 - 15) << 10));
+    }
+
+    /// gemm_rows rows of y times one block of gemm_block columns, every weight read serves the gemm_rows rows
+    template<int num_row, typename Weight>
+    void GemmBlock(const float *__restrict x, int inner, const Weight *__restrict w, int cols,
+                   const float *__restrict scale, float *__restrict y) {
+        float sum[num_row][gemm_block] = {};
+        for (int k = 0; k < inner; k++) {
+            const Weight *w_row = w + static_cast<size_t>(k) * cols;
+            for (int r = 0; r < num_row; r++) {
+                const float x_value = x[static_cast<size_t>(r) * inner + k];
+                for (int c = 0; c < gemm_block; c++)
+                    sum[r][c] += x_value * Decode(w_row[c]);
+            }
+        }
+        for (int r = 0; r < num_row; r++)
+            for (int c = 0; c < gemm_block; c++)
+                y[static_cast<size_t>(r) * cols + c] += scale ? sum[r][c] * scale[c] : sum[r][c];
+    }
+
+    /**
+     * y[r][c] += sum_k x[r][k] * w[k][c] for r < rows, c < cols, with scale[c] applied to the sums if given.
+     * Tiled by gemm_rows rows (the clips of a batch) & gemm_block columns accumulated in registers, the innermost
+     * loop runs over contiguous outputs.
+     */
+    template<typename Weight>
+    void Gemm(const float *__restrict x, int rows, int inner, const Weight *__restrict w, int cols,
+              const float *__restrict scale, float *__restrict y) {
+        const int block_end = cols - cols % gemm_block;
+        for (int begin = 0; begin < block_end; begin += gemm_block) {
+            const float *block_scale = scale ? scale + begin : nullptr;
+            int r = 0;
+            for (; r + gemm_rows <= rows; r += gemm_rows)
+                GemmBlock<gemm_rows>(x + static_cast<size_t>(r) * inner, inner, w + begin, cols, block_scale,
+                                     y + static_cast<size_t>(r) * cols + begin);
+            for (; r < rows; r++)
+                GemmBlock<1>(x + static_cast<size_t>(r) * inner, inner, w + begin, cols, block_scale,
+                             y + static_cast<size_t>(r) * cols + begin);
+        }
+        // The last columns (e.g. the 6 outputs of the classifier)
+        for (int r = 0; r < rows; r++)
+            for (int c = block_end; c < cols; c++) {
+                float sum = 0;
+                for (int k = 0; k < inner; k++)
+                    sum += x[static_cast<size_t>(r) * inner + k] * Decode(w[static_cast<size_t>(k) * cols + c]);
+                y[static_cast<size_t>(r) * cols + c] += scale ? sum * scale[c] : sum;
+            }
+    }
+
+    void Gemm(const float *x, int rows, const PackedMatrix &w, float *y) {
+        switch (w.precision) {
+            case FP32:
+                Gemm(x, rows, w.inner, w.fp32.data(), w.cols, nullptr, y);
+                break;
+            case FP16:
+                Gemm(x, rows, w.inner, w.fp16.data(), w.cols, nullptr, y);
+                break;
+            case INT8:
+                Gemm(x, rows, w.inner, w.int8.data(), w.cols, w.scale.data(), y);
+                break;
+        }
+    }
+
+    /**
+     * matrix is [inner][cols] (already transposed)
+     * @param importance weight of each inner row's error for INT8, [inner] or empty for all alike
+     */
+    PackedMatrix Pack(const std::vector<float> &matrix, int inner, int cols, Precision precision,
+                      const std::vector<float> &importance) {
+        PackedMatrix packed;
+        packed.inner = inner;
+        packed.cols = cols;
+        packed.precision = precision;
+        if (precision == FP32) {
+            packed.fp32 = matrix;
+        } else if (precision == FP16) {
+            packed.fp16.resize(matrix.size());
+            std::transform(matrix.begin(), matrix.end(), packed.fp16.begin(), EncodeHalf);
+        } else {
+            // Per output channel: a few outlying weights would leave the others few levels, the threshold that maps
+            // to 127 is the one with the least error over the column, the weights beyond it are clipped
+            const auto quantize = [](float weight, float scale) {
+                return std::min(std::max(std::nearbyint(weight / scale), -127.0f), 127.0f);
+            };
+            const int num_threshold = 41;
+            packed.scale.assign(cols, 1.0f);
+            for (int c = 0; c < cols; c++) {
+                float max_weight = 0;
+                for (int k = 0; k < inner; k++)
+                    max_weight = std::max(max_weight, std::abs(matrix[static_cast<size_t>(k) * cols + c]));
+                if (max_weight == 0)
+                    continue;
+                double best_error = std::numeric_limits<double>::infinity();
+                for (int t = 0; t < num_threshold; t++) {
+                    const float scale = max_weight * (1.0f - 0.5f * t / (num_threshold - 1)) / 127.0f;
+                    double error = 0;
+                    for (int k = 0; k < inner; k++) {
+                        const float weight = matrix[static_cast<size_t>(k) * cols + c];
+                        const double difference = weight - quantize(weight, scale) * scale;
+                        error += (importance.empty() ? 1.0 : importance[k]) * difference * difference;
+                    }
+                    if (error < best_error) {
+                        best_error = error;
+                        packed.scale[c] = scale;
+                    }
+                }
+            }
+            packed.int8.resize(matrix.size());
+            for (int k = 0; k < inner; k++)
+                for (int c = 0; c < cols; c++) {
+                    const size_t i = static_cast<size_t>(k) * cols + c;
+                    packed.int8[i] = static_cast<int8_t>(quantize(matrix[i], packed.scale[c]));
+                }
+        }
+        return packed;
+    }
+
+    /// [rows][cols] -> [cols][rows] into output at column offset (output has output_cols columns)
+    void Transpose(const float *matrix, int rows, int cols, float *output, int output_cols, int offset) {
+        for (int r = 0; r < rows; r++)
+            for (int c = 0; c < cols; c++)
+                output[static_cast<size_t>(c + offset) * output_cols + r] = matrix[static_cast<size_t>(r) * cols + c];
+    }
+
+    template<typename T>
+    bool Read(std::ifstream &file, T &value) {
+        return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+
+    bool ReadFloats(std::ifstream &file, std::vector<float> &values, size_t count) {
+        values.resize(count);
+        return static_cast<bool>(file.read(reinterpret_cast<char *>(values.data()), count * sizeof(float)));
+    }
+}
+
+size_t PackedMatrix::GetBytes() const {
+    return fp32.size() * sizeof(float) + fp16.size() * sizeof(uint16_t) + int8.size() * sizeof(int8_t) +
+           scale.size() * sizeof(float);
+}
+
+LstmModel::LstmModel(const InputSpec &input_spec, const std::vector<LstmLayer> &lstm_layers,
+                     const std::vector<DenseLayer> &dense_layers)
+        : input_spec(input_spec), lstm_layers(lstm_layers), dense_layers(dense_layers) {
+    PrepareWeights();
+}
+
+void LstmModel::PrepareWeights() {
+    // [x_t, h_t-1] times the stacked [weight_ih; weight_hh] transposed gives all the gates of a step at once
+    lstm_weights.clear();
+    for (size_t l = 0; l < lstm_layers.size(); l++) {
+        const auto &layer = lstm_layers[l];
+        const int num_gate = 4 * layer.hidden_size, inner = layer.input_size + layer.hidden_size;
+        std::vector<float> weight(static_cast<size_t>(inner) * num_gate);
+        Transpose(layer.weight_ih.data(), num_gate, layer.input_size, weight.data(), num_gate, 0);
+        Transpose(layer.weight_hh.data(), num_gate, layer.hidden_size, weight.data(), num_gate, layer.input_size);
+        lstm_weights.push_back(Pack(weight, inner, num_gate, precision,
+                                    IsCalibrated() ? lstm_importance[l] : std::vector<float>()));
+    }
+
+    dense_weights.clear();
+    for (size_t l = 0; l < dense_layers.size(); l++) {
+        const auto &layer = dense_layers[l];
+        std::vector<float> weight(static_cast<size_t>(layer.input_size) * layer.output_size);
+        Transpose(layer.weight.data(), layer.output_size, layer.input_size, weight.data(), layer.output_size, 0);
+        dense_weights.push_back(Pack(weight, layer.input_size, layer.output_size, precision,
+                                     IsCalibrated() ? dense_importance[l] : std::vector<float>()));
+    }
+}
+
+void LstmModel::SetPrecision(Precision precision) {
+    if (this->precision == precision)
+        return;
+    this->precision = precision;
+    PrepareWeights();
+}
+
+bool LstmModel::Calibrate(const std::vector<const float *> &inputs, const std::vector<int> &num_frames) {
+    const int batch = inputs.size();
+    if (!IsLoaded() || batch == 0 || num_frames.size() != inputs.size() ||
+        *std::min_element(num_frames.begin(), num_frames.end()) <= 0)
+        return false;
+
+    // The inputs the float weights see, whatever the precision
+    const Precision calibrated = precision;
+    precision = FP32;
+    lstm_importance.clear();
+    dense_importance.clear();
+    PrepareWeights();
+
+    std::vector<std::vector<double>> lstm_power(lstm_layers.size()), dense_power(dense_layers.size());
+    LstmState state;
+    InitState(state, batch);
+    RunLstm(inputs, num_frames, state, &lstm_power);
+    RunDense(state.hidden.back(), batch, &dense_power);
+
+    double num_step = 0;
+    for (int num_frame: num_frames)
+        num_step += num_frame;
+    for (const auto &power: lstm_power) {
+        lstm_importance.emplace_back(power.size());
+        std::transform(power.begin(), power.end(), lstm_importance.back().begin(),
+                       [num_step](double sum) { return static_cast<float>(sum / num_step); });
+    }
+    for (const auto &power: dense_power) {
+        dense_importance.emplace_back(power.size());
+        std::transform(power.begin(), power.end(), dense_importance.back().begin(),
+                       [batch](double sum) { return static_cast<float>(sum / batch); });
+    }
+
+    precision = calibrated;
+    PrepareWeights();
+    return true;
+}
+
+size_t LstmModel::GetWeightBytes() const {
+    size_t bytes = 0;
+    for (const auto &weight: lstm_weights)
+        bytes += weight.GetBytes();
+    for (const auto &weight: dense_weights)
+        bytes += weight.GetBytes();
+    for (const auto &layer: lstm_layers)
+        bytes += layer.bias.size() * sizeof(float);
+    for (const auto &layer: dense_layers)
+        bytes += layer.bias.size() * sizeof(float);
+    return bytes;
+}
+
+bool LstmModel::Load(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << "Cannot open the model " << filename << std::endl;
+        return false;
+    }
+
+    const auto fail = [&filename, this]() {
+        std::cout << "Not a valid model " << filename << std::endl;
+        lstm_layers.clear();
+        dense_layers.clear();
+        return false;
+    };
+
+    char magic[8];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, model_magic, sizeof(magic)) != 0)
+        return fail();
+
+    InputSpec spec;
+    uint32_t num_column;
+    if (!Read(file, num_column))
+        return fail();
+    for (uint32_t i = 0; i < num_column; i++) {
+        uint32_t length;
+        if (!Read(file, length))
+            return fail();
+        std::string name(length, '\0');
+        if (!file.read(&name[0], length))
+            return fail();
+        spec.column_names.push_back(name);
+    }
+    uint32_t sequence_length;
+    if (!ReadFloats(file, spec.mean, num_column) || !ReadFloats(file, spec.std, num_column) ||
+        !Read(file, sequence_length))
+        return fail();
+    spec.sequence_length = sequence_length;
+
+    uint32_t num_lstm_layer, num_dense_layer;
+    std::vector<LstmLayer> lstms;
+    if (!Read(file, num_lstm_layer) || num_lstm_layer == 0)
+        return fail();
+    for (uint32_t l = 0; l < num_lstm_layer; l++) {
+        LstmLayer layer;
+        uint32_t input_size, hidden_size;
+        if (!Read(file, input_size) || !Read(file, hidden_size))
+            return fail();
+        layer.input_size = input_size;
+        layer.hidden_size = hidden_size;
+        const size_t num_gate = 4 * static_cast<size_t>(hidden_size);
+        if (!ReadFloats(file, layer.weight_ih, num_gate * input_size) ||
+            !ReadFloats(file, layer.weight_hh, num_gate * hidden_size) || !ReadFloats(file, layer.bias, num_gate))
+            return fail();
+        // Every layer reads the hidden state of the previous one
+        if (!lstms.empty() && layer.input_size != lstms.back().hidden_size)
+            return fail();
+        lstms.push_back(std::move(layer));
+    }
+
+    std::vector<DenseLayer> denses;
+    if (!Read(file, num_dense_layer))
+        return fail();
+    int previous_size = lstms.back().hidden_size;
+    for (uint32_t l = 0; l < num_dense_layer; l++) {
+        DenseLayer layer;
+        uint32_t input_size, output_size, activation;
+        if (!Read(file, input_size) || !Read(file, output_size) || !Read(file, activation) || activation > SOFTMAX)
+            return fail();
+        layer.input_size = input_size;
+        layer.output_size = output_size;
+        layer.activation = static_cast<Activation>(activation);
+        if (!ReadFloats(file, layer.weight, static_cast<size_t>(output_size) * input_size) ||
+            !ReadFloats(file, layer.bias, output_size) || layer.input_size != previous_size)
+            return fail();
+        previous_size = layer.output_size;
+        denses.push_back(std::move(layer));
+    }
+
+    // The input is built from the columns: a model without them cannot be fed
+    if (static_cast<int>(num_column) != lstms.front().input_size) {
+        std::cout << "The model has " << num_column << " input columns for " << lstms.front().input_size
+                  << " inputs" << std::endl;
+        return fail();
+    }
+
+    input_spec = spec;
+    lstm_layers = std::move(lstms);
+    dense_layers = std::move(denses);
+    lstm_importance.clear();
+    dense_importance.clear();
+    PrepareWeights();
+    return true;
+}
+
+bool LstmModel::BuildInput(const FeatureMatrix &angles, const OpenPoseData &openpose, std::vector<float> &input,
+                           int &num_frame, const FrameRange &range) const {
+    const FrameRange angle_range = range.Clamp(angles.GetNumFrame());
+    const FrameRange openpose_range = angle_range.Rescale(angles.GetNumFrame(), openpose.GetNumFrame());
+    const int num_input = input_spec.column_names.size();
+    std::vector<const float *> columns(num_input);
+    std::vector<int> column_frames(num_input);
+    int longest = 0;
+    for (int i = 0; i < num_input; i++) {
+        const auto &name = input_spec.column_names[i];
+        int column = angles.GetSchema().FindColumn(name);
+        if (column >= 0) {
+            columns[i] = angles.Column(column) + angle_range.begin;
+            column_frames[i] = angle_range.GetNumFrame();
+        } else if ((column = openpose.FindColumn(name)) >= 0) {
+            columns[i] = openpose.Column(column) + openpose_range.begin;
+            column_frames[i] = openpose_range.GetNumFrame();
+        } else {
+            std::cout << "The model input " << name << " is missing" << std::endl;
+            return false;
+        }
+        longest = std::max(longest, column_frames[i]);
+    }
+
+    // The angles & the video may not have the same number of frames, both are stretched to the same length
+    num_frame = input_spec.sequence_length > 0 ? input_spec.sequence_length : longest;
+    input.assign(static_cast<size_t>(num_frame) * num_input, 0.0f);
+    std::vector<float> resampled(num_frame);
+    for (int i = 0; i < num_input; i++) {
+        similarity::Similarity::Resample(columns[i], column_frames[i], 1, resampled.data(), num_frame);
+        const float mean = input_spec.mean[i], std = input_spec.std[i] != 0 ? input_spec.std[i] : 1.0f;
+        for (int t = 0; t < num_frame; t++) {
+            // A missing keypoint (NaN) becomes the mean
+            const float value = (resampled[t] - mean) / std;
+            input[static_cast<size_t>(t) * num_input + i] = std::isnan(value) ? 0.0f : value;
+        }
+    }
+    return true;
+}
+
+std::vector<float> LstmModel::Predict(const float *input, int num_frame) const {
+    return PredictBatch({input}, {num_frame});
+}
+
+std::vector<float> LstmModel::PredictBatch(const std::vector<const float *> &inputs,
+                                           const std::vector<int> &num_frames) const {
+    const int batch = inputs.size();
+    if (!IsLoaded() || batch == 0 || num_frames.size() != inputs.size())
+        return {};
+    // A clip without a frame has no last frame to read
+    if (*std::min_element(num_frames.begin(), num_frames.end()) <= 0)
+        return {};
+
+    LstmState state;
+    InitState(state, batch);
+    RunLstm(inputs, num_frames, state);
+    return RunDense(state.hidden.back(), batch);
+}
+
+void LstmModel::ResetState(LstmState &state) const {
+    InitState(state, 1);
+}
+
+void LstmModel::Advance(const float *input, int num_frame, LstmState &state) const {
+    if (!IsLoaded() || num_frame <= 0)
+        return;
+    if (state.hidden.size() != lstm_layers.size())
+        InitState(state, 1);
+    RunLstm({input}, {num_frame}, state);
+}
+
+std::vector<float> LstmModel::Output(const LstmState &state) const {
+    if (!IsLoaded())
+        return {};
+    // Nothing fed yet: the output of the zero state
+    if (state.hidden.size() != lstm_layers.size())
+        return RunDense(std::vector<float>(lstm_layers.back().hidden_size, 0.0f), 1);
+    return RunDense(state.hidden.back(), 1);
+}
+
+void LstmModel::InitState(LstmState &state, int batch) const {
+    const int num_layer = lstm_layers.size();
+    state.hidden.resize(num_layer);
+    state.cell.resize(num_layer);
+    for (int l = 0; l < num_layer; l++) {
+        state.hidden[l].assign(static_cast<size_t>(batch) * lstm_layers[l].hidden_size, 0.0f);
+        state.cell[l].assign(static_cast<size_t>(batch) * lstm_layers[l].hidden_size, 0.0f);
+    }
+    state.num_frame = 0;
+}
+
+void LstmModel::RunLstm(const std::vector<const float *> &inputs, const std::vector<int> &num_frames,
+                        LstmState &state, std::vector<std::vector<double>> *input_power) const {
+    const int batch = inputs.size();
+    const int num_layer = lstm_layers.size();
+    const int max_frame = *std::max_element(num_frames.begin(), num_frames.end());
+    auto &hidden = state.hidden, &cell = state.cell;
+    // Scratch kept in the state, a stream fed frame by frame reuses it
+    auto &step_input = state.step_input, &gates = state.gates;
+
+    for (int t = 0; t < max_frame; t++) {
+        for (int l = 0; l < num_layer; l++) {
+            const auto &layer = lstm_layers[l];
+            const int input_size = layer.input_size, hidden_size = layer.hidden_size, num_gate = 4 * hidden_size;
+            const int step_size = input_size + hidden_size;
+
+            // [x_t, h_t-1] of every clip, a clip that already ended keeps its state (its gates are not applied)
+            step_input.resize(static_cast<size_t>(batch) * step_size);
+            for (int b = 0; b < batch; b++) {
+                const float *x = l == 0 ? inputs[b] + static_cast<size_t>(std::min(t, num_frames[b] - 1)) * input_size
+                                        : hidden[l - 1].data() + static_cast<size_t>(b) * input_size;
+                const float *h = hidden[l].data() + static_cast<size_t>(b) * hidden_size;
+                std::copy(x, x + input_size, step_input.begin() + static_cast<size_t>(b) * step_size);
+                std::copy(h, h + hidden_size, step_input.begin() + static_cast<size_t>(b) * step_size + input_size);
+            }
+            if (input_power != nullptr) {
+                auto &power = (*input_power)[l];
+                power.resize(step_size, 0.0);
+                for (int b = 0; b < batch; b++) {
+                    if (t >= num_frames[b])
+                        continue;
+                    for (int k = 0; k < step_size; k++)
+                        power[k] += static_cast<double>(step_input[static_cast<size_t>(b) * step_size + k]) *
+                                    step_input[static_cast<size_t>(b) * step_size + k];
+                }
+            }
+
+            gates.resize(static_cast<size_t>(batch) * num_gate);
+            for (int b = 0; b < batch; b++)
+                std::copy(layer.bias.begin(), layer.bias.end(), gates.begin() + static_cast<size_t>(b) * num_gate);
+            Gemm(step_input.data(), batch, lstm_weights[l], gates.data());
+
+            // Fused gates: i, f, g, o -> cell & hidden state in one pass
+            for (int b = 0; b < batch; b++) {
+                if (t >= num_frames[b])
+                    continue;
+                const float *g = gates.data() + static_cast<size_t>(b) * num_gate;
+                float *__restrict h = hidden[l].data() + static_cast<size_t>(b) * hidden_size;
+                float *__restrict c = cell[l].data() + static_cast<size_t>(b) * hidden_size;
+                for (int j = 0; j < hidden_size; j++) {
+                    const float input_gate = Sigmoid(g[j]);
+                    const float forget_gate = Sigmoid(g[hidden_size + j]);
+                    const float cell_gate = Tanh(g[2 * hidden_size + j]);
+                    const float output_gate = Sigmoid(g[3 * hidden_size + j]);
+                    c[j] = forget_gate * c[j] + input_gate * cell_gate;
+                    h[j] = output_gate * Tanh(c[j]);
+                }
+            }
+        }
+    }
+    state.num_frame += max_frame;
+}
+
+std::vector<float> LstmModel::RunDense(std::vector<float> x, int batch,
+                                       std::vector<std::vector<double>> *input_power) const {
+    std::vector<float> y;
+    for (size_t l = 0; l < dense_layers.size(); l++) {
+        const auto &layer = dense_layers[l];
+        const int output_size = layer.output_size;
+        if (input_power != nullptr) {
+            auto &power = (*input_power)[l];
+            power.assign(layer.input_size, 0.0);
+            for (size_t i = 0; i < x.size(); i++)
+                power[i % layer.input_size] += static_cast<double>(x[i]) * x[i];
+        }
+        y.resize(static_cast<size_t>(batch) * output_size);
+        for (int b = 0; b < batch; b++)
+            std::copy(layer.bias.begin(), layer.bias.end(), y.begin() + static_cast<size_t>(b) * output_size);
+        Gemm(x.data(), batch, dense_weights[l], y.data());
+
+        for (int b = 0; b < batch; b++) {
+            float *row = y.data() + static_cast<size_t>(b) * output_size;
+            if (layer.activation == RELU) {
+                for (int i = 0; i < output_size; i++)
+                    row[i] = row[i] > 0 ? row[i] : 0.0f;
+            } else if (layer.activation == SIGMOID) {
+                for (int i = 0; i < output_size; i++)
+                    row[i] = Sigmoid(row[i]);
+            } else if (layer.activation == SOFTMAX) {
+                const float max_value = *std::max_element(row, row + output_size);
+                float sum = 0;
+                for (int i = 0; i < output_size; i++) {
+                    row[i] = Exp(row[i] - max_value);
+                    sum += row[i];
+                }
+                for (int i = 0; i < output_size; i++)
+                    row[i] /= sum;
+            }
+        }
+        std::swap(x, y);
+    }
+    return x;
+}
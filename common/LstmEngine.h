@@ -0,0 +1,255 @@
+#ifndef TESTBED_LSTMENGINE_H
+#define TESTBED_LSTMENGINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FeatureExtractor.h"
+#include "OpenPoseData.h"
+
+using namespace featureExtractor;
+using namespace openPoseData;
+
+namespace lstmEngine {
+
+    enum Activation {
+        NONE, RELU, SIGMOID, SOFTMAX
+    };
+
+    /// How the weights are stored for inference, the arithmetic is float in every mode
+    enum Precision {
+        FP32,
+        /// IEEE half, about 3 significant digits
+        FP16,
+        /**
+         * Symmetric int8 with one scale per output channel (gate / neuron): the clipping threshold, from max |w| down
+         * to half of it, with the least rounding & clipping error, each input weighted by its mean square over the
+         * calibration clips (LstmModel::Calibrate), all alike until then
+         */
+        INT8
+    };
+
+    inline const char *PrecisionName(Precision precision) {
+        return precision == FP16 ? "fp16" : (precision == INT8 ? "int8" : "fp32");
+    }
+
+    /// A weight matrix transposed to [inner][cols], stored in one precision
+    struct PackedMatrix {
+        int inner = 0;
+        int cols = 0;
+        Precision precision = FP32;
+        std::vector<float> fp32;
+        std::vector<uint16_t> fp16;
+        std::vector<int8_t> int8;
+        /// INT8 only, [cols]
+        std::vector<float> scale;
+
+        size_t GetBytes() const;
+    };
+
+    /// One torch.nn.LSTM layer (unidirectional), the weights in PyTorch's layout and gate order (i, f, g, o)
+    struct LstmLayer {
+        int input_size = 0;
+        int hidden_size = 0;
+        /// [4 * hidden_size][input_size]
+        std::vector<float> weight_ih;
+        /// [4 * hidden_size][hidden_size]
+        std::vector<float> weight_hh;
+        /// bias_ih + bias_hh, [4 * hidden_size]
+        std::vector<float> bias;
+    };
+
+    /// One torch.nn.Linear layer followed by its activation
+    struct DenseLayer {
+        int input_size = 0;
+        int output_size = 0;
+        Activation activation = NONE;
+        /// [output_size][input_size]
+        std::vector<float> weight;
+        std::vector<float> bias;
+    };
+
+    /**
+     * How a clip becomes the input sequence: the columns (angle features or OpenPose keypoints) by name,
+     * standardized with the training statistics, resampled to sequence_length frames (0 keeps the clip length).
+     */
+    struct InputSpec {
+        std::vector<std::string> column_names;
+        std::vector<float> mean;
+        std::vector<float> std;
+        int sequence_length = 0;
+    };
+
+    /**
+     * Recurrent state of a stream fed by LstmModel::Advance: hidden & cell state of every layer, carried from one
+     * call to the next
+     */
+    struct LstmState {
+        std::vector<std::vector<float>> hidden;
+        std::vector<std::vector<float>> cell;
+        /// Frames fed since the last reset
+        int num_frame = 0;
+        /// Scratch of the steps
+        std::vector<float> step_input, gates;
+    };
+
+    /**
+     * Native inference of the forehand classifier: stacked LSTM layers, the last hidden state through the dense
+     * layers, e.g. the 6-way probabilities read by Analysizer::Suggest_str.
+     * The weights come from the flat file written by Py_package/PyAnalysizer/ExportLstm.py.
+     *
+     * Every time step is one small GEMM per layer (the clips of a batch are the rows) and one fused pass for the
+     * gates: sigmoid / tanh, cell & hidden state together. The weights are kept transposed so the products are
+     * branch-free loops over contiguous outputs that the compiler vectorizes; exp is a polynomial approximation
+     * (relative error 3e-7), so the output matches PyTorch to about 1e-6.
+     * The weights can also be stored as FP16 or INT8 (SetPrecision): the products decode them in registers, INT8
+     * scales the accumulated sums once per output channel.
+     * A stream (e.g. live playback) is fed incrementally: Advance runs only the new frames from the state the
+     * previous call left, Output reads the dense layers at any point. Advance over a clip in any number of pieces
+     * then Output gives exactly what Predict gives on the whole clip.
+     */
+    class LstmModel {
+    private:
+        InputSpec input_spec;
+        std::vector<LstmLayer> lstm_layers;
+        std::vector<DenseLayer> dense_layers;
+
+        Precision precision = FP32;
+        /// The weights transposed to [input][output], weight_ih & weight_hh of a layer stacked in one matrix
+        std::vector<PackedMatrix> lstm_weights;
+        std::vector<PackedMatrix> dense_weights;
+        /// Mean square of every input of the weight matrices over the calibration clips, empty before Calibrate
+        std::vector<std::vector<float>> lstm_importance;
+        std::vector<std::vector<float>> dense_importance;
+
+        // -------------------- Methods -------------------- //
+        void PrepareWeights();
+
+        /// Zero state for batch clips
+        void InitState(LstmState &state, int batch) const;
+
+        /**
+         * The LSTM layers over the frames of every clip, from state (batch = inputs.size())
+         * @param input_power if given, adds the squares of every layer's [x_t, h_t-1] of the clips' frames
+         */
+        void RunLstm(const std::vector<const float *> &inputs, const std::vector<int> &num_frames,
+                     LstmState &state, std::vector<std::vector<double>> *input_power = nullptr) const;
+
+        /**
+         * The dense layers on the last layer's hidden states, batch rows
+         * @param input_power if given, adds the squares of every layer's input
+         */
+        std::vector<float> RunDense(std::vector<float> x, int batch,
+                                    std::vector<std::vector<double>> *input_power = nullptr) const;
+
+    public:
+        LstmModel() = default;
+
+        LstmModel(const InputSpec &input_spec, const std::vector<LstmLayer> &lstm_layers,
+                  const std::vector<DenseLayer> &dense_layers);
+
+        /**
+         * Read a model exported by ExportLstm.py
+         * @return false if the file cannot be read, is not a model or does not name one column per input
+         */
+        bool Load(const std::string &filename);
+
+        /**
+         * The input sequence of a clip, time-major (frame, input)
+         * @param num_frame the number of frames of the result
+         * @param range the part of the clip (angles' frames, the keypoints' are rescaled to it), read in place
+         * @return false (with a message) if a column of the input spec is in neither table
+         */
+        bool BuildInput(const FeatureMatrix &angles, const OpenPoseData &openpose, std::vector<float> &input,
+                        int &num_frame, const FrameRange &range = FrameRange()) const;
+
+        /// Output of one clip, input is time-major (frame, input)
+        std::vector<float> Predict(const float *input, int num_frame) const;
+
+        /**
+         * Output of many clips in one pass, the clips may have different lengths
+         * @return the outputs of clip b at b * GetNumOutput(), empty if a clip has no frame
+         */
+        std::vector<float> PredictBatch(const std::vector<const float *> &inputs,
+                                        const std::vector<int> &num_frames) const;
+
+        /// Back to the zero state, the start of a new stream
+        void ResetState(LstmState &state) const;
+
+        /**
+         * Feed the next frames of a stream, input is time-major (frame, input). A state that was never reset is
+         * reset first.
+         */
+        void Advance(const float *input, int num_frame, LstmState &state) const;
+
+        /// Output of the stream so far, what Predict gives on all the frames fed since the reset
+        std::vector<float> Output(const LstmState &state) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        bool IsLoaded() const;
+
+        /// Repack the weights, the float weights of the layers stay the source of every precision
+        void SetPrecision(Precision precision);
+
+        /**
+         * Measure the inputs of every weight matrix on representative clips (in FP32) & repack: INT8 then spends its
+         * levels on the weights the largest inputs multiply. Kept until the next Load.
+         * @return false if there is no model or a clip has no frame
+         */
+        bool Calibrate(const std::vector<const float *> &inputs, const std::vector<int> &num_frames);
+
+        bool IsCalibrated() const;
+
+        Precision GetPrecision() const;
+
+        /// Size of the packed weights read by inference (biases included)
+        size_t GetWeightBytes() const;
+
+        const InputSpec &GetInputSpec() const;
+
+        int GetNumInput() const;
+
+        int GetNumOutput() const;
+
+        const std::vector<LstmLayer> &GetLstmLayers() const;
+
+        const std::vector<DenseLayer> &GetDenseLayers() const;
+    };
+
+    inline bool LstmModel::IsLoaded() const {
+        return !lstm_layers.empty();
+    }
+
+    inline bool LstmModel::IsCalibrated() const {
+        return !lstm_importance.empty();
+    }
+
+    inline Precision LstmModel::GetPrecision() const {
+        return precision;
+    }
+
+    inline const InputSpec &LstmModel::GetInputSpec() const {
+        return input_spec;
+    }
+
+    inline int LstmModel::GetNumInput() const {
+        return lstm_layers.empty() ? 0 : lstm_layers.front().input_size;
+    }
+
+    inline int LstmModel::GetNumOutput() const {
+        if (!dense_layers.empty())
+            return dense_layers.back().output_size;
+        return lstm_layers.empty() ? 0 : lstm_layers.back().hidden_size;
+    }
+
+    inline const std::vector<LstmLayer> &LstmModel::GetLstmLayers() const {
+        return lstm_layers;
+    }
+
+    inline const std::vector<DenseLayer> &LstmModel::GetDenseLayers() const {
+        return dense_layers;
+    }
+}
+
+#endif //TESTBED_LSTMENGINE_H
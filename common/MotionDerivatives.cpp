@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#include "MotionDerivatives.h"
+#include "AngleKernel.h"
+
+using namespace motionDerivatives;
+using namespace angleTool;
+
+namespace {
+    /// Fewer joint-frames than this per worker and the threads cost more than they save
+    constexpr size_t min_worker_samples = 1 << 15;
+
+    /**
+     * Angular velocity (degree / s) of the rotation from q0 to q1 over span seconds: the relative rotation
+     * q1 * conj(q0) as axis * angle. Branch-free, for the vectorized loops.
+     */
+    inline void RelativeRotation(float x0, float y0, float z0, float w0, float x1, float y1, float z1, float w1,
+                                 float span, float &wx, float &wy, float &wz) {
+        float dw = w1 * w0 + x1 * x0 + y1 * y0 + z1 * z0;
+        float dx = x1 * w0 - w1 * x0 - y1 * z0 + z1 * y0;
+        float dy = y1 * w0 - w1 * y0 - z1 * x0 + x1 * z0;
+        float dz = z1 * w0 - w1 * z0 - x1 * y0 + y1 * x0;
+        // q & -q are the same rotation, take the short way round
+        const float sign = dw < 0 ? -1.0f : 1.0f;
+        dw *= sign;
+        const float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+        // angle / length = 2 atan(r) / length with r = length / dw, its series for the small rotations of a frame
+        const float r = length / std::max(dw, 1e-12f), r2 = r * r;
+        const float series = 2 / std::max(dw, 1e-12f) *
+                             (1 + r2 * (-1.0f / 3 + r2 * (1.0f / 5 + r2 * (-1.0f / 7 + r2 * (1.0f / 9)))));
+        const float factor = r < 0.25f ? series : 2 * AngleKernel::Atan2(length, dw) / length;
+        const float scale = sign * factor * AngleKernel::rad_to_deg / span;
+        wx = dx * scale;
+        wy = dy * scale;
+        wz = dz * scale;
+    }
+}
+
+void MotionDerivatives::Gradient(const float *__restrict x, int num_frame, float frame_time, float *__restrict y) {
+    if (num_frame < 2) {
+        std::fill(y, y + std::max(num_frame, 0), 0.0f);
+        return;
+    }
+    const float inv_step = 1 / frame_time, inv_span = 0.5f / frame_time;
+    y[0] = (x[1] - x[0]) * inv_step;
+    for (int t = 1; t < num_frame - 1; t++)
+        y[t] = (x[t + 1] - x[t - 1]) * inv_span;
+    y[num_frame - 1] = (x[num_frame - 1] - x[num_frame - 2]) * inv_step;
+}
+
+void MotionDerivatives::AngularVelocity(const float *__restrict x, const float *__restrict y,
+                                        const float *__restrict z, const float *__restrict w, int num_frame,
+                                        float frame_time, float *__restrict ox, float *__restrict oy,
+                                        float *__restrict oz) {
+    if (num_frame < 2) {
+        std::fill(ox, ox + std::max(num_frame, 0), 0.0f);
+        std::fill(oy, oy + std::max(num_frame, 0), 0.0f);
+        std::fill(oz, oz + std::max(num_frame, 0), 0.0f);
+        return;
+    }
+    const int last = num_frame - 1;
+    RelativeRotation(x[0], y[0], z[0], w[0], x[1], y[1], z[1], w[1], frame_time, ox[0], oy[0], oz[0]);
+    for (int t = 1; t < last; t++)
+        RelativeRotation(x[t - 1], y[t - 1], z[t - 1], w[t - 1], x[t + 1], y[t + 1], z[t + 1], w[t + 1],
+                         2 * frame_time, ox[t], oy[t], oz[t]);
+    RelativeRotation(x[last - 1], y[last - 1], z[last - 1], w[last - 1], x[last], y[last], z[last], w[last],
+                     frame_time, ox[last], oy[last], oz[last]);
+}
+
+void MotionDerivatives::Magnitude(const float *__restrict x, const float *__restrict y, const float *__restrict z,
+                                  int num_frame, float *__restrict out) {
+    for (int t = 0; t < num_frame; t++)
+        out[t] = std::sqrt(x[t] * x[t] + y[t] * y[t] + z[t] * z[t]);
+}
+
+void DerivativeBuffer::Build(const PoseBuffer &pose, double new_frame_time, const std::vector<int> &joints,
+                             int num_worker) {
+    num_frame = pose.GetNumFrame();
+    num_joint = pose.GetNumJoint();
+    frame_time = new_frame_time > 0 ? new_frame_time : 1.0 / 30;
+    for (auto &array: derivatives) {
+        array.x.assign(static_cast<size_t>(num_frame) * num_joint, 0.0f);
+        array.y.assign(array.x.size(), 0.0f);
+        array.z.assign(array.x.size(), 0.0f);
+    }
+
+    std::vector<int> targets = joints;
+    if (targets.empty()) {
+        for (int joint = 0; joint < num_joint; joint++)
+            targets.push_back(joint);
+    }
+
+    if (num_worker <= 0) {
+        const size_t num_sample = targets.size() * static_cast<size_t>(num_frame);
+        num_worker = static_cast<int>(std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                       std::max<size_t>(num_sample / min_worker_samples, 1)));
+    }
+    num_worker = std::min<int>(num_worker, std::max<size_t>(targets.size(), 1));
+
+    // The joints write disjoint ranges, the workers take the next joint when they are free
+    std::atomic<size_t> next_target{0};
+    const auto work = [&]() {
+        for (size_t target = next_target++; target < targets.size(); target = next_target++)
+            ComputeJoint(pose, targets[target]);
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_worker; i++)
+        workers.emplace_back(work);
+    work();
+    for (auto &worker: workers)
+        worker.join();
+}
+
+void DerivativeBuffer::ComputeJoint(const PoseBuffer &pose, int joint) {
+    const size_t begin = Index(joint, 0);
+    const float dt = static_cast<float>(frame_time);
+
+    const float *positions[3] = {pose.GetPositionX().data() + begin, pose.GetPositionY().data() + begin,
+                                 pose.GetPositionZ().data() + begin};
+    auto &velocity = derivatives[VELOCITY], &acceleration = derivatives[ACCELERATION], &jerk = derivatives[JERK];
+    float *velocities[3] = {velocity.x.data() + begin, velocity.y.data() + begin, velocity.z.data() + begin};
+    float *accelerations[3] = {acceleration.x.data() + begin, acceleration.y.data() + begin,
+                               acceleration.z.data() + begin};
+    float *jerks[3] = {jerk.x.data() + begin, jerk.y.data() + begin, jerk.z.data() + begin};
+    for (int axis = 0; axis < 3; axis++) {
+        MotionDerivatives::Gradient(positions[axis], num_frame, dt, velocities[axis]);
+        MotionDerivatives::Gradient(velocities[axis], num_frame, dt, accelerations[axis]);
+        MotionDerivatives::Gradient(accelerations[axis], num_frame, dt, jerks[axis]);
+    }
+
+    const auto &q = pose.GetOrientations();
+    auto &angular = derivatives[ANGULAR_VELOCITY];
+    MotionDerivatives::AngularVelocity(q.x.data() + begin, q.y.data() + begin, q.z.data() + begin,
+                                       q.w.data() + begin, num_frame, dt, angular.x.data() + begin,
+                                       angular.y.data() + begin, angular.z.data() + begin);
+}
+
+void DerivativeBuffer::GetMagnitude(DerivativeKind kind, int joint, float *out) const {
+    const size_t begin = Index(joint, 0);
+    const auto &array = derivatives[kind];
+    MotionDerivatives::Magnitude(array.x.data() + begin, array.y.data() + begin, array.z.data() + begin, num_frame,
+                                 out);
+}
@@ -0,0 +1,142 @@
+#ifndef TESTBED_MOTIONDERIVATIVES_H
+#define TESTBED_MOTIONDERIVATIVES_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "PoseBuffer.h"
+
+using namespace poseBuffer;
+
+namespace motionDerivatives {
+
+    enum DerivativeKind {
+        /// World position, per second (BVH units / s)
+        VELOCITY,
+        /// ... per second squared
+        ACCELERATION,
+        /// ... per second cubed
+        JERK,
+        /// World orientation, per second (degree / s, about the world axes)
+        ANGULAR_VELOCITY,
+        NUM_DERIVATIVE
+    };
+
+    /// Structure of arrays of 3D vectors, like angleTool::QuaternionArray
+    struct Vector3Array {
+        std::vector<float> x, y, z;
+
+        void resize(size_t n);
+    };
+
+    /**
+     * Finite differences of float series, numpy.gradient's scheme: central differences inside, one-sided at the
+     * two ends. Every kernel is a single loop over contiguous frames, vectorized by the compiler.
+     */
+    class MotionDerivatives {
+    public:
+        /**
+         * d in / dt
+         * @param out num_frame values, must not be in
+         */
+        static void Gradient(const float *in, int num_frame, float frame_time, float *out);
+
+        /**
+         * Angular velocity (degree / s, world axes) of a series of world orientations: the rotation from frame
+         * t - 1 to t + 1 (t to t + 1 / t - 1 to t at the ends) taken as axis * angle over its time span.
+         * The hemisphere of the quaternions does not matter.
+         */
+        static void AngularVelocity(const float *qx, const float *qy, const float *qz, const float *qw,
+                                    int num_frame, float frame_time, float *wx, float *wy, float *wz);
+
+        /// Element-wise length of num_frame 3D vectors
+        static void Magnitude(const float *x, const float *y, const float *z, int num_frame, float *out);
+    };
+
+    /**
+     * Velocity, acceleration, jerk & angular velocity of every joint for every frame of a PoseBuffer, for the
+     * stroke-quality metrics (swing speed, wrist snap, smoothness).
+     * Acceleration is the gradient of the velocity and jerk the gradient of the acceleration, so each derivative
+     * widens the stencil: raw MocapNET clips should be smoothed first (signalFilter) or the jerk is mostly noise.
+     * Joint-major like PoseBuffer (index = joint * num_frame + frame): the frames of a joint are contiguous.
+     * Joints are independent, Build spreads them over worker threads.
+     */
+    class DerivativeBuffer {
+    private:
+        int num_frame = 0;
+        int num_joint = 0;
+        double frame_time = 1.0 / 30;
+
+        Vector3Array derivatives[NUM_DERIVATIVE];
+
+        /// Every derivative of one joint
+        void ComputeJoint(const PoseBuffer &pose, int joint);
+
+    public:
+        DerivativeBuffer() = default;
+
+        /**
+         * Differentiate the world transforms of the pose buffer
+         * @param frame_time seconds between frames (BVH::GetInterval)
+         * @param joints only these joints (the others are left at 0), every joint if empty
+         * @param num_worker threads (0: one per core, fewer for a short clip), 1 when the caller is already one
+         *        of many workers
+         */
+        void Build(const PoseBuffer &pose, double frame_time, const std::vector<int> &joints = {},
+                   int num_worker = 0);
+
+        /**
+         * Length of a derivative of a joint over all frames: speed, acceleration, jerk, angular speed
+         * @param out num_frame values
+         */
+        void GetMagnitude(DerivativeKind kind, int joint, float *out) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        int GetNumFrame() const;
+
+        int GetNumJoint() const;
+
+        double GetFrameTime() const;
+
+        size_t Index(int joint, int frame) const;
+
+        glm::vec3 Get(DerivativeKind kind, int joint, int frame) const;
+
+        const Vector3Array &GetArray(DerivativeKind kind) const;
+    };
+
+    inline void Vector3Array::resize(size_t n) {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+    }
+
+    inline int DerivativeBuffer::GetNumFrame() const {
+        return num_frame;
+    }
+
+    inline int DerivativeBuffer::GetNumJoint() const {
+        return num_joint;
+    }
+
+    inline double DerivativeBuffer::GetFrameTime() const {
+        return frame_time;
+    }
+
+    inline size_t DerivativeBuffer::Index(int joint, int frame) const {
+        return static_cast<size_t>(joint) * num_frame + frame;
+    }
+
+    inline glm::vec3 DerivativeBuffer::Get(DerivativeKind kind, int joint, int frame) const {
+        const auto i = Index(joint, frame);
+        const auto &array = derivatives[kind];
+        return {array.x[i], array.y[i], array.z[i]};
+    }
+
+    inline const Vector3Array &DerivativeBuffer::GetArray(DerivativeKind kind) const {
+        return derivatives[kind];
+    }
+}
+
+#endif //TESTBED_MOTIONDERIVATIVES_H
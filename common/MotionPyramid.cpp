@@ -0,0 +1,42 @@
+#include <algorithm>
+
+#include "MotionPyramid.h"
+
+using namespace motionPyramid;
+
+MotionPyramid::MotionPyramid(const float *series, int num_frame, int num_channel, int num_level) {
+    Build(series, num_frame, num_channel, num_level);
+}
+
+void MotionPyramid::Build(const float *series, int num_frame, int num_channel, int num_level) {
+    this->num_channel = num_channel;
+    levels.clear();
+    num_frames.clear();
+    if (num_frame <= 0 || num_channel <= 0 || num_level <= 0)
+        return;
+
+    levels.emplace_back(series, series + static_cast<size_t>(num_frame) * num_channel);
+    num_frames.push_back(num_frame);
+    while (static_cast<int>(levels.size()) < num_level && num_frames.back() >= 4) {
+        const int previous_frames = num_frames.back();
+        std::vector<float> level(static_cast<size_t>((previous_frames + 1) / 2) * num_channel);
+        Downsample(levels.back().data(), previous_frames, num_channel, level.data());
+        levels.push_back(std::move(level));
+        num_frames.push_back((previous_frames + 1) / 2);
+    }
+}
+
+void MotionPyramid::Downsample(const float *series, int num_frame, int num_channel, float *output) {
+    const int output_frames = (num_frame + 1) / 2;
+    const auto frame = [&](int t) {
+        return series + static_cast<size_t>(std::clamp(t, 0, num_frame - 1)) * num_channel;
+    };
+    for (int t = 0; t < output_frames; t++) {
+        const int center = 2 * t;
+        const float *__restrict a = frame(center - 2), *__restrict b = frame(center - 1);
+        const float *__restrict c = frame(center), *__restrict d = frame(center + 1), *__restrict e = frame(center + 2);
+        float *__restrict out = output + static_cast<size_t>(t) * num_channel;
+        for (int k = 0; k < num_channel; k++)
+            out[k] = (a[k] + e[k] + 4 * (b[k] + d[k]) + 6 * c[k]) * (1.0f / 16);
+    }
+}
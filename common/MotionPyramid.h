@@ -0,0 +1,79 @@
+#ifndef TESTBED_MOTIONPYRAMID_H
+#define TESTBED_MOTIONPYRAMID_H
+
+#include <vector>
+
+namespace motionPyramid {
+
+    /**
+     * A multichannel series at several time resolutions, for coarse-to-fine alignment (Similarity::FastDtwPath).
+     * Level 0 is the series itself, level l has half the frames of level l - 1: (n + 1) / 2, i.e. 2x, 4x, 8x...
+     * fewer than the series. Every level is low-passed before it is decimated (binomial [1 4 6 4 1] / 16, the
+     * edges clamped), so a fast motion does not alias into a slow one.
+     * Time-major like Similarity's series: channel c of frame t of a level is at t * num_channel + c. A level is
+     * built in one pass whose inner loops run over the channels of a frame, contiguous & vectorized.
+     */
+    class MotionPyramid {
+    private:
+        int num_channel = 0;
+        std::vector<std::vector<float>> levels;
+        std::vector<int> num_frames;
+
+    public:
+        MotionPyramid() = default;
+
+        /**
+         * @param num_level levels including the series, fewer if a level would have less than two frames
+         */
+        MotionPyramid(const float *series, int num_frame, int num_channel, int num_level = 4);
+
+        /// Replace the content, same parameters as the constructor
+        void Build(const float *series, int num_frame, int num_channel, int num_level = 4);
+
+        /**
+         * Halve a series: the low-pass, then every other frame (the first one kept)
+         * @param output (num_frame + 1) / 2 frames
+         */
+        static void Downsample(const float *series, int num_frame, int num_channel, float *output);
+
+        // -------------------- Getter & Setter -------------------- //
+        bool IsEmpty() const;
+
+        int GetNumLevel() const;
+
+        int GetNumChannel() const;
+
+        int GetNumFrame(int level) const;
+
+        const float *GetLevel(int level) const;
+
+        /// Frames of the series per frame of the level, 2^level
+        int GetFactor(int level) const;
+    };
+
+    inline bool MotionPyramid::IsEmpty() const {
+        return levels.empty();
+    }
+
+    inline int MotionPyramid::GetNumLevel() const {
+        return static_cast<int>(levels.size());
+    }
+
+    inline int MotionPyramid::GetNumChannel() const {
+        return num_channel;
+    }
+
+    inline int MotionPyramid::GetNumFrame(int level) const {
+        return num_frames[level];
+    }
+
+    inline const float *MotionPyramid::GetLevel(int level) const {
+        return levels[level].data();
+    }
+
+    inline int MotionPyramid::GetFactor(int level) const {
+        return 1 << level;
+    }
+}
+
+#endif //TESTBED_MOTIONPYRAMID_H
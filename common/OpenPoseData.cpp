@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "OpenPoseData.h"
+#include "MappedFile.h"
+
+using namespace openPoseData;
+using mappedFile::MappedFile;
+
+namespace {
+
+    const double exact_powers_of_ten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+                                          1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    /**
+     * Parse the cell starting at begin as a float, the cell ends at the next ',' or at row_end.
+     * Plain decimal numbers (what OpenPose exports) take the fast path, in the same scan that finds the end of the
+     * cell: a mantissa and a power of ten that double both represent exactly, so the double result is correctly
+     * rounded before the conversion to float (the same float as strtof but in the rare double rounding case,
+     * 1 ulp). Anything else goes through strtof.
+     * @param cell_end set to the end of the cell
+     * @return false if the cell is empty or not entirely a number
+     */
+    bool ParseFloat(const char *begin, const char *row_end, float &value, const char *&cell_end) {
+        const char *cursor = begin;
+        const bool negative = cursor != row_end && *cursor == '-';
+        if (cursor != row_end && (*cursor == '-' || *cursor == '+'))
+            cursor++;
+
+        uint64_t mantissa = 0;
+        int num_digit = 0, exponent = 0;
+        bool has_digit = false;
+        for (; cursor != row_end && *cursor >= '0' && *cursor <= '9'; cursor++) {
+            has_digit = true;
+            if (num_digit < 19) {
+                mantissa = mantissa * 10 + (*cursor - '0');
+                num_digit += mantissa != 0;
+            } else {
+                exponent++;
+            }
+        }
+        if (cursor != row_end && *cursor == '.') {
+            for (cursor++; cursor != row_end && *cursor >= '0' && *cursor <= '9'; cursor++) {
+                has_digit = true;
+                if (num_digit < 19) {
+                    mantissa = mantissa * 10 + (*cursor - '0');
+                    num_digit += mantissa != 0;
+                    exponent--;
+                }
+            }
+        }
+        if (cursor != row_end && (*cursor == 'e' || *cursor == 'E')) {
+            const char *exponent_cursor = cursor + 1;
+            const bool negative_exponent = exponent_cursor != row_end && *exponent_cursor == '-';
+            if (exponent_cursor != row_end && (*exponent_cursor == '-' || *exponent_cursor == '+'))
+                exponent_cursor++;
+            int written_exponent = 0;
+            const char *exponent_digits = exponent_cursor;
+            for (; exponent_cursor != row_end && *exponent_cursor >= '0' && *exponent_cursor <= '9'; exponent_cursor++)
+                written_exponent = std::min(written_exponent * 10 + (*exponent_cursor - '0'), 10000);
+            if (exponent_cursor != exponent_digits) {
+                exponent += negative_exponent ? -written_exponent : written_exponent;
+                cursor = exponent_cursor;
+            }
+        }
+
+        const bool isCellEnd = cursor == row_end || *cursor == ',';
+        if (isCellEnd && has_digit && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+            cell_end = cursor;
+            double result = static_cast<double>(mantissa);
+            result = exponent < 0 ? result / exact_powers_of_ten[-exponent] : result * exact_powers_of_ten[exponent];
+            value = static_cast<float>(negative ? -result : result);
+            return true;
+        }
+
+        // nan, inf, leading blanks, huge exponents...
+        if (isCellEnd) {
+            cell_end = cursor;
+        } else {
+            const void *comma = std::memchr(cursor, ',', row_end - cursor);
+            cell_end = comma != nullptr ? static_cast<const char *>(comma) : row_end;
+        }
+        char cell[64];
+        const size_t length = cell_end - begin;
+        if (length == 0 || length >= sizeof(cell))
+            return false;
+        std::memcpy(cell, begin, length);
+        cell[length] = '\0';
+        char *parsed_end;
+        value = std::strtof(cell, &parsed_end);
+        return parsed_end != cell && *parsed_end == '\0';
+    }
+
+    /// End of the line starting at line_begin (the '\n' or end), a trailing '\r' is left out by the caller
+    const char *LineEnd(const char *line_begin, const char *end) {
+        const void *found = std::memchr(line_begin, '\n', end - line_begin);
+        return found != nullptr ? static_cast<const char *>(found) : end;
+    }
+}
+
+bool OpenPoseData::Load(const std::string &filename) {
+    return Load(filename, {});
+}
+
+bool OpenPoseData::Load(const std::string &filename, const std::vector<std::string> &selected_columns) {
+    MappedFile file(filename);
+    if (!file.IsOpen())
+        return false;
+
+    column_names.clear();
+    data.clear();
+    num_frame = 0;
+
+    const char *cursor = file.Begin(), *end = file.End();
+    if (cursor == end)
+        return true;
+
+    // Header: where each column of the file goes, -1 for the columns that are not selected
+    const char *header_end = LineEnd(cursor, end);
+    const char *header_content_end = header_end != cursor && header_end[-1] == '\r' ? header_end - 1 : header_end;
+    std::vector<std::string> file_columns;
+    for (const char *cell = cursor; cursor != header_content_end && cell <= header_content_end;) {
+        const char *cell_end = std::find(cell, header_content_end, ',');
+        file_columns.emplace_back(cell, cell_end);
+        cell = cell_end + 1;
+    }
+    std::vector<int> destination(file_columns.size(), -1);
+    if (selected_columns.empty()) {
+        column_names = file_columns;
+        for (size_t c = 0; c < file_columns.size(); c++)
+            destination[c] = c;
+    } else {
+        for (const auto &name: selected_columns) {
+            auto found = std::find(file_columns.begin(), file_columns.end(), name);
+            if (found != file_columns.end() && destination[found - file_columns.begin()] < 0) {
+                destination[found - file_columns.begin()] = column_names.size();
+                column_names.push_back(name);
+            }
+        }
+    }
+    // A row is not read past its last selected cell
+    int last_column = -1;
+    for (size_t c = 0; c < destination.size(); c++) {
+        if (destination[c] >= 0)
+            last_column = c;
+    }
+
+    // The rows (blank lines skipped), so the column-major matrix is filled in place without a transpose
+    std::vector<std::pair<const char *, const char *>> rows;
+    for (const char *line = header_end + (header_end != end); line < end;) {
+        const char *line_end = LineEnd(line, end);
+        const char *content_end = line_end != line && line_end[-1] == '\r' ? line_end - 1 : line_end;
+        if (content_end != line)
+            rows.emplace_back(line, content_end);
+        line = line_end + 1;
+    }
+    num_frame = rows.size();
+    data.resize(column_names.size() * static_cast<size_t>(num_frame));
+
+    // Parsed a block of rows at a time, then each column's part of the block is copied as one run: writing every
+    // cell straight to its column touches one page per column and row
+    const int block_size = 64;
+    const size_t num_column = column_names.size();
+    std::vector<float> block(block_size * num_column);
+    for (int block_begin = 0; block_begin < num_frame; block_begin += block_size) {
+        const int block_end = std::min(block_begin + block_size, num_frame);
+        std::fill(block.begin(), block.end(), std::numeric_limits<float>::quiet_NaN());
+        for (int f = block_begin; f < block_end; f++) {
+            float *row = block.data() + (f - block_begin) * num_column;
+            const char *cell = rows[f].first, *row_end = rows[f].second;
+            for (int c = 0; c <= last_column && cell <= row_end; c++) {
+                const char *cell_end;
+                float value;
+                if (destination[c] < 0) {
+                    const void *comma = std::memchr(cell, ',', row_end - cell);
+                    cell_end = comma != nullptr ? static_cast<const char *>(comma) : row_end;
+                } else if (ParseFloat(cell, row_end, value, cell_end)) {
+                    row[destination[c]] = value;
+                }
+                cell = cell_end + 1;
+            }
+        }
+        for (size_t c = 0; c < num_column; c++) {
+            float *column = data.data() + c * num_frame;
+            for (int f = block_begin; f < block_end; f++)
+                column[f] = block[(f - block_begin) * num_column + c];
+        }
+    }
+    return true;
+}
+
+int OpenPoseData::FindColumn(const std::string &name) const {
+    auto found = std::find(column_names.begin(), column_names.end(), name);
+    return found == column_names.end() ? -1 : found - column_names.begin();
+}
+
+bool OpenPoseData::GetKeypoint(const std::string &keypoint, const float *&x, const float *&y) const {
+    const int x_column = FindColumn("2DX_" + keypoint), y_column = FindColumn("2DY_" + keypoint);
+    if (x_column < 0 || y_column < 0)
+        return false;
+    x = Column(x_column);
+    y = Column(y_column);
+    return true;
+}
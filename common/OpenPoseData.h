@@ -0,0 +1,79 @@
+#ifndef TESTBED_OPENPOSEDATA_H
+#define TESTBED_OPENPOSEDATA_H
+
+#include <string>
+#include <vector>
+
+namespace openPoseData {
+
+    /**
+     * The OpenPose keypoints of a clip as exported to csv (one row per frame, one column per keypoint coordinate,
+     * e.g. 2DX_rshoulder). Column-major like FeatureMatrix: column c of frame f is at c * num_frame + f.
+     * Cells that are empty or not a number are NaN.
+     * Keypoint x & y are the columns 2DX_<keypoint> & 2DY_<keypoint>.
+     */
+    class OpenPoseData {
+    private:
+        std::vector<std::string> column_names;
+        int num_frame = 0;
+        std::vector<float> data;
+
+    public:
+        OpenPoseData() = default;
+
+        /**
+         * Replace the content with the csv file, the first line is the header.
+         * The file is memory-mapped and parsed in place, straight into the column-major matrix.
+         * @return false if the file cannot be opened
+         */
+        bool Load(const std::string &filename);
+
+        /**
+         * Same with only the selected columns, in the order given. The cells of the other columns are not parsed
+         * and a row is not read past its last selected cell. Names the header does not have are left out.
+         */
+        bool Load(const std::string &filename, const std::vector<std::string> &selected_columns);
+
+        /// Index of the column, -1 if there is none
+        int FindColumn(const std::string &name) const;
+
+        const float *Column(int column) const;
+
+        /**
+         * The image coordinates of a keypoint over all frames, e.g. "rshoulder"
+         * @return false if the keypoint's 2DX_ or 2DY_ column is missing
+         */
+        bool GetKeypoint(const std::string &keypoint, const float *&x, const float *&y) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        const std::vector<std::string> &GetColumnNames() const;
+
+        int GetNumFrame() const;
+
+        int GetNumColumn() const;
+
+        const std::vector<float> &GetData() const;
+    };
+
+    inline const float *OpenPoseData::Column(int column) const {
+        return data.data() + static_cast<size_t>(column) * num_frame;
+    }
+
+    inline const std::vector<std::string> &OpenPoseData::GetColumnNames() const {
+        return column_names;
+    }
+
+    inline int OpenPoseData::GetNumFrame() const {
+        return num_frame;
+    }
+
+    inline int OpenPoseData::GetNumColumn() const {
+        return column_names.size();
+    }
+
+    inline const std::vector<float> &OpenPoseData::GetData() const {
+        return data;
+    }
+}
+
+#endif //TESTBED_OPENPOSEDATA_H
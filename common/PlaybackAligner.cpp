@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include "PlaybackAligner.h"
+#include "BoneNames.h"
+#include "Similarity.h"
+
+using namespace playbackAligner;
+using similarity::Similarity;
+using motionPyramid::MotionPyramid;
+
+namespace {
+    /// The columns of features named in column_names, time-major & z-normalized per column
+    std::vector<float> TimeMajor(const FeatureMatrix &features, const std::vector<std::string> &column_names) {
+        const int num_frame = features.GetNumFrame(), num_channel = static_cast<int>(column_names.size());
+        std::vector<float> series(static_cast<size_t>(num_frame) * num_channel);
+        for (int c = 0; c < num_channel; c++) {
+            const float *column = features.Column(features.GetSchema().FindColumn(column_names[c]));
+            for (int f = 0; f < num_frame; f++)
+                series[static_cast<size_t>(f) * num_channel + c] = column[f];
+        }
+        Similarity::ZNormalize(series.data(), num_frame, num_channel);
+        return series;
+    }
+}
+
+PlaybackAligner::PlaybackAligner(const AlignerConfig &config) : config(config) {}
+
+PlaybackAligner::~PlaybackAligner() {
+    Reset();
+}
+
+void PlaybackAligner::Start(const BVH *new_user_bvh, const BVH *new_expert_bvh) {
+    Reset();
+    if (new_user_bvh == nullptr || new_expert_bvh == nullptr)
+        return;
+
+    // Snapshot: the clips can be edited while the job runs, the angles do not depend on where the skeletons stand
+    user_bvh = new_user_bvh;
+    expert_bvh = new_expert_bvh;
+    user_pose.Build(user_bvh, glm::vec3(0.0f));
+    expert_pose.Build(expert_bvh, glm::vec3(0.0f));
+    user_motion = *user_bvh->GetModifiedMotions();
+    expert_motion = *expert_bvh->GetModifiedMotions();
+
+    isCancelRequested = false;
+    job_thread = std::thread(&PlaybackAligner::RunJob, this);
+}
+
+void PlaybackAligner::Reset() {
+    isCancelRequested = true;
+    if (job_thread.joinable())
+        job_thread.join();
+    isReady = false;
+    expert_frames.clear();
+    user_bvh = nullptr;
+    expert_bvh = nullptr;
+}
+
+void PlaybackAligner::RunJob() {
+    const auto start = std::chrono::high_resolution_clock::now();
+    const FeatureSchema user_schema(user_bvh, config.target_list, skeleton::TARGET_BONE_NAMES);
+    const FeatureSchema expert_schema(expert_bvh, config.target_list, skeleton::TARGET_BONE_NAMES);
+    const FeatureMatrix user_features = FeatureExtractor::Extract(user_schema, user_bvh, user_motion, user_pose);
+    if (isCancelRequested)
+        return;
+    const FeatureMatrix expert_features = FeatureExtractor::Extract(expert_schema, expert_bvh, expert_motion,
+                                                                    expert_pose);
+    if (isCancelRequested)
+        return;
+
+    float path_distance = 0;
+    auto frames = Align(user_features, expert_features, config, &path_distance);
+    if (frames.empty() || isCancelRequested)
+        return;
+    expert_frames = std::move(frames);
+    distance = path_distance;
+    align_time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    isReady = true;
+
+    std::cout << "Playback alignment: " << user_features.GetNumFrame() << " x " << expert_features.GetNumFrame()
+              << " frames in " << align_time << " ms, distance " << distance << std::endl;
+}
+
+std::vector<int> PlaybackAligner::Align(const FeatureMatrix &user_features, const FeatureMatrix &expert_features,
+                                        const AlignerConfig &config, float *distance) {
+    std::vector<std::string> column_names;
+    for (const auto &column: user_features.GetSchema().GetColumns()) {
+        if (expert_features.GetSchema().FindColumn(column.name) >= 0)
+            column_names.push_back(column.name);
+    }
+    const int num_user = user_features.GetNumFrame(), num_expert = expert_features.GetNumFrame();
+    if (column_names.empty() || num_user == 0 || num_expert == 0)
+        return {};
+
+    const auto user_series = TimeMajor(user_features, column_names);
+    const auto expert_series = TimeMajor(expert_features, column_names);
+    const int radius = std::max(config.min_radius,
+                                static_cast<int>(config.band_fraction * std::max(num_user, num_expert)));
+    // Coarse-to-fine: linear in the frames, long practice sessions included
+    const int num_channel = static_cast<int>(column_names.size());
+    const MotionPyramid user_pyramid(user_series.data(), num_user, num_channel, config.num_level);
+    const MotionPyramid expert_pyramid(expert_series.data(), num_expert, num_channel, config.num_level);
+    std::vector<std::pair<int, int>> path;
+    const float path_distance = Similarity::FastDtwPath(user_pyramid, expert_pyramid, radius, config.refine_radius,
+                                                        path);
+    if (path.empty())
+        return {};
+    if (distance != nullptr)
+        *distance = path_distance;
+
+    // Every user frame is on the path, a run of expert frames is matched to it
+    std::vector<int> frames(num_user);
+    for (size_t k = 0; k < path.size();) {
+        const int user_frame = path[k].first, first_expert = path[k].second;
+        while (k + 1 < path.size() && path[k + 1].first == user_frame)
+            k++;
+        frames[user_frame] = (first_expert + path[k].second) / 2;
+        k++;
+    }
+    return frames;
+}
@@ -0,0 +1,127 @@
+#ifndef TESTBED_PLAYBACKALIGNER_H
+#define TESTBED_PLAYBACKALIGNER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BVH.h"
+#include "PoseBuffer.h"
+#include "FeatureExtractor.h"
+
+using namespace bvh;
+using namespace poseBuffer;
+using namespace featureExtractor;
+
+namespace playbackAligner {
+
+    struct AlignerConfig {
+        /// Joints whose angle features are aligned, the columns both clips have are used
+        std::vector<std::string> target_list = {"chest", "rShldr", "rForeArm", "rHand", "lShldr", "lForeArm", "hip",
+                                                "rThigh", "lThigh"};
+        /// Band radius of the DTW, as a fraction of the longer clip...
+        float band_fraction = 0.1f;
+        /// ...but at least this many frames
+        int min_radius = 8;
+        /// Levels of the motion pyramids (1: the banded DTW at full resolution only)
+        int num_level = 4;
+        /// Half-width of the window the path is refined in at each finer level, in frames of that level
+        int refine_radius = 4;
+    };
+
+    /**
+     * Aligns the expert clip to the user's for synchronized playback: a DTW warping path between their joint-angle
+     * trajectories (z-normalized per column) gives, for every frame of the user, the expert's frame in the same
+     * phase of the stroke. The path is found coarse-to-fine over motion pyramids of both trajectories
+     * (Similarity::FastDtwPath), so the time stays linear on long sessions.
+     * Start takes a snapshot of both clips on the main thread (forward kinematics & a copy of the modified motion,
+     * like Analysizer) and a worker thread aligns them once. Playback then only looks the expert's frame up
+     * (GetExpertFrame), nothing is aligned per frame.
+     */
+    class PlaybackAligner {
+    private:
+        AlignerConfig config;
+
+        // -------------------- Snapshot -------------------- //
+        /// Only the hierarchies are read off the main thread
+        const BVH *user_bvh = nullptr;
+        const BVH *expert_bvh = nullptr;
+        std::vector<double> user_motion, expert_motion;
+        PoseBuffer user_pose, expert_pose;
+
+        // -------------------- Job -------------------- //
+        std::thread job_thread;
+        std::atomic<bool> isReady{false};
+        std::atomic<bool> isCancelRequested{false};
+
+        /// expert_frames[f]: the expert's frame played with the user's frame f, written before isReady is set
+        std::vector<int> expert_frames;
+        float distance = 0;
+        /// Wall-clock time of the alignment (ms)
+        double align_time = 0;
+
+        // -------------------- Methods -------------------- //
+        void RunJob();
+
+    public:
+        PlaybackAligner() = default;
+
+        explicit PlaybackAligner(const AlignerConfig &config);
+
+        ~PlaybackAligner();
+
+        PlaybackAligner(const PlaybackAligner &) = delete;
+
+        PlaybackAligner &operator=(const PlaybackAligner &) = delete;
+
+        /**
+         * Align the modified motions of both clips in the background, a running alignment is dropped first.
+         * Both BVHs must outlive the job: Reset before deleting either.
+         */
+        void Start(const BVH *new_user_bvh, const BVH *new_expert_bvh);
+
+        /// Wait for a running alignment and drop the result, playback goes back to lockstep
+        void Reset();
+
+        /**
+         * The alignment itself: for every frame of the user's features, the expert's frame matched to it (the
+         * middle of its run on the warping path, so the frames never go backwards)
+         * @param distance set to the DTW distance if not null
+         * @return empty if the features share no column or either is empty
+         */
+        static std::vector<int> Align(const FeatureMatrix &user_features, const FeatureMatrix &expert_features,
+                                      const AlignerConfig &config = AlignerConfig(), float *distance = nullptr);
+
+        // -------------------- Getter & Setter -------------------- //
+        bool IsReady() const;
+
+        /// O(1), -1 until the alignment is ready and for a frame the user's clip did not have when it started
+        int GetExpertFrame(int user_frame) const;
+
+        /// Valid once ready
+        float GetDistance() const;
+
+        double GetAlignTime() const;
+    };
+
+    inline bool PlaybackAligner::IsReady() const {
+        return isReady;
+    }
+
+    inline int PlaybackAligner::GetExpertFrame(int user_frame) const {
+        if (!isReady || user_frame < 0 || user_frame >= static_cast<int>(expert_frames.size()))
+            return -1;
+        return expert_frames[user_frame];
+    }
+
+    inline float PlaybackAligner::GetDistance() const {
+        return distance;
+    }
+
+    inline double PlaybackAligner::GetAlignTime() const {
+        return align_time;
+    }
+}
+
+#endif //TESTBED_PLAYBACKALIGNER_H
@@ -0,0 +1,137 @@
+#include <glm/gtc/quaternion.hpp>
+
+#include "PoseBuffer.h"
+#include "AngleKernel.h"
+
+using namespace poseBuffer;
+using namespace angleTool;
+
+void PoseBuffer::Resize(int new_num_frame, int new_num_joint) {
+    num_frame = new_num_frame;
+    num_joint = new_num_joint;
+
+    const size_t size = static_cast<size_t>(num_frame) * num_joint;
+    orientations.resize(size);
+    position_x.resize(size);
+    position_y.resize(size);
+    position_z.resize(size);
+    chain_translations.resize(num_joint);
+    chain_rotations.resize(num_joint);
+}
+
+void PoseBuffer::Build(const BVH *bvh, const glm::vec3 &skeleton_position) {
+    Resize(bvh->GetNumModifiedFrame(), bvh->GetNumJoint());
+    for (int frame = 0; frame < num_frame; frame++)
+        ComputeFrame(bvh, frame, frame, skeleton_position);
+}
+
+void PoseBuffer::BuildFrame(const BVH *bvh, int frame, const glm::vec3 &skeleton_position) {
+    Resize(1, bvh->GetNumJoint());
+    ComputeFrame(bvh, frame, 0, skeleton_position);
+}
+
+void PoseBuffer::ComputeFrame(const BVH *bvh, int frame, int slot, const glm::vec3 &skeleton_position) {
+    // The joints are stored parent first, so the chain of the parent is always ready.
+    // chain_*[id] is the transform a child of id starts from, i.e. the product over the ancestors in
+    // Skeleton::ApplyBvhMotion, which makes one frame O(num_joint) instead of O(num_joint * depth).
+    for (int id = 0; id < num_joint; id++) {
+        auto joint = bvh->GetJoint(id);
+
+        glm::vec3 pos{joint->offset[0], joint->offset[1], joint->offset[2]};
+        glm::vec3 angle{0, 0, 0};
+        for (auto channel: joint->channels) {
+            switch (channel->type) {
+                case X_ROTATION:
+                    angle.x = bvh->GetModifiedMotion(frame, channel->index);
+                    break;
+                case Y_ROTATION:
+                    angle.y = bvh->GetModifiedMotion(frame, channel->index);
+                    break;
+                case Z_ROTATION:
+                    angle.z = bvh->GetModifiedMotion(frame, channel->index);
+                    break;
+                case X_POSITION:
+                    pos.x = bvh->GetModifiedMotion(frame, channel->index);
+                    break;
+                case Y_POSITION:
+                    pos.y = bvh->GetModifiedMotion(frame, channel->index);
+                    break;
+                case Z_POSITION:
+                    pos.z = bvh->GetModifiedMotion(frame, channel->index);
+                    break;
+            }
+        }
+        pos *= bvh->GetPositionScale();
+
+        glm::mat4 translation(1.0), rotation(1.0);
+        if (!joint->parents.empty()) {
+            translation = chain_translations[joint->parents.back()->index];
+            rotation = chain_rotations[joint->parents.back()->index];
+        }
+
+        // The chain for the children: move to this joint & apply its motion rotation
+        auto &chain_translation = chain_translations[id];
+        auto &chain_rotation = chain_rotations[id];
+        // I don't want to move by hip's position
+        chain_translation = glm::translate(translation, joint->name != "hip" ? pos : skeleton_position);
+        chain_rotation = rotation;
+        for (auto axis: bvh->GetRotationOrder(id)) {
+            glm::vec3 axisVec3;
+            float radians;
+            switch (axis) {
+                case X_ROTATION:
+                    radians = glm::radians(angle.x);
+                    axisVec3 = glm::vec3(1.0, 0.0, 0.0);
+                    break;
+                case Y_ROTATION:
+                    radians = glm::radians(angle.y);
+                    axisVec3 = glm::vec3(0.0, 1.0, 0.0);
+                    break;
+                default:
+                case Z_ROTATION:
+                    radians = glm::radians(angle.z);
+                    axisVec3 = glm::vec3(0.0, 0.0, 1.0);
+                    break;
+            }
+            chain_rotation = glm::rotate(chain_rotation, radians, axisVec3);
+            chain_translation = glm::rotate(chain_translation, radians, axisVec3);
+        }
+
+        // Move to current joint's position
+        if (joint->name == "hip")
+            translation = glm::translate(translation, skeleton_position);
+
+        // rotate current joint object to turn to child
+        pos = glm::normalize(pos);
+        glm::vec3 orig = glm::vec3(0.0, -1.0, 0.0);
+        glm::vec3 cross = glm::normalize(glm::cross(pos, orig));
+        if (glm::length(cross) > 0) {
+            rotation = glm::rotate(rotation, glm::pi<float>() - glm::acos(glm::dot(pos, orig)), cross);
+            translation = glm::rotate(translation, glm::pi<float>() - glm::acos(glm::dot(pos, orig)), cross);
+        } else if (pos.x > 0) {
+            rotation = glm::rotate(rotation, glm::radians(180.0f), glm::vec3(0.0, 1.0, 0.0));
+            translation = glm::rotate(translation, glm::radians(180.0f), glm::vec3(0.0, 1.0, 0.0));
+        }
+
+        glm::vec4 result_pos = translation * glm::vec4(0.0, 0.0, 0.0, 1.0);
+        glm::quat result_angle = glm::quat_cast(rotation);
+        auto i = Index(id, slot);
+        orientations.x[i] = result_angle.x;
+        orientations.y[i] = result_angle.y;
+        orientations.z[i] = result_angle.z;
+        orientations.w[i] = result_angle.w;
+        position_x[i] = result_pos.x;
+        position_y[i] = result_pos.y;
+        position_z[i] = result_pos.z;
+    }
+}
+
+void PoseBuffer::GetGlobalAngles(int joint, float *x, float *y, float *z) const {
+    auto begin = Index(joint, 0);
+    AngleKernel::QuaternionToEulerAngles(orientations.x.data() + begin, orientations.y.data() + begin,
+                                         orientations.z.data() + begin, orientations.w.data() + begin,
+                                         x, y, z, num_frame);
+    AngleKernel::EulerAnglesToDegree(x, x, num_frame);
+    AngleKernel::EulerAnglesToDegree(y, y, num_frame);
+    AngleKernel::EulerAnglesToDegree(z, z, num_frame);
+}
@@ -0,0 +1,119 @@
+#ifndef TESTBED_POSEBUFFER_H
+#define TESTBED_POSEBUFFER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "BVH.h"
+#include "AngleTool.h"
+
+using namespace bvh;
+
+namespace poseBuffer {
+
+    /**
+     * World orientation & position of every joint for every frame of a clip.
+     * It runs the same forward kinematics as Skeleton::ApplyBvhMotion, but on the whole clip at once
+     * and without touching the physics objects, so it is what whole-clip analysis should read from.
+     * The storage is joint-major: the frames of one joint are contiguous (index = joint * num_frame + frame).
+     */
+    class PoseBuffer {
+    private:
+        int num_frame = 0;
+        int num_joint = 0;
+
+        angleTool::QuaternionArray orientations;
+        std::vector<float> position_x, position_y, position_z;
+
+        /// Scratch space of the forward kinematics, one transform per joint
+        std::vector<glm::mat4> chain_translations, chain_rotations;
+
+        // -------------------- Methods -------------------- //
+        void Resize(int new_num_frame, int new_num_joint);
+
+        /// Forward kinematics of one motion frame, stored at frame index slot
+        void ComputeFrame(const BVH *bvh, int frame, int slot, const glm::vec3 &skeleton_position);
+
+    public:
+        PoseBuffer() = default;
+
+        /**
+         * Compute the world transforms of all the modified motion frames
+         * @param skeleton_position same as the position given to the Skeleton
+         */
+        void Build(const BVH *bvh, const glm::vec3 &skeleton_position);
+
+        /**
+         * Compute the world transforms of a single motion frame, stored as frame 0.
+         * Used to play a clip frame by frame without keeping the whole clip, the buffers are reused.
+         */
+        void BuildFrame(const BVH *bvh, int frame, const glm::vec3 &skeleton_position);
+
+        /**
+         * Global Euler angles (degree) of a joint over all frames, the whole-clip version of Bone::GetSelfAngle()
+         * @param x, y, z output arrays of num_frame elements
+         */
+        void GetGlobalAngles(int joint, float *x, float *y, float *z) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        int GetNumFrame() const;
+
+        int GetNumJoint() const;
+
+        size_t Index(int joint, int frame) const;
+
+        rp3d::Quaternion GetOrientation(int joint, int frame) const;
+
+        glm::vec3 GetPosition(int joint, int frame) const;
+
+        const angleTool::QuaternionArray &GetOrientations() const;
+
+        const std::vector<float> &GetPositionX() const;
+
+        const std::vector<float> &GetPositionY() const;
+
+        const std::vector<float> &GetPositionZ() const;
+    };
+
+    inline int PoseBuffer::GetNumFrame() const {
+        return num_frame;
+    }
+
+    inline int PoseBuffer::GetNumJoint() const {
+        return num_joint;
+    }
+
+    inline size_t PoseBuffer::Index(int joint, int frame) const {
+        return static_cast<size_t>(joint) * num_frame + frame;
+    }
+
+    inline rp3d::Quaternion PoseBuffer::GetOrientation(int joint, int frame) const {
+        return orientations.Get(Index(joint, frame));
+    }
+
+    inline glm::vec3 PoseBuffer::GetPosition(int joint, int frame) const {
+        auto i = Index(joint, frame);
+        return {position_x[i], position_y[i], position_z[i]};
+    }
+
+    inline const angleTool::QuaternionArray &PoseBuffer::GetOrientations() const {
+        return orientations;
+    }
+
+    inline const std::vector<float> &PoseBuffer::GetPositionX() const {
+        return position_x;
+    }
+
+    inline const std::vector<float> &PoseBuffer::GetPositionY() const {
+        return position_y;
+    }
+
+    inline const std::vector<float> &PoseBuffer::GetPositionZ() const {
+        return position_z;
+    }
+}
+
+#endif //TESTBED_POSEBUFFER_H
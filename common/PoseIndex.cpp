@@ -0,0 +1,531 @@
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <queue>
+
+#include "PoseIndex.h"
+#include "AngleKernel.h"
+
+using namespace poseIndex;
+using namespace angleTool;
+
+namespace {
+    /**
+     * The file: magic, then int32 dimension, max_links, ef_construction, ef_search, entry_point, max_level,
+     * num_column, num_clip, num_entry, then the column names & clip names (uint32 length + bytes each), the entries
+     * (int32 clip, frame, level), int64 num_upper_link & the upper links (int32 each, entry after entry), zero
+     * padding to a multiple of float_alignment bytes, and finally the pose vectors (num_entry x dimension floats)
+     * followed by the level-0 links (num_entry x (2 max_links + 1) int32). Native byte order.
+     */
+    const char index_magic[8] = {'T', 'B', 'P', 'O', 'S', 'I', 'X', '1'};
+    const size_t float_alignment = 64;
+
+    template<typename T>
+    void Write(std::ofstream &file, const T &value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void WriteString(std::ofstream &file, const std::string &text) {
+        Write<uint32_t>(file, text.size());
+        file.write(text.data(), text.size());
+    }
+
+    /// Reads the header of a mapped index, every read is checked against the end of the file
+    class HeaderReader {
+    private:
+        const char *cursor;
+        const char *end;
+
+    public:
+        HeaderReader(const char *begin, const char *end) : cursor(begin), end(end) {}
+
+        template<typename T>
+        bool Read(T &value) {
+            if (static_cast<size_t>(end - cursor) < sizeof(T))
+                return false;
+            std::memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return true;
+        }
+
+        bool ReadString(std::string &text) {
+            uint32_t length;
+            if (!Read(length) || static_cast<size_t>(end - cursor) < length)
+                return false;
+            text.assign(cursor, length);
+            cursor += length;
+            return true;
+        }
+
+        const char *GetCursor() const {
+            return cursor;
+        }
+    };
+
+    const int num_lane = 8;
+
+    /// The sum runs in num_lane independent lanes so that the compiler vectorizes it
+    float SquaredDistance(const float *__restrict a, const float *__restrict b, int dimension) {
+        float lanes[num_lane] = {};
+        int i = 0;
+        for (; i + num_lane <= dimension; i += num_lane) {
+            for (int l = 0; l < num_lane; l++)
+                lanes[l] += (a[i + l] - b[i + l]) * (a[i + l] - b[i + l]);
+        }
+        float sum = 0;
+        for (float lane: lanes)
+            sum += lane;
+        for (; i < dimension; i++)
+            sum += (a[i] - b[i]) * (a[i] - b[i]);
+        return sum;
+    }
+
+    /// Start loading a pose vector into the cache, a search reads it next: a level-0 search of a large index waits on
+    /// memory more than it computes
+    inline void Prefetch(const float *vector, int dimension) {
+#if defined(__GNUC__) || defined(__clang__)
+        const char *bytes = reinterpret_cast<const char *>(vector);
+        for (size_t offset = 0; offset < dimension * sizeof(float); offset += 64)
+            __builtin_prefetch(bytes + offset);
+#endif
+    }
+
+    /// Marks the poses a search reached, one per thread & reused: clearing is a new epoch, not a pass over n poses
+    struct VisitedSet {
+        std::vector<uint32_t> epochs;
+        uint32_t epoch = 0;
+
+        void Reset(size_t num_entry) {
+            if (epochs.size() < num_entry)
+                epochs.resize(num_entry, 0);
+            if (++epoch == 0) {
+                std::fill(epochs.begin(), epochs.end(), 0);
+                epoch = 1;
+            }
+        }
+
+        /// Whether the pose was reached already, it is from now on
+        bool Visit(int entry) {
+            if (epochs[entry] == epoch)
+                return true;
+            epochs[entry] = epoch;
+            return false;
+        }
+    };
+
+    bool IsAngleColumn(const FeatureColumn &column) {
+        return column.kind == SELF_X || column.kind == SELF_Y || column.kind == SELF_Z || column.kind == PARENT ||
+               column.kind == CHILD;
+    }
+}
+
+PoseIndex::PoseIndex(const PoseIndexConfig &config)
+        : max_links(std::max(config.max_links, 2)), ef_construction(std::max(config.ef_construction, 1)),
+          ef_search(std::max(config.ef_search, 1)), generator(config.seed) {}
+
+int32_t *PoseIndex::MutableLinks(int entry, int level) {
+    if (level == 0)
+        return link_storage.data() + static_cast<size_t>(entry) * (2 * max_links + 1);
+    return upper_links.data() + upper_offset[entry] + static_cast<size_t>(level - 1) * (max_links + 1);
+}
+
+void PoseIndex::Own() {
+    if (mapped_file == nullptr)
+        return;
+    vector_storage.assign(vectors, vectors + entries.size() * dimension);
+    link_storage.assign(links0, links0 + entries.size() * (2 * max_links + 1));
+    vectors = vector_storage.data();
+    links0 = link_storage.data();
+    mapped_file.reset();
+}
+
+int PoseIndex::AddClip(const std::string &name, const FeatureMatrix &features) {
+    // The first clip fixes the columns, the derivative ones are not part of a pose
+    if (columns.empty()) {
+        for (const auto &column: features.GetSchema().GetColumns()) {
+            if (IsAngleColumn(column))
+                columns.push_back(column.name);
+        }
+        dimension = 2 * static_cast<int>(columns.size());
+    }
+    std::vector<int> sources;
+    for (const auto &column: columns) {
+        sources.push_back(features.GetSchema().FindColumn(column));
+        if (sources.back() < 0) {
+            std::cout << "Cannot index the poses of " << name << ": it has no " << column << " feature" << std::endl;
+            return -1;
+        }
+    }
+    if (columns.empty()) {
+        std::cout << "Cannot index the poses of " << name << ": it has no angle feature" << std::endl;
+        return -1;
+    }
+
+    Own();
+    const int clip = static_cast<int>(clips.size());
+    const int first_entry = static_cast<int>(entries.size()), num_frame = features.GetNumFrame();
+    clips.push_back(name);
+    clip_begin.push_back(first_entry);
+    vector_storage.resize(vector_storage.size() + static_cast<size_t>(num_frame) * dimension);
+    link_storage.resize(link_storage.size() + static_cast<size_t>(num_frame) * (2 * max_links + 1), 0);
+    vectors = vector_storage.data();
+    links0 = link_storage.data();
+    Embed(features, sources, 0, num_frame, vector_storage.data() + static_cast<size_t>(first_entry) * dimension);
+
+    // Insertion is sequential, every pose links to the graph the previous ones made
+    for (int frame = 0; frame < num_frame; frame++) {
+        entries.push_back({clip, frame});
+        Insert(first_entry + frame);
+    }
+    return clip;
+}
+
+void PoseIndex::Insert(int entry) {
+    // Level l is reached with probability max_links^-l
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const double level_scale = 1 / std::log(static_cast<double>(max_links));
+    const int level = static_cast<int>(-std::log(1.0 - uniform(generator)) * level_scale);
+    levels.push_back(level);
+    upper_offset.push_back(static_cast<int64_t>(upper_links.size()));
+    upper_links.resize(upper_links.size() + static_cast<size_t>(level) * (max_links + 1), 0);
+    if (entry_point < 0) {
+        entry_point = entry;
+        max_level = level;
+        return;
+    }
+
+    const float *query = Vector(entry);
+    int num_distance = 0;
+    std::vector<Candidate> starts = {{SquaredDistance(query, Vector(entry_point), dimension), entry_point}};
+    for (int l = max_level; l > level; l--)
+        starts = {SearchLevel(query, starts, 1, l, num_distance).front()};
+
+    for (int l = std::min(level, max_level); l >= 0; l--) {
+        const auto found = SearchLevel(query, starts, ef_construction, l, num_distance);
+        const auto neighbors = SelectNeighbors(found, max_links);
+        int32_t *links = MutableLinks(entry, l);
+        links[0] = static_cast<int32_t>(neighbors.size());
+        for (size_t i = 0; i < neighbors.size(); i++)
+            links[i + 1] = neighbors[i].second;
+
+        // Links go both ways, a neighbour that has too many keeps the best spread of them
+        const int max_neighbor = l == 0 ? 2 * max_links : max_links;
+        for (const auto &[distance, neighbor]: neighbors) {
+            int32_t *neighbor_links = MutableLinks(neighbor, l);
+            if (neighbor_links[0] < max_neighbor) {
+                neighbor_links[++neighbor_links[0]] = entry;
+                continue;
+            }
+            std::vector<Candidate> candidates = {{distance, entry}};
+            for (int i = 1; i <= neighbor_links[0]; i++)
+                candidates.emplace_back(SquaredDistance(Vector(neighbor), Vector(neighbor_links[i]), dimension),
+                                        neighbor_links[i]);
+            std::sort(candidates.begin(), candidates.end());
+            const auto kept = SelectNeighbors(candidates, max_neighbor);
+            neighbor_links[0] = static_cast<int32_t>(kept.size());
+            for (size_t i = 0; i < kept.size(); i++)
+                neighbor_links[i + 1] = kept[i].second;
+        }
+        starts = found;
+    }
+    if (level > max_level) {
+        entry_point = entry;
+        max_level = level;
+    }
+}
+
+std::vector<PoseIndex::Candidate> PoseIndex::SearchLevel(const float *query, const std::vector<Candidate> &starts,
+                                                         int ef, int level, int &num_distance) const {
+    thread_local VisitedSet visited;
+    visited.Reset(entries.size());
+
+    // Nearest first to explore, farthest first to drop
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> candidates;
+    std::priority_queue<Candidate> nearest;
+    for (const auto &start: starts) {
+        if (visited.Visit(start.second))
+            continue;
+        candidates.push(start);
+        nearest.push(start);
+    }
+    while (nearest.size() > static_cast<size_t>(ef))
+        nearest.pop();
+
+    while (!candidates.empty()) {
+        const auto [distance, entry] = candidates.top();
+        // Every pose left is farther than the ef nearest ones
+        if (distance > nearest.top().first && nearest.size() >= static_cast<size_t>(ef))
+            break;
+        candidates.pop();
+        const int32_t *links = Links(entry, level);
+        if (links[0] > 0)
+            Prefetch(Vector(links[1]), dimension);
+        for (int i = 1; i <= links[0]; i++) {
+            const int neighbor = links[i];
+            if (i < links[0])
+                Prefetch(Vector(links[i + 1]), dimension);
+            if (visited.Visit(neighbor))
+                continue;
+            const float neighbor_distance = SquaredDistance(query, Vector(neighbor), dimension);
+            num_distance++;
+            if (nearest.size() < static_cast<size_t>(ef) || neighbor_distance < nearest.top().first) {
+                candidates.emplace(neighbor_distance, neighbor);
+                nearest.emplace(neighbor_distance, neighbor);
+                if (nearest.size() > static_cast<size_t>(ef))
+                    nearest.pop();
+            }
+        }
+    }
+
+    std::vector<Candidate> result(nearest.size());
+    for (size_t i = result.size(); i-- > 0; nearest.pop())
+        result[i] = nearest.top();
+    return result;
+}
+
+std::vector<PoseIndex::Candidate> PoseIndex::SelectNeighbors(const std::vector<Candidate> &candidates,
+                                                             int max_neighbor) const {
+    // A candidate nearer to a kept neighbour than to the base is reached through it, a link to it adds nothing
+    std::vector<Candidate> result;
+    for (const auto &candidate: candidates) {
+        if (static_cast<int>(result.size()) >= max_neighbor)
+            break;
+        const bool isSpread = std::none_of(result.begin(), result.end(), [&](const Candidate &kept) {
+            return SquaredDistance(Vector(candidate.second), Vector(kept.second), dimension) < candidate.first;
+        });
+        if (isSpread)
+            result.push_back(candidate);
+    }
+    return result;
+}
+
+void PoseIndex::Embed(const FeatureMatrix &features, const std::vector<int> &sources, int begin, int end,
+                      float *out) const {
+    const float scale = 1 / std::sqrt(static_cast<float>(sources.size()));
+    for (size_t c = 0; c < sources.size(); c++) {
+        const float *column = features.Column(sources[c]);
+        for (int frame = begin; frame < end; frame++) {
+            float sine, cosine;
+            AngleKernel::SinCos(column[frame] * AngleKernel::deg_to_rad, sine, cosine);
+            float *vector = out + static_cast<size_t>(frame - begin) * dimension;
+            vector[2 * c] = cosine * scale;
+            vector[2 * c + 1] = sine * scale;
+        }
+    }
+}
+
+bool PoseIndex::Embed(const FeatureMatrix &features, int frame, float *vector) const {
+    if (columns.empty() || frame < 0 || frame >= features.GetNumFrame())
+        return false;
+    std::vector<int> sources;
+    for (const auto &column: columns) {
+        sources.push_back(features.GetSchema().FindColumn(column));
+        if (sources.back() < 0)
+            return false;
+    }
+    Embed(features, sources, frame, frame + 1, vector);
+    return true;
+}
+
+std::vector<PoseIndex::Candidate> PoseIndex::SearchGraph(const float *vector, int ef, int &num_distance) const {
+    num_distance++;
+    std::vector<Candidate> starts = {{SquaredDistance(vector, Vector(entry_point), dimension), entry_point}};
+    for (int l = max_level; l > 0; l--)
+        starts = {SearchLevel(vector, starts, 1, l, num_distance).front()};
+    return SearchLevel(vector, starts, ef, 0, num_distance);
+}
+
+std::vector<PoseMatch> PoseIndex::SelectOccurrences(int entry, const std::vector<Candidate> &candidates, int k,
+                                                    int window) const {
+    const auto isSameOccurrence = [this, window](int a, int b) {
+        return entries[a].clip == entries[b].clip && std::abs(entries[a].frame - entries[b].frame) <= window;
+    };
+    std::vector<PoseMatch> matches;
+    for (const auto &[distance, candidate]: candidates) {
+        if (static_cast<int>(matches.size()) >= k)
+            break;
+        if (isSameOccurrence(candidate, entry))
+            continue;
+        const bool isNew = std::none_of(matches.begin(), matches.end(), [&](const PoseMatch &kept) {
+            return isSameOccurrence(candidate, kept.entry);
+        });
+        if (isNew)
+            matches.push_back({candidate, distance});
+    }
+    return matches;
+}
+
+std::vector<PoseMatch> PoseIndex::Search(const float *vector, int k, int ef, PoseSearchStats *stats) const {
+    std::vector<PoseMatch> matches;
+    if (entry_point < 0 || k <= 0)
+        return matches;
+    ef = std::max(ef > 0 ? ef : ef_search, k);
+
+    int num_distance = 0;
+    const auto found = SearchGraph(vector, ef, num_distance);
+    for (size_t i = 0; i < found.size() && i < static_cast<size_t>(k); i++)
+        matches.push_back({found[i].second, found[i].first});
+    if (stats != nullptr) {
+        stats->num_entry = GetNumEntry();
+        stats->num_distance = num_distance;
+    }
+    return matches;
+}
+
+std::vector<PoseMatch> PoseIndex::Search(int entry, int k, int window, int ef, PoseSearchStats *stats) const {
+    std::vector<PoseMatch> matches;
+    if (entry < 0 || entry >= GetNumEntry() || k <= 0)
+        return matches;
+    window = std::max(window, 0);
+
+    // The skipped frames take candidates too: at first the own window's, then twice as many until k are left
+    int num_distance = 0;
+    for (int num_candidate = std::max(ef > 0 ? ef : ef_search, k) + 2 * window + 1;;
+         num_candidate = std::min(2 * num_candidate, GetNumEntry())) {
+        const auto found = SearchGraph(Vector(entry), num_candidate, num_distance);
+        matches = SelectOccurrences(entry, found, k, window);
+        if (static_cast<int>(matches.size()) >= k || num_candidate >= GetNumEntry())
+            break;
+    }
+    if (stats != nullptr) {
+        stats->num_entry = GetNumEntry();
+        stats->num_distance = num_distance;
+    }
+    return matches;
+}
+
+std::vector<PoseMatch> PoseIndex::SearchExhaustive(const float *vector, int k) const {
+    std::vector<PoseMatch> matches(entries.size());
+    for (size_t entry = 0; entry < entries.size(); entry++)
+        matches[entry] = {static_cast<int>(entry), SquaredDistance(vector, Vector(entry), dimension)};
+    const auto nearer = [](const PoseMatch &a, const PoseMatch &b) {
+        return a.distance < b.distance || (a.distance == b.distance && a.entry < b.entry);
+    };
+    const size_t num_match = std::min(matches.size(), static_cast<size_t>(std::max(k, 0)));
+    std::partial_sort(matches.begin(), matches.begin() + num_match, matches.end(), nearer);
+    matches.resize(num_match);
+    return matches;
+}
+
+std::vector<PoseMatch> PoseIndex::SearchExhaustive(int entry, int k, int window) const {
+    if (entry < 0 || entry >= GetNumEntry())
+        return {};
+    std::vector<Candidate> candidates(entries.size());
+    for (size_t other = 0; other < entries.size(); other++)
+        candidates[other] = {SquaredDistance(Vector(entry), Vector(other), dimension), static_cast<int>(other)};
+    std::sort(candidates.begin(), candidates.end());
+    return SelectOccurrences(entry, candidates, k, std::max(window, 0));
+}
+
+int PoseIndex::FindClip(const std::string &name) const {
+    const auto clip = std::find(clips.begin(), clips.end(), name);
+    return clip == clips.end() ? -1 : static_cast<int>(clip - clips.begin());
+}
+
+int PoseIndex::FindEntry(int clip, int frame) const {
+    if (clip < 0 || clip >= GetNumClip() || frame < 0)
+        return -1;
+    const int entry = clip_begin[clip] + frame;
+    const int end = clip + 1 < GetNumClip() ? clip_begin[clip + 1] : GetNumEntry();
+    return entry < end ? entry : -1;
+}
+
+bool PoseIndex::Save(const std::string &filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        return false;
+
+    file.write(index_magic, sizeof(index_magic));
+    for (const int value: {dimension, max_links, ef_construction, ef_search, entry_point, max_level,
+                           static_cast<int>(columns.size()), GetNumClip(), GetNumEntry()})
+        Write<int32_t>(file, value);
+    for (const auto &column: columns)
+        WriteString(file, column);
+    for (const auto &clip: clips)
+        WriteString(file, clip);
+    for (size_t entry = 0; entry < entries.size(); entry++) {
+        Write<int32_t>(file, entries[entry].clip);
+        Write<int32_t>(file, entries[entry].frame);
+        Write<int32_t>(file, levels[entry]);
+    }
+    Write<int64_t>(file, static_cast<int64_t>(upper_links.size()));
+    file.write(reinterpret_cast<const char *>(upper_links.data()), upper_links.size() * sizeof(int32_t));
+
+    // The arrays start aligned, they are used in place once mapped
+    const size_t padding = (float_alignment - static_cast<size_t>(file.tellp()) % float_alignment) % float_alignment;
+    const char zeros[float_alignment] = {};
+    file.write(zeros, padding);
+    file.write(reinterpret_cast<const char *>(vectors), entries.size() * dimension * sizeof(float));
+    file.write(reinterpret_cast<const char *>(links0), entries.size() * (2 * max_links + 1) * sizeof(int32_t));
+    return static_cast<bool>(file);
+}
+
+bool PoseIndex::Load(const std::string &filename) {
+    auto file = std::make_unique<mappedFile::MappedFile>(filename, false);
+    if (!file->IsOpen()) {
+        std::cout << "Cannot open the pose index " << filename << std::endl;
+        return false;
+    }
+
+    PoseIndex index;
+    HeaderReader reader(file->Begin(), file->End());
+    char magic[sizeof(index_magic)];
+    int32_t num_column, num_clip, num_entry;
+    int64_t num_upper_link;
+    bool isValid = reader.Read(magic) && std::memcmp(magic, index_magic, sizeof(magic)) == 0 &&
+                   reader.Read(index.dimension) && reader.Read(index.max_links) &&
+                   reader.Read(index.ef_construction) && reader.Read(index.ef_search) &&
+                   reader.Read(index.entry_point) && reader.Read(index.max_level) && reader.Read(num_column) &&
+                   reader.Read(num_clip) && reader.Read(num_entry) && num_column >= 0 && num_clip >= 0 &&
+                   num_entry >= 0 && index.dimension == 2 * num_column && index.max_links >= 2 &&
+                   index.entry_point < num_entry && (num_entry == 0 || index.entry_point >= 0);
+    for (int32_t c = 0; isValid && c < num_column; c++) {
+        index.columns.emplace_back();
+        isValid = reader.ReadString(index.columns.back());
+    }
+    for (int32_t c = 0; isValid && c < num_clip; c++) {
+        index.clips.emplace_back();
+        isValid = reader.ReadString(index.clips.back());
+    }
+    int64_t upper_size = 0;
+    for (int32_t e = 0; isValid && e < num_entry; e++) {
+        PoseEntry entry;
+        int32_t level;
+        isValid = reader.Read(entry.clip) && reader.Read(entry.frame) && reader.Read(level) && entry.clip >= 0 &&
+                  entry.clip < num_clip && level >= 0 && level <= index.max_level;
+        // A clip starts where its frame 0 is
+        if (isValid && entry.frame == 0 && entry.clip == static_cast<int>(index.clip_begin.size()))
+            index.clip_begin.push_back(e);
+        index.entries.push_back(entry);
+        index.levels.push_back(level);
+        index.upper_offset.push_back(upper_size);
+        upper_size += static_cast<int64_t>(level) * (index.max_links + 1);
+    }
+    isValid = isValid && reader.Read(num_upper_link) && num_upper_link == upper_size &&
+              static_cast<int>(index.clip_begin.size()) == num_clip &&
+              static_cast<size_t>(file->End() - reader.GetCursor()) >= upper_size * sizeof(int32_t);
+    if (isValid) {
+        index.upper_links.resize(upper_size);
+        for (auto &link: index.upper_links)
+            reader.Read(link);
+    }
+
+    const size_t header_size = reader.GetCursor() - file->Begin();
+    const size_t array_begin = (header_size + float_alignment - 1) / float_alignment * float_alignment;
+    const size_t vector_size = static_cast<size_t>(num_entry) * index.dimension * sizeof(float);
+    const size_t link_size = static_cast<size_t>(num_entry) * (2 * index.max_links + 1) * sizeof(int32_t);
+    isValid = isValid && file->GetSize() == array_begin + vector_size + link_size;
+    if (!isValid) {
+        std::cout << filename << " is not a pose index" << std::endl;
+        return false;
+    }
+
+    index.vectors = reinterpret_cast<const float *>(file->Begin() + array_begin);
+    index.links0 = reinterpret_cast<const int32_t *>(file->Begin() + array_begin + vector_size);
+    // The levels of the poses added next only need to stay geometric, not to repeat the build's draws
+    index.generator.seed(static_cast<uint32_t>(num_entry));
+    index.mapped_file = std::move(file);
+    *this = std::move(index);
+    return true;
+}
@@ -0,0 +1,267 @@
+#ifndef TESTBED_POSEINDEX_H
+#define TESTBED_POSEINDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "FeatureExtractor.h"
+#include "MappedFile.h"
+
+using namespace featureExtractor;
+
+namespace poseIndex {
+
+    /// One indexed pose: a frame of one of the clips
+    struct PoseEntry {
+        int clip = 0;
+        int frame = 0;
+    };
+
+    struct PoseMatch {
+        int entry = -1;
+        /// Squared distance between the pose vectors, 0 (same pose) to 4
+        float distance = 0;
+    };
+
+    /// Work done by one Search
+    struct PoseSearchStats {
+        int num_entry = 0;
+        /// Pose vectors compared to the query
+        int num_distance = 0;
+    };
+
+    struct PoseIndexConfig {
+        /// Joints whose angle features (FeatureSchema columns) make up the pose vector
+        std::vector<std::string> target_list = {"chest", "rCollar", "rShldr", "rForeArm", "rHand", "lShldr",
+                                                "lForeArm", "hip", "rThigh", "lThigh"};
+        /// Links of a pose on the upper levels of the graph, twice as many on level 0
+        int max_links = 24;
+        /// Candidates kept while a pose is linked, more gives a better graph & a slower insertion.
+        /// Close poses are many & nearly as close as each other, below 400 the graph misses a tenth of them; the price
+        /// is the build, 1.5 to 3 ms per pose on one core (under an hour per million poses)
+        int ef_construction = 400;
+        /**
+         * Candidates kept by Search, at least k: more gives a better recall & a slower query. The default trades
+         * latency for recall: on a million poses (pose/index, one core) 160 finds 0.97 of the 10 nearest in 0.5 to
+         * 0.65 ms p50 and about 1 ms p99; 128 is under 0.55 ms p50 for 0.94 (SetEfSearch), 256 finds 0.99 in 0.8 to
+         * 1 ms
+         */
+        int ef_search = 160;
+        /// Seed of the level draws, the same insertions give the same graph
+        uint32_t seed = 1;
+    };
+
+    /**
+     * Approximate nearest-neighbour index over single poses: every frame of every clip added.
+     *
+     * A pose is its angle feature columns, each angle a as (cos a, sin a) scaled by 1 / sqrt(num_column): the squared
+     * distance of two poses is the mean of 2 - 2 cos(angle difference) over the columns, it does not jump at +-180
+     * and does not depend on the clip's length or speed.
+     *
+     * The poses form a hierarchical navigable small world graph (HNSW, Malkov & Yashunin): every pose gets a random
+     * level (geometric, 1 / max_links of the poses per level up) and is linked to its nearest poses on each level up
+     * to its own, picked by the neighbour heuristic so the links spread in all directions. Search descends greedily
+     * from the top level & explores level 0 keeping the ef_search nearest poses found: about ef_search * log(n)
+     * distances per query instead of n. Clips are added one after the other as they load, there is no rebuild.
+     *
+     * Save writes the index to one file (TBPOSIX1, see PoseIndex.cpp) and Load maps it: the pose vectors & level-0
+     * links are used in place, until the next AddClip copies them into memory.
+     * Searches may run concurrently, AddClip may not run with anything else.
+     */
+    class PoseIndex {
+    private:
+        std::vector<std::string> columns;
+        std::vector<std::string> clips;
+        /// First entry of each clip, a clip's entries are consecutive
+        std::vector<int> clip_begin;
+        std::vector<PoseEntry> entries;
+        /// Floats per pose vector, 2 per column
+        int dimension = 0;
+        int max_links = 24;
+        int ef_construction = 400;
+        int ef_search = 160;
+
+        /// The top level's pose, where every search starts, -1 if empty
+        int entry_point = -1;
+        int max_level = -1;
+        std::vector<int32_t> levels;
+        std::mt19937 generator;
+
+        /// Built in memory: owns the pose vectors & the level-0 links (count + 2 * max_links ids per pose)
+        std::vector<float> vector_storage;
+        std::vector<int32_t> link_storage;
+        /// Loaded: the mapped file they point into
+        std::unique_ptr<mappedFile::MappedFile> mapped_file;
+        const float *vectors = nullptr;
+        const int32_t *links0 = nullptr;
+
+        /// Links of levels 1 to the pose's level (count + max_links ids each), from upper_offset[pose] on
+        std::vector<int64_t> upper_offset;
+        std::vector<int32_t> upper_links;
+
+        // -------------------- Methods -------------------- //
+        using Candidate = std::pair<float, int>;
+
+        const float *Vector(int entry) const;
+
+        const int32_t *Links(int entry, int level) const;
+
+        int32_t *MutableLinks(int entry, int level);
+
+        /// Copy the mapped arrays into memory, the next insertions grow them
+        void Own();
+
+        /// Link the last entry into the graph
+        void Insert(int entry);
+
+        /**
+         * The ef nearest poses of query on a level, nearest first, reached from starts
+         * @param num_distance add the distances computed
+         */
+        std::vector<Candidate> SearchLevel(const float *query, const std::vector<Candidate> &starts, int ef,
+                                           int level, int &num_distance) const;
+
+        /// At most max_neighbor of the candidates (nearest first), each nearer to base than to the ones kept
+        std::vector<Candidate> SelectNeighbors(const std::vector<Candidate> &candidates, int max_neighbor) const;
+
+        /// The level-0 search of Search, from the top level's greedy descent, ef nearest first
+        std::vector<Candidate> SearchGraph(const float *vector, int ef, int &num_distance) const;
+
+        /**
+         * Up to k of the candidates (nearest first) that are another occurrence of entry's pose: the frames of
+         * entry's clip within window frames of it are skipped, & a candidate within window frames of a kept one of
+         * the same clip is the same occurrence
+         */
+        std::vector<PoseMatch> SelectOccurrences(int entry, const std::vector<Candidate> &candidates, int k,
+                                                 int window) const;
+
+        /// The pose vectors of features' frames [begin, end), columns at sources
+        void Embed(const FeatureMatrix &features, const std::vector<int> &sources, int begin, int end,
+                   float *out) const;
+
+    public:
+        explicit PoseIndex(const PoseIndexConfig &config = PoseIndexConfig());
+
+        PoseIndex(PoseIndex &&) = default;
+
+        PoseIndex &operator=(PoseIndex &&) = default;
+
+        /**
+         * Index every frame of a clip's features (ExpertIndex::LoadClip), the first clip added fixes the columns
+         * @return the clip, -1 (with a message) if the features lack one of the index's columns
+         */
+        int AddClip(const std::string &name, const FeatureMatrix &features);
+
+        /// @return false if the file cannot be written
+        bool Save(const std::string &filename) const;
+
+        /// @return false (with a message) if the file cannot be opened or is not an index
+        bool Load(const std::string &filename);
+
+        /**
+         * The pose vector of a frame of a clip's features, GetDimension() floats
+         * @return false if the features lack one of the index's columns or the frame is out of the clip
+         */
+        bool Embed(const FeatureMatrix &features, int frame, float *vector) const;
+
+        /**
+         * The k nearest poses of a pose vector, nearest first
+         * @param ef candidates kept, 0 for the configured ef_search
+         */
+        std::vector<PoseMatch> Search(const float *vector, int k, int ef = 0, PoseSearchStats *stats = nullptr) const;
+
+        /**
+         * The k nearest occurrences of an indexed pose elsewhere, nearest first: its own clip's frames within window
+         * frames of it are skipped and the matches within window frames of each other in a clip count once (the
+         * nearest), so a pose held for a few frames does not fill the k matches. The search widens its ef until k
+         * matches are left or every pose was considered.
+         * @param window frames, about the length of a stroke
+         */
+        std::vector<PoseMatch> Search(int entry, int k, int window, int ef = 0,
+                                      PoseSearchStats *stats = nullptr) const;
+
+        /// The k nearest poses by comparing every one of them: the reference for Search
+        std::vector<PoseMatch> SearchExhaustive(const float *vector, int k) const;
+
+        /// Same for the occurrences of an indexed pose
+        std::vector<PoseMatch> SearchExhaustive(int entry, int k, int window) const;
+
+        /// Index of the clip added with this name, -1 if there is none
+        int FindClip(const std::string &name) const;
+
+        /// The entry of a frame of a clip, -1 if it is not indexed
+        int FindEntry(int clip, int frame) const;
+
+        // -------------------- Getter & Setter -------------------- //
+        bool IsEmpty() const;
+
+        int GetNumEntry() const;
+
+        const PoseEntry &GetEntry(int entry) const;
+
+        const std::string &GetClip(int entry) const;
+
+        int GetNumClip() const;
+
+        const std::vector<std::string> &GetColumns() const;
+
+        int GetDimension() const;
+
+        /// Levels of the graph above level 0
+        int GetMaxLevel() const;
+
+        void SetEfSearch(int ef_search);
+    };
+
+    inline const float *PoseIndex::Vector(int entry) const {
+        return vectors + static_cast<size_t>(entry) * dimension;
+    }
+
+    inline const int32_t *PoseIndex::Links(int entry, int level) const {
+        if (level == 0)
+            return links0 + static_cast<size_t>(entry) * (2 * max_links + 1);
+        return upper_links.data() + upper_offset[entry] + static_cast<size_t>(level - 1) * (max_links + 1);
+    }
+
+    inline bool PoseIndex::IsEmpty() const {
+        return entries.empty();
+    }
+
+    inline int PoseIndex::GetNumEntry() const {
+        return static_cast<int>(entries.size());
+    }
+
+    inline const PoseEntry &PoseIndex::GetEntry(int entry) const {
+        return entries[entry];
+    }
+
+    inline const std::string &PoseIndex::GetClip(int entry) const {
+        return clips[entries[entry].clip];
+    }
+
+    inline int PoseIndex::GetNumClip() const {
+        return static_cast<int>(clips.size());
+    }
+
+    inline const std::vector<std::string> &PoseIndex::GetColumns() const {
+        return columns;
+    }
+
+    inline int PoseIndex::GetDimension() const {
+        return dimension;
+    }
+
+    inline int PoseIndex::GetMaxLevel() const {
+        return max_level;
+    }
+
+    inline void PoseIndex::SetEfSearch(int new_ef_search) {
+        ef_search = std::max(new_ef_search, 1);
+    }
+}
+
+#endif //TESTBED_POSEINDEX_H
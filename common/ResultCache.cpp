@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "ResultCache.h"
+
+using namespace resultCache;
+namespace fs = std::filesystem;
+
+namespace {
+    const char cache_magic[8] = {'T', 'B', 'C', 'A', 'C', 'H', 'E', '1'};
+    const char *cache_extension = ".bin";
+
+    int64_t Now() {
+        return fs::file_time_type::clock::now().time_since_epoch().count();
+    }
+
+    template<typename T>
+    void Write(std::ofstream &file, const T &value) {
+        file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void WriteString(std::ofstream &file, const std::string &text) {
+        Write<uint32_t>(file, text.size());
+        file.write(text.data(), text.size());
+    }
+
+    void WriteFloats(std::ofstream &file, const float *values, size_t count) {
+        Write<uint64_t>(file, count);
+        file.write(reinterpret_cast<const char *>(values), count * sizeof(float));
+    }
+
+    template<typename T>
+    bool Read(std::ifstream &file, T &value) {
+        return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+
+    /// Bytes left after the read position: a count read from the file is checked against it before anything is
+    /// allocated, a corrupt entry is dropped instead of throwing
+    uint64_t Remaining(std::ifstream &file) {
+        const auto position = file.tellg();
+        if (position < 0)
+            return 0;
+        file.seekg(0, std::ios::end);
+        const auto end = file.tellg();
+        file.seekg(position);
+        return end > position ? static_cast<uint64_t>(end - position) : 0;
+    }
+
+    bool ReadString(std::ifstream &file, std::string &text) {
+        uint32_t size;
+        if (!Read(file, size) || size > Remaining(file))
+            return false;
+        text.resize(size);
+        return static_cast<bool>(file.read(&text[0], size));
+    }
+
+    bool ReadFloats(std::ifstream &file, std::vector<float> &values) {
+        uint64_t count;
+        if (!Read(file, count) || count > Remaining(file) / sizeof(float))
+            return false;
+        values.resize(count);
+        return static_cast<bool>(file.read(reinterpret_cast<char *>(values.data()), count * sizeof(float)));
+    }
+
+    bool ReadEntry(const std::string &path, CacheEntry &entry) {
+        std::ifstream file(path, std::ios::binary);
+        char magic[8];
+        if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, cache_magic, sizeof(magic)) != 0)
+            return false;
+
+        uint32_t num_target, num_column, num_result;
+        int32_t num_frame;
+        std::vector<std::string> target_list;
+        std::vector<FeatureColumn> columns;
+        // Every target & column takes at least its 4-byte length
+        if (!Read(file, num_target) || num_target > Remaining(file) / 4)
+            return false;
+        target_list.resize(num_target);
+        for (auto &target: target_list) {
+            if (!ReadString(file, target))
+                return false;
+        }
+        if (!Read(file, num_column) || num_column > Remaining(file) / 4)
+            return false;
+        columns.resize(num_column);
+        for (auto &column: columns) {
+            int32_t kind;
+            if (!ReadString(file, column.name) || !Read(file, kind) || !Read(file, column.joint) ||
+                !Read(file, column.other_joint))
+                return false;
+            column.kind = static_cast<FeatureKind>(kind);
+        }
+        std::vector<float> data;
+        if (!Read(file, num_frame) || num_frame < 0 || !ReadFloats(file, data) ||
+            data.size() != static_cast<size_t>(num_frame) * num_column)
+            return false;
+        FeatureMatrix features(FeatureSchema(target_list, columns), num_frame);
+        if (!data.empty())
+            std::copy(data.begin(), data.end(), features.Column(0));
+
+        std::map<std::string, std::vector<float>> results;
+        if (!Read(file, num_result))
+            return false;
+        for (uint32_t i = 0; i < num_result; i++) {
+            std::string name;
+            if (!ReadString(file, name) || !ReadFloats(file, results[name]))
+                return false;
+        }
+
+        entry.features = std::move(features);
+        entry.results = std::move(results);
+        return true;
+    }
+
+    bool WriteEntry(const std::string &path, const CacheEntry &entry) {
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return false;
+        file.write(cache_magic, sizeof(cache_magic));
+
+        const auto &schema = entry.features.GetSchema();
+        Write<uint32_t>(file, schema.GetTargetList().size());
+        for (const auto &target: schema.GetTargetList())
+            WriteString(file, target);
+        Write<uint32_t>(file, schema.GetNumColumn());
+        for (const auto &column: schema.GetColumns()) {
+            WriteString(file, column.name);
+            Write<int32_t>(file, column.kind);
+            Write<int32_t>(file, column.joint);
+            Write<int32_t>(file, column.other_joint);
+        }
+        Write<int32_t>(file, entry.features.GetNumFrame());
+        WriteFloats(file, entry.features.GetData().data(), entry.features.GetData().size());
+
+        Write<uint32_t>(file, entry.results.size());
+        for (const auto &[name, values]: entry.results) {
+            WriteString(file, name);
+            WriteFloats(file, values.data(), values.size());
+        }
+        return static_cast<bool>(file);
+    }
+}
+
+void ContentHash::Add(const void *data, size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = value;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    value = hash;
+}
+
+void ContentHash::Add(const std::string &text) {
+    const uint64_t size = text.size();
+    Add(&size, sizeof(size));
+    Add(text.data(), text.size());
+}
+
+void ContentHash::Add(const std::vector<std::string> &texts) {
+    const uint64_t size = texts.size();
+    Add(&size, sizeof(size));
+    for (const auto &text: texts)
+        Add(text);
+}
+
+std::string ContentHash::GetHex() const {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 0; i < 16; i++)
+        hex[15 - i] = digits[(value >> (4 * i)) & 0xf];
+    return hex;
+}
+
+ResultCache &ResultCache::Instance() {
+    static ResultCache instance;
+    return instance;
+}
+
+std::string ResultCache::EntryPath(const std::string &key) const {
+    return (fs::path(directory) / (key + cache_extension)).string();
+}
+
+void ResultCache::BuildIndex() {
+    if (isIndexed)
+        return;
+    isIndexed = true;
+
+    std::error_code error;
+    fs::create_directories(directory, error);
+    for (const auto &file: fs::directory_iterator(directory, error)) {
+        if (!file.is_regular_file() || file.path().extension() != cache_extension)
+            continue;
+        const size_t num_byte = file.file_size(error);
+        const int64_t last_use = file.last_write_time(error).time_since_epoch().count();
+        index[file.path().stem().string()] = {num_byte, last_use};
+        stats.num_byte += num_byte;
+    }
+    stats.num_entry = index.size();
+    Evict();
+}
+
+void ResultCache::Evict() {
+    std::error_code error;
+    while (stats.num_byte > max_byte && !index.empty()) {
+        auto oldest = std::min_element(index.begin(), index.end(), [](const auto &a, const auto &b) {
+            return a.second.last_use < b.second.last_use;
+        });
+        fs::remove(EntryPath(oldest->first), error);
+        stats.num_byte -= oldest->second.num_byte;
+        stats.num_eviction++;
+        index.erase(oldest);
+    }
+    stats.num_entry = index.size();
+}
+
+bool ResultCache::Load(const std::string &key, CacheEntry &entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BuildIndex();
+
+    auto indexed = index.find(key);
+    if (indexed == index.end()) {
+        stats.num_miss++;
+        return false;
+    }
+    const std::string path = EntryPath(key);
+    if (!ReadEntry(path, entry)) {
+        // Truncated or from another version: drop it
+        std::error_code error;
+        fs::remove(path, error);
+        stats.num_byte -= indexed->second.num_byte;
+        index.erase(indexed);
+        stats.num_entry = index.size();
+        stats.num_miss++;
+        return false;
+    }
+
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    indexed->second.last_use = Now();
+    stats.num_hit++;
+    return true;
+}
+
+void ResultCache::Store(const std::string &key, const CacheEntry &entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    BuildIndex();
+
+    // Written aside then renamed, a reader never sees half an entry
+    const std::string path = EntryPath(key), temporary_path = path + ".tmp";
+    std::error_code error;
+    if (!WriteEntry(temporary_path, entry)) {
+        std::cout << "Cannot write the cache entry " << temporary_path << std::endl;
+        fs::remove(temporary_path, error);
+        return;
+    }
+    fs::rename(temporary_path, path, error);
+    if (error) {
+        fs::remove(temporary_path, error);
+        return;
+    }
+
+    auto indexed = index.find(key);
+    if (indexed != index.end())
+        stats.num_byte -= indexed->second.num_byte;
+    const size_t num_byte = fs::file_size(path, error);
+    index[key] = {num_byte, Now()};
+    stats.num_byte += num_byte;
+    stats.num_store++;
+    Evict();
+}
+
+void ResultCache::SetDirectory(const std::string &directory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isIndexed)
+        this->directory = directory;
+}
+
+void ResultCache::SetMaxByte(size_t max_byte) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->max_byte = max_byte;
+    if (isIndexed)
+        Evict();
+}
+
+CacheStats ResultCache::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
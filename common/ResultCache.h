@@ -0,0 +1,122 @@
+#ifndef TESTBED_RESULTCACHE_H
+#define TESTBED_RESULTCACHE_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "FeatureExtractor.h"
+
+using namespace featureExtractor;
+
+namespace resultCache {
+
+    /// FNV-1a (64 bit) over everything added, in order
+    class ContentHash {
+    private:
+        uint64_t value = 14695981039346656037ull;
+
+    public:
+        void Add(const void *data, size_t size);
+
+        /// Length-prefixed, so "ab" + "c" and "a" + "bc" differ
+        void Add(const std::string &text);
+
+        void Add(const std::vector<std::string> &texts);
+
+        template<typename T>
+        void Add(const std::vector<T> &values);
+
+        // -------------------- Getter & Setter -------------------- //
+        /// 16 hex digits
+        std::string GetHex() const;
+    };
+
+    template<typename T>
+    void ContentHash::Add(const std::vector<T> &values) {
+        const uint64_t size = values.size();
+        Add(&size, sizeof(size));
+        Add(values.data(), values.size() * sizeof(T));
+    }
+
+    /// What an analysis leaves behind: the whole-body features & the model outputs per identifier
+    struct CacheEntry {
+        FeatureMatrix features;
+        std::map<std::string, std::vector<float>> results;
+    };
+
+    struct CacheStats {
+        int num_hit = 0;
+        int num_miss = 0;
+        int num_store = 0;
+        int num_eviction = 0;
+        int num_entry = 0;
+        size_t num_byte = 0;
+
+        float GetHitRate() const;
+    };
+
+    /**
+     * Persistent cache of analysis results, one file per entry in the cache directory named after its key.
+     * The key is a content hash of everything the result depends on (ContentHash: motion, keypoints, analyzer
+     * configuration, model version), so a stale entry is never hit, it just ages out.
+     * Least recently used entries (file modification time, refreshed on every hit) are evicted once the directory
+     * holds more than max_byte. Thread-safe.
+     */
+    class ResultCache {
+    private:
+        struct IndexEntry {
+            size_t num_byte;
+            /// Larger is more recent
+            int64_t last_use;
+        };
+
+        std::string directory = "cache";
+        size_t max_byte = 256 * 1024 * 1024;
+
+        /// Built from the directory on first use
+        std::map<std::string, IndexEntry> index;
+        bool isIndexed = false;
+        CacheStats stats;
+
+        std::mutex mutex;
+
+        ResultCache() = default;
+
+        // -------------------- Methods -------------------- //
+        std::string EntryPath(const std::string &key) const;
+
+        void BuildIndex();
+
+        /// Remove the least recently used entries until the cache fits in max_byte
+        void Evict();
+
+    public:
+        static ResultCache &Instance();
+
+        ResultCache(const ResultCache &) = delete;
+
+        ResultCache &operator=(const ResultCache &) = delete;
+
+        /// @return false on a miss (or an unreadable entry, which is dropped)
+        bool Load(const std::string &key, CacheEntry &entry);
+
+        void Store(const std::string &key, const CacheEntry &entry);
+
+        // -------------------- Getter & Setter -------------------- //
+        /// Only effective before the first Load / Store
+        void SetDirectory(const std::string &directory);
+
+        void SetMaxByte(size_t max_byte);
+
+        CacheStats GetStats();
+    };
+
+    inline float CacheStats::GetHitRate() const {
+        return num_hit + num_miss == 0 ? 0.0f : static_cast<float>(num_hit) / (num_hit + num_miss);
+    }
+}
+
+#endif //TESTBED_RESULTCACHE_H
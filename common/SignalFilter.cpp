@@ -0,0 +1,399 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#include "SignalFilter.h"
+
+using namespace signalFilter;
+
+namespace {
+    /// y = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2) x, run in transposed direct form II
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    /// Low-pass Butterworth of the given order as biquads (bilinear transform, prewarped cutoff)
+    std::vector<Biquad> ButterworthSections(int order, double cutoff, double frame_time) {
+        const double sample_rate = 1 / frame_time;
+        cutoff = std::min(cutoff, 0.49 * sample_rate);
+        const double k = std::tan(M_PI * cutoff / sample_rate), k2 = k * k;
+        std::vector<Biquad> sections;
+        // One biquad per conjugate pole pair, its Q from the pole's angle
+        for (int pair = 0; pair < order / 2; pair++) {
+            const double q = 1 / (2 * std::cos(M_PI * (2 * pair + 1) / (2.0 * order)));
+            const double norm = 1 / (1 + k / q + k2);
+            sections.push_back({k2 * norm, 2 * k2 * norm, k2 * norm, 2 * (k2 - 1) * norm, (1 - k / q + k2) * norm});
+        }
+        // The real pole of an odd order
+        if (order % 2 == 1)
+            sections.push_back({k / (1 + k), k / (1 + k), 0, (k - 1) / (k + 1), 0});
+        return sections;
+    }
+
+    /**
+     * Run the sections over the frames of a time-major buffer in place, forward or backward. Each section starts
+     * in its steady state for the first frame it sees (scipy's sosfilt_zi), the ends do not ring.
+     */
+    void RunSections(const std::vector<Biquad> &sections, double *data, int num_frame, int num_channel,
+                     bool isBackward, std::vector<double> &z1, std::vector<double> &z2) {
+        z1.resize(num_channel);
+        z2.resize(num_channel);
+        const int first = isBackward ? num_frame - 1 : 0, step = isBackward ? -1 : 1;
+        for (const auto &s: sections) {
+            // Steady state of a constant input x0: the output is x0 (unit DC gain)
+            const double *x0 = data + static_cast<size_t>(first) * num_channel;
+            for (int c = 0; c < num_channel; c++) {
+                z2[c] = (s.b2 - s.a2) * x0[c];
+                z1[c] = (s.b1 - s.a1) * x0[c] + z2[c];
+            }
+            double *__restrict state1 = z1.data(), *__restrict state2 = z2.data();
+            for (int i = 0, t = first; i < num_frame; i++, t += step) {
+                double *__restrict frame = data + static_cast<size_t>(t) * num_channel;
+                for (int c = 0; c < num_channel; c++) {
+                    const double x = frame[c];
+                    const double y = s.b0 * x + state1[c];
+                    state1[c] = s.b1 * x - s.a1 * y + state2[c];
+                    state2[c] = s.b2 * x - s.a2 * y;
+                    frame[c] = y;
+                }
+            }
+        }
+    }
+
+    /**
+     * Weights of the least-squares polynomial of the given degree over the 2 * half + 1 frames of a window,
+     * evaluated at position (-half to half, 0 is the center): the fit at that frame is sum_k w[k] * x[k]
+     */
+    std::vector<double> SavgolWeights(int half, int degree, int position) {
+        const int size = degree + 1;
+        // Normal equations G y = v, G = A^T A with A[k][j] = (k / half)^j, v = powers of the position
+        std::vector<double> g(static_cast<size_t>(size) * size, 0.0), v(size);
+        for (int k = -half; k <= half; k++) {
+            const double u = static_cast<double>(k) / half;
+            for (int i = 0; i < size; i++)
+                for (int j = 0; j < size; j++)
+                    g[static_cast<size_t>(i) * size + j] += std::pow(u, i + j);
+        }
+        for (int j = 0; j < size; j++)
+            v[j] = std::pow(static_cast<double>(position) / half, j);
+
+        // Gaussian elimination with partial pivoting, G is small & symmetric positive definite
+        for (int col = 0; col < size; col++) {
+            int pivot = col;
+            for (int row = col + 1; row < size; row++) {
+                if (std::abs(g[static_cast<size_t>(row) * size + col]) > std::abs(g[static_cast<size_t>(pivot) * size + col]))
+                    pivot = row;
+            }
+            for (int j = 0; j < size; j++)
+                std::swap(g[static_cast<size_t>(col) * size + j], g[static_cast<size_t>(pivot) * size + j]);
+            std::swap(v[col], v[pivot]);
+            for (int row = col + 1; row < size; row++) {
+                const double factor = g[static_cast<size_t>(row) * size + col] / g[static_cast<size_t>(col) * size + col];
+                for (int j = col; j < size; j++)
+                    g[static_cast<size_t>(row) * size + j] -= factor * g[static_cast<size_t>(col) * size + j];
+                v[row] -= factor * v[col];
+            }
+        }
+        for (int row = size - 1; row >= 0; row--) {
+            for (int j = row + 1; j < size; j++)
+                v[row] -= g[static_cast<size_t>(row) * size + j] * v[j];
+            v[row] /= g[static_cast<size_t>(row) * size + row];
+        }
+
+        std::vector<double> weights(2 * half + 1);
+        for (int k = -half; k <= half; k++) {
+            const double u = static_cast<double>(k) / half;
+            double weight = 0;
+            for (int j = 0; j < size; j++)
+                weight += v[j] * std::pow(u, j);
+            weights[k + half] = weight;
+        }
+        return weights;
+    }
+
+    /// The odd window & degree Savitzky-Golay can use on num_frame frames, window 1 if it cannot smooth
+    void SavgolShape(const FilterConfig &config, int num_frame, int &window, int &degree) {
+        window = std::min(config.window | 1, num_frame % 2 == 1 ? num_frame : num_frame - 1);
+        degree = std::clamp(config.degree, 0, std::max(window - 1, 0));
+        if (window < 3)
+            window = 1;
+    }
+
+    /// The whole turns (degree) in an angle difference, only rounded past half a turn: angles rarely jump
+    inline double Turns(double difference) {
+        return std::abs(difference) > 180 ? 360 * std::nearbyint(difference / 360) : 0.0;
+    }
+
+    /// alpha of an exponential smoothing with the given cutoff (Hz)
+    inline double OneEuroAlpha(double cutoff, double frame_time) {
+        return 1 / (1 + 1 / (2 * M_PI * cutoff * frame_time));
+    }
+
+    void FilterButterworth(const MotionClip &clip, const FilterConfig &config) {
+        const auto sections = ButterworthSections(std::max(config.order, 1), config.cutoff, clip.frame_time);
+        const int num_frame = clip.num_frame, num_channel = clip.num_channel;
+
+        // Odd extension at both ends (scipy's default padding), the zero-phase pass then has no edge transient
+        const int pad = std::min(3 * (2 * static_cast<int>(sections.size()) + 1), num_frame - 1);
+        const int padded_frames = num_frame + 2 * pad;
+        std::vector<double> padded(static_cast<size_t>(padded_frames) * num_channel);
+        const auto at = [&](int t) {
+            return clip.motion + static_cast<size_t>(t) * num_channel;
+        };
+        std::copy(at(0), at(num_frame), padded.begin() + static_cast<size_t>(pad) * num_channel);
+        for (int k = 1; k <= pad; k++) {
+            double *before = padded.data() + static_cast<size_t>(pad - k) * num_channel;
+            double *after = padded.data() + static_cast<size_t>(pad + num_frame - 1 + k) * num_channel;
+            for (int c = 0; c < num_channel; c++) {
+                before[c] = 2 * at(0)[c] - at(k)[c];
+                after[c] = 2 * at(num_frame - 1)[c] - at(num_frame - 1 - k)[c];
+            }
+        }
+
+        std::vector<double> z1, z2;
+        RunSections(sections, padded.data(), padded_frames, num_channel, false, z1, z2);
+        RunSections(sections, padded.data(), padded_frames, num_channel, true, z1, z2);
+        std::copy(padded.begin() + static_cast<size_t>(pad) * num_channel,
+                  padded.begin() + static_cast<size_t>(pad + num_frame) * num_channel, clip.motion);
+    }
+
+    void FilterSavitzkyGolay(const MotionClip &clip, const FilterConfig &config) {
+        const int num_frame = clip.num_frame, num_channel = clip.num_channel;
+        int window, degree;
+        SavgolShape(config, num_frame, window, degree);
+        if (window == 1)
+            return;
+        const int half = window / 2;
+
+        std::vector<double> output(static_cast<size_t>(num_frame) * num_channel, 0.0);
+        // Frame t is the fit over [begin, begin + window) taken at t: the centered window inside the clip, the
+        // first / last window at the ends
+        std::vector<std::vector<double>> weights(window);
+        for (int t = 0; t < num_frame; t++) {
+            const int begin = std::clamp(t - half, 0, num_frame - window), position = t - begin - half;
+            auto &w = weights[position + half];
+            if (w.empty())
+                w = SavgolWeights(half, degree, position);
+            double *__restrict out = output.data() + static_cast<size_t>(t) * num_channel;
+            for (int k = 0; k < window; k++) {
+                const double weight = w[k];
+                const double *__restrict in = clip.motion + static_cast<size_t>(begin + k) * num_channel;
+                for (int c = 0; c < num_channel; c++)
+                    out[c] += weight * in[c];
+            }
+        }
+        std::copy(output.begin(), output.end(), clip.motion);
+    }
+}
+
+void SignalFilter::Unwrap(const MotionClip &clip) {
+    const int num_rotation = clip.rotation_channels.size();
+    std::vector<double> previous(num_rotation), offset(num_rotation, 0.0);
+    for (int r = 0; r < num_rotation; r++)
+        previous[r] = clip.motion[clip.rotation_channels[r]];
+    for (int t = 1; t < clip.num_frame; t++) {
+        double *frame = clip.motion + static_cast<size_t>(t) * clip.num_channel;
+        for (int r = 0; r < num_rotation; r++) {
+            const double raw = frame[clip.rotation_channels[r]];
+            offset[r] -= Turns(raw - previous[r]);
+            previous[r] = raw;
+            frame[clip.rotation_channels[r]] = raw + offset[r];
+        }
+    }
+}
+
+void SignalFilter::Filter(const MotionClip &clip, const FilterConfig &config) {
+    if (clip.motion == nullptr || clip.num_frame < 2 || clip.num_channel <= 0)
+        return;
+
+    // The raw angles, the filtered ones are wrapped back near them
+    const bool isUnwrapping = config.isUnwrapping && !clip.rotation_channels.empty();
+    std::vector<double> raw;
+    if (isUnwrapping) {
+        raw.resize(static_cast<size_t>(clip.num_frame) * clip.rotation_channels.size());
+        for (int t = 0; t < clip.num_frame; t++)
+            for (size_t r = 0; r < clip.rotation_channels.size(); r++)
+                raw[t * clip.rotation_channels.size() + r] =
+                        clip.motion[static_cast<size_t>(t) * clip.num_channel + clip.rotation_channels[r]];
+        Unwrap(clip);
+    }
+
+    switch (config.kind) {
+        case BUTTERWORTH:
+            FilterButterworth(clip, config);
+            break;
+        case SAVITZKY_GOLAY:
+            FilterSavitzkyGolay(clip, config);
+            break;
+        case ONE_EURO: {
+            // The streaming filter over the clip, already unwrapped
+            FilterConfig stream_config = config;
+            stream_config.isUnwrapping = false;
+            StreamingFilter filter(stream_config, clip.num_channel, clip.frame_time);
+            for (int t = 0; t < clip.num_frame; t++)
+                filter.Push(clip.motion + static_cast<size_t>(t) * clip.num_channel);
+            break;
+        }
+    }
+
+    if (isUnwrapping) {
+        for (int t = 0; t < clip.num_frame; t++)
+            for (size_t r = 0; r < clip.rotation_channels.size(); r++) {
+                double &value = clip.motion[static_cast<size_t>(t) * clip.num_channel + clip.rotation_channels[r]];
+                value += Turns(raw[t * clip.rotation_channels.size() + r] - value);
+            }
+    }
+}
+
+void SignalFilter::FilterAll(const std::vector<MotionClip> &clips, const FilterConfig &config, int num_worker) {
+    if (num_worker <= 0)
+        num_worker = std::max(1u, std::thread::hardware_concurrency());
+    num_worker = std::min<int>(num_worker, std::max<size_t>(clips.size(), 1));
+    std::atomic<size_t> next_clip{0};
+    const auto work = [&]() {
+        for (size_t clip = next_clip++; clip < clips.size(); clip = next_clip++)
+            Filter(clips[clip], config);
+    };
+    std::vector<std::thread> workers;
+    for (int i = 1; i < num_worker; i++)
+        workers.emplace_back(work);
+    work();
+    for (auto &worker: workers)
+        worker.join();
+}
+
+void SignalFilter::Apply(BVH *bvh, const FilterConfig &config) {
+    Filter(Clip(bvh, *bvh->GetModifiedMotions()), config);
+}
+
+std::vector<double> SignalFilter::Filtered(const BVH *bvh, const FilterConfig &config) {
+    std::vector<double> motion = *bvh->GetModifiedMotions();
+    Filter(Clip(bvh, motion), config);
+    return motion;
+}
+
+MotionClip SignalFilter::Clip(const BVH *bvh, std::vector<double> &motion) {
+    MotionClip clip;
+    clip.motion = motion.data();
+    clip.num_channel = bvh->GetNumChannel();
+    clip.num_frame = clip.num_channel > 0 ? static_cast<int>(motion.size() / clip.num_channel) : 0;
+    if (bvh->GetInterval() > 0)
+        clip.frame_time = bvh->GetInterval();
+    for (int c = 0; c < clip.num_channel; c++) {
+        const auto type = bvh->GetChannel(c)->type;
+        if (type == X_ROTATION || type == Y_ROTATION || type == Z_ROTATION)
+            clip.rotation_channels.push_back(c);
+    }
+    return clip;
+}
+
+StreamingFilter::StreamingFilter(const FilterConfig &config, int num_channel, double frame_time,
+                                 const std::vector<int> &rotation_channels)
+        : config(config), num_channel(num_channel), frame_time(frame_time > 0 ? frame_time : 1.0 / 30),
+          isRotation(num_channel, 0) {
+    for (int channel: rotation_channels)
+        isRotation[channel] = 1;
+    Reset();
+}
+
+void StreamingFilter::Reset() {
+    num_frame = 0;
+    previous_raw.assign(num_channel, 0.0);
+    unwrap_offset.assign(num_channel, 0.0);
+    if (config.kind == BUTTERWORTH) {
+        const auto sections = ButterworthSections(std::max(config.order, 1), config.cutoff, frame_time);
+        coefficients.clear();
+        for (const auto &s: sections)
+            coefficients.insert(coefficients.end(), {s.b0, s.b1, s.b2, s.a1, s.a2});
+        z1.assign(sections.size(), std::vector<double>(num_channel, 0.0));
+        z2.assign(sections.size(), std::vector<double>(num_channel, 0.0));
+    } else if (config.kind == SAVITZKY_GOLAY) {
+        int window, degree;
+        SavgolShape(config, config.window | 1, window, degree);
+        history.assign(static_cast<size_t>(window) * num_channel, 0.0);
+        // The fit over the last window frames, at the newest one
+        weights = window > 1 ? SavgolWeights(window / 2, degree, window / 2) : std::vector<double>{1.0};
+    } else {
+        previous_value.assign(num_channel, 0.0);
+        previous_speed.assign(num_channel, 0.0);
+    }
+}
+
+void StreamingFilter::Push(double *frame) {
+    if (config.isUnwrapping) {
+        raw.assign(frame, frame + num_channel);
+        for (int c = 0; c < num_channel; c++) {
+            if (!isRotation[c])
+                continue;
+            if (num_frame > 0)
+                unwrap_offset[c] -= Turns(frame[c] - previous_raw[c]);
+            previous_raw[c] = frame[c];
+            frame[c] += unwrap_offset[c];
+        }
+    }
+
+    switch (config.kind) {
+        case BUTTERWORTH: {
+            for (size_t s = 0; s < z1.size(); s++) {
+                const double *k = coefficients.data() + 5 * s;
+                const double b0 = k[0], b1 = k[1], b2 = k[2], a1 = k[3], a2 = k[4];
+                double *__restrict state1 = z1[s].data(), *__restrict state2 = z2[s].data();
+                // The first frame starts every section in its steady state, like the whole-clip pass
+                if (num_frame == 0) {
+                    for (int c = 0; c < num_channel; c++) {
+                        state2[c] = (b2 - a2) * frame[c];
+                        state1[c] = (b1 - a1) * frame[c] + state2[c];
+                    }
+                }
+                for (int c = 0; c < num_channel; c++) {
+                    const double x = frame[c];
+                    const double y = b0 * x + state1[c];
+                    state1[c] = b1 * x - a1 * y + state2[c];
+                    state2[c] = b2 * x - a2 * y;
+                    frame[c] = y;
+                }
+            }
+            break;
+        }
+        case SAVITZKY_GOLAY: {
+            const int window = static_cast<int>(weights.size());
+            std::copy(frame, frame + num_channel, history.begin() + static_cast<size_t>(num_frame % window) * num_channel);
+            // Until the window is full the frames pass through
+            if (num_frame + 1 < window)
+                break;
+            std::fill(frame, frame + num_channel, 0.0);
+            for (int k = 0; k < window; k++) {
+                // weights[k] is for the k-th oldest frame of the window
+                const double weight = weights[k];
+                const double *__restrict in = history.data() + static_cast<size_t>((num_frame + 1 + k) % window) * num_channel;
+                for (int c = 0; c < num_channel; c++)
+                    frame[c] += weight * in[c];
+            }
+            break;
+        }
+        case ONE_EURO: {
+            if (num_frame == 0) {
+                std::copy(frame, frame + num_channel, previous_value.begin());
+                break;
+            }
+            const double speed_alpha = OneEuroAlpha(config.derivative_cutoff, frame_time);
+            double *__restrict value = previous_value.data(), *__restrict speed = previous_speed.data();
+            for (int c = 0; c < num_channel; c++) {
+                speed[c] += speed_alpha * ((frame[c] - value[c]) / frame_time - speed[c]);
+                const double alpha = OneEuroAlpha(config.min_cutoff + config.beta * std::abs(speed[c]), frame_time);
+                value[c] += alpha * (frame[c] - value[c]);
+                frame[c] = value[c];
+            }
+            break;
+        }
+    }
+
+    if (config.isUnwrapping) {
+        for (int c = 0; c < num_channel; c++) {
+            if (isRotation[c])
+                frame[c] += Turns(raw[c] - frame[c]);
+        }
+    }
+    num_frame++;
+}
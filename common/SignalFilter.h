@@ -0,0 +1,130 @@
+#ifndef TESTBED_SIGNALFILTER_H
+#define TESTBED_SIGNALFILTER_H
+
+#include <vector>
+
+#include "BVH.h"
+
+using namespace bvh;
+
+namespace signalFilter {
+
+    enum FilterKind {
+        /// Zero-phase low-pass: the Butterworth biquads run forward then backward (scipy.signal.sosfiltfilt)
+        BUTTERWORTH,
+        /// Local polynomial fit (scipy.signal.savgol_filter, mode "interp" at the ends)
+        SAVITZKY_GOLAY,
+        /// Adaptive low-pass opening with speed (Casiez et al.), causal
+        ONE_EURO
+    };
+
+    inline const char *FilterName(FilterKind kind) {
+        return kind == BUTTERWORTH ? "butterworth" : (kind == SAVITZKY_GOLAY ? "savitzky-golay" : "one-euro");
+    }
+
+    struct FilterConfig {
+        FilterKind kind = BUTTERWORTH;
+        /// Butterworth order, forward & backward squares the response: -6 dB at the cutoff
+        int order = 4;
+        /// Butterworth cutoff (Hz)
+        double cutoff = 6.0;
+        /// Savitzky-Golay window (frames, odd) & degree of the fitted polynomial
+        int window = 9;
+        int degree = 3;
+        /// One-Euro cutoff at rest (Hz)...
+        double min_cutoff = 1.0;
+        /// ...raised by beta per unit of speed (unit / s)...
+        double beta = 0.05;
+        /// ...the speed itself low-passed at this cutoff (Hz)
+        double derivative_cutoff = 1.0;
+        /// Unwrap the rotation channels first, a 360 degree jump is not smoothed into a spin.
+        /// The result is then wrapped back to within 180 degrees of the raw angles.
+        bool isUnwrapping = true;
+    };
+
+    /// A time-major clip: channel c of frame t is at motion[t * num_channel + c], like BVH's motions
+    struct MotionClip {
+        double *motion = nullptr;
+        int num_frame = 0;
+        int num_channel = 0;
+        /// Seconds between frames
+        double frame_time = 1.0 / 30;
+        /// The channels holding angles (degree)
+        std::vector<int> rotation_channels;
+    };
+
+    /**
+     * Smoothing of the joint-angle tracks, e.g. the jittery MocapNET output of VideoToBvhConverter, without going
+     * through Python.
+     * Every filter runs per channel, the channels are independent: each pass walks the frames once and its inner
+     * loop runs over the channels of a frame (contiguous, the compiler vectorizes it). FilterAll spreads clips over
+     * worker threads.
+     */
+    class SignalFilter {
+    public:
+        /// Remove the 360 degree jumps of the listed channels in place (numpy.unwrap, in degree)
+        static void Unwrap(const MotionClip &clip);
+
+        /// Filter every channel of the clip in place
+        static void Filter(const MotionClip &clip, const FilterConfig &config);
+
+        /// Filter many clips on num_worker threads (0: one per core)
+        static void FilterAll(const std::vector<MotionClip> &clips, const FilterConfig &config, int num_worker = 0);
+
+        /// The modified motion of a BVH, filtered in place
+        static void Apply(BVH *bvh, const FilterConfig &config);
+
+        /// A filtered copy of the modified motion, the BVH is left as is
+        static std::vector<double> Filtered(const BVH *bvh, const FilterConfig &config);
+
+        /// The BVH's clip over motion (its modified motion or a copy of it)
+        static MotionClip Clip(const BVH *bvh, std::vector<double> &motion);
+    };
+
+    /**
+     * The same filters one frame at a time, for live input: causal, so the output of a frame never waits for the
+     * next ones. Butterworth runs its biquads forward only (phase lag instead of zero phase), Savitzky-Golay fits
+     * the last window frames and takes the fit at the newest frame.
+     */
+    class StreamingFilter {
+    private:
+        FilterConfig config;
+        int num_channel;
+        double frame_time;
+        /// 1 for the rotation channels
+        std::vector<char> isRotation;
+
+        int num_frame = 0;
+        /// Unwrapping: the previous raw value & the offset added to the channel
+        std::vector<double> previous_raw, unwrap_offset;
+        /// Butterworth: b0 b1 b2 a1 a2 of each section & its state, [section][channel]
+        std::vector<double> coefficients;
+        std::vector<std::vector<double>> z1, z2;
+        /// Savitzky-Golay: the last window frames (a ring) & the end-point weights
+        std::vector<double> history;
+        std::vector<double> weights;
+        /// One-Euro: the previous filtered value & filtered speed
+        std::vector<double> previous_value, previous_speed;
+        /// The raw frame of the current Push, to wrap the rotations back
+        std::vector<double> raw;
+
+    public:
+        StreamingFilter(const FilterConfig &config, int num_channel, double frame_time,
+                        const std::vector<int> &rotation_channels = {});
+
+        /// Back to the first frame of a stream
+        void Reset();
+
+        /// Filter the next frame (num_channel values) in place
+        void Push(double *frame);
+
+        // -------------------- Getter & Setter -------------------- //
+        int GetNumFrame() const;
+    };
+
+    inline int StreamingFilter::GetNumFrame() const {
+        return num_frame;
+    }
+}
+
+#endif //TESTBED_SIGNALFILTER_H
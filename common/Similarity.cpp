@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Similarity.h"
+
+using namespace similarity;
+
+namespace {
+    /**
+     * Evaluate the (n1 + 1) x (n2 + 1) accumulated matrix of s1 & s2 by anti-diagonals and return its last cell.
+     * Row 0 & column 0 are padding. Cell (I, J) of anti-diagonal K = I + J is stored at index I of that diagonal,
+     * it depends on up (I - 1, J) & left (I, J - 1) of diagonal K - 1 and on diagonal (I - 1, J - 1) of K - 2.
+     * @param outside value of the padding & of the cells outside the band
+     * @param corner value of cell (0, 0)
+     * @param cell (squared distance, up, left, diagonal) -> value, inlined into the vectorized loop
+     */
+    template<typename Cell>
+    float Wavefront(const float *s1, int n1, const float *s2, int n2, int num_channel, int sakoe_chiba_radius,
+                    float outside, float corner, Cell cell) {
+        // Frame i of s1 is at i + 1 of channel c, frame j of s2 at n2 - j of its reversed channel: along a
+        // diagonal both are read contiguously as I grows
+        std::vector<float> s1_channel(static_cast<size_t>(n1 + 1) * num_channel);
+        std::vector<float> s2_reversed(static_cast<size_t>(n2 + 1) * num_channel);
+        for (int c = 0; c < num_channel; c++) {
+            for (int i = 0; i < n1; i++)
+                s1_channel[static_cast<size_t>(c) * (n1 + 1) + i + 1] = s1[static_cast<size_t>(i) * num_channel + c];
+            for (int j = 0; j < n2; j++)
+                s2_reversed[static_cast<size_t>(c) * (n2 + 1) + n2 - j] = s2[static_cast<size_t>(j) * num_channel + c];
+        }
+
+        // tslearn's sakoe_chiba_mask: j - i within [-lower, upper], the band widens by the difference of length
+        // on the side of the longer series
+        int lower = std::max(n1, n2), upper = std::max(n1, n2);
+        if (sakoe_chiba_radius >= 0) {
+            lower = sakoe_chiba_radius + std::max(0, n1 - n2);
+            upper = sakoe_chiba_radius + std::max(0, n2 - n1);
+        }
+
+        // Diagonals K - 2, K - 1 & K, the range written on each is [begin, end), everything else is outside
+        std::vector<float> diagonals[3] = {std::vector<float>(n1 + 1, outside), std::vector<float>(n1 + 1, outside),
+                                           std::vector<float>(n1 + 1, outside)};
+        int begin[3] = {0, 0, 0}, end[3] = {1, 0, 0};
+        diagonals[0][0] = corner;
+        std::vector<float> distance(n1 + 1);
+
+        for (int k = 2; k <= n1 + n2; k++) {
+            auto &current = diagonals[k % 3];
+            const auto &previous = diagonals[(k + 2) % 3];
+            const auto &before = diagonals[(k + 1) % 3];
+            int &current_begin = begin[k % 3], &current_end = end[k % 3];
+
+            // The buffer still holds diagonal K - 3
+            std::fill(current.begin() + current_begin, current.begin() + current_end, outside);
+
+            // 1 <= I <= n1, 1 <= J = K - I <= n2 and, with i = I - 1 & j = J - 1, -lower <= K - 2I <= upper
+            current_begin = std::max({1, k - n2, (k - upper + 1) / 2});
+            current_end = std::min({n1, k - 1, (k + lower) / 2}) + 1;
+            if (current_begin >= current_end) {
+                current_end = current_begin;
+                continue;
+            }
+
+            std::fill(distance.begin() + current_begin, distance.begin() + current_end, 0.0f);
+            for (int c = 0; c < num_channel; c++) {
+                const float *x = s1_channel.data() + static_cast<size_t>(c) * (n1 + 1);
+                const float *y = s2_reversed.data() + static_cast<size_t>(c) * (n2 + 1);
+                // J - 1 = K - I - 1 is at n2 - K + I + 1
+                const int offset = n2 - k + 1;
+                for (int I = current_begin; I < current_end; I++) {
+                    const float diff = x[I] - y[offset + I];
+                    distance[I] += diff * diff;
+                }
+            }
+
+            for (int I = current_begin; I < current_end; I++)
+                current[I] = cell(distance[I], previous[I - 1], previous[I], before[I - 1]);
+        }
+
+        return diagonals[(n1 + n2) % 3][n1];
+    }
+}
+
+void Similarity::Resample(const float *series, int num_frame, int num_channel, float *output,
+                          int output_num_frame) {
+    if (num_frame <= 0) {
+        std::fill(output, output + static_cast<size_t>(output_num_frame) * num_channel, 0.0f);
+        return;
+    }
+
+    for (int k = 0; k < output_num_frame; k++) {
+        // Frame k sits at k / (output_num_frame - 1) of [0, 1], find it between two input frames
+        const double x = output_num_frame > 1 ? static_cast<double>(k) / (output_num_frame - 1) : 0.0;
+        const double position = x * (num_frame - 1);
+        const int i0 = std::min(static_cast<int>(position), num_frame - 1);
+        const int i1 = std::min(i0 + 1, num_frame - 1);
+        const double t = position - i0;
+        const float *f0 = series + static_cast<size_t>(i0) * num_channel;
+        const float *f1 = series + static_cast<size_t>(i1) * num_channel;
+        float *out = output + static_cast<size_t>(k) * num_channel;
+        for (int c = 0; c < num_channel; c++)
+            out[c] = static_cast<float>(f0[c] + (f1[c] - f0[c]) * t);
+    }
+}
+
+std::vector<float> Similarity::Resample(const std::vector<float> &series, int num_channel, int output_num_frame) {
+    std::vector<float> output(static_cast<size_t>(output_num_frame) * num_channel);
+    Resample(series.data(), series.size() / num_channel, num_channel, output.data(), output_num_frame);
+    return output;
+}
+
+void Similarity::ZNormalize(float *series, int num_frame, int num_channel) {
+    if (num_frame <= 0)
+        return;
+
+    for (int c = 0; c < num_channel; c++) {
+        double sum = 0, square_sum = 0;
+        for (int t = 0; t < num_frame; t++)
+            sum += series[static_cast<size_t>(t) * num_channel + c];
+        const double mean = sum / num_frame;
+        for (int t = 0; t < num_frame; t++) {
+            const double diff = series[static_cast<size_t>(t) * num_channel + c] - mean;
+            square_sum += diff * diff;
+        }
+        double std = std::sqrt(square_sum / num_frame);
+        // Same as tslearn: a constant channel is only centered
+        if (std == 0)
+            std = 1;
+        for (int t = 0; t < num_frame; t++) {
+            float &value = series[static_cast<size_t>(t) * num_channel + c];
+            value = static_cast<float>((value - mean) / std);
+        }
+    }
+}
+
+float Similarity::Dtw(const float *s1, int n1, const float *s2, int n2, int num_channel, int sakoe_chiba_radius) {
+    const float inf = std::numeric_limits<float>::infinity();
+    if (n1 <= 0 || n2 <= 0)
+        return inf;
+
+    // Accumulated squared distances, sqrt at the end like tslearn
+    return std::sqrt(Wavefront(s1, n1, s2, n2, num_channel, sakoe_chiba_radius, inf, 0.0f,
+                               [](float distance, float up, float left, float diagonal) {
+                                   return distance + std::min(std::min(up, left), diagonal);
+                               }));
+}
+
+float Similarity::DtwPath(const float *s1, int n1, const float *s2, int n2, int num_channel, int radius,
+                          std::vector<std::pair<int, int>> &path) {
+    path.clear();
+    if (n1 <= 0 || n2 <= 0)
+        return std::numeric_limits<float>::infinity();
+
+    // Row i's band is [center - radius, center + radius] around the diagonal, wide enough that consecutive bands
+    // touch and that row 0 & row n1 - 1 reach the corners
+    const double slope = n1 > 1 ? static_cast<double>(n2 - 1) / (n1 - 1) : 0.0;
+    radius = std::max(radius, static_cast<int>(std::ceil(slope)));
+    if (n1 == 1)
+        radius = std::max(radius, n2 - 1);
+    std::vector<std::pair<int, int>> window(n1);
+    for (int i = 0; i < n1; i++) {
+        const int center = static_cast<int>(std::lround(i * slope));
+        window[i] = {std::max(center - radius, 0), std::min(center + radius + 1, n2)};
+    }
+    return DtwPathWindow(s1, n1, s2, n2, num_channel, window, path);
+}
+
+float Similarity::DtwPathWindow(const float *s1, int n1, const float *s2, int n2, int num_channel,
+                                const std::vector<std::pair<int, int>> &window,
+                                std::vector<std::pair<int, int>> &path) {
+    const float inf = std::numeric_limits<float>::infinity();
+    path.clear();
+    if (n1 <= 0 || n2 <= 0 || static_cast<int>(window.size()) != n1)
+        return inf;
+
+    // One byte per cell of the window for the backtracking, row i's cells start at offsets[i]
+    std::vector<size_t> offsets(n1 + 1, 0);
+    int max_width = 0;
+    for (int i = 0; i < n1; i++) {
+        const int width = std::max(window[i].second - window[i].first, 0);
+        offsets[i + 1] = offsets[i] + width;
+        max_width = std::max(max_width, width);
+    }
+
+    enum Step : unsigned char {
+        DIAGONAL, UP, LEFT
+    };
+    std::vector<unsigned char> steps(offsets[n1]);
+    std::vector<float> previous(max_width, inf), current(max_width, inf);
+    int previous_begin = 0, previous_end = 0;
+    for (int i = 0; i < n1; i++) {
+        const int begin = window[i].first, end = window[i].second;
+        const float *frame1 = s1 + static_cast<size_t>(i) * num_channel;
+        unsigned char *row_steps = steps.data() + offsets[i];
+        for (int j = begin; j < end; j++) {
+            const float *frame2 = s2 + static_cast<size_t>(j) * num_channel;
+            float distance = 0;
+            for (int c = 0; c < num_channel; c++) {
+                const float difference = frame1[c] - frame2[c];
+                distance += difference * difference;
+            }
+
+            float best = i == 0 && j == 0 ? 0.0f : inf;
+            Step step = DIAGONAL;
+            if (j - 1 >= previous_begin && j - 1 < previous_end && previous[j - 1 - previous_begin] < best)
+                best = previous[j - 1 - previous_begin];
+            if (j >= previous_begin && j < previous_end && previous[j - previous_begin] < best) {
+                best = previous[j - previous_begin];
+                step = UP;
+            }
+            if (j > begin && current[j - 1 - begin] < best) {
+                best = current[j - 1 - begin];
+                step = LEFT;
+            }
+            current[j - begin] = distance + best;
+            row_steps[j - begin] = step;
+        }
+        std::swap(previous, current);
+        previous_begin = begin;
+        previous_end = end;
+    }
+
+    // Back from the last cell, the window must hold it & a path to it
+    if (n2 - 1 < previous_begin || n2 - 1 >= previous_end || previous[n2 - 1 - previous_begin] == inf)
+        return inf;
+    const float accumulated = previous[n2 - 1 - previous_begin];
+    int i = n1 - 1, j = n2 - 1;
+    path.emplace_back(i, j);
+    while (i > 0 || j > 0) {
+        const Step step = static_cast<Step>(steps[offsets[i] + j - window[i].first]);
+        if (step != LEFT)
+            i--;
+        if (step != UP)
+            j--;
+        path.emplace_back(i, j);
+    }
+    std::reverse(path.begin(), path.end());
+    return std::sqrt(accumulated);
+}
+
+float Similarity::FastDtwPath(const MotionPyramid &p1, const MotionPyramid &p2, int radius, int refine_radius,
+                              std::vector<std::pair<int, int>> &path) {
+    path.clear();
+    if (p1.IsEmpty() || p2.IsEmpty() || p1.GetNumChannel() != p2.GetNumChannel())
+        return std::numeric_limits<float>::infinity();
+    const int num_channel = p1.GetNumChannel();
+
+    // The coarsest level both have: the banded DTW, its radius scaled down with the frames
+    int level = std::min(p1.GetNumLevel(), p2.GetNumLevel()) - 1;
+    const int coarse_radius = std::max(radius / p1.GetFactor(level), refine_radius);
+    float distance = DtwPath(p1.GetLevel(level), p1.GetNumFrame(level), p2.GetLevel(level), p2.GetNumFrame(level),
+                             num_channel, coarse_radius, path);
+
+    std::vector<std::pair<int, int>> projected, window;
+    for (level--; level >= 0; level--) {
+        const int n1 = p1.GetNumFrame(level), n2 = p2.GetNumFrame(level);
+        // Cell (i, j) of the coarser path covers rows 2i, 2i + 1 & columns 2j, 2j + 1 of this level
+        projected.assign(n1, {n2, 0});
+        for (const auto &[i, j]: path) {
+            for (int row = 2 * i; row <= std::min(2 * i + 1, n1 - 1); row++) {
+                projected[row].first = std::min(projected[row].first, 2 * j);
+                projected[row].second = std::max(projected[row].second, std::min(2 * j + 2, n2));
+            }
+        }
+        // Widened by refine_radius in both directions: the columns of the rows within refine_radius, +-refine_radius
+        window.resize(n1);
+        for (int i = 0; i < n1; i++) {
+            int begin = n2, end = 0;
+            for (int row = std::max(i - refine_radius, 0); row <= std::min(i + refine_radius, n1 - 1); row++) {
+                begin = std::min(begin, projected[row].first);
+                end = std::max(end, projected[row].second);
+            }
+            window[i] = {std::max(begin - refine_radius, 0), std::min(end + refine_radius, n2)};
+        }
+        distance = DtwPathWindow(p1.GetLevel(level), n1, p2.GetLevel(level), n2, num_channel, window, path);
+    }
+    return distance;
+}
+
+float Similarity::Lcss(const float *s1, int n1, const float *s2, int n2, int num_channel, float eps,
+                       int sakoe_chiba_radius) {
+    if (n1 <= 0 || n2 <= 0)
+        return 0;
+
+    // Compare the squared distances, a negative eps matches nothing
+    const float squared_eps = eps < 0 ? -1.0f : eps * eps;
+    // Lengths are counted in float (exact up to 2^24 frames) so the select stays in one vector type
+    const float length = Wavefront(s1, n1, s2, n2, num_channel, sakoe_chiba_radius, 0.0f, 0.0f,
+                                   [squared_eps](float distance, float up, float left, float diagonal) {
+                                       return distance <= squared_eps ? diagonal + 1 : std::max(up, left);
+                                   });
+    return length / std::min(n1, n2);
+}
+
+float Similarity::ResampledLcss(const float *s1, int n1, const float *s2, int n2, float eps) {
+    const int num_frame = std::max(n1, n2);
+    std::vector<float> r1(num_frame), r2(num_frame);
+    Resample(s1, n1, 1, r1.data(), num_frame);
+    Resample(s2, n2, 1, r2.data(), num_frame);
+    ZNormalize(r1.data(), num_frame, 1);
+    ZNormalize(r2.data(), num_frame, 1);
+    return Lcss(r1.data(), num_frame, r2.data(), num_frame, 1, eps);
+}
@@ -0,0 +1,104 @@
+#ifndef TESTBED_SIMILARITY_H
+#define TESTBED_SIMILARITY_H
+
+#include <utility>
+#include <vector>
+
+#include "MotionPyramid.h"
+
+namespace similarity {
+
+    using motionPyramid::MotionPyramid;
+
+    /**
+     * Elastic similarity of multichannel time series, the same definitions as tslearn
+     * (TimeSeriesResampler, TimeSeriesScalerMeanVariance, dtw and lcss_path).
+     * A series of num_frame frames and num_channel channels is time-major, like a tslearn (sz, d) array:
+     * channel c of frame t is at t * num_channel + c.
+     *
+     * Dtw & Lcss evaluate the accumulated matrix by anti-diagonals (wavefront): a cell only depends on the two
+     * previous anti-diagonals, so the cells of one anti-diagonal are independent and the inner loops are branch-free
+     * loops over contiguous arrays that the compiler vectorizes. Only three anti-diagonals are kept (O(n) memory).
+     */
+    class Similarity {
+    public:
+        /// No global constraint, every cell of the accumulated matrix is evaluated
+        inline static constexpr int no_constraint = -1;
+
+        /**
+         * Linear resampling to output_num_frame frames, like TimeSeriesResampler(sz=output_num_frame).
+         * Both series span [0, 1] whatever their number of frames.
+         */
+        static void Resample(const float *series, int num_frame, int num_channel, float *output,
+                             int output_num_frame);
+
+        static std::vector<float> Resample(const std::vector<float> &series, int num_channel, int output_num_frame);
+
+        /**
+         * Scale every channel in place to mean 0 and (population) standard deviation 1,
+         * like TimeSeriesScalerMeanVariance(mu=0, std=1). A constant channel only gets centered.
+         */
+        static void ZNormalize(float *series, int num_frame, int num_channel);
+
+        /**
+         * Dynamic time warping distance: the square root of the accumulated squared euclidean distances
+         * along the best path, like tslearn.metrics.dtw.
+         * @param sakoe_chiba_radius band radius of the Sakoe-Chiba constraint (same band as tslearn for series of
+         * different lengths), no_constraint for none
+         * @return infinity if the band does not reach the last cell
+         */
+        static float Dtw(const float *s1, int n1, const float *s2, int n2, int num_channel,
+                         int sakoe_chiba_radius = no_constraint);
+
+        /**
+         * Dynamic time warping with its warping path, to align two clips of different lengths.
+         * The band follows the diagonal of the n1 x n2 matrix: frame i of s1 is only matched to the frames of s2
+         * within radius of i * (n2 - 1) / (n1 - 1). Only two rows of the accumulated matrix are kept, plus one
+         * byte per cell of the band for the backtracking: time & memory are O(n1 * radius).
+         * @param radius widened when s2 is longer than the band can follow (at least the slope), and to the whole
+         * of s2 when s1 has a single frame
+         * @param path the matched frames (i, j), from (0, 0) to (n1 - 1, n2 - 1), both non-decreasing
+         * @return the distance along the path, like Dtw: sqrt of the accumulated squared euclidean distances
+         */
+        static float DtwPath(const float *s1, int n1, const float *s2, int n2, int num_channel, int radius,
+                             std::vector<std::pair<int, int>> &path);
+
+        /**
+         * Same within any window: row i of the accumulated matrix only has the columns [window[i].first,
+         * window[i].second). Time & memory are linear in the number of cells of the window.
+         * @param window n1 ranges, both ends non-decreasing and consecutive rows touching
+         * @return infinity (and an empty path) if no path through the window reaches the last cell
+         */
+        static float DtwPathWindow(const float *s1, int n1, const float *s2, int n2, int num_channel,
+                                   const std::vector<std::pair<int, int>> &window,
+                                   std::vector<std::pair<int, int>> &path);
+
+        /**
+         * Coarse-to-fine DtwPath (FastDTW): the banded DtwPath at the coarsest level both pyramids have, then at
+         * every finer level the path is projected (a cell covers 2 x 2 cells) and refined by DtwPathWindow in a
+         * window refine_radius around it. Time & memory are linear in the frames, an approximation of DtwPath with
+         * the same radius that holds while the warp varies slower than the coarsest level.
+         * @param radius the global band, in frames of the series (level 0)
+         * @param path of the series (level 0), like DtwPath's
+         */
+        static float FastDtwPath(const MotionPyramid &p1, const MotionPyramid &p2, int radius, int refine_radius,
+                                 std::vector<std::pair<int, int>> &path);
+
+        /**
+         * Longest common subsequence similarity in [0, 1], like the similarity of tslearn.metrics.lcss_path:
+         * two frames match when their euclidean distance is at most eps, the length of the longest matching
+         * subsequence is divided by min(n1, n2).
+         * @param sakoe_chiba_radius band radius of the Sakoe-Chiba constraint, no_constraint for none
+         */
+        static float Lcss(const float *s1, int n1, const float *s2, int n2, int num_channel, float eps = 1.0f,
+                          int sakoe_chiba_radius = no_constraint);
+
+        /**
+         * The comparison Analysize.BvhAnalyze does on one column: both series resampled to the longest one,
+         * z-normalized, then Lcss.
+         */
+        static float ResampledLcss(const float *s1, int n1, const float *s2, int n2, float eps = 0.5f);
+    };
+}
+
+#endif //TESTBED_SIMILARITY_H
@@ -0,0 +1,88 @@
+#include <pybind11/embed.h>
+#include <pybind11/numpy.h>
+
+#include "Similarity.h"
+
+namespace py = pybind11;
+using namespace similarity;
+
+namespace {
+    using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+    /// A 1d array is a single channel series, a 2d array is (sz, d) like tslearn
+    void GetShape(const FloatArray &series, int &num_frame, int &num_channel) {
+        if (series.ndim() == 1) {
+            num_frame = series.shape(0);
+            num_channel = 1;
+        } else if (series.ndim() == 2) {
+            num_frame = series.shape(0);
+            num_channel = series.shape(1);
+        } else {
+            throw py::value_error("expect a (sz,) or (sz, d) array");
+        }
+    }
+
+    int GetRadius(const py::object &sakoe_chiba_radius) {
+        return sakoe_chiba_radius.is_none() ? Similarity::no_constraint : sakoe_chiba_radius.cast<int>();
+    }
+
+    FloatArray SameShape(const FloatArray &series, int num_frame, int num_channel) {
+        if (series.ndim() == 1)
+            return FloatArray(num_frame);
+        return FloatArray({num_frame, num_channel});
+    }
+}
+
+/**
+ * The native similarity engine for the Python analysis (Py_package.PyAnalysizer.Analysize).
+ * It only exists inside the testbed's interpreter, the Python code falls back to tslearn elsewhere.
+ * The GIL is released while computing.
+ */
+PYBIND11_EMBEDDED_MODULE(native_similarity, m) {
+    m.doc() = "Native resampling, z-normalization, DTW & LCSS with the tslearn definitions";
+
+    m.def("resample", [](const FloatArray &series, int sz) {
+        int num_frame, num_channel;
+        GetShape(series, num_frame, num_channel);
+        auto result = SameShape(series, sz, num_channel);
+        {
+            py::gil_scoped_release release;
+            Similarity::Resample(series.data(), num_frame, num_channel, result.mutable_data(), sz);
+        }
+        return result;
+    }, py::arg("series"), py::arg("sz"));
+
+    m.def("znormalize", [](const FloatArray &series) {
+        int num_frame, num_channel;
+        GetShape(series, num_frame, num_channel);
+        auto result = SameShape(series, num_frame, num_channel);
+        std::copy(series.data(), series.data() + series.size(), result.mutable_data());
+        {
+            py::gil_scoped_release release;
+            Similarity::ZNormalize(result.mutable_data(), num_frame, num_channel);
+        }
+        return result;
+    }, py::arg("series"));
+
+    m.def("dtw", [](const FloatArray &s1, const FloatArray &s2, const py::object &sakoe_chiba_radius) {
+        int n1, n2, d1, d2;
+        GetShape(s1, n1, d1);
+        GetShape(s2, n2, d2);
+        if (d1 != d2)
+            throw py::value_error("the series have a different number of channels");
+        const int radius = GetRadius(sakoe_chiba_radius);
+        py::gil_scoped_release release;
+        return Similarity::Dtw(s1.data(), n1, s2.data(), n2, d1, radius);
+    }, py::arg("s1"), py::arg("s2"), py::arg("sakoe_chiba_radius") = py::none());
+
+    m.def("lcss", [](const FloatArray &s1, const FloatArray &s2, float eps, const py::object &sakoe_chiba_radius) {
+        int n1, n2, d1, d2;
+        GetShape(s1, n1, d1);
+        GetShape(s2, n2, d2);
+        if (d1 != d2)
+            throw py::value_error("the series have a different number of channels");
+        const int radius = GetRadius(sakoe_chiba_radius);
+        py::gil_scoped_release release;
+        return Similarity::Lcss(s1.data(), n1, s2.data(), n2, d1, eps, radius);
+    }, py::arg("s1"), py::arg("s2"), py::arg("eps") = 1.0f, py::arg("sakoe_chiba_radius") = py::none());
+}
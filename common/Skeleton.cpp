@@ -13,6 +13,7 @@ Skeleton::CreateBone(const string &bone_name, Bone *parent, rp3d::Vector3 &pos,
 
     auto new_bone = new Bone(bone_name, boneObject, BoneType::CONE, pos, parent, orientation,
                              local_coordinate_quatern, mPhysicsObjects, bvh, joint);
+    new_bone->SetLength(size.y);
     if (parent != nullptr) {
         parent->AppendChild(new_bone);
     }
@@ -27,6 +28,7 @@ Skeleton::CreateBone(const string &bone_name, Bone *parent, rp3d::Vector3 &pos,
 
     auto new_bone = new Bone(bone_name, boneObject, BoneType::SPHERE, pos, parent, orientation,
                              local_coordinate_quatern, mPhysicsObjects, bvh, joint);
+    new_bone->SetLength(radius);
 
     if (parent != nullptr) {
         parent->AppendChild(new_bone);
@@ -103,6 +105,7 @@ Skeleton::Skeleton(rp3d::PhysicsCommon &mPhysicsCommon, rp3d::PhysicsWorld *mPhy
             }
         }
     }// Physic
+    BuildPreorder();
 
     InitBvhMotion();
     bvh->SetPositionScale(SCALE);
@@ -121,20 +124,93 @@ Skeleton::~Skeleton() {
     }
 }
 
+void Skeleton::BuildPreorder() {
+    preorder_bones.clear();
+    preorder_index.clear();
+    preorder_parent.clear();
+    subtree_end.clear();
+    parent_distance.clear();
+
+    // Iterative depth first walk from the roots, children in name order as Bone keeps them
+    std::vector<std::pair<Bone *, bool>> stack;
+    for (auto &[name, bone]: bones) {
+        if (bone->GetParent() == nullptr)
+            stack.emplace_back(bone, false);
+    }
+    while (!stack.empty()) {
+        auto [bone, is_exiting] = stack.back();
+        stack.pop_back();
+        if (is_exiting) {
+            subtree_end[preorder_index[bone]] = preorder_bones.size();
+            continue;
+        }
+
+        const int index = preorder_bones.size();
+        preorder_index[bone] = index;
+        preorder_bones.push_back(bone);
+        subtree_end.push_back(index + 1);
+
+        auto parent = bone->GetParent();
+        preorder_parent.push_back(parent != nullptr ? preorder_index[parent] : -1);
+        // The bone starts at the end of its parent, a sphere is centered one radius further
+        float distance = 0;
+        if (parent != nullptr)
+            distance = parent->GetLength() + (bone->GetBoneType() == SPHERE ? bone->GetLength() : 0);
+        parent_distance.push_back(distance);
+
+        stack.emplace_back(bone, true);
+        const auto &children = bone->GetChildren();
+        for (auto child = children.rbegin(); child != children.rend(); ++child)
+            stack.emplace_back(child->second, false);
+    }
+
+    propagated_positions.resize(preorder_bones.size());
+    propagated_orientations.resize(preorder_bones.size());
+}
+
+void Skeleton::PropagateSubtree(int root, const rp3d::Quaternion &orientation) {
+    const int end = subtree_end[root];
+    const auto &default_orientation = Bone::GetDefaultOrientation();
+
+    // Only the positions follow the parents, the orientations of the descendants are kept
+    propagated_positions[root] = preorder_bones[root]->GetPosition();
+    propagated_orientations[root] = orientation;
+    for (int i = root + 1; i < end; i++) {
+        const int parent = preorder_parent[i];
+        propagated_orientations[i] = preorder_bones[i]->GetPhysicsObject()->getTransform().getOrientation();
+        propagated_positions[i] = propagated_positions[parent] +
+                                  propagated_orientations[parent] * default_orientation * parent_distance[i];
+        preorder_bones[i]->SetPosition(propagated_positions[i]);
+    }
+}
+
+void Skeleton::CommitTransforms(int begin, int end) {
+    // ReactPhysics3D sets one body at a time, the batch is that nothing reads a transform in between
+    for (int i = begin; i < end; i++)
+        preorder_bones[i]->GetPhysicsObject()->setTransform({propagated_positions[i], propagated_orientations[i]});
+}
+
+void Skeleton::UpdateChild(Bone *bone) {
+    const int root = preorder_index.at(bone);
+    PropagateSubtree(root, bone->GetPhysicsObject()->getTransform().getOrientation());
+    CommitTransforms(root + 1, subtree_end[root]);
+}
+
 void Skeleton::SetJointRotation(Bone *bone, rp3d::Vector3 &angle) {
     SetJointRotation(bone, angle.x, angle.y, angle.z);
 }
 
 /// rotate worldly
 void Skeleton::SetJointRotation(Bone *bone, rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ) {
-    auto old_eulerAngle = AngleTool::QuaternionToEulerAngles(bone->GetOriginQuaternion());
-    auto new_quatern = rp3d::Quaternion::fromEulerAngles(angleX + old_eulerAngle.x, angleY + old_eulerAngle.y,
-                                                         angleZ + old_eulerAngle.z);
-    bone->GetPhysicsObject()->setTransform({bone->GetPosition(), new_quatern});
+    auto new_quatern = rp3d::Quaternion::fromEulerAngles(angleX, angleY, angleZ) * bone->GetOriginQuaternion();
+
+    // The bone & its subtree in one batch
+    const int root = preorder_index.at(bone);
+    PropagateSubtree(root, new_quatern);
+    CommitTransforms(root, subtree_end[root]);
 
     // Event occur!!!
     bone_transform_changed.fire(bone);
-    bone->UpdateChild(rp3d::Quaternion::fromEulerAngles(angleX, angleY, angleZ));
 }
 
 
@@ -143,11 +219,12 @@ void Skeleton::SetJointRotation_local(Bone *bone, rp3d::Vector3 &angle) {
 }
 
 void Skeleton::SetJointRotation_local(Bone *bone, rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ) {
-    bone->SetJointRotation_local(angleX, angleY, angleZ);
+    const int root = preorder_index.at(bone);
+    PropagateSubtree(root, bone->GetJointRotation_local(angleX, angleY, angleZ));
+    CommitTransforms(root, subtree_end[root]);
 
     // Event occur!!!
     bone_transform_changed.fire(bone);
-    bone->UpdateChild(rp3d::Quaternion::fromEulerAngles(angleX, angleY, angleZ));
 }
 
 Bone *Skeleton::FindBone(rp3d::RigidBody *body) {
@@ -177,6 +254,14 @@ void Skeleton::NextBvhMotion() {
     ApplyBvhMotion(bvh_frame);
 }
 
+void Skeleton::SetBvhMotion(int frame) {
+    const int num_frame = bvh->GetNumModifiedFrame();
+    if (num_frame == 0)
+        return;
+    bvh_frame = (frame % num_frame + num_frame) % num_frame;
+    ApplyBvhMotion(bvh_frame);
+}
+
 void Skeleton::InitBvhMotion() {
     bvh_frame = 0;
     ApplyBvhMotion(bvh_frame);
@@ -260,13 +345,17 @@ void Skeleton::ApplyBvhMotion(const int frame) {
 
             glm::vec4 result_pos = translations[id] * glm::vec4(0.0, 0.0, 0.0, 1.0);
             glm::quat result_angle = glm::quat_cast(rotations[id]);
-            bones[joint_name]->GetPhysicsObject()->setTransform(
-                    {{result_pos.x, result_pos.y, result_pos.z},
-                     rp3d::Quaternion(result_angle.x, result_angle.y, result_angle.z, result_angle.w)});
-
-            bone_transform_changed.fire(bones[joint_name]);
+            const int index = preorder_index.at(bones[joint_name]);
+            propagated_positions[index] = {result_pos.x, result_pos.y, result_pos.z};
+            propagated_orientations[index] = rp3d::Quaternion(result_angle.x, result_angle.y, result_angle.z,
+                                                              result_angle.w);
         }
     }
+
+    // Every bone is a target bone, the whole skeleton goes in one batch
+    CommitTransforms(0, static_cast<int>(preorder_bones.size()));
+    for (auto bone: preorder_bones)
+        bone_transform_changed.fire(bone);
 }
 
 void Skeleton::ShowAnalyzeResult(const string &BoneName) {
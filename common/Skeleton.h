@@ -16,8 +16,7 @@
 #include "openglframework.h"
 #include "BVH.h"
 #include "Event.h"
-
-#define SCALE 0.1f
+#include "BoneNames.h"
 
 using namespace bvh;
 using namespace bone;
@@ -48,10 +47,7 @@ namespace skeleton {
         const float frictionCoeff = 0.4f;
 
         /// BVH
-        const std::vector<string> target_bone_names{"hip", "abdomen", "chest", "neck", "neck1", "head", "rCollar",
-                                                    "rShldr", "rForeArm", "rHand", "lCollar", "lShldr", "lForeArm",
-                                                    "lHand", "rButtock", "rThigh", "rShin", "rFoot", "lButtock",
-                                                    "lThigh", "lShin", "lFoot"};
+        const std::vector<string> target_bone_names = TARGET_BONE_NAMES;
     protected:
 
         openglframework::Color objectColor = openglframework::Color(0.0f, 0.68f, 0.99f, 1.0f);
@@ -59,10 +55,30 @@ namespace skeleton {
 
         std::map<const string, Bone *> bones;
 
+        /// The bones in preorder (a parent before its children), built once the bones exist
+        std::vector<Bone *> preorder_bones;
+        std::map<const Bone *, int> preorder_index;
+        std::vector<int> preorder_parent;
+        /// The subtree of preorder_bones[i] is [i, subtree_end[i])
+        std::vector<int> subtree_end;
+        /// Cached distance from the parent's position to the bone's position
+        std::vector<float> parent_distance;
+        /// The transforms CommitTransforms sets, in preorder, filled by UpdateChild & ApplyBvhMotion
+        std::vector<rp3d::Vector3> propagated_positions;
+        std::vector<rp3d::Quaternion> propagated_orientations;
+
         BVH *bvh;
         int bvh_frame;
 
         // -------------------- Methods -------------------- //
+        void BuildPreorder();
+
+        /// The positions of the subtree of preorder_bones[root] once the root has this orientation
+        void PropagateSubtree(int root, const rp3d::Quaternion &orientation);
+
+        /// Set the physics transforms of preorder_bones [begin, end) from the propagated arrays, in one pass
+        void CommitTransforms(int begin, int end);
+
         void ConfigNewObject(PhysicsObject *new_object, const rp3d::Vector3 &pos, const rp3d::Quaternion &orientation);
 
 
@@ -102,7 +118,7 @@ namespace skeleton {
         ~Skeleton();
 
         /** SetJointRotation
-         * @details rotate worldly & use Euler angle
+         * @details rotate worldly & use Euler angle, the rotation is composed onto the origin quaternion
          * @param bone
          * @param angle
          */
@@ -119,6 +135,12 @@ namespace skeleton {
 
         void SetJointRotation_local(Bone *bone, rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ);
 
+        /**
+         * Move the descendants of the bone so they stay attached to it after it rotated.
+         * @details iterates over the preorder array, the physics transforms are set in one batch at the end
+         */
+        void UpdateChild(Bone *bone);
+
         void RotateJoint(Bone *bone, rp3d::Vector3 &angle);
 
         void RotateJoint(Bone *bone, rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ);
@@ -133,6 +155,9 @@ namespace skeleton {
         // -------------------- Motion -------------------- //
         void NextBvhMotion();
 
+        /// Jump to a frame of the modified motion, wrapped like NextBvhMotion
+        void SetBvhMotion(int frame);
+
         void ApplyBvhMotion(const int frame);
 
         void InitBvhMotion();
@@ -141,8 +166,21 @@ namespace skeleton {
         BVH *GetBvh() ;
 
         const std::vector<std::string> &GetTargetBoneNames() const;
+
+        const rp3d::Vector3 &GetSkeletonPosition() const;
+
+        /// The frame of the modified motion shown
+        int GetBvhFrame() const;
     };
 
+    inline int Skeleton::GetBvhFrame() const {
+        return bvh_frame;
+    }
+
+    inline const rp3d::Vector3 &Skeleton::GetSkeletonPosition() const {
+        return mSkeletonPosition;
+    }
+
     inline const std::vector<std::string> &Skeleton::GetTargetBoneNames() const {
         return target_bone_names;
     }
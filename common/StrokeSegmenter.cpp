@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cmath>
+
+#include "StrokeSegmenter.h"
+#include "AngleKernel.h"
+
+using namespace strokeSegmenter;
+using angleTool::AngleKernel;
+
+namespace {
+    /**
+     * Angle (degree) of the rotation from a to b: the relative rotation conj(a) * b is (v, w) and its angle is
+     * 2 atan2(|v|, |w|), accurate for the small angles between frames unlike acos(|a . b|)
+     */
+    inline float RotationAngle(float ax, float ay, float az, float aw, float bx, float by, float bz, float bw) {
+        const float w = aw * bw + ax * bx + ay * by + az * bz;
+        const float vx = aw * bx - bw * ax - (ay * bz - az * by);
+        const float vy = aw * by - bw * ay - (az * bx - ax * bz);
+        const float vz = aw * bz - bw * az - (ax * by - ay * bx);
+        return 2 * AngleKernel::Atan2(std::sqrt(vx * vx + vy * vy + vz * vz), std::fabs(w)) *
+               AngleKernel::rad_to_deg;
+    }
+}
+
+StreamingStrokeDetector::StreamingStrokeDetector(const SegmenterConfig &config, float frame_time)
+        : config(config), frame_time(frame_time) {}
+
+void StreamingStrokeDetector::Push(float speed) {
+    const int frame = num_frame++;
+
+    window.push_back(speed);
+    window_sum += speed;
+    if (static_cast<int>(window.size()) > std::max(config.smoothing, 1)) {
+        window_sum -= window.front();
+        window.pop_front();
+    }
+    const float smoothed = static_cast<float>(window_sum / window.size());
+
+    if (!isInStroke) {
+        if (smoothed < config.onset_speed)
+            return;
+        isInStroke = true;
+        onset_frame = frame;
+        num_below = 0;
+        peak_speed = smoothed;
+        // The previous stroke's trailing padding gives way to this one
+        if (onset_frame < last_end && !closed_segments.empty()) {
+            auto &previous = closed_segments.back().frames;
+            previous.end = std::max(onset_frame, previous.begin);
+        }
+        last_end = std::min(last_end, onset_frame);
+        return;
+    }
+
+    peak_speed = std::max(peak_speed, smoothed);
+    num_below = smoothed < config.offset_speed ? num_below + 1 : 0;
+    if (num_below >= config.offset_hold)
+        Close(frame - config.offset_hold + 1);
+    else if (frame + 1 - onset_frame >= config.max_stroke_frames)
+        Close(frame + 1);
+}
+
+void StreamingStrokeDetector::PushPose(const std::vector<rp3d::Quaternion> &orientations) {
+    float speed = 0;
+    if (previous_orientations.size() == orientations.size()) {
+        for (size_t j = 0; j < orientations.size(); j++) {
+            const auto &a = previous_orientations[j], &b = orientations[j];
+            speed = std::max(speed, RotationAngle(a.x, a.y, a.z, a.w, b.x, b.y, b.z, b.w) / frame_time);
+        }
+    }
+    previous_orientations = orientations;
+    Push(speed);
+}
+
+void StreamingStrokeDetector::Close(int offset_frame) {
+    isInStroke = false;
+    if (offset_frame - onset_frame < config.min_stroke_frames)
+        return;
+
+    // Still moving when forced to close: no trailing padding, the motion goes on in the next segment
+    const bool isSettled = num_below >= config.offset_hold;
+    StrokeSegment segment;
+    segment.frames.begin = std::max(onset_frame - config.padding, last_end);
+    segment.frames.end = offset_frame + (isSettled ? config.padding : 0);
+    segment.peak_speed = peak_speed;
+    last_end = segment.frames.end;
+    closed_segments.push_back(segment);
+}
+
+void StreamingStrokeDetector::Finish() {
+    if (isInStroke) {
+        num_below = 0;
+        Close(num_frame);
+    }
+    for (auto &segment: closed_segments)
+        segment.frames.end = std::min(segment.frames.end, num_frame);
+}
+
+bool StreamingStrokeDetector::Pop(StrokeSegment &segment) {
+    if (closed_segments.empty() || closed_segments.front().frames.end > num_frame)
+        return false;
+    segment = closed_segments.front();
+    closed_segments.pop_front();
+    return true;
+}
+
+void StrokeSegmenter::AngularSpeed(const PoseBuffer &pose, int joint, float frame_time, float *speed) {
+    const int num_frame = pose.GetNumFrame();
+    if (num_frame == 0)
+        return;
+    const auto &q = pose.GetOrientations();
+    const size_t begin = pose.Index(joint, 0);
+    const float *__restrict qx = q.x.data() + begin, *__restrict qy = q.y.data() + begin;
+    const float *__restrict qz = q.z.data() + begin, *__restrict qw = q.w.data() + begin;
+    const float inv_frame_time = 1 / frame_time;
+
+    speed[0] = 0;
+    for (int f = 1; f < num_frame; f++)
+        speed[f] = RotationAngle(qx[f - 1], qy[f - 1], qz[f - 1], qw[f - 1], qx[f], qy[f], qz[f], qw[f]) *
+                   inv_frame_time;
+}
+
+std::vector<StrokeSegment> StrokeSegmenter::Segment(const BVH *bvh, const PoseBuffer &pose,
+                                                    const SegmenterConfig &config) {
+    const int num_frame = pose.GetNumFrame();
+    const float frame_time = bvh->GetInterval() > 0 ? static_cast<float>(bvh->GetInterval()) : 1.0f / 30;
+
+    // The fastest of the watched joints, frame by frame
+    std::vector<float> speed(num_frame, 0.0f), joint_speed(num_frame);
+    bool isWatched = false;
+    for (const auto &joint_name: config.joint_names) {
+        const Joint *joint = bvh->GetJoint(joint_name);
+        if (joint == nullptr)
+            continue;
+        isWatched = true;
+        AngularSpeed(pose, joint->index, frame_time, joint_speed.data());
+        for (int f = 0; f < num_frame; f++)
+            speed[f] = std::max(speed[f], joint_speed[f]);
+    }
+    if (!isWatched)
+        return {};
+
+    StreamingStrokeDetector detector(config, frame_time);
+    for (float frame_speed: speed)
+        detector.Push(frame_speed);
+    detector.Finish();
+
+    std::vector<StrokeSegment> segments;
+    StrokeSegment segment;
+    while (detector.Pop(segment))
+        segments.push_back(segment);
+    return segments;
+}
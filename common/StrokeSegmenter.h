@@ -0,0 +1,135 @@
+#ifndef TESTBED_STROKESEGMENTER_H
+#define TESTBED_STROKESEGMENTER_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "BVH.h"
+#include "PoseBuffer.h"
+#include "FeatureExtractor.h"
+
+using namespace bvh;
+using namespace poseBuffer;
+using namespace featureExtractor;
+
+namespace strokeSegmenter {
+
+    /// One stroke of a practice session
+    struct StrokeSegment {
+        FrameRange frames;
+        /// Highest (smoothed) angular speed within the stroke, degree / s
+        float peak_speed = 0;
+    };
+
+    struct SegmenterConfig {
+        /// Joints whose angular speed is watched, the fastest one counts
+        std::vector<std::string> joint_names = {"rHand", "rForeArm"};
+        /// A stroke starts once the speed reaches onset_speed (degree / s)...
+        float onset_speed = 200;
+        /// ...and ends once it stayed below offset_speed for offset_hold frames
+        float offset_speed = 80;
+        int offset_hold = 6;
+        /// Trailing moving average of the speed, in frames
+        int smoothing = 5;
+        /// Frames kept before the onset & after the offset
+        int padding = 10;
+        /// Shorter strokes (onset to offset) are noise
+        int min_stroke_frames = 8;
+        /// A stroke still running after this many frames is closed, it bounds the detector's latency
+        int max_stroke_frames = 300;
+    };
+
+    /**
+     * Hysteresis stroke detector over a stream of angular speeds, one per frame.
+     * A segment is ready (Pop) once all its frames were pushed: at most offset_hold + padding frames after the
+     * motion settled, and at most max_stroke_frames + padding frames after the onset of a stroke that never settles.
+     * Segments are [onset - padding, offset + padding), they do not overlap.
+     * StrokeSegmenter::Segment runs the same detector over a whole clip, so both give the same segments.
+     */
+    class StreamingStrokeDetector {
+    private:
+        SegmenterConfig config;
+        float frame_time;
+
+        /// Frames pushed so far
+        int num_frame = 0;
+
+        /// Speeds of the last smoothing frames & their sum
+        std::deque<float> window;
+        double window_sum = 0;
+
+        bool isInStroke = false;
+        int onset_frame = 0;
+        int num_below = 0;
+        float peak_speed = 0;
+        /// Where the last segment ended, the next one starts after it
+        int last_end = 0;
+
+        std::deque<StrokeSegment> closed_segments;
+
+        /// Watched joints' orientation at the previous PushPose
+        std::vector<rp3d::Quaternion> previous_orientations;
+
+        // -------------------- Methods -------------------- //
+        void Close(int offset_frame);
+
+    public:
+        /**
+         * @param frame_time seconds between frames (BVH::GetInterval)
+         */
+        StreamingStrokeDetector(const SegmenterConfig &config, float frame_time);
+
+        /// The next frame's angular speed (degree / s)
+        void Push(float speed);
+
+        /**
+         * The next frame's global orientation of the watched joints (config.joint_names order), the angular speed
+         * is taken from the previous frame's
+         */
+        void PushPose(const std::vector<rp3d::Quaternion> &orientations);
+
+        /// End of the stream: close a running stroke, every segment becomes ready
+        void Finish();
+
+        /// The oldest ready segment, false if none is ready yet
+        bool Pop(StrokeSegment &segment);
+
+        // -------------------- Getter & Setter -------------------- //
+        int GetNumFrame() const;
+
+        /// Frames between the motion settling and its segment being ready
+        int GetLatency() const;
+    };
+
+    /**
+     * Cuts a long practice session into strokes from the angular speed of the right hand & forearm.
+     */
+    class StrokeSegmenter {
+    public:
+        /**
+         * Angular speed (degree / s) of a joint's global orientation over all frames of the pose buffer, in one
+         * branch-free pass: the angle of the rotation between consecutive frames over the frame time.
+         * Frame 0 has no predecessor and gets 0.
+         * Max error 1.2e-4 degree per frame (AngleKernel::Atan2).
+         */
+        static void AngularSpeed(const PoseBuffer &pose, int joint, float frame_time, float *speed);
+
+        /**
+         * The strokes of the clip the pose buffer was built from, in order
+         * @return empty if none of the watched joints is in the BVH
+         */
+        static std::vector<StrokeSegment> Segment(const BVH *bvh, const PoseBuffer &pose,
+                                                  const SegmenterConfig &config = SegmenterConfig());
+    };
+
+    inline int StreamingStrokeDetector::GetNumFrame() const {
+        return num_frame;
+    }
+
+    inline int StreamingStrokeDetector::GetLatency() const {
+        return config.offset_hold + config.padding;
+    }
+}
+
+#endif //TESTBED_STROKESEGMENTER_H
@@ -76,12 +76,17 @@ void BvhScene::createPhysicsWorld() {
 // Destroy the physics world
 void BvhScene::destroyPhysicsWorld() {
     if (mPhysicsWorld != nullptr) {
+        playback_aligner.Reset();
+        live_classifier.Stop();
+
         delete mFloor2;
 
         delete skeleton1;
 
         delete experx_skeleton;
 
+        DestroyCrowd();
+
         mPhysicsObjects.clear();
 
         mPhysicsCommon.destroyPhysicsWorld(mPhysicsWorld);
@@ -106,6 +111,8 @@ void BvhScene::update() {
             }
         }
     }
+    if (forehand_stroke_analysizer != nullptr)
+        forehand_stroke_analysizer->Update();
     SceneDemo::update();
 }
 
@@ -132,6 +139,9 @@ skeleton::Skeleton *BvhScene::CreateSkeleton(BVH *new_bvh) {
     raycastedTarget_bone = skeleton1->FindBone("head");
     raycastedTarget_oldcolor = raycastedTarget_bone->GetPhysicsObject()->getColor();
     RecordRaycastTarget(raycastedTarget_bone);
+
+    if (isLiveClassifying)
+        live_classifier.Start(bvh, live_openpose_path);
     return skeleton1;
 }
 
@@ -143,16 +153,20 @@ skeleton::Skeleton *BvhScene::CreateSkeleton(string &new_bvh) {
 }
 
 void BvhScene::DestroySkeleton() {
+    // A running alignment reads both bvhs, the live classifier the user's
+    playback_aligner.Reset();
+    live_classifier.Stop();
     if (skeleton1 != nullptr) {
+        // First: a running analysis reads the skeleton's bvh
+        delete forehand_stroke_analysizer;
+        forehand_stroke_analysizer = nullptr;
+
         delete skeleton1;
         skeleton1 = nullptr;
 
         delete bvh;
         bvh = nullptr;
 
-        delete forehand_stroke_analysizer;
-        forehand_stroke_analysizer = nullptr;
-
         raycastedTarget_bone = nullptr;
 
         motion_nexted.clear();
@@ -174,6 +188,10 @@ skeleton::Skeleton *BvhScene::CreateExpertSkeleton(BVH *new_bvh) {
     experx_skeleton = new skeleton::Skeleton(mPhysicsCommon, mPhysicsWorld, mPhysicsObjects, mMeshFolderPath,
                                              expert_bvh, rp3d::Vector3(10, 0, 0));
 
+    // Once per load, the playback only looks the frames up
+    if (skeleton1 != nullptr)
+        playback_aligner.Start(bvh, expert_bvh);
+
     return experx_skeleton;
 }
 
@@ -185,6 +203,7 @@ skeleton::Skeleton *BvhScene::CreateExpertSkeleton(string &new_bvh) {
 }
 
 void BvhScene::DestroyExpertSkeleton() {
+    playback_aligner.Reset();
     if (experx_skeleton != nullptr) {
         delete experx_skeleton;
         experx_skeleton = nullptr;
@@ -194,6 +213,108 @@ void BvhScene::DestroyExpertSkeleton() {
     }
 }
 
+bool BvhScene::MatchExpert(const string &bvh_path) {
+    // Mapped on first use, the library stays on disk until a search touches it
+    if (!isExpertIndexLoaded)
+        isExpertIndexLoaded = expert_index.Load(expert_index_path);
+    if (!isExpertIndexLoaded || expert_index.IsEmpty())
+        return false;
+
+    // The clip is read again on its own, the shown one only gets its motion while it plays
+    const expertIndex::IndexConfig config;
+    FeatureMatrix features;
+    std::vector<strokeSegmenter::StrokeSegment> strokes;
+    if (!expertIndex::ExpertIndex::LoadClip(bvh_path, config.target_list, config.segmenter_config, features,
+                                            strokes))
+        return false;
+    std::vector<FrameRange> ranges;
+    for (const auto &stroke: strokes)
+        ranges.push_back(stroke.frames);
+    if (ranges.empty())
+        ranges.emplace_back();
+
+    expert_matches.clear();
+    for (const auto &range: ranges) {
+        expertIndex::SearchStats stats;
+        const auto matches = expert_index.Search(features, range, 1, &stats);
+        if (matches.empty())
+            return false;
+        expert_matches.push_back(matches.front());
+
+        const auto &match = matches.front();
+        const auto &entry = expert_index.GetEntry(match.entry);
+        const FrameRange frames = range.Clamp(features.GetNumFrame());
+        std::cout << "Stroke [" << frames.begin << ", " << frames.end << "): expert "
+                  << expert_index.GetClip(match.entry).bvh_path << " [" << entry.frames.begin << ", "
+                  << entry.frames.end << "), distance " << match.distance << " (" << stats.num_dtw << " / "
+                  << stats.num_entry << " DTW)" << std::endl;
+    }
+
+    const int nearest = expert_matches.front().entry;
+    expert_bvh_path = expert_index.GetClip(nearest).bvh_path;
+    expert_video_path = expert_index.GetClip(nearest).video_path;
+    expert_frames = expert_index.GetEntry(nearest).frames;
+    return true;
+}
+
+bool BvhScene::FindSimilarPoses(const string &bvh_path, int frame, int k) {
+    // Without a library file the index starts empty and holds the searched clips only
+    if (!isPoseIndexLoaded) {
+        pose_index.Load(pose_index_path);
+        isPoseIndexLoaded = true;
+    }
+
+    int clip = pose_index.FindClip(bvh_path);
+    if (clip < 0) {
+        const poseIndex::PoseIndexConfig config;
+        const expertIndex::IndexConfig expert_config;
+        FeatureMatrix features;
+        std::vector<strokeSegmenter::StrokeSegment> strokes;
+        if (!expertIndex::ExpertIndex::LoadClip(bvh_path, config.target_list, expert_config.segmenter_config, features,
+                                                strokes))
+            return false;
+        clip = pose_index.AddClip(bvh_path, features);
+    }
+    const int entry = pose_index.FindEntry(clip, frame);
+    if (entry < 0)
+        return false;
+
+    poseIndex::PoseSearchStats stats;
+    pose_matches = pose_index.Search(entry, k, pose_window, 0, &stats);
+    std::cout << "Poses like frame " << frame << " (" << stats.num_distance << " / " << stats.num_entry
+              << " compared):" << std::endl;
+    for (const auto &match: pose_matches) {
+        const auto &pose = pose_index.GetEntry(match.entry);
+        std::cout << "    " << pose_index.GetClip(match.entry) << " frame " << pose.frame << ", distance "
+                  << match.distance << std::endl;
+    }
+    return true;
+}
+
+crowd::Crowd *BvhScene::CreateCrowd(const std::vector<string> &bvh_paths, int num_member) {
+    DestroyCrowd();
+    if (bvh_paths.empty())
+        return nullptr;
+
+    crowd = new crowd::Crowd(mPhysicsCommon, mPhysicsWorld, mMeshFolderPath);
+
+    // Square grid centered on the origin, in front of the single skeletons
+    const int num_column = std::ceil(std::sqrt(num_member));
+    for (int i = 0; i < num_member; i++) {
+        const float x = (i % num_column - (num_column - 1) * 0.5f) * crowd_spacing;
+        const float z = (i / num_column + 1) * crowd_spacing;
+        crowd->AddMember(bvh_paths[i % bvh_paths.size()], rp3d::Vector3(x, 0, z));
+    }
+    crowd->ApplyBvhMotion(0);
+
+    return crowd;
+}
+
+void BvhScene::DestroyCrowd() {
+    delete crowd;
+    crowd = nullptr;
+}
+
 skeleton::Skeleton *BvhScene::GetSkeleton() {
     return skeleton1;
 }
@@ -201,12 +322,16 @@ skeleton::Skeleton *BvhScene::GetSkeleton() {
 // Called when a raycast hit occurs (show the information of the angles)
 rp3d::decimal BvhScene::notifyRaycastHit(const rp3d::RaycastInfo &raycastInfo) {
 
+    // The crowd bones are collision bodies, not rigid bodies
+    if (crowd != nullptr && crowd->Pick(raycastInfo.body))
+        return raycastInfo.hitFraction;
+
     auto *body = dynamic_cast<rp3d::RigidBody *>(raycastInfo.body);
 
-    Bone *target_bone = skeleton1->FindBone(body);
+    Bone *target_bone = skeleton1 != nullptr ? skeleton1->FindBone(body) : nullptr;
     if (target_bone != nullptr) {
         RecordRaycastTarget(target_bone);
-    } else {
+    } else if (experx_skeleton != nullptr) {
         target_bone = experx_skeleton->FindBone(body);
         if (target_bone != nullptr) {
             RecordRaycastTarget(target_bone);
@@ -249,6 +374,10 @@ bool BvhScene::keyboardEvent(int key, int scancode, int action, int mods) {
         motion_nexted.fire();
         return true;
     }
+    if (key == GLFW_KEY_P && action == GLFW_PRESS && crowd != nullptr) {
+        crowd->SetPickingEnabled(!crowd->IsPickingEnabled());
+        return true;
+    }
     if (key == GLFW_KEY_T && action == GLFW_PRESS) {
         skeleton1->SetJointRotation_local(raycastedTarget_bone, 0, M_PI / 6, 0);
         return true;
@@ -262,16 +391,54 @@ bool BvhScene::keyboardEvent(int key, int scancode, int action, int mods) {
 }
 
 void BvhScene::MotionNext() {
-    if (skeleton1 != nullptr)
+    if (skeleton1 != nullptr) {
         skeleton1->NextBvhMotion();
-    if (experx_skeleton != nullptr)
-        experx_skeleton->NextBvhMotion();
+        // A new window classified: the tint follows it
+        if (live_classifier.Step(skeleton1->GetBvhFrame())) {
+            skeleton1->ClearAnalyzeResult();
+            for (const auto &bone_name: live_classifier.GetFailedBones())
+                skeleton1->ShowAnalyzeResult(bone_name);
+        }
+    }
+    if (experx_skeleton != nullptr) {
+        const int expert_frame = skeleton1 != nullptr ? playback_aligner.GetExpertFrame(skeleton1->GetBvhFrame()) : -1;
+        if (expert_frame >= 0)
+            experx_skeleton->SetBvhMotion(expert_frame);
+        else
+            experx_skeleton->NextBvhMotion();
+    }
+    if (crowd != nullptr)
+        crowd->NextBvhMotion();
+}
+
+void BvhScene::renderSinglePass(openglframework::Shader &shader, const openglframework::Matrix4 &worldToCameraMatrix) {
+    SceneDemo::renderSinglePass(shader, worldToCameraMatrix);
+
+    if (crowd != nullptr) {
+        if (mIsWireframeEnabled)
+            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        crowd->render(mIsWireframeEnabled ? mColorShader : shader, worldToCameraMatrix);
+        if (mIsWireframeEnabled)
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    }
 }
 
 void BvhScene::ForearmStrokeAnalyze(const std::string &openposePath) {
     forehand_stroke_analysizer->Analyze(openposePath);
 }
 
+void BvhScene::SetLiveClassifying(bool isLive, const std::string &openposePath) {
+    isLiveClassifying = isLive;
+    live_openpose_path = openposePath;
+    if (isLive && skeleton1 != nullptr) {
+        isLiveClassifying = live_classifier.Start(bvh, live_openpose_path);
+    } else if (!isLive && live_classifier.IsRunning()) {
+        live_classifier.Stop();
+        if (skeleton1 != nullptr)
+            skeleton1->ClearAnalyzeResult();
+    }
+}
+
 string BvhScene::GetForearmStrokeAnalyzeSuggestions() {
     if (forehand_stroke_analysizer != nullptr) {
         return forehand_stroke_analysizer->GetSuggestion();
@@ -41,6 +41,11 @@
 #include "VideoToBvhConverter.h"
 #include "BVH.h"
 #include "AngleTool.h"
+#include "Crowd.h"
+#include "ExpertIndex.h"
+#include "PoseIndex.h"
+#include "PlaybackAligner.h"
+#include "LiveClassifier.h"
 
 using namespace event;
 
@@ -75,9 +80,41 @@ namespace bvhscene {
         string expert_bvh_path = "static/front_bigman_pose_22_segment.bvh";
         string expert_video_path = "static/2dJoints_v1.4.csv_lastRun3DHiRes.mp4";
 
+        // -------------------- Expert library -------------------- //
+        /// Built by testbed_batch --build-expert-index, without it the expert above is always shown
+        string expert_index_path = "static/experts.idx";
+        expertIndex::ExpertIndex expert_index;
+        bool isExpertIndexLoaded = false;
+        /// The nearest expert stroke of each stroke of the last matched clip
+        std::vector<expertIndex::ExpertMatch> expert_matches;
+        /// Frames of the shown expert clip that hold the matched stroke
+        FrameRange expert_frames;
+
+        /// Every frame of the library (testbed_batch --build-pose-index) & of the clips searched since
+        string pose_index_path = "static/poses.idx";
+        poseIndex::PoseIndex pose_index;
+        bool isPoseIndexLoaded = false;
+        /// Frames on either side of a match that are the same occurrence of the pose, about a stroke
+        int pose_window = 60;
+        /// The poses nearest to the last searched frame
+        std::vector<poseIndex::PoseMatch> pose_matches;
+
+        /// The expert follows the user through a DTW warping path once it is computed, in lockstep until then
+        playbackAligner::PlaybackAligner playback_aligner;
+
+        // -------------------- Crowd -------------------- //
+        crowd::Crowd *crowd = nullptr;
+        /// Distance between two members of the crowd
+        float crowd_spacing = 10.0f;
+
         // -------------------- Analysizer -------------------- //
         analysizer::Analysizer *forehand_stroke_analysizer;
 
+        /// Classifies the user's clip as it plays and tints the failing bones, while isLiveClassifying
+        liveClassifier::LiveClassifier live_classifier;
+        bool isLiveClassifying = false;
+        std::string live_openpose_path;
+
         // -------------------- Physics -------------------- //
         Box *mFloor2;
 
@@ -134,13 +171,47 @@ namespace bvhscene {
 
         void DestroyExpertSkeleton();
 
+        /**
+         * Pick the expert stroke of the library nearest to each stroke of a clip, the first stroke's expert becomes
+         * the expert that is shown (GetExpertBvhPath, GetExpertVideoPath & GetExpertFrames)
+         * @return false if there is no expert index or the clip cannot be matched, the expert is left as is
+         */
+        bool MatchExpert(const string &bvh_path);
+
+        /**
+         * The k poses of the library & the clips searched so far nearest to a frame of a clip (GetPoseMatches), the
+         * clip is indexed on its first search. The frames around it & around each match are left out (pose_window):
+         * the k matches are k other occurrences of the pose
+         * @return false if the clip cannot be indexed or the frame is out of it
+         */
+        bool FindSimilarPoses(const string &bvh_path, int frame, int k);
+
+        /**
+         * Create a crowd of num_member skeletons on a grid, member i plays bvh_paths[i % bvh_paths.size()]
+         * @details the crowd bones are not in the physics world, press P to make them pickable
+         */
+        crowd::Crowd *CreateCrowd(const std::vector<string> &bvh_paths, int num_member);
+
+        void DestroyCrowd();
+
         void ForearmStrokeAnalyze(const std::string &openposePath);
 
         string GetForearmStrokeAnalyzeSuggestions();
 
+        /**
+         * Classify the skeleton's clip frame by frame while it plays, the bones are tinted as the classification
+         * changes. Kept on for the clips loaded after.
+         * @param openposePath the clip's keypoints, if the model takes some
+         */
+        void SetLiveClassifying(bool isLive, const std::string &openposePath = "");
+
         // -------------------- Events -------------------- //
         float notifyRaycastHit(const rp3d::RaycastInfo &raycastInfo) override;
 
+        /// Render the scene in a single pass, plus the instanced crowd
+        void renderSinglePass(openglframework::Shader &shader,
+                              const openglframework::Matrix4 &worldToCameraMatrix) override;
+
         /// Called when a keyboard event occurs
         virtual bool keyboardEvent(int key, int scancode, int action, int mods) override;
 
@@ -149,6 +220,8 @@ namespace bvhscene {
 
         skeleton::Skeleton *GetExpertSkeleton();
 
+        crowd::Crowd *GetCrowd() const;
+
         Bone *GetRaycastedTarget_bone() const;
 
         analysizer::Analysizer *GetForehandStrokeAnalysizer() const;
@@ -156,6 +229,20 @@ namespace bvhscene {
         string &GetExpertBvhPath();
 
         string &GetExpertVideoPath();
+
+        const FrameRange &GetExpertFrames() const;
+
+        const std::vector<expertIndex::ExpertMatch> &GetExpertMatches() const;
+
+        const expertIndex::ExpertIndex &GetExpertIndex() const;
+
+        const std::vector<poseIndex::PoseMatch> &GetPoseMatches() const;
+
+        const poseIndex::PoseIndex &GetPoseIndex() const;
+
+        const playbackAligner::PlaybackAligner &GetPlaybackAligner() const;
+
+        const liveClassifier::LiveClassifier &GetLiveClassifier() const;
     };
 
     inline Bone *BvhScene::GetRaycastedTarget_bone() const {
@@ -170,6 +257,10 @@ namespace bvhscene {
         return experx_skeleton;
     }
 
+    inline crowd::Crowd *BvhScene::GetCrowd() const {
+        return crowd;
+    }
+
     inline string &BvhScene::GetExpertBvhPath() {
         return expert_bvh_path;
     }
@@ -178,6 +269,34 @@ namespace bvhscene {
         return expert_video_path;
     }
 
+    inline const FrameRange &BvhScene::GetExpertFrames() const {
+        return expert_frames;
+    }
+
+    inline const std::vector<expertIndex::ExpertMatch> &BvhScene::GetExpertMatches() const {
+        return expert_matches;
+    }
+
+    inline const expertIndex::ExpertIndex &BvhScene::GetExpertIndex() const {
+        return expert_index;
+    }
+
+    inline const std::vector<poseIndex::PoseMatch> &BvhScene::GetPoseMatches() const {
+        return pose_matches;
+    }
+
+    inline const poseIndex::PoseIndex &BvhScene::GetPoseIndex() const {
+        return pose_index;
+    }
+
+    inline const playbackAligner::PlaybackAligner &BvhScene::GetPlaybackAligner() const {
+        return playback_aligner;
+    }
+
+    inline const liveClassifier::LiveClassifier &BvhScene::GetLiveClassifier() const {
+        return live_classifier;
+    }
+
 
 }  // namespace bvhscene
 
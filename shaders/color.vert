@@ -29,9 +29,11 @@
 uniform mat4 localToWorldMatrix;        // Local-space to world-space matrix
 uniform mat4 worldToCameraMatrix;       // World-space to camera-space matrix
 uniform mat4 projectionMatrix;          // Projection matrix
+uniform bool isInstanced;               // True if the local-to-world matrix comes per instance
 
 // In variables
 in vec4 vertexPosition;
+in mat4 instanceLocalToWorldMatrix;     // Local-space to world-space matrix of the instance
 in uint vertexColor;
 
 // Out variables
@@ -39,8 +41,10 @@ out vec4 vertexColorOut;
 
 void main() {
 
+    mat4 localToWorld = isInstanced ? instanceLocalToWorldMatrix : localToWorldMatrix;
+
     // Compute the vertex position
-    vec4 positionCameraSpace = worldToCameraMatrix * localToWorldMatrix * vertexPosition;
+    vec4 positionCameraSpace = worldToCameraMatrix * localToWorld * vertexPosition;
 
     // Compute the clip-space vertex coordinates
     gl_Position = projectionMatrix * positionCameraSpace;
@@ -29,12 +29,16 @@
 uniform mat4 localToWorldMatrix;        // Local-space to world-space matrix
 uniform mat4 worldToCameraMatrix;       // World-space to camera-space matrix
 uniform mat4 projectionMatrix;          // Projection matrix
+uniform bool isInstanced;               // True if the local-to-world matrix comes per instance
 
 // In variables
 in vec4 vertexPosition;
+in mat4 instanceLocalToWorldMatrix;     // Local-space to world-space matrix of the instance
 
 void main() {
 
+    mat4 localToWorld = isInstanced ? instanceLocalToWorldMatrix : localToWorldMatrix;
+
     // Compute the clip-space vertex coordinates
-    gl_Position = projectionMatrix * worldToCameraMatrix * localToWorldMatrix * vertexPosition;
+    gl_Position = projectionMatrix * worldToCameraMatrix * localToWorld * vertexPosition;
 }
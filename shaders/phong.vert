@@ -34,11 +34,13 @@ uniform mat4 projectionMatrix;          // Projection matrix
 uniform mat3 normalMatrix;              // Normal matrix
 uniform mat4 shadowMapLight0ProjectionMatrix; // Shadow map projection matrix for light 0
 uniform mat4 shadowMapLight1ProjectionMatrix; // Shadow map projection matrix for light 1
+uniform bool isInstanced;               // True if the local-to-world matrix comes per instance
 
 // In variables
 in vec4 vertexPosition;
 in vec3 vertexNormal;
 in vec2 textureCoords;
+in mat4 instanceLocalToWorldMatrix;     // Local-space to world-space matrix of the instance
 
 // Out variables
 out vec3 vertexPosCameraSpace;      // Camera-space position of the vertex
@@ -48,12 +50,19 @@ out vec4 shadowMapCoords[2];        // Shadow map texture coords
 
 void main() {
 
+    mat4 localToWorld = isInstanced ? instanceLocalToWorldMatrix : localToWorldMatrix;
+
     // Compute the vertex position
-    vec4 positionCameraSpace = worldToCameraMatrix * localToWorldMatrix * vertexPosition;
+    vec4 positionCameraSpace = worldToCameraMatrix * localToWorld * vertexPosition;
     vertexPosCameraSpace = positionCameraSpace.xyz;
 
-    // Compute the world surface normal
-    vertexNormalCameraSpace = normalMatrix * vertexNormal;
+    // Compute the world surface normal (the normal matrix cannot be a uniform for instances)
+    if (isInstanced) {
+        vertexNormalCameraSpace = transpose(inverse(mat3(worldToCameraMatrix * localToWorld))) * vertexNormal;
+    }
+    else {
+        vertexNormalCameraSpace = normalMatrix * vertexNormal;
+    }
 
     // Get the texture coordinates
     texCoords = textureCoords;
@@ -66,7 +75,7 @@ void main() {
     shadowMapProjectionMatrix[0] = shadowMapLight0ProjectionMatrix;
     shadowMapProjectionMatrix[1] = shadowMapLight1ProjectionMatrix;
     for (int l=0; l < 2; l++) {
-        shadowMapCoords[l] = shadowMapProjectionMatrix[l] * worldToLightCameraMatrix[l] * localToWorldMatrix * vertexPosition;
+        shadowMapCoords[l] = shadowMapProjectionMatrix[l] * worldToLightCameraMatrix[l] * localToWorld * vertexPosition;
     }
 
     // Compute the clip-space vertex coordinates
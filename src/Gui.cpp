@@ -30,6 +30,8 @@
 #include "TestbedApplication.h"
 #include "bvh_viewer/BvhScene.h"
 #include "AngleTool.h"
+#include "ClassifierSession.h"
+#include "SignalFilter.h"
 
 using namespace nanogui;
 using namespace angleTool;
@@ -181,6 +183,15 @@ void Gui::update() {
     mPhysicsStepTimeLabel->set_caption(
             std::string("Physics step time : ") + floatToString(mCachedPhysicsStepTime * 1000.0, 1) +
             std::string(" ms"));
+
+    // Progress of the background analysis
+    if (mAnalyzeProgressBar != nullptr && mCurrentSceneName == "BVH") {
+        auto analysizer = ((bvhscene::BvhScene *) mApp->mCurrentScene)->GetForehandStrokeAnalysizer();
+        if (analysizer != nullptr) {
+            mAnalyzeStageLabel->set_caption(analysizer->GetStageName());
+            mAnalyzeProgressBar->set_value(analysizer->IsRunning() ? analysizer->GetProgress() : 0.0f);
+        }
+    }
 }
 
 void Gui::createSimulationPanel() {
@@ -760,6 +771,9 @@ void Gui::createUtilsPanel() {
         play_video_button->set_callback([&]() {
             auto scene = (bvhscene::BvhScene *) this->mApp->mCurrentScene;
 
+            // The nearest expert of the library if there is one
+            scene->MatchExpert(mBvhPath);
+
             // Create bvh
             auto skeletonBvh = new BVH(mBvhPath.c_str());
             auto expertSkeletonBvh = new BVH(scene->GetExpertBvhPath().c_str());
@@ -769,7 +783,15 @@ void Gui::createUtilsPanel() {
             int num_frame = skeletonBvh->GetNumFrame();
             // Play video
             pVideoController->Load(mVideoPath, num_frame);
-            pExpertVideoController->Load(scene->GetExpertVideoPath(), num_frame);
+            // The expert keeps its own timing, the playback follows it through the DTW alignment.
+            // Not every expert of the library has its video
+            if (!scene->GetExpertVideoPath().empty()) {
+                pExpertVideoController->Load(scene->GetExpertVideoPath(), expertSkeletonBvh->GetNumFrame());
+            } else {
+                pExpertVideoController->SetVideoPath("");
+                auto *expert_motion = expertSkeletonBvh->GetMotions();
+                expertSkeletonBvh->PushBackMotion(expert_motion->begin(), expert_motion->end());
+            }
 
             // Create skeleton
             scene->CreateSkeleton(skeletonBvh);
@@ -794,6 +816,21 @@ void Gui::createUtilsPanel() {
             adjustPanel();
         });
 
+        // -------------------- Crowd -------------------- //
+        new Label(mUtilsPanel, "Crowd", "sans-bold");
+        new Label(mUtilsPanel, "Number of skeletons: ");
+        crowdSize_intbox = new IntBox<int>(mUtilsPanel, 30);
+        crowdSize_intbox->set_editable(true);
+        crowdSize_intbox->set_min_max_values(1, 500);
+        auto open_crowd_button = new Button(mUtilsPanel, "Open Files");
+        open_crowd_button->set_callback([&]() {
+            auto crowd_paths = file_dialog({{"bvh", "BioVision Motion Capture"}}, false, true);
+            if (crowd_paths.empty())
+                return;
+            auto scene = (bvhscene::BvhScene *) this->mApp->mCurrentScene;
+            scene->CreateCrowd(crowd_paths, crowdSize_intbox->value());
+        });
+
         // -------------------- Video to bvh -------------------- //
         new Label(mUtilsPanel, "Video to bvh", "sans-bold");
         new Label(mUtilsPanel, "Video File Path: ");
@@ -811,6 +848,46 @@ void Gui::createUtilsPanel() {
             pVideoToBvhConverter->Convert(videoPath_textbox->value(), bvhPath_textbox->value());
         });
 
+        // -------------------- Smoothing -------------------- //
+        new Label(mUtilsPanel, "Smooth motion", "sans-bold");
+        auto filter_combobox = new ComboBox(mUtilsPanel, {"Butterworth", "Savitzky-Golay", "One-Euro"});
+        auto smooth_button = new Button(mUtilsPanel, "Smooth");
+        smooth_button->set_callback([this, filter_combobox]() {
+            auto scene = (bvhscene::BvhScene *) this->mApp->mCurrentScene;
+            auto skeleton = scene->GetSkeleton();
+            if (skeleton == nullptr || skeleton->GetBvh()->GetNumModifiedFrame() == 0)
+                return;
+            // The played motion is filtered in place, the current frame shown again
+            signalFilter::FilterConfig config;
+            config.kind = static_cast<signalFilter::FilterKind>(filter_combobox->selected_index());
+            signalFilter::SignalFilter::Apply(skeleton->GetBvh(), config);
+            skeleton->ApplyBvhMotion(skeleton->GetBvhFrame());
+        });
+
+        // -------------------- Pose search -------------------- //
+        new Label(mUtilsPanel, "Pose search", "sans-bold");
+        auto similar_button = new Button(mUtilsPanel, "Similar poses");
+        similar_button->set_callback([this]() {
+            auto scene = (bvhscene::BvhScene *) this->mApp->mCurrentScene;
+            auto skeleton = scene->GetSkeleton();
+            if (skeleton == nullptr || mBvhPath.empty())
+                return;
+            // Where else, in this clip or in the library, the shown frame's pose occurs
+            if (!scene->FindSimilarPoses(mBvhPath, skeleton->GetBvhFrame(), 6)) {
+                createMessageDialog("Pose search", "Cannot search the poses of this clip",
+                                    MessageDialog::Type::Warning);
+                return;
+            }
+            const auto &index = scene->GetPoseIndex();
+            std::string message;
+            for (const auto &match: scene->GetPoseMatches()) {
+                std::string clip = index.GetClip(match.entry);
+                clip = clip.substr(clip.find_last_of("/\\") + 1);
+                message += clip + " frame " + std::to_string(index.GetEntry(match.entry).frame) + "\n";
+            }
+            createMessageDialog("Pose search", message, MessageDialog::Type::Information);
+        });
+
         mUtilsPanel->set_visible(true);
     }
 }
@@ -828,12 +905,47 @@ void Gui::createAnalyzePanel() {
             mOpenposePath = onOpenFileButtonPressed({{"csv", "Comma-Separated Values"}}, false);
         });
 
+        auto segment_checkbox = new CheckBox(mAnalyzePanel, "Split into strokes");
+        segment_checkbox->set_checked(mIsSegmentingStrokes);
+        segment_checkbox->set_callback([&](bool value) {
+            mIsSegmentingStrokes = value;
+        });
+
         auto analyze_button = new Button(mAnalyzePanel, "Forearm Stroke Analyze");
         analyze_button->set_callback([&]() {
             auto scene = (bvhscene::BvhScene *) this->mApp->mCurrentScene;
+            if (scene->GetForehandStrokeAnalysizer() != nullptr)
+                scene->GetForehandStrokeAnalysizer()->SetSegmenting(mIsSegmentingStrokes);
             scene->ForearmStrokeAnalyze(mOpenposePath);
         });
 
+        // The analysis runs in the background, the result comes with analysize_done
+        mAnalyzeStageLabel = new Label(mAnalyzePanel, "Idle");
+        mAnalyzeProgressBar = new ProgressBar(mAnalyzePanel);
+        auto cancel_button = new Button(mAnalyzePanel, "Cancel");
+        cancel_button->set_callback([&]() {
+            auto scene = (bvhscene::BvhScene *) this->mApp->mCurrentScene;
+            if (scene->GetForehandStrokeAnalysizer() != nullptr)
+                scene->GetForehandStrokeAnalysizer()->Cancel();
+        });
+
+        // The bones are tinted as the clip plays, the checkbox is cleared if the model cannot run live
+        auto live_checkbox = new CheckBox(mAnalyzePanel, "Live classification");
+        live_checkbox->set_checked(mIsLiveClassifying);
+        live_checkbox->set_callback([&, live_checkbox](bool value) {
+            auto scene = (bvhscene::BvhScene *) this->mApp->mCurrentScene;
+            scene->SetLiveClassifying(value, mOpenposePath);
+            mIsLiveClassifying = value && (scene->GetSkeleton() == nullptr || scene->GetLiveClassifier().IsRunning());
+            live_checkbox->set_checked(mIsLiveClassifying);
+        });
+
+        // Weight storage of the native classifier, takes effect on the next analysis
+        new Label(mAnalyzePanel, "Classifier precision");
+        auto precision_combobox = new ComboBox(mAnalyzePanel, {"FP32", "FP16", "INT8"});
+        precision_combobox->set_callback([](int index) {
+            classifierSession::ClassifierSession::Instance().SetPrecision(static_cast<lstmEngine::Precision>(index));
+        });
+
         mAnalyzePanel->set_visible(true);
     }
 }
@@ -947,12 +1059,10 @@ void Gui::onChangeBoneTransform_bvhscene(Bone *target) {
     // Only change the info if the target is raycasted target
     if (raycastedBone == target) {
         /// Update Slider info
-        auto degrees = AngleTool::QuaternionToEulerAngles(
-                raycastedBone->GetPhysicsObject()->getTransform().getOrientation());
-        auto offset_degrees = AngleTool::QuaternionToEulerAngles(raycastedBone->GetOriginQuaternion());
-        degrees = AngleTool::EulerAnglesToDegree(degrees);
-        offset_degrees = AngleTool::EulerAnglesToDegree(offset_degrees);
-        auto result_deg = degrees - offset_degrees;
+        // The rotation relative to the origin, so it reads back what SetJointRotation was given
+        auto relative_quatern = raycastedBone->GetPhysicsObject()->getTransform().getOrientation() *
+                                raycastedBone->GetOriginQuaternion().getInverse();
+        auto result_deg = AngleTool::EulerAnglesToDegree(AngleTool::QuaternionToEulerAngles(relative_quatern));
         mRotateSlider_x->set_value(result_deg.x);
         mRotateSlider_y->set_value(result_deg.y);
         mRotateSlider_z->set_value(result_deg.z);
@@ -1003,8 +1113,10 @@ void Gui::onMotionNext() {
         pVideoController->Next();
         isNext = true;
     }
-    if (!pExpertVideoController->GetVideoPath().empty()) {
-        pExpertVideoController->Next();
+    // The expert's video shows the expert skeleton's frame, the alignment picks it
+    auto scene = (bvhscene::BvhScene *) this->mApp->mCurrentScene;
+    if (!pExpertVideoController->GetVideoPath().empty() && scene->GetExpertSkeleton() != nullptr) {
+        pExpertVideoController->ShowFrame(scene->GetExpertSkeleton()->GetBvhFrame());
         isNext = true;
     }
     if (isNext)
@@ -125,11 +125,19 @@ class Gui {
         std::string mVideoPath;
         TextBox *videoPath_textbox;
         TextBox *bvhPath_textbox;
+        IntBox<int> *crowdSize_intbox;
 
         // Analyze panel
         Widget *mAnalyzePanel;
         Vector2i mAnalyzePanelPos{15, 505};
         std::string mOpenposePath;
+        Label *mAnalyzeStageLabel = nullptr;
+        ProgressBar *mAnalyzeProgressBar = nullptr;
+        /// Analyze every stroke of a practice session instead of the clip as one stroke
+        bool mIsSegmentingStrokes = false;
+
+        /// Classify the clip while it plays (BvhScene::SetLiveClassifying)
+        bool mIsLiveClassifying = false;
 
         // Image Viewer
         Window *bvhImageWindow;
@@ -60,9 +60,14 @@ int main(int /*argc*/, char** /*argv*/) {
     // Initialize the Python interpreter
     py::initialize_interpreter();
 
-    // Create and start the testbed application
-    TestbedApplication application;
-    application.start();
+    {
+        // The analysis jobs call Python from worker threads: the main thread only takes the GIL when it needs it
+        py::gil_scoped_release release;
+
+        // Create and start the testbed application
+        TestbedApplication application;
+        application.start();
+    }
 
     // Shutdown the Python interpreter
     py::finalize_interpreter();
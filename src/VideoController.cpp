@@ -58,6 +58,15 @@ void VideoController::Previous() {
     Show();
 }
 
+void VideoController::ShowFrame(int frame) {
+    const int num_frame = frames.size();
+    if (num_frame == 0)
+        return;
+    currentFrameIdx = (frame % num_frame + num_frame) % num_frame;
+
+    Show();
+}
+
 void VideoController::MatchFrame(int target_nFrame, cv::VideoCapture *pVideoCapture) {
     if (!pVideoCapture->isOpened()) {
         throw std::runtime_error("VideoController::MatchFrame: Video not found");
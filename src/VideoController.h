@@ -65,6 +65,9 @@ namespace videoLoader {
 
         void Previous();
 
+        /// Show a frame of the loaded video, wrapped like Next
+        void ShowFrame(int frame);
+
         // ----------------- Getter & Setter -----------------
         void SetVideoPath(const std::string &path);
 
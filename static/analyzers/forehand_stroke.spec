@@ -0,0 +1,25 @@
+# The forehand stroke analyzer (common/AnalyzerSpec.h for the format)
+analyzer forehand_stroke
+
+# Scorer output: 0,1,2: rotation, 3,4,5: fore_arm (correct, too much, too little)
+identifier fore_arm
+target rForeArm
+scorer forehand_classifier
+first_class 3
+pass_threshold 0.5
+suggest_pass Your swing motion is correct.
+suggest_too_much Wave your arm less.
+suggest_too_little Wave your arm more.
+suggest_wrong Your swing motion is wrong.\nPlease see our expert motion and try to mimic it.
+# Checks run natively on the features, e.g. a minimum racket hand speed (BVH units / s):
+# check rHand_speed max > 150 Swing your racket faster.
+
+identifier rotation
+target hip
+scorer forehand_classifier
+first_class 0
+pass_threshold 0.5
+suggest_pass Your hip rotation motion is correct.
+suggest_too_much Rotate your waist less.
+suggest_too_little Rotate your waist more.
+suggest_wrong Your hip rotation motion is wrong.\nPlease see our expert motion and try to mimic it.
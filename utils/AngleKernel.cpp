@@ -0,0 +1,51 @@
+#include "AngleKernel.h"
+
+using namespace angleTool;
+
+void AngleKernel::QuaternionToEulerAngles(const float *__restrict qx, const float *__restrict qy,
+                                          const float *__restrict qz, const float *__restrict qw,
+                                          float *__restrict ex, float *__restrict ey, float *__restrict ez,
+                                          size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+        // roll (x-axis rotation)
+        ex[i] = Atan2(2 * (w * x + y * z), 1 - 2 * (x * x + y * y));
+        // pitch (y-axis rotation), 2 * atan2(sqrt(1 + s), sqrt(1 - s)) - pi / 2 == asin(s)
+        ey[i] = Asin(2 * (w * y - x * z));
+        // yaw (z-axis rotation)
+        ez[i] = Atan2(2 * (w * z + x * y), 1 - 2 * (y * y + z * z));
+    }
+}
+
+void AngleKernel::EulerAnglesToQuaternion(const float *__restrict ex, const float *__restrict ey,
+                                          const float *__restrict ez, float *__restrict qx, float *__restrict qy,
+                                          float *__restrict qz, float *__restrict qw, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        float sx, cx, sy, cy, sz, cz;
+        SinCos(ex[i] * 0.5f, sx, cx);
+        SinCos(ey[i] * 0.5f, sy, cy);
+        SinCos(ez[i] * 0.5f, sz, cz);
+        // qz * qy * qx
+        qx[i] = sx * cy * cz - cx * sy * sz;
+        qy[i] = cx * sy * cz + sx * cy * sz;
+        qz[i] = cx * cy * sz - sx * sy * cz;
+        qw[i] = cx * cy * cz + sx * sy * sz;
+    }
+}
+
+void AngleKernel::EulerAnglesToDegree(const float *in, float *out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = in[i] * rad_to_deg;
+}
+
+void AngleKernel::DegreeToEulerAngles(const float *in, float *out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = in[i] * deg_to_rad;
+}
+
+void AngleKernel::AngleBetween(const float *__restrict ax, const float *__restrict ay, const float *__restrict az,
+                               const float *__restrict bx, const float *__restrict by, const float *__restrict bz,
+                               float *__restrict out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = Acos(ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i]);
+}
@@ -0,0 +1,118 @@
+#ifndef TESTBED_ANGLEKERNEL_H
+#define TESTBED_ANGLEKERNEL_H
+
+#include <cmath>
+#include <cstddef>
+
+namespace angleTool {
+
+    /**
+     * Batch angle kernels over structure-of-arrays input.
+     * Every loop is branch-free and works on contiguous float arrays so the compiler can vectorize it.
+     * The transcendental functions are replaced by polynomial approximations, sqrt uses the hardware
+     * (vector) square root which is exact. The maximum error of each kernel is stated on the kernel and
+     * was measured against double precision std:: math over the whole input domain.
+     */
+    class AngleKernel {
+    public:
+        inline static constexpr float pi = 3.14159265358979323846f;
+        inline static constexpr float half_pi = 1.57079632679489661923f;
+        inline static constexpr float rad_to_deg = 57.2957795130823208768f;
+        inline static constexpr float deg_to_rad = 0.01745329251994329577f;
+
+        // -------------------- Scalar approximations -------------------- //
+        /// atan2 approximation, max error 2.0e-6 rad
+        static float Atan2(float y, float x);
+
+        /// acos approximation for x in [-1, 1] (clamped), max error 4.5e-7 rad
+        static float Acos(float x);
+
+        /// asin approximation for x in [-1, 1] (clamped), max error 4.5e-7 rad
+        static float Asin(float x);
+
+        /// sin & cos approximation, max error 2.5e-7 for x within [-4pi, 4pi]
+        static void SinCos(float x, float &s, float &c);
+
+        // -------------------- Batch kernels -------------------- //
+        /**
+         * Quaternion -> Euler angles (radian), same convention as AngleTool::QuaternionToEulerAngles.
+         * Max error 7.0e-6 rad for unit quaternions with |pitch| < 89 degree. Closer to the gimbal lock the
+         * float input itself dominates the error (as it does for the scalar version).
+         */
+        static void QuaternionToEulerAngles(const float *qx, const float *qy, const float *qz, const float *qw,
+                                            float *ex, float *ey, float *ez, size_t n);
+
+        /**
+         * Euler angles (radian) -> quaternion, same convention as rp3d::Quaternion::fromEulerAngles.
+         * Max error 2.5e-7 per component for angles within [-2pi, 2pi].
+         */
+        static void EulerAnglesToQuaternion(const float *ex, const float *ey, const float *ez,
+                                            float *qx, float *qy, float *qz, float *qw, size_t n);
+
+        /// Radian -> degree, in may be out. Error 0.5 ulp
+        static void EulerAnglesToDegree(const float *in, float *out, size_t n);
+
+        /// Degree -> radian, in may be out. Error 0.5 ulp
+        static void DegreeToEulerAngles(const float *in, float *out, size_t n);
+
+        /**
+         * Angle (radian) between unit vectors a[i] and b[i], i.e. acos(a . b) with the dot product clamped.
+         * Max error 4.5e-7 rad plus the rounding of the dot product.
+         */
+        static void AngleBetween(const float *ax, const float *ay, const float *az,
+                                 const float *bx, const float *by, const float *bz, float *out, size_t n);
+    };
+
+    inline float AngleKernel::Atan2(float y, float x) {
+        const float abs_x = std::fabs(x), abs_y = std::fabs(y);
+        const float max_xy = abs_x > abs_y ? abs_x : abs_y;
+        const float min_xy = abs_x > abs_y ? abs_y : abs_x;
+        // atan(a) for a in [0, 1], odd minimax polynomial
+        const float a = min_xy / (max_xy > 1e-30f ? max_xy : 1e-30f);
+        const float s = a * a;
+        float r = ((((-0.0117212f * s + 0.05265332f) * s - 0.11643287f) * s + 0.19354346f) * s - 0.33262347f) * s +
+                  0.99997726f;
+        r *= a;
+        // Unfold the octant
+        r = abs_y > abs_x ? half_pi - r : r;
+        r = x < 0 ? pi - r : r;
+        return std::copysign(r, y);
+    }
+
+    inline float AngleKernel::Acos(float x) {
+        // Abramowitz & Stegun 4.4.46: acos(x) = sqrt(1 - x) * P(x) for x in [0, 1]
+        const float clamped = x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x);
+        const float a = std::fabs(clamped);
+        float p = -0.0012624911f;
+        p = p * a + 0.0066700901f;
+        p = p * a - 0.0170881256f;
+        p = p * a + 0.0308918810f;
+        p = p * a - 0.0501743046f;
+        p = p * a + 0.0889789874f;
+        p = p * a - 0.2145988016f;
+        p = p * a + 1.5707963050f;
+        const float r = std::sqrt(1.0f - a) * p;
+        return clamped < 0 ? pi - r : r;
+    }
+
+    inline float AngleKernel::Asin(float x) {
+        return half_pi - Acos(x);
+    }
+
+    inline void AngleKernel::SinCos(float x, float &s, float &c) {
+        // Reduce to [-pi, pi], then fold into [-pi/2, pi/2] where the Taylor series converges fast
+        const float turns = x * (0.5f / pi);
+        const float k = static_cast<float>(static_cast<int>(turns + (turns < 0 ? -0.5f : 0.5f)));
+        float r = (x - k * 6.28125f) - k * 1.9353071795864769253e-3f;
+        const float fold = r > half_pi ? pi : (r < -half_pi ? -pi : 0.0f);
+        const float sign_c = fold != 0.0f ? -1.0f : 1.0f;
+        r = fold != 0.0f ? fold - r : r;
+        const float r2 = r * r;
+        s = r * (1.0f + r2 * (-1.6666667e-1f + r2 * (8.3333333e-3f + r2 * (-1.9841270e-4f +
+                 r2 * (2.7557319e-6f + r2 * -2.5052108e-8f)))));
+        c = sign_c * (1.0f + r2 * (-0.5f + r2 * (4.1666667e-2f + r2 * (-1.3888889e-3f +
+                      r2 * (2.4801587e-5f + r2 * (-2.7557319e-7f + r2 * 2.0876757e-9f))))));
+    }
+}
+
+#endif //TESTBED_ANGLEKERNEL_H
@@ -73,3 +73,71 @@ angleTool::AngleTool::rotate_local_euler(rp3d::decimal angleX, rp3d::decimal ang
     return angle;
 }
 
+
+rp3d::Quaternion
+angleTool::AngleTool::rotate_local_quatern(rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ,
+                                           const rp3d::Quaternion &local_coordinate_quatern) {
+    // Compose the axis rotations in the local frame (x first, z last), i.e. qz * qy * qx
+    const auto local_rotation = rp3d::Quaternion::fromEulerAngles(angleX, angleY, angleZ);
+
+    // local * q * local^-1 keeps the rotation angle and only moves the rotation axis into the world frame
+    const auto axis = local_coordinate_quatern * rp3d::Vector3(local_rotation.x, local_rotation.y, local_rotation.z);
+    return {axis.x, axis.y, axis.z, local_rotation.w};
+}
+
+void angleTool::AngleTool::rotate_local_quatern_batch(const float *angleX, const float *angleY, const float *angleZ,
+                                                      const QuaternionArray &local_coordinate_quaterns,
+                                                      QuaternionArray &result) {
+    const size_t n = local_coordinate_quaterns.size();
+    result.resize(n);
+
+    const float *__restrict lx = local_coordinate_quaterns.x.data();
+    const float *__restrict ly = local_coordinate_quaterns.y.data();
+    const float *__restrict lz = local_coordinate_quaterns.z.data();
+    const float *__restrict lw = local_coordinate_quaterns.w.data();
+    float *__restrict rx = result.x.data();
+    float *__restrict ry = result.y.data();
+    float *__restrict rz = result.z.data();
+    float *__restrict rw = result.w.data();
+
+    for (size_t i = 0; i < n; i++) {
+        const float sx = std::sin(angleX[i] * 0.5f), cx = std::cos(angleX[i] * 0.5f);
+        const float sy = std::sin(angleY[i] * 0.5f), cy = std::cos(angleY[i] * 0.5f);
+        const float sz = std::sin(angleZ[i] * 0.5f), cz = std::cos(angleZ[i] * 0.5f);
+
+        // qz * qy * qx
+        const float qx = sx * cy * cz - cx * sy * sz;
+        const float qy = cx * sy * cz + sx * cy * sz;
+        const float qz = cx * cy * sz - sx * sy * cz;
+        const float qw = cx * cy * cz + sx * sy * sz;
+
+        // Rotate the axis (qx, qy, qz) by the local coordinate: v + 2w(u x v) + 2u x (u x v)
+        const float tx = 2 * (ly[i] * qz - lz[i] * qy);
+        const float ty = 2 * (lz[i] * qx - lx[i] * qz);
+        const float tz = 2 * (lx[i] * qy - ly[i] * qx);
+        rx[i] = qx + lw[i] * tx + (ly[i] * tz - lz[i] * ty);
+        ry[i] = qy + lw[i] * ty + (lz[i] * tx - lx[i] * tz);
+        rz[i] = qz + lw[i] * tz + (lx[i] * ty - ly[i] * tx);
+        rw[i] = qw;
+    }
+}
+
+void angleTool::AngleTool::multiply_quatern_batch(const QuaternionArray &lhs, const QuaternionArray &rhs,
+                                                  QuaternionArray &result) {
+    const size_t n = lhs.size();
+    result.resize(n);
+
+    const float *__restrict ax = lhs.x.data(), *__restrict ay = lhs.y.data();
+    const float *__restrict az = lhs.z.data(), *__restrict aw = lhs.w.data();
+    const float *__restrict bx = rhs.x.data(), *__restrict by = rhs.y.data();
+    const float *__restrict bz = rhs.z.data(), *__restrict bw = rhs.w.data();
+    float *__restrict rx = result.x.data(), *__restrict ry = result.y.data();
+    float *__restrict rz = result.z.data(), *__restrict rw = result.w.data();
+
+    for (size_t i = 0; i < n; i++) {
+        rx[i] = aw[i] * bx[i] + ax[i] * bw[i] + ay[i] * bz[i] - az[i] * by[i];
+        ry[i] = aw[i] * by[i] + ay[i] * bw[i] + az[i] * bx[i] - ax[i] * bz[i];
+        rz[i] = aw[i] * bz[i] + az[i] * bw[i] + ax[i] * by[i] - ay[i] * bx[i];
+        rw[i] = aw[i] * bw[i] - ax[i] * bx[i] - ay[i] * by[i] - az[i] * bz[i];
+    }
+}
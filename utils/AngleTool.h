@@ -1,6 +1,8 @@
 #ifndef TESTBED_ANGLETOOL_H
 #define TESTBED_ANGLETOOL_H
 
+#include <vector>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -8,6 +10,22 @@
 
 namespace angleTool {
 
+    /**
+     * Structure-of-arrays storage for quaternions used by the batch methods.
+     * Each component lives in its own contiguous array so that the loops over them can be vectorized.
+     */
+    struct QuaternionArray {
+        std::vector<float> x, y, z, w;
+
+        void resize(size_t n);
+
+        size_t size() const;
+
+        rp3d::Quaternion Get(size_t i) const;
+
+        void Set(size_t i, const rp3d::Quaternion &q);
+    };
+
     class AngleTool {
     public:
         inline static const rp3d::Vector3 default_axis_x{1, 0, 0};
@@ -28,8 +46,51 @@ namespace angleTool {
 
         static rp3d::Vector3 rotate_local_euler(rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ,
                                                 const rp3d::Quaternion local_coordinate_quatern);
+
+        /** rotate_local_quatern
+         * @details Rotate about the x, y and z axes of the local coordinate (x first, z last).
+         * The axis rotations are composed in the local frame and conjugated into the world frame,
+         * i.e. local * (qz * qy * qx) * local^-1, without going through matrices or Euler angles.
+         */
+        static rp3d::Quaternion rotate_local_quatern(rp3d::decimal angleX, rp3d::decimal angleY, rp3d::decimal angleZ,
+                                                     const rp3d::Quaternion &local_coordinate_quatern);
+
+        /** rotate_local_quatern_batch
+         * @details Batch version of rotate_local_quatern. Element i rotates by
+         * (angleX[i], angleY[i], angleZ[i]) in the frame local_coordinate_quaterns[i].
+         * The result must not be one of the inputs.
+         */
+        static void rotate_local_quatern_batch(const float *angleX, const float *angleY, const float *angleZ,
+                                               const QuaternionArray &local_coordinate_quaterns,
+                                               QuaternionArray &result);
+
+        /// Element-wise lhs[i] * rhs[i], the result must not be one of the inputs
+        static void multiply_quatern_batch(const QuaternionArray &lhs, const QuaternionArray &rhs,
+                                           QuaternionArray &result);
     };
 
+    inline void QuaternionArray::resize(size_t n) {
+        x.resize(n);
+        y.resize(n);
+        z.resize(n);
+        w.resize(n);
+    }
+
+    inline size_t QuaternionArray::size() const {
+        return w.size();
+    }
+
+    inline rp3d::Quaternion QuaternionArray::Get(size_t i) const {
+        return {x[i], y[i], z[i], w[i]};
+    }
+
+    inline void QuaternionArray::Set(size_t i, const rp3d::Quaternion &q) {
+        x[i] = q.x;
+        y[i] = q.y;
+        z[i] = q.z;
+        w[i] = q.w;
+    }
+
 }
 
 
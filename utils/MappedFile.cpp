@@ -0,0 +1,74 @@
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+using namespace mappedFile;
+
+MappedFile::MappedFile(const std::string &filename, bool isSequential) {
+#ifdef _WIN32
+    file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       isSequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    LARGE_INTEGER file_size;
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return;
+    }
+    if (!GetFileSizeEx(file, &file_size))
+        return;
+    size = static_cast<size_t>(file_size.QuadPart);
+    if (size == 0) {
+        isOpen = true;
+        return;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr)
+        begin = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    isOpen = begin != nullptr;
+#else
+    const int file = open(filename.c_str(), O_RDONLY);
+    struct stat file_stat{};
+    if (file < 0)
+        return;
+    if (fstat(file, &file_stat) == 0) {
+        size = static_cast<size_t>(file_stat.st_size);
+        isOpen = size == 0;
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        // Populated: the whole file is read anyway, one fault instead of one per page
+        if (isSequential)
+            flags |= MAP_POPULATE;
+#endif
+        void *mapped = size > 0 ? mmap(nullptr, size, PROT_READ, flags, file, 0) : MAP_FAILED;
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, size, isSequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+            begin = static_cast<const char *>(mapped);
+            isOpen = true;
+        }
+    }
+    close(file);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+    if (begin != nullptr)
+        UnmapViewOfFile(begin);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    if (file != nullptr)
+        CloseHandle(file);
+#else
+    if (begin != nullptr)
+        munmap(const_cast<char *>(begin), size);
+#endif
+}
@@ -0,0 +1,62 @@
+#ifndef TESTBED_MAPPEDFILE_H
+#define TESTBED_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace mappedFile {
+
+    /// A whole file mapped read-only, unmapped on destruction
+    class MappedFile {
+    private:
+        const char *begin = nullptr;
+        size_t size = 0;
+        bool isOpen = false;
+#ifdef _WIN32
+        /// HANDLEs, windows.h stays out of the header
+        void *file = nullptr;
+        void *mapping = nullptr;
+#endif
+
+    public:
+        /**
+         * @param isSequential the file is read once front to back (a csv): the pages are read ahead at once.
+         * Otherwise (an index) a page is only read when it is touched.
+         */
+        explicit MappedFile(const std::string &filename, bool isSequential = true);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        // -------------------- Getter & Setter -------------------- //
+        /// An empty file opens fine but maps nothing
+        bool IsOpen() const;
+
+        const char *Begin() const;
+
+        const char *End() const;
+
+        size_t GetSize() const;
+    };
+
+    inline bool MappedFile::IsOpen() const {
+        return isOpen;
+    }
+
+    inline const char *MappedFile::Begin() const {
+        return begin;
+    }
+
+    inline const char *MappedFile::End() const {
+        return begin + (begin != nullptr ? size : 0);
+    }
+
+    inline size_t MappedFile::GetSize() const {
+        return begin != nullptr ? size : 0;
+    }
+}
+
+#endif //TESTBED_MAPPEDFILE_H
@@ -0,0 +1,77 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+using namespace threadPool;
+
+ThreadPool::ThreadPool(size_t num_thread) {
+    if (num_thread == 0)
+        num_thread = std::max(1u, std::thread::hardware_concurrency());
+    // The caller is one of the threads
+    for (size_t i = 1; i < num_thread; i++)
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_stopping = true;
+    }
+    job_ready.notify_all();
+    for (auto &worker: workers)
+        worker.join();
+}
+
+void ThreadPool::WorkerLoop() {
+    size_t last_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        job_ready.wait(lock, [&] { return is_stopping || generation != last_generation; });
+        if (is_stopping)
+            return;
+        last_generation = generation;
+        RunChunks(lock);
+    }
+}
+
+void ThreadPool::RunChunks(std::unique_lock<std::mutex> &lock) {
+    const size_t length = job_end - job_begin;
+    while (next_chunk < num_chunk) {
+        const size_t chunk = next_chunk++;
+        const size_t chunk_begin = job_begin + length * chunk / num_chunk;
+        const size_t chunk_end = job_begin + length * (chunk + 1) / num_chunk;
+
+        lock.unlock();
+        job(chunk_begin, chunk_end);
+        lock.lock();
+
+        if (++finished_chunk == num_chunk)
+            job_done.notify_all();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)> &fn,
+                             size_t min_chunk) {
+    if (end <= begin)
+        return;
+    const size_t length = end - begin;
+    const size_t chunks = std::min(GetNumThread(), std::max<size_t>(1, length / std::max<size_t>(1, min_chunk)));
+    if (chunks == 1) {
+        fn(begin, end);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    job = fn;
+    job_begin = begin;
+    job_end = end;
+    num_chunk = chunks;
+    next_chunk = 0;
+    finished_chunk = 0;
+    generation++;
+    job_ready.notify_all();
+
+    RunChunks(lock);
+    job_done.wait(lock, [&] { return finished_chunk == num_chunk; });
+    job = nullptr;
+}
@@ -0,0 +1,71 @@
+#ifndef TESTBED_THREADPOOL_H
+#define TESTBED_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threadPool {
+
+    /**
+     * Fixed set of worker threads for data-parallel loops.
+     * ParallelFor splits [begin, end) into contiguous chunks, the calling thread works on a chunk too
+     * and returns when every chunk is done. One ParallelFor runs at a time per pool.
+     */
+    class ThreadPool {
+    private:
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable job_ready;
+        std::condition_variable job_done;
+
+        /// The current job, split into num_chunk chunks
+        std::function<void(size_t, size_t)> job;
+        size_t job_begin = 0;
+        size_t job_end = 0;
+        size_t num_chunk = 0;
+        size_t next_chunk = 0;
+        size_t finished_chunk = 0;
+        /// Bumped for every job so a worker never runs the same job twice
+        size_t generation = 0;
+        bool is_stopping = false;
+
+        // -------------------- Methods -------------------- //
+        void WorkerLoop();
+
+        /// Run the chunks of the current job until none is left, mutex must be held
+        void RunChunks(std::unique_lock<std::mutex> &lock);
+
+    public:
+        /**
+         * @param num_thread total threads including the caller, 0 means std::thread::hardware_concurrency()
+         */
+        explicit ThreadPool(size_t num_thread = 0);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * Call fn(chunk_begin, chunk_end) over [begin, end) in parallel and wait for it
+         * @param min_chunk smallest range worth a chunk, small loops run on the caller only
+         */
+        void ParallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)> &fn,
+                         size_t min_chunk = 1);
+
+        // -------------------- Getter & Setter -------------------- //
+        size_t GetNumThread() const;
+    };
+
+    inline size_t ThreadPool::GetNumThread() const {
+        return workers.size() + 1;
+    }
+}
+
+#endif //TESTBED_THREADPOOL_H